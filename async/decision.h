@@ -0,0 +1,71 @@
+#pragma once
+
+#include "scheduler.h"
+
+#include <coroutine>
+
+namespace miplot::async {
+
+template <typename T>
+class Decision;
+
+/**
+ * Place where an answer that is not known yet will be delivered.
+ * The coroutine awaiting the pending decision is resumed on the scheduler
+ * after resolve()
+ */
+template <typename T>
+class DecisionSlot {
+public:
+    explicit DecisionSlot(Scheduler& scheduler) : scheduler_(&scheduler) {}
+
+    DecisionSlot(const DecisionSlot&) = delete;
+    DecisionSlot& operator= (const DecisionSlot&) = delete;
+
+    // Decision to return when the answer is given later through resolve()
+    Decision<T> pending()
+    {
+        ready_ = false;
+        return Decision<T>(*this);
+    }
+
+    void resolve(T value)
+    {
+        value_ = value;
+        ready_ = true;
+        if (auto waiting = std::exchange(waiting_, nullptr)) {
+            scheduler_->schedule(waiting);
+        }
+    }
+
+private:
+    friend class Decision<T>;
+
+    Scheduler* scheduler_;
+    T value_{};
+    bool ready_ = false;
+    std::coroutine_handle<> waiting_;
+};
+
+/**
+ * Awaitable answer of a strategy: either known right away or pending in a slot.
+ * Known answers do not suspend the awaiting coroutine
+ */
+template <typename T>
+class Decision {
+public:
+    Decision(T value) : value_(value) {}
+    explicit Decision(DecisionSlot<T>& slot) : slot_(&slot) {}
+
+    bool await_ready() const noexcept { return !slot_ || slot_->ready_; }
+
+    void await_suspend(std::coroutine_handle<> awaiting) noexcept { slot_->waiting_ = awaiting; }
+
+    T await_resume() const { return slot_ ? slot_->value_ : value_; }
+
+private:
+    T value_{};
+    DecisionSlot<T>* slot_ = nullptr;
+};
+
+} // namespace miplot::async
@@ -0,0 +1,29 @@
+#include "scheduler.h"
+
+namespace miplot::async {
+
+void Scheduler::Root::promise_type::unhandled_exception()
+{
+    --scheduler->numActive_;
+    if (!scheduler->error_) {
+        scheduler->error_ = std::current_exception();
+    }
+}
+
+size_t Scheduler::run()
+{
+    size_t numResumed = 0;
+    while (!ready_.empty()) {
+        auto handle = ready_.front();
+        ready_.pop_front();
+        handle.resume();
+        ++numResumed;
+
+        if (error_) {
+            std::rethrow_exception(std::exchange(error_, nullptr));
+        }
+    }
+    return numResumed;
+}
+
+} // namespace miplot::async
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "task.h"
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <utility>
+
+namespace miplot::async {
+
+/**
+ * Single-threaded scheduler of coroutines.
+ * Spawned tasks and coroutines passed to schedule() are resumed in FIFO
+ * order by run(). Everything must be called from the thread running it
+ */
+class Scheduler {
+public:
+    // Start the task on the next run(). onDone receives its result
+    template <typename T, typename F>
+    void spawn(Task<T> task, F onDone)
+    {
+        auto root = runRoot(std::move(task), std::move(onDone));
+        ++numActive_;
+        ready_.push_back(root.handle);
+    }
+
+    // Resume the coroutine on the next run()
+    void schedule(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+    // Resume ready coroutines until there are none left. Returns number of
+    // resumptions. Rethrows the first exception that escaped a spawned task
+    size_t run();
+
+    // Number of spawned tasks not finished yet
+    size_t numActive() const { return numActive_; }
+
+    bool hasReady() const { return !ready_.empty(); }
+
+private:
+    // Self-destroying coroutine owning a spawned task
+    struct Root {
+        struct promise_type {
+            Scheduler* scheduler = nullptr;
+
+            Root get_return_object()
+            {
+                return Root{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception();
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    template <typename T, typename F>
+    Root runRoot(Task<T> task, F onDone)
+    {
+        co_await Bind{this};
+        onDone(co_await std::move(task));
+        --numActive_;
+    }
+
+    // Lets the root coroutine learn its scheduler without suspending
+    struct Bind {
+        Scheduler* scheduler;
+
+        bool await_ready() noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<Root::promise_type> handle) noexcept
+        {
+            handle.promise().scheduler = scheduler;
+            return false;
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::deque<std::coroutine_handle<>> ready_;
+    size_t numActive_ = 0;
+    std::exception_ptr error_;
+};
+
+} // namespace miplot::async
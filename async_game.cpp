@@ -0,0 +1,122 @@
+#include "async_game.h"
+
+namespace miplot::cardgame::durak {
+
+template <typename CardTraits>
+BasicAsyncGame<CardTraits>::BasicAsyncGame(Players&& players, async::Scheduler& scheduler, Rules rules)
+    : Base(std::move(players), rules)
+    , slot_(scheduler)
+    , batchSlot_(scheduler)
+{
+    // Players never change their strategies, look the asynchronous ones up once
+    for (const auto& player : this->players()) {
+        async_.push_back(dynamic_cast<AsyncStrategy*>(&player.strategy()));
+    }
+}
+
+template <typename CardTraits>
+async::Task<RoundResult> BasicAsyncGame<CardTraits>::playRound(size_t firstAttackerIdx)
+{
+    return play(firstAttackerIdx, std::nullopt);
+}
+
+template <typename CardTraits>
+async::Task<RoundResult> BasicAsyncGame<CardTraits>::playRound(size_t firstAttackerIdx,
+                                                               const typename Deck::Order& order)
+{
+    return play(firstAttackerIdx, order);
+}
+
+template <typename CardTraits>
+async::Task<RoundResult> BasicAsyncGame<CardTraits>::play(size_t firstAttackerIdx,
+                                                          std::optional<typename Deck::Order> order)
+{
+    this->startRound(firstAttackerIdx, order ? &*order : nullptr);
+
+    while (!this->isFinished()) {
+        this->beginBout();
+
+        while (this->boutContinues()) {
+            bool attacked;
+            if (this->rules().batchedAttacks) {
+                AttackBatch batch;
+                if (this->curAttacker().numCards() > 0) {
+                    auto* strategy = async_[this->curAttackerIdx()];
+                    if (strategy && !strategy->supportsBatches()) {
+                        int attackIdx = co_await attack();
+                        if (attackIdx != -1) {
+                            batch.push_back(attackIdx);
+                        }
+                    } else {
+                        batch = co_await attackBatch();
+                    }
+                }
+                attacked = this->applyAttackBatch(batch);
+            } else {
+                int attackIdx = -1;
+                if (this->curAttacker().numCards() > 0) {
+                    attackIdx = co_await attack();
+                }
+                attacked = this->applyAttack(attackIdx);
+            }
+            if (!attacked) {
+                continue;
+            }
+
+            while (this->needsDefense()) {
+                if (this->canTransfer() && this->applyTransfer(co_await transfer())) {
+                    continue;
+                }
+                this->applyDefense(co_await defend());
+            }
+
+            this->printTable();
+        }
+
+        this->finishBout(this->endBout());
+    }
+
+    co_return this->finishRound();
+}
+
+template <typename CardTraits>
+async::Decision<int> BasicAsyncGame<CardTraits>::attack()
+{
+    if (auto* strategy = async_[this->curAttackerIdx()]) {
+        return strategy->attackAsync(this->state(), this->curAttacker().hand(), slot_);
+    }
+    return this->curAttacker().attack(this->state());
+}
+
+template <typename CardTraits>
+async::Decision<AttackBatch> BasicAsyncGame<CardTraits>::attackBatch()
+{
+    if (auto* strategy = async_[this->curAttackerIdx()]) {
+        return strategy->attackBatchAsync(this->state(), this->curAttacker().hand(), batchSlot_);
+    }
+    return this->curAttacker().attackBatch(this->state());
+}
+
+template <typename CardTraits>
+async::Decision<int> BasicAsyncGame<CardTraits>::defend()
+{
+    if (auto* strategy = async_[this->defenderIdx()]) {
+        return strategy->defendAsync(this->state(), this->defender().hand(), slot_);
+    }
+    return this->defender().defend(this->state());
+}
+
+template <typename CardTraits>
+async::Decision<int> BasicAsyncGame<CardTraits>::transfer()
+{
+    if (auto* strategy = async_[this->defenderIdx()]) {
+        return strategy->transferAsync(this->state(), this->defender().hand(), slot_);
+    }
+    return this->defender().transfer(this->state());
+}
+
+template class BasicAsyncGame<cards::Std24CardTraits>;
+template class BasicAsyncGame<cards::Std36CardTraits>;
+template class BasicAsyncGame<cards::Std52CardTraits>;
+
+} // namespace miplot::cardgame::durak
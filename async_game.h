@@ -0,0 +1,95 @@
+#pragma once
+
+#include "game.h"
+#include "async/decision.h"
+#include "async/task.h"
+
+#include <optional>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Strategy answering through decisions which may be resolved later,
+ * e.g. by a remote client or a batched evaluator. Playable only in an AsyncGame.
+ * The state and the hand stay valid until the decision is resolved
+ */
+template <typename CardTraits>
+class BasicAsyncStrategy : public BasicStrategy<CardTraits> {
+public:
+    using typename BasicStrategy<CardTraits>::GameState;
+    using typename BasicStrategy<CardTraits>::Cards;
+
+    // Return a card index or slot.pending() and resolve the slot later
+    virtual async::Decision<int> attackAsync(const GameState& state, const Cards& hand,
+                                             async::DecisionSlot<int>& slot) = 0;
+
+    virtual async::Decision<int> defendAsync(const GameState& state, const Cards& hand,
+                                             async::DecisionSlot<int>& slot) = 0;
+
+    virtual async::Decision<int> transferAsync(const GameState& /*state*/, const Cards& /*hand*/,
+                                               async::DecisionSlot<int>& /*slot*/)
+    {
+        return -1;
+    }
+
+    // Used for batched attacks if supportsBatches(), otherwise attackAsync() is
+    virtual async::Decision<AttackBatch> attackBatchAsync(const GameState& /*state*/, const Cards& /*hand*/,
+                                                          async::DecisionSlot<AttackBatch>& /*slot*/)
+    {
+        return AttackBatch();
+    }
+
+    virtual bool supportsBatches() const { return false; }
+
+    int attack(const GameState&, const Cards&) final { throw notSynchronous(); }
+    int defend(const GameState&, const Cards&) final { throw notSynchronous(); }
+    int transfer(const GameState&, const Cards&) final { throw notSynchronous(); }
+    AttackBatch attackBatch(const GameState&, const Cards&) final { throw notSynchronous(); }
+
+private:
+    Exception notSynchronous() const
+    {
+        return Exception("Strategy " + this->name() + " can be played only in an asynchronous game");
+    }
+};
+
+/**
+ * Game driven as a coroutine, so that many games can be multiplexed on one
+ * thread while their players think. Rounds follow the same steps as BasicGame.
+ * Seats with synchronous strategies answer inline without suspending
+ */
+template <typename CardTraits>
+class BasicAsyncGame : public BasicGame<CardTraits> {
+public:
+    using Base = BasicGame<CardTraits>;
+    using typename Base::Deck;
+    using typename Base::Players;
+    using AsyncStrategy = BasicAsyncStrategy<CardTraits>;
+
+    BasicAsyncGame(Players&& players, async::Scheduler& scheduler, Rules rules = Rules());
+
+    // The game must outlive the task
+    async::Task<RoundResult> playRound(size_t firstAttackerIdx);
+    async::Task<RoundResult> playRound(size_t firstAttackerIdx, const typename Deck::Order& order);
+
+private:
+    async::Task<RoundResult> play(size_t firstAttackerIdx, std::optional<typename Deck::Order> order);
+
+    async::Decision<int> attack();
+    async::Decision<AttackBatch> attackBatch();
+    async::Decision<int> defend();
+    async::Decision<int> transfer();
+
+    // Asynchronous strategy of every seat, null for synchronous ones
+    std::vector<AsyncStrategy*> async_;
+
+    async::DecisionSlot<int> slot_;
+    async::DecisionSlot<AttackBatch> batchSlot_;
+};
+
+// Standard 36 card game
+using AsyncStrategy = BasicAsyncStrategy<cards::Std36CardTraits>;
+using AsyncGame = BasicAsyncGame<cards::Std36CardTraits>;
+
+} // namespace miplot::cardgame::durak
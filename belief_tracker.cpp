@@ -0,0 +1,304 @@
+#include "belief_tracker.h"
+#include "exception.h"
+
+#include <algorithm>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+using Traits = Card::Traits;
+
+bool beats(size_t attackCode, size_t defenseCode, Suit trump)
+{
+    auto attackSuit = Traits::suitOf(attackCode);
+    auto defenseSuit = Traits::suitOf(defenseCode);
+    if (attackSuit == defenseSuit) {
+        return Traits::rankOf(attackCode) < Traits::rankOf(defenseCode);
+    }
+    return defenseSuit == trump;
+}
+
+} // namespace
+
+BeliefTracker::BeliefTracker(size_t numPlayers, size_t selfIdx, float resignWeight)
+    : seats_(numPlayers)
+    , selfIdx_(selfIdx)
+    , resignWeight_(resignWeight)
+{
+    REQUIRE(numPlayers <= MAX_SEATS && selfIdx < numPlayers,
+            "Invalid seat " << selfIdx << " of " << numPlayers);
+}
+
+void BeliefTracker::onDeal(CardSet ownHand, size_t trumpCode, size_t deckSize)
+{
+    trumpCode_ = trumpCode;
+    trumpSuit_ = Traits::suitOf(trumpCode);
+    trumpInDeck_ = deckSize > 0;
+    deckSize_ = deckSize;
+
+    // The trump card is shown to everyone. With an empty deck it is the last
+    // dealt card, in the hand of the last seat
+    unseen_ = CardSet::full() - ownHand;
+    unseen_.erase(trumpCode);
+    size_t trumpHolder = trumpInDeck_ ? seats_.size() : seats_.size() - 1;
+    discard_ = CardSet();
+    table_ = CardSet();
+
+    for (size_t idx = 0; idx < seats_.size(); ++idx) {
+        auto& seat = seats_[idx];
+        seat.numCards = ownHand.size();
+        seat.weights.fill(1.0f);
+        if (idx == selfIdx_) {
+            seat.known = ownHand;
+            seat.possible = ownHand;
+        } else {
+            seat.known = CardSet();
+            seat.possible = unseen_;
+            if (idx == trumpHolder) {
+                seat.known.insert(trumpCode);
+                seat.possible.insert(trumpCode);
+            }
+        }
+    }
+}
+
+void BeliefTracker::onAttack(size_t playerIdx, size_t code)
+{
+    reveal(playerIdx, code);
+    table_.insert(code);
+}
+
+void BeliefTracker::onDefense(size_t playerIdx, size_t attackCode, size_t defenseCode)
+{
+    if (defenseCode != NO_CARD) {
+        reveal(playerIdx, defenseCode);
+        table_.insert(defenseCode);
+        return;
+    }
+
+    if (playerIdx == selfIdx_) {
+        return;
+    }
+
+    // Resigning while holding a beating card is legal, so this is only evidence
+    auto& seat = seats_[playerIdx];
+    (seat.possible - seat.known).forEach([&](size_t code) {
+        if (beats(attackCode, code, trumpSuit_)) {
+            seat.weights[code] *= resignWeight_;
+            if (resignWeight_ == 0.0f) {
+                seat.possible.erase(code);
+            }
+        }
+    });
+}
+
+void BeliefTracker::onPickup(size_t playerIdx, CardSet cards)
+{
+    auto& seat = seats_[playerIdx];
+    table_ -= cards;
+    seat.known |= cards;
+    seat.possible |= cards;
+    seat.numCards += cards.size();
+}
+
+void BeliefTracker::onDiscard(CardSet cards)
+{
+    table_ -= cards;
+    discard_ |= cards;
+}
+
+void BeliefTracker::onRefill(size_t playerIdx, size_t numCards)
+{
+    auto& seat = seats_[playerIdx];
+    numCards = std::min(numCards, deckSize_);
+    deckSize_ -= numCards;
+    seat.numCards += numCards;
+
+    // The trump card at the bottom is the last one to be drawn
+    if (deckSize_ == 0 && trumpInDeck_ && numCards > 0) {
+        trumpInDeck_ = false;
+        seat.known.insert(trumpCode_);
+        seat.possible.insert(trumpCode_);
+    }
+}
+
+void BeliefTracker::onOwnRefill(CardSet cards)
+{
+    auto& seat = seats_[selfIdx_];
+    deckSize_ -= std::min(cards.size(), deckSize_);
+    seat.numCards += cards.size();
+    seat.known |= cards;
+    seat.possible |= cards;
+    if (cards.contains(trumpCode_)) {
+        trumpInDeck_ = false;
+    }
+
+    unseen_ -= cards;
+    for (size_t idx = 0; idx < seats_.size(); ++idx) {
+        if (idx != selfIdx_) {
+            seats_[idx].possible -= cards;
+        }
+    }
+}
+
+bool BeliefTracker::sample(std::mt19937_64& rng, std::vector<CardSet>& hands, CardSet& deck,
+                           size_t maxAttempts) const
+{
+    hands.resize(seats_.size());
+
+    size_t numHidden = 0;
+    std::array<size_t, MAX_SEATS> order;
+    size_t numOrdered = 0;
+    for (size_t idx = 0; idx < seats_.size(); ++idx) {
+        const auto& seat = seats_[idx];
+        if (seat.known.size() > seat.numCards) {
+            return false;
+        }
+        numHidden += seat.numCards - seat.known.size();
+        if (seat.numCards > seat.known.size()) {
+            order[numOrdered++] = idx;
+        }
+    }
+    if (numHidden + deckSize_ - (trumpInDeck_ ? 1 : 0) != unseen_.size()) {
+        return false;
+    }
+
+    // Most constrained seats first
+    auto slack = [&](size_t idx) {
+        const auto& seat = seats_[idx];
+        return static_cast<long>((seat.possible & unseen_).size())
+             - static_cast<long>(seat.numCards - seat.known.size());
+    };
+    for (size_t i = 1; i < numOrdered; ++i) {
+        for (size_t j = i; j > 0 && slack(order[j]) < slack(order[j - 1]); --j) {
+            std::swap(order[j], order[j - 1]);
+        }
+    }
+
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    for (size_t attempt = 0; attempt < maxAttempts; ++attempt) {
+        CardSet remaining = unseen_;
+        bool ok = true;
+
+        for (size_t idx = 0; idx < seats_.size(); ++idx) {
+            hands[idx] = seats_[idx].known;
+        }
+
+        for (size_t i = 0; i < numOrdered && ok; ++i) {
+            const auto& seat = seats_[order[i]];
+            CardSet candidates = seat.possible & remaining;
+            size_t need = seat.numCards - seat.known.size();
+            if (candidates.size() < need) {
+                ok = false;
+                break;
+            }
+
+            for (; need > 0; --need) {
+                float total = 0.0f;
+                candidates.forEach([&](size_t code) { total += seat.weights[code]; });
+
+                float point = uniform(rng) * total;
+                size_t chosen = NO_CARD;
+                candidates.forEach([&](size_t code) {
+                    if (chosen == NO_CARD) {
+                        point -= seat.weights[code];
+                        if (point <= 0.0f) chosen = code;
+                    }
+                });
+                if (chosen == NO_CARD) {
+                    // Rounding left the point past the last card
+                    chosen = 63 - __builtin_clzll(candidates.mask());
+                }
+
+                candidates.erase(chosen);
+                remaining.erase(chosen);
+                hands[order[i]].insert(chosen);
+            }
+        }
+
+        if (ok) {
+            deck = remaining;
+            if (trumpInDeck_) {
+                deck.insert(trumpCode_);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void BeliefTracker::reveal(size_t playerIdx, size_t code)
+{
+    auto& seat = seats_[playerIdx];
+    seat.known.erase(code);
+    seat.possible.erase(code);
+    if (seat.numCards > 0) {
+        --seat.numCards;
+    }
+    exclude(CardSet(CardSet::MaskType(1) << code));
+}
+
+void BeliefTracker::exclude(CardSet cards)
+{
+    unseen_ -= cards;
+    for (auto& seat : seats_) {
+        seat.possible -= cards - seat.known;
+    }
+}
+
+BeliefObserver::BeliefObserver(float resignWeight)
+    : resignWeight_(resignWeight)
+{
+}
+
+void BeliefObserver::onDeal(size_t selfIdx, size_t numPlayers, const Cards& hand,
+                            const Card& trumpCard, size_t deckSize)
+{
+    if (!tracker_ || tracker_->numPlayers() != numPlayers || tracker_->selfIdx() != selfIdx) {
+        tracker_.emplace(numPlayers, selfIdx, resignWeight_);
+    }
+    tracker_->onDeal(CardSet::of(hand), trumpCard.code(), deckSize);
+}
+
+void BeliefObserver::onAttack(size_t playerIdx, const Card& card)
+{
+    tracker_->onAttack(playerIdx, card.code());
+}
+
+void BeliefObserver::onDefense(size_t playerIdx, const Card& attack, const Card* defense)
+{
+    tracker_->onDefense(playerIdx, attack.code(), defense ? defense->code() : BeliefTracker::NO_CARD);
+}
+
+void BeliefObserver::onPickup(size_t playerIdx, const Cards& undefended, const CardPairs& defended)
+{
+    CardSet cards = CardSet::of(undefended);
+    for (const auto& pair : defended) {
+        cards.insert(pair.attacking);
+        cards.insert(pair.defending);
+    }
+    tracker_->onPickup(playerIdx, cards);
+}
+
+void BeliefObserver::onDiscard(const CardPairs& defended)
+{
+    CardSet cards;
+    for (const auto& pair : defended) {
+        cards.insert(pair.attacking);
+        cards.insert(pair.defending);
+    }
+    tracker_->onDiscard(cards);
+}
+
+void BeliefObserver::onRefill(size_t playerIdx, size_t numCards, const Cards& drawn)
+{
+    if (playerIdx == tracker_->selfIdx()) {
+        tracker_->onOwnRefill(CardSet::of(drawn));
+    } else {
+        tracker_->onRefill(playerIdx, numCards);
+    }
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "card.h"
+#include "game_observer.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * What one player knows about the other players' hands.
+ *
+ * For every seat the tracker keeps the cards known to be in the hand
+ * (picked up from the table and not played since) and the cards that may
+ * be there, plus a weight per card for soft evidence: a defender who resigned
+ * against a card is less likely to hold cards that beat it.
+ * The tracker is updated incrementally from game events, in the order
+ * they happen, and can sample hidden hands consistent with everything seen.
+ */
+class BeliefTracker {
+public:
+    static constexpr size_t NO_CARD = static_cast<size_t>(-1);
+    static constexpr size_t RADIX = Card::Traits::radix();
+    static constexpr size_t MAX_SEATS = 8;
+
+    /**
+     * @param numPlayers number of seats at the table
+     * @param selfIdx seat of the player owning the tracker
+     * @param resignWeight weight multiplier for the cards able to beat a card
+     *        the player resigned against. 0 excludes them completely
+     */
+    BeliefTracker(size_t numPlayers, size_t selfIdx, float resignWeight = 0.25f);
+
+    // New round: own hand, the trump card at the bottom of the deck and
+    // the number of cards left in the deck after dealing
+    void onDeal(CardSet ownHand, size_t trumpCode, size_t deckSize);
+
+    void onAttack(size_t playerIdx, size_t code);
+
+    // defenseCode is NO_CARD if the defender resigned
+    void onDefense(size_t playerIdx, size_t attackCode, size_t defenseCode);
+
+    // Defender took all the cards from the table
+    void onPickup(size_t playerIdx, CardSet cards);
+
+    void onDiscard(CardSet cards);
+
+    // Player drew cards from the deck. Own cards are passed explicitly
+    void onRefill(size_t playerIdx, size_t numCards);
+    void onOwnRefill(CardSet cards);
+
+    size_t numPlayers() const { return seats_.size(); }
+    size_t selfIdx() const { return selfIdx_; }
+
+    CardSet known(size_t playerIdx) const { return seats_[playerIdx].known; }
+    CardSet possible(size_t playerIdx) const { return seats_[playerIdx].possible; }
+    size_t numCards(size_t playerIdx) const { return seats_[playerIdx].numCards; }
+    float weight(size_t playerIdx, size_t code) const { return seats_[playerIdx].weights[code]; }
+
+    // Cards whose location is not known: hidden in opponents' hands or in the deck
+    CardSet unseen() const { return unseen_; }
+    size_t deckSize() const { return deckSize_; }
+    CardSet discard() const { return discard_; }
+    CardSet table() const { return table_; }
+
+    /**
+     * Sample hidden hands consistent with what is known.
+     * hands[i] receives the full hand of player i (own hand for self),
+     * deck the cards left in the deck, including the trump card.
+     * Returns false if no consistent deal was found in the given number of attempts
+     */
+    bool sample(std::mt19937_64& rng, std::vector<CardSet>& hands, CardSet& deck,
+                size_t maxAttempts = 16) const;
+
+private:
+    struct Seat {
+        CardSet known;
+        CardSet possible;
+        size_t numCards = 0;
+        std::array<float, RADIX> weights;
+    };
+
+    // The card left its holder's hand and became public
+    void reveal(size_t playerIdx, size_t code);
+    void exclude(CardSet cards);
+
+    std::vector<Seat> seats_;
+    size_t selfIdx_;
+    float resignWeight_;
+
+    Suit trumpSuit_ = Suit::Clubs;
+    size_t trumpCode_ = NO_CARD;
+    bool trumpInDeck_ = false;
+    size_t deckSize_ = 0;
+
+    CardSet unseen_;
+    CardSet discard_;
+    CardSet table_;
+};
+
+/**
+ * Keeps a BeliefTracker of the observing player up to date from game events.
+ * Strategies own one and return it from Strategy::observer()
+ */
+class BeliefObserver : public GameObserver {
+public:
+    explicit BeliefObserver(float resignWeight = 0.25f);
+
+    // Tracker of the current round, nullptr before the first deal
+    const BeliefTracker* tracker() const { return tracker_ ? &*tracker_ : nullptr; }
+
+    void onDeal(size_t selfIdx, size_t numPlayers, const Cards& hand,
+                const Card& trumpCard, size_t deckSize) override;
+    void onAttack(size_t playerIdx, const Card& card) override;
+    void onDefense(size_t playerIdx, const Card& attack, const Card* defense) override;
+    void onPickup(size_t playerIdx, const Cards& undefended, const CardPairs& defended) override;
+    void onDiscard(const CardPairs& defended) override;
+    void onRefill(size_t playerIdx, size_t numCards, const Cards& drawn) override;
+
+private:
+    float resignWeight_;
+    std::optional<BeliefTracker> tracker_;
+};
+
+} // namespace miplot::cardgame::durak
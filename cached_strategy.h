@@ -0,0 +1,298 @@
+#pragma once
+
+#include "canonical.h"
+#include "game.h"
+#include "strategy.h"
+#include "utils.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+struct DecisionCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+
+    double hitRate() const
+    {
+        return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+    }
+};
+
+/**
+ * Memoizes decisions of a deterministic strategy S. S declares the parts of
+ * a decision it reads in S::CACHED_INPUTS (see DecisionInput), decisions are
+ * keyed on exactly those and answered with the same cards S would play.
+ *
+ * Unless S reads INPUT_SUIT_NAMES, 36 card decisions are keyed with suits
+ * relabeled by canonicalPermutation(), so decisions that differ only by the
+ * names of non-trump suits share an entry.
+ *
+ * Every thread has its own fixed-size set-associative store per S, shared by
+ * all instances of S on the thread. S is default-constructed, so that all of
+ * them decide alike. Hands too long to encode bypass the cache
+ */
+template <typename S>
+class CachedStrategy : public BasicStrategy<typename S::Cards::value_type::Traits> {
+public:
+    using CardTraits = typename S::Cards::value_type::Traits;
+    using typename BasicStrategy<CardTraits>::GameState;
+    using typename BasicStrategy<CardTraits>::Cards;
+
+    static constexpr uint32_t INPUTS = S::CACHED_INPUTS;
+
+    static_assert(std::is_default_constructible_v<S>, "Cached strategies are not configured");
+
+    int attack(const GameState& state, const Cards& hand) override
+    {
+        return single(Kind::Attack, state, hand);
+    }
+
+    AttackBatch attackBatch(const GameState& state, const Cards& hand) override
+    {
+        Key key;
+        SuitPermutation permutation;
+        if (!makeKey(Kind::AttackBatch, state, hand, key, permutation)) {
+            return strategy_.attackBatch(state, hand);
+        }
+        auto& store = threadStore();
+        AttackBatch batch;
+        if (const auto* entry = store.find(key)) {
+            auto inverse = permutation.inverse();
+            for (size_t i = 0; i < entry->size; ++i) {
+                batch.push_back(indexOf(hand, relabel(inverse, entry->codes[i])));
+            }
+            return batch;
+        }
+        batch = strategy_.attackBatch(state, hand);
+        auto& entry = store.insert(key);
+        for (size_t cardIdx : batch) {
+            entry.codes[entry.size++] = static_cast<uint8_t>(relabel(permutation, hand[cardIdx].code()));
+        }
+        return batch;
+    }
+
+    int defend(const GameState& state, const Cards& hand) override
+    {
+        return single(Kind::Defend, state, hand);
+    }
+
+    int transfer(const GameState& state, const Cards& hand) override
+    {
+        return single(Kind::Transfer, state, hand);
+    }
+
+    const std::string& name() const override { return strategy_.name(); }
+
+    void seed(uint64_t value) override { strategy_.seed(value); }
+
+    BasicGameObserver<CardTraits>* observer() override { return strategy_.observer(); }
+
+    std::string saveState() const override { return strategy_.saveState(); }
+    void loadState(const std::string& state) override { strategy_.loadState(state); }
+
+    // Counters of the calling thread's store
+    static DecisionCacheStats threadStats() { return threadStore().stats; }
+
+private:
+    static constexpr size_t NUM_SETS = 4096;
+    static constexpr size_t NUM_WAYS = 4;
+    static constexpr size_t CODE_BITS = 6;
+    static constexpr size_t CODES_PER_WORD = 64 / CODE_BITS;
+    static constexpr size_t ORDER_WORDS = 3;
+    static constexpr size_t MAX_ORDERED_HAND = ORDER_WORDS * CODES_PER_WORD;
+
+    static_assert(CardTraits::radix() <= (size_t(1) << CODE_BITS), "Card codes do not fit into the key");
+
+    // SuitPermutation works on 36 card codes
+    static constexpr bool CANONICAL =
+        std::is_same_v<CardTraits, cards::Std36CardTraits> && !(INPUTS & INPUT_SUIT_NAMES);
+
+    enum class Kind : uint64_t { Attack, AttackBatch, Defend, Transfer };
+
+    // Header, hand, undefended, defended attacks and defenses, hand order
+    using Key = std::array<uint64_t, 5 + ORDER_WORDS>;
+
+    struct Entry {
+        Key key{};      // all zeros if empty
+        std::array<uint8_t, MAX_ATTACK_SIZE> codes;
+        uint8_t size = 0;
+    };
+
+    struct Store {
+        std::vector<Entry> entries = std::vector<Entry>(NUM_SETS * NUM_WAYS);
+        std::vector<uint8_t> victims = std::vector<uint8_t>(NUM_SETS);
+        DecisionCacheStats stats;
+
+        static size_t setOf(const Key& key)
+        {
+            uint64_t h = 0;
+            for (uint64_t word : key) {
+                h = mixSeed(h, word);
+            }
+            return h & (NUM_SETS - 1);
+        }
+
+        const Entry* find(const Key& key)
+        {
+            const Entry* set = &entries[setOf(key) * NUM_WAYS];
+            for (size_t way = 0; way < NUM_WAYS; ++way) {
+                if (set[way].key == key) {
+                    ++stats.hits;
+                    return &set[way];
+                }
+            }
+            ++stats.misses;
+            return nullptr;
+        }
+
+        // Replaces the ways of a full set in turn
+        Entry& insert(const Key& key)
+        {
+            size_t setIdx = setOf(key);
+            Entry& entry = entries[setIdx * NUM_WAYS + victims[setIdx]];
+            victims[setIdx] = (victims[setIdx] + 1) % NUM_WAYS;
+            entry.key = key;
+            entry.size = 0;
+            return entry;
+        }
+    };
+
+    static_assert((NUM_SETS & (NUM_SETS - 1)) == 0, "Number of sets must be a power of two");
+
+    static Store& threadStore()
+    {
+        thread_local Store store;
+        return store;
+    }
+
+    static size_t indexOf(const Cards& hand, size_t code)
+    {
+        for (size_t i = 0; i < hand.size(); ++i) {
+            if (hand[i].code() == code) {
+                return i;
+            }
+        }
+        throw Exception() << "Cached card " << code << " is not in hand";
+    }
+
+    static size_t relabel(const SuitPermutation& permutation, size_t code)
+    {
+        if constexpr (CANONICAL) {
+            return permutation(code);
+        }
+        return code;
+    }
+
+    template <typename CardSet>
+    static uint64_t relabelMask(const SuitPermutation& permutation, CardSet set)
+    {
+        if constexpr (CANONICAL) {
+            return permutation(set).mask();
+        }
+        return set.mask();
+    }
+
+    // False if the decision cannot be encoded. Codes in the key are relabeled
+    // by permutation, the identity unless CANONICAL
+    static bool makeKey(Kind kind, const GameState& state, const Cards& hand, Key& key,
+                        SuitPermutation& permutation)
+    {
+        using CardSet = typename CardTypes<CardTraits>::CardSet;
+
+        if ((INPUTS & INPUT_HAND_ORDER) && hand.size() > MAX_ORDERED_HAND) {
+            return false;
+        }
+        key.fill(0);
+
+        const auto& undefended = state.undefendedCards();
+        CardSet attacks, defenses;
+        for (const auto& pair : state.defendedCards()) {
+            attacks.insert(pair.attacking);
+            defenses.insert(pair.defending);
+        }
+        if constexpr (CANONICAL) {
+            permutation = canonicalPermutation(state.trumpSuit(),
+                                               {CardSet::of(hand), CardSet::of(undefended), attacks, defenses});
+        }
+
+        uint64_t header = 1;
+        auto put = [&header](uint64_t value, size_t bits) { header = header << bits | value; };
+        put(static_cast<uint64_t>(kind), 2);
+        if (INPUTS & INPUT_TRUMP) {
+            put(CANONICAL ? 0 : static_cast<uint64_t>(state.trumpSuit()), 3);
+        }
+        if (INPUTS & INPUT_DEFENDER_CARDS) {
+            put(state.opponents()[state.defenderIdx()].numCards, 7);
+        }
+        if (INPUTS & INPUT_NUM_PLAYERS) {
+            put(state.opponents().size(), 4);
+        }
+        if (INPUTS & INPUT_DECK_SIZE) {
+            size_t numSeen = state.undefendedCards().size() + 2 * state.defendedCards().size()
+                + state.discard().size();
+            for (const auto& opponent : state.opponents()) {
+                numSeen += opponent.numCards;
+            }
+            put(numSeen < CardTraits::radix() ? CardTraits::radix() - numSeen : 0, 7);
+        }
+        if (INPUTS & INPUT_TABLE) {
+            put(undefended.empty() ? 0 : relabel(permutation, undefended.front().code()) + 1, 7);
+            key[2] = relabelMask(permutation, CardSet::of(undefended));
+            key[3] = relabelMask(permutation, attacks);
+            key[4] = relabelMask(permutation, defenses);
+        }
+        key[0] = header;
+
+        if (INPUTS & INPUT_HAND) {
+            key[1] = relabelMask(permutation, CardSet::of(hand));
+        }
+        if (INPUTS & INPUT_HAND_ORDER) {
+            for (size_t i = 0; i < hand.size(); ++i) {
+                key[5 + i / CODES_PER_WORD] |=
+                    uint64_t(relabel(permutation, hand[i].code()) + 1) << (i % CODES_PER_WORD * CODE_BITS);
+            }
+        }
+        return true;
+    }
+
+    int single(Kind kind, const GameState& state, const Cards& hand)
+    {
+        Key key;
+        SuitPermutation permutation;
+        if (!makeKey(kind, state, hand, key, permutation)) {
+            return decide(kind, state, hand);
+        }
+        auto& store = threadStore();
+        if (const auto* entry = store.find(key)) {
+            return entry->size
+                ? static_cast<int>(indexOf(hand, relabel(permutation.inverse(), entry->codes[0])))
+                : -1;
+        }
+        int cardIdx = decide(kind, state, hand);
+        auto& entry = store.insert(key);
+        if (cardIdx != -1) {
+            entry.codes[entry.size++] = static_cast<uint8_t>(relabel(permutation, hand[cardIdx].code()));
+        }
+        return cardIdx;
+    }
+
+    int decide(Kind kind, const GameState& state, const Cards& hand)
+    {
+        switch (kind) {
+            case Kind::Attack: return strategy_.attack(state, hand);
+            case Kind::Defend: return strategy_.defend(state, hand);
+            case Kind::Transfer: return strategy_.transfer(state, hand);
+            case Kind::AttackBatch: break;
+        }
+        throw Exception() << "Unexpected decision kind";
+    }
+
+    S strategy_;
+};
+
+} // namespace miplot::cardgame::durak
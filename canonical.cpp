@@ -0,0 +1,90 @@
+#include "canonical.h"
+#include "exception.h"
+
+#include <utility>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr size_t NUM_RANKS = Card::Traits::numRanks();
+constexpr uint64_t RANKS_MASK = (uint64_t(1) << NUM_RANKS) - 1;
+constexpr size_t MAX_KEY_SETS = 64 / NUM_RANKS;
+
+} // namespace
+
+SuitPermutation::SuitPermutation()
+    : to_{0, 1, 2, 3}
+{
+}
+
+size_t SuitPermutation::operator()(size_t code) const
+{
+    return to_[code / NUM_RANKS] * NUM_RANKS + code % NUM_RANKS;
+}
+
+CardSet SuitPermutation::operator()(CardSet set) const
+{
+    uint64_t mask = set.mask();
+    uint64_t result = 0;
+    for (size_t suit = 0; suit < NUM_SUITS; ++suit) {
+        result |= ((mask >> (suit * NUM_RANKS)) & RANKS_MASK) << (to_[suit] * NUM_RANKS);
+    }
+    return CardSet(result);
+}
+
+SuitPermutation SuitPermutation::inverse() const
+{
+    SuitPermutation result;
+    for (size_t suit = 0; suit < NUM_SUITS; ++suit) {
+        result.to_[to_[suit]] = suit;
+    }
+    return result;
+}
+
+SuitPermutation canonicalPermutation(Suit trump, std::initializer_list<CardSet> sets)
+{
+    REQUIRE(sets.size() <= MAX_KEY_SETS, "Too many card sets to canonicalize: " << sets.size());
+
+    // Rank masks of a suit in all sets, the first set most significant
+    uint64_t keys[SuitPermutation::NUM_SUITS] = {};
+    for (CardSet set : sets) {
+        uint64_t mask = set.mask();
+        for (size_t suit = 0; suit < SuitPermutation::NUM_SUITS; ++suit) {
+            keys[suit] = (keys[suit] << NUM_RANKS) | ((mask >> (suit * NUM_RANKS)) & RANKS_MASK);
+        }
+    }
+
+    uint8_t others[3];
+    size_t numOthers = 0;
+    for (size_t suit = 0; suit < SuitPermutation::NUM_SUITS; ++suit) {
+        if (suit != static_cast<size_t>(trump)) {
+            others[numOthers++] = suit;
+        }
+    }
+
+    // Sorting network, highest key first
+    auto order = [&](size_t lhs, size_t rhs) {
+        if (keys[others[lhs]] < keys[others[rhs]]) {
+            std::swap(others[lhs], others[rhs]);
+        }
+    };
+    order(0, 1);
+    order(1, 2);
+    order(0, 1);
+
+    SuitPermutation permutation;
+    permutation.to_[static_cast<size_t>(trump)] = static_cast<uint8_t>(Suit::Clubs);
+    for (size_t idx = 0; idx < numOthers; ++idx) {
+        permutation.to_[others[idx]] = idx + 1;
+    }
+    return permutation;
+}
+
+CanonicalHand canonicalize(CardSet hand, Suit trump)
+{
+    auto permutation = canonicalPermutation(trump, {hand});
+    return {permutation(hand), permutation};
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "card.h"
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Relabeling of suits of the 36 card deck, applied to card sets by moving
+ * whole 9-bit rank masks
+ */
+class SuitPermutation {
+public:
+    static constexpr size_t NUM_SUITS = 4;
+
+    // Identity
+    SuitPermutation();
+
+    // Suit that suit becomes
+    Suit operator()(Suit suit) const { return static_cast<Suit>(to_[static_cast<size_t>(suit)]); }
+    size_t operator()(size_t code) const;
+    CardSet operator()(CardSet set) const;
+
+    SuitPermutation inverse() const;
+
+    bool operator== (const SuitPermutation& other) const { return to_ == other.to_; }
+
+private:
+    friend SuitPermutation canonicalPermutation(Suit trump, std::initializer_list<CardSet> sets);
+
+    std::array<uint8_t, NUM_SUITS> to_;
+};
+
+/*
+ * Non-trump suits are interchangeable: positions that differ only by how
+ * they are labeled play the same. The canonical labeling moves the trump
+ * to Clubs and orders the other suits by their rank masks in the given sets,
+ * compared set by set, the highest becoming Diamonds. Suits with equal masks
+ * in every set are interchangeable, so the canonical sets do not depend
+ * on which of them goes first.
+ */
+
+// Up to 7 sets, permuted together, e.g. a hand and the cards on the table
+SuitPermutation canonicalPermutation(Suit trump, std::initializer_list<CardSet> sets);
+
+struct CanonicalHand {
+    CardSet hand;
+    // Maps the original hand to the canonical one, its inverse maps answers back
+    SuitPermutation permutation;
+};
+
+CanonicalHand canonicalize(CardSet hand, Suit trump);
+
+} // namespace miplot::cardgame::durak
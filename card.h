@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common/card.h"
+#include "common/card_set.h"
 #include "common/card_traits.h"
 
 #include <ostream>
@@ -9,16 +10,31 @@
 
 namespace miplot::cardgame::durak {
 
+template <typename CardTraits>
+struct BasicCardPair {
+    cards::Card<CardTraits> attacking;
+    cards::Card<CardTraits> defending;
+};
+
+// Card types of a game played with the deck described by CardTraits
+template <typename CardTraits>
+struct CardTypes {
+    using Suit = typename CardTraits::SuitType;
+    using Rank = typename CardTraits::RankType;
+    using Card = cards::Card<CardTraits>;
+    using Cards = std::vector<Card>;
+    using CardSet = cards::CardSet<CardTraits>;
+    using CardPair = BasicCardPair<CardTraits>;
+    using CardPairs = std::vector<CardPair>;
+};
+
+// Standard 36 card game
 using Suit = cards::Suit4;
 using Rank = cards::Rank9;
 using Card = cards::Card36;
 using Cards = std::vector<Card>;
-
-struct CardPair {
-    Card attacking;
-    Card defending;
-};
-
+using CardSet = cards::CardSet36;
+using CardPair = BasicCardPair<cards::Std36CardTraits>;
 using CardPairs = std::vector<CardPair>;
 
 } // namespace miplot::cardgame::durak
@@ -0,0 +1,228 @@
+#include "cfr/abstraction.h"
+#include "game.h"
+
+#include <algorithm>
+
+namespace miplot::cardgame::durak::cfr {
+
+namespace {
+
+constexpr size_t NUM_RANKS = Card::Traits::numRanks();
+constexpr uint64_t RANKS_MASK = (uint64_t(1) << NUM_RANKS) - 1;
+// Three lowest ranks of every suit
+constexpr CardSet LOW_CARDS(0x7ull | 0x7ull << NUM_RANKS | 0x7ull << 2 * NUM_RANKS | 0x7ull << 3 * NUM_RANKS);
+
+uint64_t trumpBits(Suit trump)
+{
+    return RANKS_MASK << (static_cast<size_t>(trump) * NUM_RANKS);
+}
+
+size_t rankOf(size_t code)
+{
+    return code % NUM_RANKS;
+}
+
+// Lowest card by rank, the lowest suit on ties. -1 if empty
+int lowest(CardSet set)
+{
+    int best = -1;
+    set.forEach([&](size_t code) {
+        if (best == -1 || rankOf(code) < rankOf(best)) {
+            best = code;
+        }
+    });
+    return best;
+}
+
+int highest(CardSet set)
+{
+    int best = -1;
+    set.forEach([&](size_t code) {
+        if (best == -1 || rankOf(code) >= rankOf(best)) {
+            best = code;
+        }
+    });
+    return best;
+}
+
+// Cards of ranks held at least twice
+CardSet paired(CardSet set)
+{
+    uint64_t counts[NUM_RANKS] = {};
+    set.forEach([&](size_t code) { ++counts[rankOf(code)]; });
+    CardSet result;
+    set.forEach([&](size_t code) {
+        if (counts[rankOf(code)] >= 2) {
+            result.insert(code);
+        }
+    });
+    return result;
+}
+
+// 0 for none, then low, middle and high thirds of ranks
+uint64_t rankBucket(int code)
+{
+    return code == -1 ? 0 : 1 + rankOf(code) / 3;
+}
+
+uint64_t deckBucket(size_t deckSize)
+{
+    if (deckSize == 0) return 0;
+    if (deckSize <= 3) return 1;
+    if (deckSize <= 8) return 2;
+    if (deckSize <= 16) return 3;
+    return 4;
+}
+
+uint64_t tableBucket(CardSet table)
+{
+    return std::min<size_t>(table.size() / 2, 3);
+}
+
+// Split into plain cards and trumps
+void split(CardSet set, Suit trump, CardSet& plain, CardSet& trumps)
+{
+    trumps = CardSet(set.mask() & trumpBits(trump));
+    plain = set - trumps;
+}
+
+// Add action idx unless another action already plays the card
+void offer(AbstractActions& actions, size_t idx, int code)
+{
+    if (code == -1) {
+        return;
+    }
+    for (size_t other = 0; other < idx; ++other) {
+        if ((actions.available >> other & 1) && actions.codes[other] == code) {
+            return;
+        }
+    }
+    actions.codes[idx] = code;
+    actions.available |= 1 << idx;
+}
+
+} // namespace
+
+uint64_t infoKey(const Observation& observation)
+{
+    CardSet plain, trumps;
+    split(observation.hand, observation.trump, plain, trumps);
+    CardSet plainCandidates, trumpCandidates;
+    split(observation.candidates, observation.trump, plainCandidates, trumpCandidates);
+
+    uint64_t lowPlain = std::min<size_t>((plain & LOW_CARDS).size(), 3);
+
+    uint64_t key = 1;
+    auto put = [&key](uint64_t value, size_t bits) { key = key << bits | value; };
+
+    put(static_cast<uint64_t>(observation.kind), 2);
+    put(deckBucket(observation.deckSize), 3);
+    put(std::min<size_t>(observation.hand.size(), 7), 3);
+    put(std::min<size_t>(observation.numOpponentCards, 7), 3);
+    put(std::min<size_t>(trumps.size(), 4), 3);
+    put(rankBucket(highest(trumps)), 2);
+    put(lowPlain, 2);
+
+    switch (observation.kind) {
+        case DecisionKind::Lead:
+            put(rankBucket(lowest(plain)), 2);
+            put(!paired(plain).empty(), 1);
+            put(rankBucket(highest(plain)), 2);
+            break;
+        case DecisionKind::PileOn:
+            put(observation.resigned, 1);
+            put(rankBucket(lowest(plainCandidates)), 2);
+            put(!trumpCandidates.empty(), 1);
+            put(tableBucket(observation.table), 2);
+            break;
+        case DecisionKind::Defend: {
+            bool trumpAttack = Card::Traits::suitOf(observation.attackCode) == observation.trump;
+            put(trumpAttack, 1);
+            put(rankBucket(observation.attackCode), 2);
+            put(rankBucket(lowest(trumpAttack ? trumpCandidates : plainCandidates)), 2);
+            put(!trumpAttack && !trumpCandidates.empty(), 1);
+            put(tableBucket(observation.table), 2);
+            break;
+        }
+    }
+    return key;
+}
+
+AbstractActions abstractActions(const Observation& observation)
+{
+    AbstractActions actions;
+    CardSet plain, trumps;
+    split(observation.candidates, observation.trump, plain, trumps);
+
+    switch (observation.kind) {
+        case DecisionKind::Lead:
+            offer(actions, 0, lowest(plain));
+            offer(actions, 1, lowest(paired(plain)));
+            offer(actions, 2, highest(plain));
+            offer(actions, 3, lowest(trumps));
+            break;
+        case DecisionKind::PileOn:
+        case DecisionKind::Defend: {
+            actions.available = 1;
+            bool trumpAttack = observation.kind == DecisionKind::Defend
+                && Card::Traits::suitOf(observation.attackCode) == observation.trump;
+            offer(actions, 1, lowest(trumpAttack ? trumps : plain));
+            if (!trumpAttack) {
+                offer(actions, 2, lowest(trumps));
+            }
+            break;
+        }
+    }
+    return actions;
+}
+
+Observation observe(const GameState& state, const Cards& hand, bool defending)
+{
+    Observation observation;
+    observation.trump = state.trumpSuit();
+    observation.hand = CardSet::of(hand);
+
+    const auto& undefended = state.undefendedCards();
+    CardSet undefendedSet = CardSet::of(undefended);
+    observation.table = undefendedSet;
+    for (const auto& pair : state.defendedCards()) {
+        observation.table.insert(pair.attacking);
+        observation.table.insert(pair.defending);
+    }
+
+    size_t numSeen = observation.table.size() + state.discard().size();
+    for (const auto& opponent : state.opponents()) {
+        numSeen += opponent.numCards;
+    }
+    observation.deckSize = numSeen < Deck::RADIX ? Deck::RADIX - numSeen : 0;
+    observation.numOpponentCards = state.opponents()[defending ? state.mainAttackerIdx() : state.defenderIdx()].numCards;
+
+    if (defending) {
+        observation.kind = DecisionKind::Defend;
+        const auto& attack = undefended.front();
+        observation.attackCode = attack.code();
+        for (const auto& card : hand) {
+            if ((card.suit() == attack.suit() && card.rank() > attack.rank())
+                    || (card.suit() != attack.suit() && card.suit() == state.trumpSuit())) {
+                observation.candidates.insert(card);
+            }
+        }
+    } else if (observation.table.empty()) {
+        observation.kind = DecisionKind::Lead;
+        observation.candidates = observation.hand;
+    } else {
+        observation.kind = DecisionKind::PileOn;
+        // With two players an attacker only sees an undefended card after a resign
+        observation.resigned = !undefended.empty();
+        uint64_t tableRanks = 0;
+        observation.table.forEach([&](size_t code) { tableRanks |= uint64_t(1) << rankOf(code); });
+        for (const auto& card : hand) {
+            if (tableRanks >> rankOf(card.code()) & 1) {
+                observation.candidates.insert(card);
+            }
+        }
+    }
+    return observation;
+}
+
+} // namespace miplot::cardgame::durak::cfr
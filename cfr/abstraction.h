@@ -0,0 +1,38 @@
+#pragma once
+
+#include "cfr/model.h"
+#include "strategy.h"
+
+#include <cstdint>
+
+namespace miplot::cardgame::durak::cfr {
+
+/*
+ * Abstraction of decisions for CFR. Information sets are keyed by buckets:
+ * deck size, hand sizes, trumps held, low cards held and a few facts about
+ * the decision (rank of the card to beat, cheapest answers, table size).
+ * Actions are abstract moves mapped to concrete cards:
+ *   Lead: lowest plain card, lowest card of a rank held twice,
+ *         highest plain card, lowest trump
+ *   PileOn: fold, lowest matching plain card, lowest matching trump
+ *   Defend: resign, cheapest beat in suit, cheapest trump over a plain card
+ * Abstract actions mapping to the same card as an earlier one are unavailable.
+ */
+constexpr size_t NUM_ACTIONS = 4;
+
+struct AbstractActions {
+    // Card code of every action, -1 to fold or resign
+    int8_t codes[NUM_ACTIONS] = {-1, -1, -1, -1};
+    // Bit mask of available actions
+    uint8_t available = 0;
+};
+
+// Nonzero key of the information set
+uint64_t infoKey(const Observation& observation);
+
+AbstractActions abstractActions(const Observation& observation);
+
+// Observation of a real two player game with default rules
+Observation observe(const GameState& state, const Cards& hand, bool defending);
+
+} // namespace miplot::cardgame::durak::cfr
@@ -0,0 +1,178 @@
+#include "cfr/model.h"
+#include "exception.h"
+
+namespace miplot::cardgame::durak::cfr {
+
+namespace {
+
+constexpr size_t NUM_RANKS = Card::Traits::numRanks();
+constexpr uint64_t RANKS_MASK = (uint64_t(1) << NUM_RANKS) - 1;
+
+uint64_t suitBits(Suit suit)
+{
+    return RANKS_MASK << (static_cast<size_t>(suit) * NUM_RANKS);
+}
+
+// Ranks present in the set, as a mask of ranks
+uint64_t rankMask(CardSet set)
+{
+    uint64_t mask = set.mask();
+    return (mask | mask >> NUM_RANKS | mask >> (2 * NUM_RANKS) | mask >> (3 * NUM_RANKS)) & RANKS_MASK;
+}
+
+// Cards of the set with ranks in the rank mask
+CardSet withRanks(CardSet set, uint64_t ranks)
+{
+    uint64_t spread = ranks | ranks << NUM_RANKS | ranks << (2 * NUM_RANKS) | ranks << (3 * NUM_RANKS);
+    return CardSet(set.mask() & spread);
+}
+
+} // namespace
+
+CompactRound::CompactRound(const Deck::Order& order, size_t firstAttackerIdx)
+{
+    REQUIRE(firstAttackerIdx < NUM_PLAYERS, "Invalid first attacker: " << firstAttackerIdx);
+
+    size_t pos = 0;
+    for (auto& hand : hands_) {
+        for (size_t i = 0; i < HAND_SIZE; ++i) {
+            hand.insert(order[pos++]);
+        }
+    }
+    // The top card shows the trump and goes to the bottom, as in Game::deal
+    trump_ = Card::Traits::suitOf(order[pos]);
+    for (size_t i = pos + 1; i < order.size(); ++i) {
+        deck_[deckEnd_++] = order[i];
+    }
+    deck_[deckEnd_++] = order[pos];
+
+    attacker_ = firstAttackerIdx;
+    nextAttack();
+}
+
+std::optional<size_t> CompactRound::loser() const
+{
+    bool hasCards[NUM_PLAYERS] = {!hands_[0].empty(), !hands_[1].empty()};
+    if (hasCards[0] != hasCards[1]) {
+        return hasCards[0] ? 0 : 1;
+    }
+    return std::nullopt;
+}
+
+DecisionKind CompactRound::kind() const
+{
+    if (defending_) {
+        return DecisionKind::Defend;
+    }
+    return table_.empty() ? DecisionKind::Lead : DecisionKind::PileOn;
+}
+
+CardSet CompactRound::candidates() const
+{
+    if (defending_) {
+        size_t code = undefended_.first();
+        Suit suit = Card::Traits::suitOf(code);
+        // Higher cards of the suit, all trumps against a plain suit
+        uint64_t higher = suitBits(suit) & ~((uint64_t(2) << code) - 1);
+        uint64_t beats = suit == trump_ ? higher : higher | suitBits(trump_);
+        return CardSet(hands_[defender()].mask() & beats);
+    }
+    if (table_.empty()) {
+        return hands_[attacker_];
+    }
+    return withRanks(hands_[attacker_], rankMask(table_));
+}
+
+bool CompactRound::boutContinues() const
+{
+    return undefended_.size() < hands_[defender()].size()
+        && undefended_.size() + numPairs_ < HAND_SIZE;
+}
+
+void CompactRound::nextAttack()
+{
+    if (!boutContinues() || hands_[attacker_].empty()) {
+        endBout();
+    }
+}
+
+void CompactRound::apply(int code)
+{
+    REQUIRE(!finished_, "Round is finished");
+    REQUIRE(code == -1 ? kind() != DecisionKind::Lead : candidates().contains(code),
+            "Illegal " << static_cast<int>(kind()) << " decision: " << code);
+
+    if (defending_) {
+        defending_ = false;
+        if (code == -1) {
+            resigned_ = true;
+        } else {
+            hands_[defender()].erase(code);
+            table_.insert(code);
+            undefended_ = CardSet();
+            ++numPairs_;
+        }
+        nextAttack();
+        return;
+    }
+
+    if (code == -1) {
+        endBout();
+        return;
+    }
+    hands_[attacker_].erase(code);
+    table_.insert(code);
+    undefended_.insert(code);
+    if (resigned_) {
+        nextAttack();
+    } else {
+        defending_ = true;
+    }
+}
+
+void CompactRound::endBout()
+{
+    ++numBouts_;
+    if (resigned_) {
+        hands_[defender()] |= table_;
+    }
+    table_ = CardSet();
+    undefended_ = CardSet();
+    numPairs_ = 0;
+
+    // Main attacker draws first
+    for (size_t i = 0, idx = attacker_; i < NUM_PLAYERS && deckPos_ < deckEnd_; ++i, idx = 1 - idx) {
+        while (hands_[idx].size() < HAND_SIZE && deckPos_ < deckEnd_) {
+            hands_[idx].insert(deck_[deckPos_++]);
+        }
+    }
+
+    if (hands_[0].empty() || hands_[1].empty() || numBouts_ >= MAX_BOUTS) {
+        finished_ = true;
+        return;
+    }
+
+    // The attacker goes on after a resign, the defender attacks after beating
+    if (!resigned_) {
+        attacker_ = defender();
+    }
+    resigned_ = false;
+    nextAttack();
+}
+
+Observation CompactRound::observe() const
+{
+    Observation observation;
+    observation.kind = kind();
+    observation.trump = trump_;
+    observation.hand = hands_[actor()];
+    observation.table = table_;
+    observation.candidates = candidates();
+    observation.attackCode = defending_ ? static_cast<int>(undefended_.first()) : -1;
+    observation.resigned = resigned_;
+    observation.numOpponentCards = hands_[1 - actor()].size();
+    observation.deckSize = deckSize();
+    return observation;
+}
+
+} // namespace miplot::cardgame::durak::cfr
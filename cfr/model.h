@@ -0,0 +1,92 @@
+#pragma once
+
+#include "card.h"
+#include "deck.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace miplot::cardgame::durak::cfr {
+
+constexpr size_t NUM_PLAYERS = 2;
+constexpr size_t HAND_SIZE = 6;
+// Same cap as Rules::maxBouts used by the tools, a longer round is a draw
+constexpr size_t MAX_BOUTS = 1000;
+
+enum class DecisionKind : uint8_t {
+    Lead,       // first card of a bout
+    PileOn,     // more cards of ranks on the table, or fold
+    Defend,     // beat the undefended card, or resign
+};
+
+// What the deciding player sees, enough to abstract a decision
+struct Observation {
+    DecisionKind kind = DecisionKind::Lead;
+    Suit trump = Suit::Clubs;
+    CardSet hand;
+    // Every card on the table
+    CardSet table;
+    // Cards that may be played, passing is allowed unless leading
+    CardSet candidates;
+    // Defend: the card to beat
+    int attackCode = -1;
+    // PileOn: the defender has resigned and takes everything
+    bool resigned = false;
+    uint8_t numOpponentCards = 0;
+    uint8_t deckSize = 0;
+};
+
+/**
+ * Two player round of the classic game (Game with default Rules) on card
+ * masks, cheap to copy for branching a game tree. Forced steps, such as
+ * folding with an empty hand, are taken automatically, so a round is
+ * always either finished or waiting for a decision of actor()
+ */
+class CompactRound {
+public:
+    CompactRound(const Deck::Order& order, size_t firstAttackerIdx);
+
+    bool isFinished() const { return finished_; }
+    // Losing player of a finished round, none on a draw
+    std::optional<size_t> loser() const;
+
+    size_t actor() const { return defending_ ? 1 - attacker_ : attacker_; }
+    DecisionKind kind() const;
+
+    // Card code to play, -1 to fold or resign
+    void apply(int code);
+
+    Observation observe() const;
+
+    const CardSet& hand(size_t playerIdx) const { return hands_[playerIdx]; }
+    Suit trump() const { return trump_; }
+    size_t deckSize() const { return deckEnd_ - deckPos_; }
+
+private:
+    size_t defender() const { return 1 - attacker_; }
+    CardSet candidates() const;
+
+    bool boutContinues() const;
+    // Ask the attacker, or end the bout
+    void nextAttack();
+    void endBout();
+
+    std::array<uint8_t, Deck::RADIX> deck_;
+    uint8_t deckPos_ = 0;
+    uint8_t deckEnd_ = 0;
+    Suit trump_ = Suit::Clubs;
+
+    CardSet hands_[NUM_PLAYERS];
+    CardSet table_;
+    CardSet undefended_;
+    uint8_t numPairs_ = 0;
+
+    uint8_t attacker_ = 0;
+    bool defending_ = false;
+    bool resigned_ = false;
+    bool finished_ = false;
+    uint16_t numBouts_ = 0;
+};
+
+} // namespace miplot::cardgame::durak::cfr
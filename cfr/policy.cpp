@@ -0,0 +1,131 @@
+#include "cfr/policy.h"
+#include "cfr/trainer.h"
+#include "exception.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace miplot::cardgame::durak::cfr {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'C', 'P'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numActions;
+    uint32_t reserved;
+    uint64_t numSlots;
+    uint64_t numEntries;
+};
+
+struct Slot {
+    uint64_t key;
+    uint8_t probs[NUM_ACTIONS];
+    uint8_t reserved[8 - NUM_ACTIONS];
+};
+
+static_assert(sizeof(Header) == 32, "Unexpected policy header size");
+static_assert(sizeof(Slot) == 16, "Unexpected policy slot size");
+
+const Header& header(const MappedFile& file)
+{
+    return *reinterpret_cast<const Header*>(file.data());
+}
+
+const Slot* slots(const MappedFile& file)
+{
+    return reinterpret_cast<const Slot*>(file.data() + sizeof(Header));
+}
+
+} // namespace
+
+Policy::Policy(MappedFile file)
+    : file_(std::move(file))
+{
+    REQUIRE(file_.size() >= sizeof(Header), "Policy is too short");
+    const auto& h = header(file_);
+    REQUIRE(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a CFR policy");
+    REQUIRE(h.version == VERSION, "Unsupported policy version: " << h.version);
+    REQUIRE(h.numActions == NUM_ACTIONS, "Policy has " << h.numActions << " actions");
+    REQUIRE(std::has_single_bit(h.numSlots) && h.numEntries < h.numSlots,
+            "Policy has invalid number of slots");
+    REQUIRE(file_.size() >= sizeof(Header) + h.numSlots * sizeof(Slot), "Policy is truncated");
+}
+
+Policy Policy::open(const std::string& path)
+{
+    return Policy(MappedFile::open(path));
+}
+
+void Policy::write(const std::string& path, const RegretTable& table)
+{
+    size_t numEntries = 0;
+    table.forEach([&](const RegretTable::Entry&) {
+        ++numEntries;
+    });
+    // At most half full, so that misses end on an empty slot soon
+    size_t numSlots = std::bit_ceil(std::max<size_t>(2 * numEntries, 2));
+
+    // An older, larger file would keep its tail
+    std::remove(path.c_str());
+    auto file = MappedFile::openWritable(path, sizeof(Header) + numSlots * sizeof(Slot));
+    std::memset(file.mutableData(), 0, file.size());
+    auto* out = reinterpret_cast<Slot*>(file.mutableData() + sizeof(Header));
+
+    size_t written = 0;
+    table.forEach([&](const RegretTable::Entry& entry) {
+        float sums[NUM_ACTIONS];
+        float total = 0;
+        for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+            sums[a] = std::max(0.0f, entry.strategy[a].load(std::memory_order_relaxed));
+            total += sums[a];
+        }
+        if (total <= 0) {
+            return;
+        }
+
+        uint64_t key = entry.key.load(std::memory_order_relaxed);
+        size_t idx = hashKey(key) & (numSlots - 1);
+        while (out[idx].key != 0) {
+            idx = (idx + 1) & (numSlots - 1);
+        }
+        out[idx].key = key;
+        for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+            out[idx].probs[a] = static_cast<uint8_t>(std::lround(255.0f * sums[a] / total));
+        }
+        ++written;
+    });
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.numActions = NUM_ACTIONS;
+    h.numSlots = numSlots;
+    h.numEntries = written;
+    std::memcpy(file.mutableData(), &h, sizeof(h));
+    file.sync();
+}
+
+const uint8_t* Policy::lookup(uint64_t key) const
+{
+    size_t mask = header(file_).numSlots - 1;
+    const Slot* table = slots(file_);
+    for (size_t idx = hashKey(key) & mask; table[idx].key != 0; idx = (idx + 1) & mask) {
+        if (table[idx].key == key) {
+            return table[idx].probs;
+        }
+    }
+    return nullptr;
+}
+
+size_t Policy::numEntries() const
+{
+    return header(file_).numEntries;
+}
+
+} // namespace miplot::cardgame::durak::cfr
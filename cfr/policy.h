@@ -0,0 +1,37 @@
+#pragma once
+
+#include "cfr/abstraction.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+
+namespace miplot::cardgame::durak::cfr {
+
+class RegretTable;
+
+/**
+ * Average strategy of a trained RegretTable, used directly through mmap.
+ * The file is a fixed header followed by a power of two number of
+ * open addressing slots: uint64 information set key (0 if empty) and
+ * the probabilities of the abstract actions quantized to 0..255
+ */
+class Policy {
+public:
+    static Policy open(const std::string& path);
+
+    // Export information sets with a nonzero average strategy
+    static void write(const std::string& path, const RegretTable& table);
+
+    // Quantized probabilities of the abstract actions, nullptr if the information set is unknown
+    const uint8_t* lookup(uint64_t key) const;
+
+    size_t numEntries() const;
+
+private:
+    explicit Policy(MappedFile file);
+
+    MappedFile file_;
+};
+
+} // namespace miplot::cardgame::durak::cfr
@@ -0,0 +1,266 @@
+#include "cfr/trainer.h"
+#include "exception.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace miplot::cardgame::durak::cfr {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'C', 'R'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t MAX_PROBES = 32;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numActions;
+    uint32_t reserved;
+    uint64_t numIterations;
+    uint64_t numEntries;
+};
+
+static_assert(sizeof(Header) == 32, "Unexpected regret checkpoint header size");
+
+// Regret matching, uniform over available actions without positive regrets
+void currentStrategy(const RegretTable::Entry* entry, uint8_t available, float* sigma)
+{
+    float total = 0;
+    for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+        float regret = entry && (available >> a & 1) ? entry->regrets[a].load(std::memory_order_relaxed) : 0.0f;
+        sigma[a] = regret > 0 ? regret : 0.0f;
+        total += sigma[a];
+    }
+    if (total > 0) {
+        for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+            sigma[a] /= total;
+        }
+        return;
+    }
+    float uniform = 1.0f / std::popcount(available);
+    for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+        sigma[a] = (available >> a & 1) ? uniform : 0.0f;
+    }
+}
+
+// Never an action of probability 0, also when rounding leaves r above 0
+size_t sample(const float* sigma, uint8_t available, std::mt19937_64& rng)
+{
+    float r = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    size_t last = 0;
+    for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+        if ((available >> a & 1) && sigma[a] > 0) {
+            last = a;
+            r -= sigma[a];
+            if (r < 0) {
+                return a;
+            }
+        }
+    }
+    return last;
+}
+
+} // namespace
+
+RegretTable::RegretTable(size_t memoryBytes)
+{
+    size_t numEntries = std::max<size_t>(memoryBytes / sizeof(Entry), MAX_PROBES);
+    capacity_ = std::bit_floor(numEntries);
+    entries_.reset(new Entry[capacity_]);
+}
+
+RegretTable::Entry* RegretTable::find(uint64_t key, bool insert)
+{
+    size_t mask = capacity_ - 1;
+    size_t idx = hashKey(key) & mask;
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe, idx = (idx + 1) & mask) {
+        Entry& entry = entries_[idx];
+        uint64_t current = entry.key.load(std::memory_order_relaxed);
+        if (current == key) {
+            return &entry;
+        }
+        if (current == 0) {
+            if (!insert) {
+                return nullptr;
+            }
+            if (entry.key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+                size_.fetch_add(1, std::memory_order_relaxed);
+                return &entry;
+            }
+            if (current == key) {
+                return &entry;
+            }
+        }
+    }
+    if (insert) {
+        numDropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+void RegretTable::save(const std::string& path, uint64_t numIterations) const
+{
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        REQUIRE(out, "Cannot open " << tmpPath << ": " << std::strerror(errno));
+
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.numActions = NUM_ACTIONS;
+        h.numIterations = numIterations;
+        h.numEntries = size();
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+        forEach([&](const Entry& entry) {
+            uint64_t key = entry.key.load(std::memory_order_relaxed);
+            float values[2 * NUM_ACTIONS];
+            for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+                values[a] = entry.regrets[a].load(std::memory_order_relaxed);
+                values[NUM_ACTIONS + a] = entry.strategy[a].load(std::memory_order_relaxed);
+            }
+            out.write(reinterpret_cast<const char*>(&key), sizeof(key));
+            out.write(reinterpret_cast<const char*>(values), sizeof(values));
+        });
+        REQUIRE(out.flush(), "Cannot write " << tmpPath);
+    }
+    REQUIRE(std::rename(tmpPath.c_str(), path.c_str()) == 0,
+            "Cannot rename " << tmpPath << ": " << std::strerror(errno));
+}
+
+uint64_t RegretTable::load(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    REQUIRE(in, "Cannot open " << path << ": " << std::strerror(errno));
+
+    Header h;
+    REQUIRE(in.read(reinterpret_cast<char*>(&h), sizeof(h)), "Regret checkpoint is too short");
+    REQUIRE(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a regret checkpoint");
+    REQUIRE(h.version == VERSION, "Unsupported regret checkpoint version: " << h.version);
+    REQUIRE(h.numActions == NUM_ACTIONS, "Regret checkpoint has " << h.numActions << " actions");
+
+    for (uint64_t idx = 0; idx < h.numEntries; ++idx) {
+        uint64_t key;
+        float values[2 * NUM_ACTIONS];
+        REQUIRE(in.read(reinterpret_cast<char*>(&key), sizeof(key))
+                && in.read(reinterpret_cast<char*>(values), sizeof(values)),
+                "Regret checkpoint is truncated");
+        Entry* entry = find(key, true);
+        REQUIRE(entry, "Regret checkpoint does not fit into " << capacity_ << " entries");
+        for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+            entry->regrets[a].store(values[a], std::memory_order_relaxed);
+            entry->strategy[a].store(values[NUM_ACTIONS + a], std::memory_order_relaxed);
+        }
+    }
+    return h.numIterations;
+}
+
+Trainer::Trainer(RegretTable& table, TrainerOptions options)
+    : table_(table)
+    , options_(options)
+{
+}
+
+void Trainer::run(size_t firstIteration, size_t numIterations)
+{
+    parallelFor(numIterations, options_.numThreads, [&](size_t, size_t begin, size_t end) {
+        // Creating a deck seeds it from std::random_device, reuse one
+        auto deck = Deck::create();
+        const auto initial = deck.order();
+        size_t numNodes = 0;
+
+        for (size_t iteration = firstIteration + begin; iteration < firstIteration + end; ++iteration) {
+            std::mt19937_64 rng(mixSeed(options_.seed, iteration));
+            deck.arrange(initial);
+            deck.seed(rng());
+            deck.shuffle();
+            auto order = deck.order();
+
+            for (size_t traverser = 0; traverser < NUM_PLAYERS; ++traverser) {
+                CompactRound round(order, iteration % NUM_PLAYERS);
+                size_t skip = std::uniform_int_distribution<size_t>(0, options_.maxSkip)(rng);
+                traverse(round, traverser, skip, 0, iteration + 1, rng, numNodes);
+            }
+        }
+        numNodes_.fetch_add(numNodes, std::memory_order_relaxed);
+    });
+}
+
+double Trainer::explored(size_t decisionIdx) const
+{
+    size_t first = decisionIdx + 1 > options_.exploreDepth ? decisionIdx + 1 - options_.exploreDepth : 0;
+    size_t last = std::min(decisionIdx, options_.maxSkip);
+    return static_cast<double>(last - first + 1) / (options_.maxSkip + 1);
+}
+
+double Trainer::traverse(CompactRound& round, size_t traverser, size_t skip, size_t decisionIdx,
+                         float weight, std::mt19937_64& rng, size_t& numNodes)
+{
+    while (!round.isFinished()) {
+        auto observation = round.observe();
+        auto actions = abstractActions(observation);
+        if (std::has_single_bit(actions.available)) {
+            round.apply(actions.codes[std::countr_zero(actions.available)]);
+            continue;
+        }
+        ++numNodes;
+
+        bool traversing = round.actor() == traverser;
+        bool exploring = traversing && decisionIdx >= skip && decisionIdx < skip + options_.exploreDepth;
+        // Regrets are kept only for explored decisions, strategies for the opponent's
+        auto* entry = table_.find(infoKey(observation), !traversing || exploring);
+        float sigma[NUM_ACTIONS];
+        currentStrategy(entry, actions.available, sigma);
+
+        if (!exploring) {
+            if (!traversing && entry) {
+                for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+                    if (sigma[a] > 0) {
+                        entry->strategy[a].fetch_add(weight * sigma[a], std::memory_order_relaxed);
+                    }
+                }
+            }
+            size_t a = sample(sigma, actions.available, rng);
+            decisionIdx += traversing;
+            round.apply(actions.codes[a]);
+            continue;
+        }
+
+        double values[NUM_ACTIONS] = {};
+        double nodeValue = 0;
+        for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+            if (actions.available >> a & 1) {
+                CompactRound child = round;
+                child.apply(actions.codes[a]);
+                values[a] = traverse(child, traverser, skip, decisionIdx + 1, weight, rng, numNodes);
+                nodeValue += sigma[a] * values[a];
+            }
+        }
+        if (entry) {
+            // Decisions the window covers less often count as much. The traverser's
+            // own reach is not divided out, see Trainer
+            double scale = 1.0 / explored(decisionIdx);
+            for (size_t a = 0; a < NUM_ACTIONS; ++a) {
+                if (actions.available >> a & 1) {
+                    entry->regrets[a].fetch_add((values[a] - nodeValue) * scale, std::memory_order_relaxed);
+                }
+            }
+        }
+        return nodeValue;
+    }
+
+    auto loser = round.loser();
+    if (!loser) {
+        return 0.0;
+    }
+    return *loser == traverser ? -1.0 : 1.0;
+}
+
+} // namespace miplot::cardgame::durak::cfr
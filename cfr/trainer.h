@@ -0,0 +1,126 @@
+#pragma once
+
+#include "cfr/abstraction.h"
+#include "cfr/model.h"
+#include "simulator.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace miplot::cardgame::durak::cfr {
+
+// Spread abstraction keys over table slots
+inline uint64_t hashKey(uint64_t key)
+{
+    key = (key ^ (key >> 31)) * 0x7fb5d329728ea185ULL;
+    key = (key ^ (key >> 27)) * 0x81dadef4bc2dd44dULL;
+    return key ^ (key >> 33);
+}
+
+/**
+ * Cumulative regrets and strategies of information sets in a fixed memory
+ * budget: open addressing over a flat array, slots claimed with a CAS on
+ * the key and values updated with relaxed atomic adds, so that threads
+ * never wait for each other. New information sets are dropped when their
+ * probe window is full.
+ *
+ * Checkpoint layout, host byte order:
+ *   header: "DKCR", uint32 version, uint32 number of actions, uint32 reserved,
+ *           uint64 completed iterations, uint64 number of entries
+ *   entries: uint64 key, float regrets[actions], float strategy sums[actions]
+ */
+class RegretTable {
+public:
+    struct Entry {
+        std::atomic<uint64_t> key{0};
+        std::atomic<float> regrets[NUM_ACTIONS] = {};
+        std::atomic<float> strategy[NUM_ACTIONS] = {};
+    };
+
+    explicit RegretTable(size_t memoryBytes);
+
+    // Entry of the key, inserted if missing and insert is set. nullptr if not found
+    Entry* find(uint64_t key, bool insert);
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t numDropped() const { return numDropped_.load(std::memory_order_relaxed); }
+
+    template <typename F>
+    void forEach(F&& f) const
+    {
+        for (size_t idx = 0; idx < capacity_; ++idx) {
+            if (entries_[idx].key.load(std::memory_order_relaxed) != 0) {
+                f(entries_[idx]);
+            }
+        }
+    }
+
+    // Written to a temporary file renamed over path, so a checkpoint is never torn
+    void save(const std::string& path, uint64_t numIterations) const;
+    // Returns the number of completed iterations
+    uint64_t load(const std::string& path);
+
+private:
+    std::unique_ptr<Entry[]> entries_;
+    size_t capacity_;
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> numDropped_{0};
+};
+
+struct TrainerOptions {
+    size_t numThreads = defaultNumThreads();
+    // Traverser decisions explored with every action along a path
+    size_t exploreDepth = 3;
+    // Traverser decisions played from the current strategy before exploring,
+    // drawn uniformly from [0, maxSkip], so that late decisions get updates too
+    size_t maxSkip = 20;
+    uint64_t seed = 1;
+};
+
+/**
+ * Monte Carlo CFR with external sampling on CompactRound. Every iteration
+ * deals a sampled deck and traverses the tree once for each player:
+ * opponents' actions are sampled and added to the average strategy,
+ * the traverser's actions are all explored and their regrets updated.
+ * Exploring every traverser decision of a whole round is exponential, so
+ * the traverser plays a random number of decisions on policy first, explores
+ * exploreDepth decisions and plays the rest on policy, which still gives
+ * unbiased values of the current strategies. Regret updates are divided by
+ * the probability of the window covering the decision.
+ *
+ * They are not divided by the probability of the traverser's own sampled
+ * actions before the window, as outcome sampling would. That probability is
+ * the traverser's reach of the information set, shared by all its actions,
+ * so it weights whole updates rather than favoring an action; abstracted
+ * information sets do not have perfect recall anyway. Dividing it out makes
+ * updates grow like 1 / reach over up to maxSkip decisions: after 200000
+ * iterations the corrected policy lost 98% instead of 86% to MinCardStrategy
+ */
+class Trainer {
+public:
+    Trainer(RegretTable& table, TrainerOptions options = TrainerOptions());
+
+    // Iteration i is sampled from (seed, i)
+    void run(size_t firstIteration, size_t numIterations);
+
+    size_t numNodes() const { return numNodes_.load(std::memory_order_relaxed); }
+
+private:
+    // The traverser explores its decisions [skip, skip + exploreDepth), decisionIdx
+    // of them are played. Strategies of iteration t are averaged with weight t,
+    // so that the uniform play of early iterations fades out
+    double traverse(CompactRound& round, size_t traverser, size_t skip, size_t decisionIdx,
+                    float weight, std::mt19937_64& rng, size_t& numNodes);
+
+    // Probability that the traverser's decision decisionIdx is explored
+    double explored(size_t decisionIdx) const;
+
+    RegretTable& table_;
+    TrainerOptions options_;
+    std::atomic<size_t> numNodes_{0};
+};
+
+} // namespace miplot::cardgame::durak::cfr
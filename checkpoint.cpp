@@ -0,0 +1,263 @@
+#include "checkpoint.h"
+#include "exception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace miplot {
+
+namespace {
+
+/*
+ * File: magic and uint32 version, then records of a uint32 payload size,
+ * the payload and a uint64 FNV-1a hash of it. Integers are in host byte order
+ */
+constexpr char MAGIC[4] = {'D', 'K', 'C', 'K'};
+constexpr uint32_t VERSION = 2;
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(uint32_t);
+
+uint64_t checksum(const char* data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+class Encoder {
+public:
+    template <typename T>
+    void put(const T& value) { raw(&value, sizeof(value)); }
+
+    void string(const std::string& value)
+    {
+        put(static_cast<uint32_t>(value.size()));
+        raw(value.data(), value.size());
+    }
+
+    template <typename T>
+    void vector(const std::vector<T>& values)
+    {
+        put(static_cast<uint32_t>(values.size()));
+        raw(values.data(), values.size() * sizeof(T));
+    }
+
+    void raw(const void* data, size_t size) { out_.append(static_cast<const char*>(data), size); }
+
+    std::string& data() { return out_; }
+
+private:
+    std::string out_;
+};
+
+// Returns false instead of reading past the end
+class Decoder {
+public:
+    Decoder(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool get(T& value) { return raw(&value, sizeof(value)); }
+
+    bool string(std::string& value)
+    {
+        uint32_t size;
+        if (!get(size) || size > size_ - pos_) {
+            return false;
+        }
+        value.assign(data_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    template <typename T>
+    bool vector(std::vector<T>& values)
+    {
+        uint32_t size;
+        if (!get(size) || size > (size_ - pos_) / sizeof(T)) {
+            return false;
+        }
+        values.resize(size);
+        return raw(values.data(), size * sizeof(T));
+    }
+
+    bool raw(void* data, size_t size)
+    {
+        if (size > size_ - pos_) {
+            return false;
+        }
+        std::memcpy(data, data_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+
+    bool atEnd() const { return pos_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+std::string encode(const Checkpoint& checkpoint)
+{
+    Encoder out;
+    out.string(checkpoint.config);
+    out.put(checkpoint.seed);
+    out.put(checkpoint.begin);
+    out.put(checkpoint.end);
+    out.vector(checkpoint.counters);
+    out.vector(checkpoint.sums);
+    out.string(checkpoint.game);
+    out.put(static_cast<uint32_t>(checkpoint.states.size()));
+    for (const auto& state : checkpoint.states) {
+        out.string(state);
+    }
+    return std::move(out.data());
+}
+
+std::optional<Checkpoint> decode(const char* data, size_t size)
+{
+    Decoder in(data, size);
+    Checkpoint checkpoint;
+    uint32_t numStates;
+    if (!in.string(checkpoint.config) || !in.get(checkpoint.seed)
+            || !in.get(checkpoint.begin) || !in.get(checkpoint.end)
+            || !in.vector(checkpoint.counters) || !in.vector(checkpoint.sums)
+            || !in.string(checkpoint.game) || !in.get(numStates)) {
+        return std::nullopt;
+    }
+    checkpoint.states.resize(numStates);
+    for (auto& state : checkpoint.states) {
+        if (!in.string(state)) {
+            return std::nullopt;
+        }
+    }
+    if (!in.atEnd()) {
+        return std::nullopt;
+    }
+    return checkpoint;
+}
+
+void writeAll(int fd, const std::string& data, const std::string& path)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        REQUIRE(n > 0, "Cannot write " << path << ": " << std::strerror(errno));
+        written += n;
+    }
+}
+
+// Last complete record of a log and the size of the log up to its end.
+// Nothing and 0 if the file does not exist
+std::optional<Checkpoint> scan(const std::string& path, size_t& validSize)
+{
+    std::string contents;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in) {
+            contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+    }
+
+    validSize = 0;
+    if (contents.empty()) {
+        return std::nullopt;
+    }
+    uint32_t version = 0;
+    REQUIRE(contents.size() >= HEADER_SIZE && std::memcmp(contents.data(), MAGIC, sizeof(MAGIC)) == 0,
+            "Not a checkpoint log: " << path);
+    std::memcpy(&version, contents.data() + sizeof(MAGIC), sizeof(version));
+    REQUIRE(version == VERSION, "Unsupported checkpoint log version: " << version);
+
+    std::optional<Checkpoint> last;
+    validSize = HEADER_SIZE;
+    while (contents.size() - validSize >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, contents.data() + validSize, sizeof(size));
+        const char* payload = contents.data() + validSize + sizeof(size);
+        size_t recordSize = sizeof(size) + size_t(size) + sizeof(uint64_t);
+        if (recordSize > contents.size() - validSize) {
+            break;
+        }
+        uint64_t hash;
+        std::memcpy(&hash, payload + size, sizeof(hash));
+        if (hash != checksum(payload, size)) {
+            break;
+        }
+        auto checkpoint = decode(payload, size);
+        if (!checkpoint) {
+            break;
+        }
+        last = std::move(checkpoint);
+        validSize += recordSize;
+    }
+    if (validSize < contents.size()) {
+        WARN() << "Ignoring " << contents.size() - validSize << " bytes of a torn record in " << path;
+    }
+    return last;
+}
+
+} // namespace
+
+CheckpointLog::CheckpointLog(const std::string& path)
+    : path_(path)
+{
+    size_t validSize;
+    last_ = scan(path, validSize);
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+    REQUIRE(fd_ >= 0, "Cannot open " << path << ": " << std::strerror(errno));
+    if (validSize == 0) {
+        std::string header(MAGIC, sizeof(MAGIC));
+        header.append(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+        REQUIRE(::ftruncate(fd_, 0) == 0, "Cannot truncate " << path << ": " << std::strerror(errno));
+        writeAll(fd_, header, path);
+        validSize = HEADER_SIZE;
+    } else {
+        REQUIRE(::ftruncate(fd_, validSize) == 0, "Cannot truncate " << path << ": " << std::strerror(errno));
+    }
+    REQUIRE(::lseek(fd_, validSize, SEEK_SET) >= 0, "Cannot seek " << path << ": " << std::strerror(errno));
+}
+
+std::optional<Checkpoint> CheckpointLog::read(const std::string& path)
+{
+    size_t validSize;
+    auto last = scan(path, validSize);
+    REQUIRE(validSize > 0, "Cannot read checkpoint log " << path);
+    return last;
+}
+
+CheckpointLog::~CheckpointLog()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void CheckpointLog::append(const Checkpoint& checkpoint)
+{
+    std::string payload = encode(checkpoint);
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    uint64_t hash = checksum(payload.data(), payload.size());
+
+    std::string record;
+    record.reserve(sizeof(size) + payload.size() + sizeof(hash));
+    record.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    record.append(payload);
+    record.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    writeAll(fd_, record, path_);
+    REQUIRE(::fdatasync(fd_) == 0, "Cannot sync " << path_ << ": " << std::strerror(errno));
+    last_ = checkpoint;
+}
+
+} // namespace miplot
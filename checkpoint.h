@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace miplot {
+
+/**
+ * Progress of a long run: everything needed to continue it
+ * and to end with the same results as if it never stopped
+ */
+struct Checkpoint {
+    // Settings of the run, a resumed run must have the same
+    std::string config;
+    uint64_t seed = 0;
+    // Rounds, or other units of work, [begin, end) are accounted for
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    std::vector<uint64_t> counters;
+    std::vector<double> sums;
+    // Snapshot of the game between rounds, see Game::snapshot()
+    std::string game;
+    // Learned state of strategies
+    std::vector<std::string> states;
+};
+
+/**
+ * Append-only log of checkpoints. Every record carries its size and checksum
+ * and is synced to disk before append() returns, so a record torn by a crash
+ * is detected and dropped when the log is opened again
+ */
+class CheckpointLog {
+public:
+    // Opens or creates the log
+    explicit CheckpointLog(const std::string& path);
+    ~CheckpointLog();
+
+    CheckpointLog(const CheckpointLog&) = delete;
+    CheckpointLog& operator= (const CheckpointLog&) = delete;
+
+    // Last complete record, nothing for a new log
+    const std::optional<Checkpoint>& last() const { return last_; }
+
+    void append(const Checkpoint& checkpoint);
+
+    // Last complete record of an existing log, without opening it for appending
+    static std::optional<Checkpoint> read(const std::string& path);
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    std::optional<Checkpoint> last_;
+};
+
+} // namespace miplot
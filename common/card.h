@@ -15,6 +15,7 @@ class Deck;
 template <typename CardTraits>
 class Card {
 public:
+    using Traits = CardTraits;
     using Suit = typename CardTraits::SuitType;
     using Rank = typename CardTraits::RankType;
 
@@ -29,6 +30,8 @@ public:
     Suit suit() const { return suit_; }
     Rank rank() const { return rank_; }
 
+    size_t code() const { return CardTraits::code(suit_, rank_); }
+
 private:
     template<typename T> friend class Deck;
 
@@ -44,6 +47,8 @@ std::ostream& operator<< (std::ostream& os, const Card<CardTraits>& card)
               << CardTraits::toString(card.suit());
 }
 
+using Card24 = Card<Std24CardTraits>;
 using Card36 = Card<Std36CardTraits>;
+using Card52 = Card<Std52CardTraits>;
 
 } // namespace miplot::cards
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "card.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace miplot::cards {
+
+/**
+ * Set of cards stored as a bitmask of card codes.
+ * The mask is the narrowest unsigned integer fitting radix() bits
+ */
+template <typename CardTraits>
+class CardSet {
+public:
+    static constexpr size_t RADIX = CardTraits::radix();
+    static_assert(RADIX <= 64, "Card set does not fit into a 64-bit mask");
+
+    using CardType = Card<CardTraits>;
+    using MaskType = std::conditional_t<RADIX <= 32, uint32_t, uint64_t>;
+    static constexpr size_t MASK_BITS = sizeof(MaskType) * 8;
+
+    constexpr CardSet() = default;
+    constexpr explicit CardSet(MaskType mask) : mask_(mask) {}
+
+    template <typename Collection>
+    static CardSet of(const Collection& cards)
+    {
+        CardSet set;
+        for (const auto& card : cards) {
+            set.insert(card.code());
+        }
+        return set;
+    }
+
+    static constexpr CardSet full()
+    {
+        return CardSet(RADIX == MASK_BITS ? ~MaskType(0) : (MaskType(1) << (RADIX % MASK_BITS)) - 1);
+    }
+
+    constexpr MaskType mask() const { return mask_; }
+
+    constexpr bool contains(size_t code) const { return (mask_ >> code) & 1; }
+    bool contains(const CardType& card) const { return contains(card.code()); }
+
+    void insert(size_t code) { mask_ |= MaskType(1) << code; }
+    void insert(const CardType& card) { insert(card.code()); }
+    void erase(size_t code) { mask_ &= ~(MaskType(1) << code); }
+    void erase(const CardType& card) { erase(card.code()); }
+
+    constexpr bool empty() const { return mask_ == 0; }
+    constexpr size_t size() const { return __builtin_popcountll(mask_); }
+
+    // Code of the lowest card in the set, the set must not be empty
+    size_t first() const { return __builtin_ctzll(mask_); }
+
+    // Cards of a single suit as a mask of ranks
+    constexpr MaskType suitMask(typename CardTraits::SuitType suit) const
+    {
+        auto shift = static_cast<size_t>(suit) * CardTraits::numRanks();
+        return (mask_ >> shift) & ((MaskType(1) << CardTraits::numRanks()) - 1);
+    }
+
+    template <typename F>
+    void forEach(F&& f) const
+    {
+        for (MaskType m = mask_; m; m &= m - 1) {
+            f(static_cast<size_t>(__builtin_ctzll(m)));
+        }
+    }
+
+    constexpr CardSet operator| (CardSet other) const { return CardSet(mask_ | other.mask_); }
+    constexpr CardSet operator& (CardSet other) const { return CardSet(mask_ & other.mask_); }
+    constexpr CardSet operator- (CardSet other) const { return CardSet(mask_ & ~other.mask_); }
+    CardSet& operator|= (CardSet other) { mask_ |= other.mask_; return *this; }
+    CardSet& operator&= (CardSet other) { mask_ &= other.mask_; return *this; }
+    CardSet& operator-= (CardSet other) { mask_ &= ~other.mask_; return *this; }
+
+    constexpr bool operator== (CardSet other) const { return mask_ == other.mask_; }
+    constexpr bool operator!= (CardSet other) const { return mask_ != other.mask_; }
+
+private:
+    MaskType mask_ = 0;
+};
+
+using CardSet24 = CardSet<Std24CardTraits>;
+using CardSet36 = CardSet<Std36CardTraits>;
+using CardSet52 = CardSet<Std52CardTraits>;
+
+} // namespace miplot::cards
@@ -2,31 +2,84 @@
 
 namespace miplot::cards {
 
-std::ostream& operator<< (std::ostream& os, Suit4 suit)
+const char* name(Suit4 suit)
 {
     switch (suit) {
-        case Suit4::Clubs: return os << "\u2663";
-        case Suit4::Diamonds: return os << "\u2666";
-        case Suit4::Hearts: return os << "\u2665";
-        case Suit4::Spades: return os << "\u2660";
+        case Suit4::Clubs: return "\u2663";
+        case Suit4::Diamonds: return "\u2666";
+        case Suit4::Hearts: return "\u2665";
+        case Suit4::Spades: return "\u2660";
+    }
+    return "[invalid]";
+}
+
+std::ostream& operator<< (std::ostream& os, Suit4 suit)
+{
+    return os << name(suit);
+}
+
+const char* name(Rank6 rank)
+{
+    switch (rank) {
+        case Rank6::Nine: return "9";
+        case Rank6::Ten: return "10";
+        case Rank6::Jack: return "J";
+        case Rank6::Queen: return "Q";
+        case Rank6::King: return "K";
+        case Rank6::Ace: return "A";
+    }
+    return "[invalid]";
+}
+
+std::ostream& operator<< (std::ostream& os, Rank6 rank)
+{
+    return os << name(rank);
+}
+
+const char* name(Rank9 rank)
+{
+    switch (rank) {
+        case Rank9::Six: return "6";
+        case Rank9::Seven: return "7";
+        case Rank9::Eight: return "8";
+        case Rank9::Nine: return "9";
+        case Rank9::Ten: return "10";
+        case Rank9::Jack: return "J";
+        case Rank9::Queen: return "Q";
+        case Rank9::King: return "K";
+        case Rank9::Ace: return "A";
     }
-    return os << "[invalid]";
+    return "[invalid]";
 }
 
 std::ostream& operator<< (std::ostream& os, Rank9 rank)
+{
+    return os << name(rank);
+}
+
+const char* name(Rank13 rank)
 {
     switch (rank) {
-        case Rank9::Six: return os << "6";
-        case Rank9::Seven: return os << "7";
-        case Rank9::Eight: return os << "8";
-        case Rank9::Nine: return os << "9";
-        case Rank9::Ten: return os << "10";
-        case Rank9::Jack: return os << "J";
-        case Rank9::Queen: return os << "Q";
-        case Rank9::King: return os << "K";
-        case Rank9::Ace: return os << "A";
+        case Rank13::Two: return "2";
+        case Rank13::Three: return "3";
+        case Rank13::Four: return "4";
+        case Rank13::Five: return "5";
+        case Rank13::Six: return "6";
+        case Rank13::Seven: return "7";
+        case Rank13::Eight: return "8";
+        case Rank13::Nine: return "9";
+        case Rank13::Ten: return "10";
+        case Rank13::Jack: return "J";
+        case Rank13::Queen: return "Q";
+        case Rank13::King: return "K";
+        case Rank13::Ace: return "A";
     }
-    return os << "[invalid]";
+    return "[invalid]";
+}
+
+std::ostream& operator<< (std::ostream& os, Rank13 rank)
+{
+    return os << name(rank);
 }
 
 } // namespace miplot::cards
@@ -20,45 +20,60 @@ struct CardTraits {
     static constexpr size_t numRanks();
     static constexpr size_t radix();
 
+    // Dense card index in [0, radix()), suit-major
+    static constexpr size_t code(SuitType s, RankType r);
+    static constexpr SuitType suitOf(size_t code);
+    static constexpr RankType rankOf(size_t code);
+
     static std::string toString(SuitType s);
     static std::string toString(RankType s);
 };
 
 enum class Suit4 { Clubs, Diamonds, Hearts, Spades };
+const char* name(Suit4 suit);
 std::ostream& operator<< (std::ostream& os, Suit4 suit);
 
+enum class Rank6 { Nine, Ten, Jack, Queen, King, Ace };
+const char* name(Rank6 rank);
+std::ostream& operator<< (std::ostream& os, Rank6 rank);
+
 enum class Rank9 { Six, Seven, Eight, Nine, Ten, Jack, Queen, King, Ace };
+const char* name(Rank9 rank);
 std::ostream& operator<< (std::ostream& os, Rank9 rank);
 
-struct Std36CardTraits {
+enum class Rank13 { Two, Three, Four, Five, Six, Seven, Eight, Nine, Ten, Jack, Queen, King, Ace };
+const char* name(Rank13 rank);
+std::ostream& operator<< (std::ostream& os, Rank13 rank);
+
+// Four French suits with ranks from R(0) to maxRank
+template <typename R, R MaxRank>
+struct StdCardTraits {
     using SuitType = Suit4;
-    using RankType = Rank9;
+    using RankType = R;
 
     static constexpr SuitType minSuit() { return SuitType::Clubs; }
     static constexpr SuitType maxSuit() { return SuitType::Spades; }
-    static constexpr RankType minRank() { return RankType::Six; }
-    static constexpr RankType maxRank() { return RankType::Ace; }
+    static constexpr RankType minRank() { return static_cast<RankType>(0); }
+    static constexpr RankType maxRank() { return MaxRank; }
 
     static constexpr size_t numSuits() { return 4; }
-    static constexpr size_t numRanks() { return 9; }
-    static constexpr size_t radix() { return 36; }
+    static constexpr size_t numRanks() { return static_cast<size_t>(MaxRank) + 1; }
+    static constexpr size_t radix() { return numSuits() * numRanks(); }
 
-    friend std::ostream& operator<<(std::ostream& os, Suit4 suit);
-    friend std::ostream& operator<<(std::ostream& os, Rank9 rank);
-
-    static std::string toString(SuitType suit)
+    static constexpr size_t code(SuitType suit, RankType rank)
     {
-        std::ostringstream ss;
-        ss << suit;
-        return ss.str();
+        return static_cast<size_t>(suit) * numRanks() + static_cast<size_t>(rank);
     }
+    static constexpr SuitType suitOf(size_t code) { return static_cast<SuitType>(code / numRanks()); }
+    static constexpr RankType rankOf(size_t code) { return static_cast<RankType>(code % numRanks()); }
 
-    static std::string toString(RankType rank)
-    {
-        std::ostringstream ss;
-        ss << rank;
-        return ss.str();
-    }
+    // Names are short enough not to allocate
+    static std::string toString(SuitType suit) { return name(suit); }
+    static std::string toString(RankType rank) { return name(rank); }
 };
 
+struct Std24CardTraits : StdCardTraits<Rank6, Rank6::Ace> {};
+struct Std36CardTraits : StdCardTraits<Rank9, Rank9::Ace> {};
+struct Std52CardTraits : StdCardTraits<Rank13, Rank13::Ace> {};
+
 } // namespace miplot::cards
@@ -4,60 +4,69 @@
 #include "enum_iterator.h"
 #include "exception.h"
 
-#include <deque>
+#include <array>
+#include <cstdint>
 #include <ostream>
 #include <random>
+#include <span>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 namespace miplot::cards {
 
+/**
+ * Cards of one deck held in place: an array of radix() cards, the deck being
+ * its last size() ones from top to bottom. Taking from or putting on the top
+ * is constant time, putting on the bottom moves the deck up
+ */
 template <typename CardTraits>
 class Deck {
 public:
     using SuitType = typename CardTraits::SuitType;
     using RankType = typename CardTraits::RankType;
     using CardType = Card<CardTraits>;
-    using ContainerType = std::deque<CardType>;
+    using ContainerType = std::span<const CardType>;
     using SuitIterator = EnumIterator<SuitType, CardTraits::minSuit(), CardTraits::maxSuit()>;
     using RankIterator = EnumIterator<RankType, CardTraits::minRank(), CardTraits::maxRank()>;
 
     static constexpr size_t RADIX = CardTraits::radix();
 
+    // Card codes from top to bottom of a full deck
+    using Order = std::array<uint8_t, RADIX>;
+
     // Creates an empty deck
     Deck()
-        : randGenerator_(std::random_device{}())
+        : cards_(placeholders(std::make_index_sequence<RADIX>()))
+        , top_(RADIX)
+        , randGenerator_(std::random_device{}())
     {
     }
 
     Deck(std::vector<CardType>&& cards)
-        : randGenerator_(std::random_device{}())
+        : Deck()
     {
-        std::move(cards.begin(), cards.end(), std::back_inserter(cards_));
+        putOnBottom(std::move(cards));
     }
 
     // Creates standard deck with each card taken once
     static Deck create() {
         Deck deck;
-
-        for (auto suit : SuitIterator()) {
-            for (auto rank : RankIterator()) {
-                deck.cards_.push_back(CardType(suit, rank));
-            }
-        }
+        deck.top_ = 0;
         return deck;
     }
 
-    const ContainerType& cards() const { return cards_; }
+    // Cards from top to bottom
+    ContainerType cards() const { return ContainerType(cards_.begin() + top_, cards_.end()); }
 
-    size_t size() const { return cards_.size(); }
+    size_t size() const { return RADIX - top_; }
 
-    bool isEmpty() const { return cards_.empty(); }
+    bool isEmpty() const { return top_ == RADIX; }
 
     const CardType& top() const
     {
         REQUIRE(!isEmpty(), "Not enough cards");
-        return cards_.front();
+        return cards_[top_];
     }
 
     const CardType& bottom() const
@@ -69,18 +78,17 @@ public:
     CardType getOneFromTop()
     {
         REQUIRE(!isEmpty(), "Not enough cards");
-        CardType result = std::move(cards_.front());
-        cards_.pop_front();
-        return result;
+        return std::move(cards_[top_++]);
     }
+
     std::vector<CardType> getFromTop(size_t count)
     {
         REQUIRE(count <= size(), "Not enough cards");
         std::vector<CardType> result;
         result.reserve(count);
-        auto till = cards_.begin() + count;
-        std::move(cards_.begin(), till, std::back_inserter(result));
-        cards_.erase(cards_.begin(), till);
+        for (size_t i = 0; i < count; ++i) {
+            result.push_back(getOneFromTop());
+        }
         return result;
     }
 
@@ -88,7 +96,8 @@ public:
     {
         REQUIRE(!isEmpty(), "Not enough cards");
         CardType result = std::move(cards_.back());
-        cards_.pop_back();
+        std::move_backward(cards_.begin() + top_, cards_.end() - 1, cards_.end());
+        ++top_;
         return result;
     }
 
@@ -96,45 +105,118 @@ public:
     {
         REQUIRE(count <= size(), "Not enough cards");
         std::vector<CardType> result;
+        result.reserve(count);
         auto from = cards_.end() - count;
         std::move(from, cards_.end(), std::back_inserter(result));
-        cards_.erase(from, cards_.end());
+        std::move_backward(cards_.begin() + top_, from, cards_.end());
+        top_ += count;
         return result;
     }
 
     void putOnTop(CardType card)
     {
-        cards_.push_front(std::move(card));
+        REQUIRE(top_ > 0, "Too many cards");
+        cards_[--top_] = std::move(card);
     }
 
     template<typename Collection>
     void putOnTop(Collection cards)
     {
-        std::move(cards.begin(), cards.end(), std::front_inserter(cards_));
+        for (auto& card : cards) {
+            putOnTop(std::move(card));
+        }
     }
 
     void putOnBottom(CardType card)
     {
-        cards_.push_back(std::move(card));
+        REQUIRE(top_ > 0, "Too many cards");
+        std::move(cards_.begin() + top_, cards_.end(), cards_.begin() + top_ - 1);
+        --top_;
+        cards_.back() = std::move(card);
     }
 
     template<typename Collection>
     void putOnBottom(Collection cards)
     {
-        std::move(cards.begin(), cards.end(), std::back_inserter(cards_));
+        REQUIRE(cards.size() <= top_, "Too many cards");
+        size_t count = cards.size();
+        std::move(cards_.begin() + top_, cards_.end(), cards_.begin() + top_ - count);
+        top_ -= count;
+        std::move(cards.begin(), cards.end(), cards_.end() - count);
     }
 
     void shuffle()
     {
-        std::shuffle(cards_.begin(), cards_.end(), randGenerator_);
+        std::shuffle(cards_.begin() + top_, cards_.end(), randGenerator_);
+    }
+
+    void seed(uint64_t value)
+    {
+        randGenerator_.seed(static_cast<std::mt19937::result_type>(value ^ (value >> 32)));
+    }
+
+    // Generator of shuffles, to save and restore it together with the deck
+    const std::mt19937& generator() const { return randGenerator_; }
+    void setGenerator(const std::mt19937& generator) { randGenerator_ = generator; }
+
+    // Current order of a full deck, to be restored by arrange()
+    Order order() const
+    {
+        REQUIRE(size() == RADIX, "Only a full deck has an order");
+        Order result;
+        for (size_t i = 0; i < RADIX; ++i) {
+            result[i] = static_cast<uint8_t>(cards_[i].code());
+        }
+        return result;
+    }
+
+    // Put cards of a full deck in the order of their codes, so that the next
+    // shuffle depends only on the generator and not on how the deck was left
+    void sort()
+    {
+        REQUIRE(size() == RADIX, "Only a full deck can be sorted");
+        for (size_t i = 0; i < RADIX; ++i) {
+            cards_[i].suit_ = CardTraits::suitOf(i);
+            cards_[i].rank_ = CardTraits::rankOf(i);
+        }
+    }
+
+    // Put cards of a full deck into the given order
+    void arrange(const Order& order)
+    {
+        REQUIRE(size() == RADIX, "Only a full deck can be arranged");
+
+        uint64_t seen = 0;
+        for (auto code : order) {
+            REQUIRE(code < RADIX && !(seen >> code & 1), "Invalid deck order");
+            seen |= uint64_t(1) << code;
+        }
+
+        // The deck holds every card exactly once, so relabeling in place
+        // keeps it a valid deck
+        for (size_t i = 0; i < RADIX; ++i) {
+            cards_[i].suit_ = CardTraits::suitOf(order[i]);
+            cards_[i].rank_ = CardTraits::rankOf(order[i]);
+        }
     }
 
 private:
-    ContainerType cards_;
+    // Every card once, the values of slots above the top do not matter
+    template <size_t... Codes>
+    static std::array<CardType, RADIX> placeholders(std::index_sequence<Codes...>)
+    {
+        return {CardType(CardTraits::suitOf(Codes), CardTraits::rankOf(Codes))...};
+    }
+
+    std::array<CardType, RADIX> cards_;
+    // Index of the top card, RADIX when empty
+    size_t top_;
     std::mt19937 randGenerator_;
 };
 
+using Deck24 = Deck<Std24CardTraits>;
 using Deck36 = Deck<Std36CardTraits>;
+using Deck52 = Deck<Std52CardTraits>;
 
 
 } // namespace miplot::cards
@@ -0,0 +1,88 @@
+#include "deal_corpus.h"
+#include "utils.h"
+
+#include <cstdio>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'D', 'L'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t radix;
+    uint32_t reserved;
+    uint64_t numDeals;
+    uint64_t seed;
+};
+
+static_assert(sizeof(Header) == 32, "Unexpected deal corpus header size");
+
+template <typename CardTraits>
+void writeDeals(uint8_t* data, uint64_t seed, size_t numDeals)
+{
+    // Creating a deck seeds it from std::random_device, reuse one
+    auto deck = cards::Deck<CardTraits>::create();
+    const auto initial = deck.order();
+    for (size_t idx = 0; idx < numDeals; ++idx) {
+        deck.arrange(initial);
+        deck.seed(mixSeed(seed, idx));
+        deck.shuffle();
+        auto order = deck.order();
+        std::memcpy(data + idx * order.size(), order.data(), order.size());
+    }
+}
+
+} // namespace
+
+DealCorpus::DealCorpus(MappedFile file)
+    : file_(std::move(file))
+{
+    REQUIRE(file_.size() >= sizeof(Header), "Deal corpus is too short");
+    Header h;
+    std::memcpy(&h, file_.data(), sizeof(h));
+    REQUIRE(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a deal corpus");
+    REQUIRE(h.version == VERSION, "Unsupported deal corpus version: " << h.version);
+    REQUIRE(h.radix > 0 && h.numDeals > 0, "Deal corpus is empty");
+    REQUIRE(file_.size() >= sizeof(Header) + h.numDeals * h.radix, "Deal corpus is truncated");
+
+    radix_ = h.radix;
+    numDeals_ = h.numDeals;
+    seed_ = h.seed;
+    dataOffset_ = sizeof(Header);
+}
+
+DealCorpus DealCorpus::open(const std::string& path)
+{
+    return DealCorpus(MappedFile::open(path));
+}
+
+void DealCorpus::write(const std::string& path, size_t radix, uint64_t seed, size_t numDeals)
+{
+    REQUIRE(numDeals > 0, "Deal corpus must not be empty");
+    // Do not leave the tail of a longer old file behind
+    std::remove(path.c_str());
+    auto file = MappedFile::openWritable(path, sizeof(Header) + numDeals * radix);
+
+    uint8_t* data = file.mutableData() + sizeof(Header);
+    switch (radix) {
+        case cards::Std24CardTraits::radix(): writeDeals<cards::Std24CardTraits>(data, seed, numDeals); break;
+        case cards::Std36CardTraits::radix(): writeDeals<cards::Std36CardTraits>(data, seed, numDeals); break;
+        case cards::Std52CardTraits::radix(): writeDeals<cards::Std52CardTraits>(data, seed, numDeals); break;
+        default: throw Exception() << "Unsupported deck size: " << radix;
+    }
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.radix = radix;
+    h.numDeals = numDeals;
+    h.seed = seed;
+    std::memcpy(file.mutableData(), &h, sizeof(h));
+    file.sync();
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common/deck.h"
+#include "exception.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Fixed set of shuffled decks shared between experiments, used through mmap.
+ * Deal i is the deck Deck::create() shuffled after seeding it from (seed, i),
+ * the same deal DuplicateMatch plays with that seed.
+ *
+ * File layout, host byte order:
+ *   header: "DKDL", uint32 version, uint32 radix, uint32 reserved,
+ *           uint64 number of deals, uint64 seed
+ *   deals: radix card codes each, from top to bottom of the deck
+ */
+class DealCorpus {
+public:
+    static DealCorpus open(const std::string& path);
+
+    // Supported radixes are the ones of the standard 24, 36 and 52 card decks
+    static void write(const std::string& path, size_t radix, uint64_t seed, size_t numDeals);
+
+    size_t radix() const { return radix_; }
+    size_t numDeals() const { return numDeals_; }
+    uint64_t seed() const { return seed_; }
+
+    const uint8_t* deal(size_t dealIdx) const
+    {
+        return file_.data() + dataOffset_ + dealIdx * radix_;
+    }
+
+    // Deals are reused from the start when idx passes the end
+    template <typename CardTraits>
+    void order(size_t idx, typename cards::Deck<CardTraits>::Order& order) const
+    {
+        static_assert(sizeof(order) == CardTraits::radix());
+        REQUIRE(radix_ == CardTraits::radix(), "Deal corpus is for " << radix_ << " card decks");
+        std::memcpy(order.data(), deal(idx % numDeals_), radix_);
+    }
+
+private:
+    explicit DealCorpus(MappedFile file);
+
+    MappedFile file_;
+    size_t radix_ = 0;
+    size_t numDeals_ = 0;
+    uint64_t seed_ = 0;
+    size_t dataOffset_ = 0;
+};
+
+} // namespace miplot::cardgame::durak
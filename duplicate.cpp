@@ -0,0 +1,186 @@
+#include "duplicate.h"
+#include "exception.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+// n! * n replays per deal grow too fast beyond this
+constexpr size_t MAX_DUPLICATE_PLAYERS = 4;
+
+} // namespace
+
+void DuplicateResult::init(size_t players, size_t replays)
+{
+    numPlayers = players;
+    numReplays = replays;
+    lossSum.assign(numPlayers, 0);
+    lossSumSq.assign(numPlayers, 0);
+    diffSum.assign(numPlayers * numPlayers, 0);
+    diffSumSq.assign(numPlayers * numPlayers, 0);
+    roundDiffSumSq.assign(numPlayers * numPlayers, 0);
+}
+
+void DuplicateResult::merge(const DuplicateResult& other)
+{
+    if (other.numPlayers == 0) {
+        return;
+    }
+    if (numPlayers == 0) {
+        init(other.numPlayers, other.numReplays);
+    }
+    REQUIRE(numPlayers == other.numPlayers && numReplays == other.numReplays,
+            "Cannot merge duplicate results of different matches");
+
+    auto add = [](std::vector<int64_t>& lhs, const std::vector<int64_t>& rhs) {
+        std::transform(lhs.begin(), lhs.end(), rhs.begin(), lhs.begin(), std::plus<int64_t>());
+    };
+    add(lossSum, other.lossSum);
+    add(lossSumSq, other.lossSumSq);
+    add(diffSum, other.diffSum);
+    add(diffSumSq, other.diffSumSq);
+    add(roundDiffSumSq, other.roundDiffSumSq);
+    numDeals += other.numDeals;
+    draws += other.draws;
+}
+
+double DuplicateResult::meanLoss(size_t i) const
+{
+    return numDeals ? lossSum[i] / (2.0 * numReplays * numDeals) : 0.0;
+}
+
+double DuplicateResult::lossStdErr(size_t i) const
+{
+    double unit = 2.0 * numReplays;
+    return standardError(lossSum[i] / unit, lossSumSq[i] / (unit * unit), numDeals);
+}
+
+double DuplicateResult::meanDiff(size_t i, size_t j) const
+{
+    return numDeals ? diffSum[i * numPlayers + j] / (2.0 * numReplays * numDeals) : 0.0;
+}
+
+double DuplicateResult::diffStdErr(size_t i, size_t j) const
+{
+    double unit = 2.0 * numReplays;
+    return standardError(diffSum[i * numPlayers + j] / unit, diffSumSq[i * numPlayers + j] / (unit * unit), numDeals);
+}
+
+double DuplicateResult::unpairedDiffStdErr(size_t i, size_t j) const
+{
+    // Sum of round differences equals the sum over deals, both in halves of a round
+    return standardError(diffSum[i * numPlayers + j] / 2.0, roundDiffSumSq[i * numPlayers + j] / 4.0, numRounds());
+}
+
+template <typename CardTraits>
+BasicDuplicateMatch<CardTraits>::BasicDuplicateMatch(PlayersFactory factory, size_t numThreads,
+                                                     Rules rules)
+    : factory_(std::move(factory))
+    , numThreads_(numThreads)
+    , rules_(rules)
+{
+}
+
+template <typename CardTraits>
+DuplicateResult BasicDuplicateMatch<CardTraits>::run(uint64_t seed, size_t firstDeal, size_t numDeals) const
+{
+    using Deck = cards::Deck<CardTraits>;
+
+    std::vector<DuplicateResult> partial(std::max<size_t>(1, numThreads_));
+
+    parallelFor(numDeals, numThreads_, [&](size_t threadIdx, size_t begin, size_t end) {
+        // One game per seating, seat s is taken by player seating[s]
+        std::vector<std::vector<size_t>> seatings;
+        std::vector<std::unique_ptr<BasicGame<CardTraits>>> games;
+        std::vector<size_t> seating;
+        do {
+            auto players = factory_();
+            if (seating.empty()) {
+                REQUIRE(players.size() <= MAX_DUPLICATE_PLAYERS,
+                        "Duplicate play supports up to " << MAX_DUPLICATE_PLAYERS << " players");
+                seating.resize(players.size());
+                std::iota(seating.begin(), seating.end(), 0);
+            }
+            BasicPlayers<CardTraits> seated;
+            for (size_t playerIdx : seating) {
+                seated.push_back(std::move(players[playerIdx]));
+            }
+            games.push_back(std::make_unique<BasicGame<CardTraits>>(std::move(seated), rules_));
+            seatings.push_back(seating);
+        } while (std::next_permutation(seating.begin(), seating.end()));
+
+        size_t numPlayers = seating.size();
+        auto& result = partial[threadIdx];
+        result.init(numPlayers, games.size() * numPlayers);
+
+        // In halves of a round
+        std::vector<int64_t> losses(numPlayers);
+        std::vector<int64_t> roundLosses(numPlayers);
+        // Creating a deck seeds it from std::random_device, reuse one
+        auto deck = Deck::create();
+        const auto initial = deck.order();
+        typename Deck::Order order;
+        for (size_t deal = firstDeal + begin; deal < firstDeal + end; ++deal) {
+            if (deals_) {
+                deals_->order<CardTraits>(deal, order);
+            } else {
+                deck.arrange(initial);
+                deck.seed(mixSeed(seed, deal));
+                deck.shuffle();
+                order = deck.order();
+            }
+
+            std::fill(losses.begin(), losses.end(), 0);
+            for (size_t idx = 0; idx < games.size(); ++idx) {
+                for (size_t firstAttacker = 0; firstAttacker < numPlayers; ++firstAttacker) {
+                    games[idx]->seed(mixSeed(seed, deal));
+                    auto roundResult = games[idx]->playRound(firstAttacker, order);
+
+                    if (roundResult.losingPlayerIdx) {
+                        std::fill(roundLosses.begin(), roundLosses.end(), 0);
+                        roundLosses[seatings[idx][*roundResult.losingPlayerIdx]] = 2;
+                    } else {
+                        std::fill(roundLosses.begin(), roundLosses.end(), 1);
+                        ++result.draws;
+                    }
+                    for (size_t i = 0; i < numPlayers; ++i) {
+                        losses[i] += roundLosses[i];
+                        for (size_t j = 0; j < numPlayers; ++j) {
+                            int64_t diff = roundLosses[i] - roundLosses[j];
+                            result.roundDiffSumSq[i * numPlayers + j] += diff * diff;
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < numPlayers; ++i) {
+                int64_t loss = losses[i];
+                result.lossSum[i] += loss;
+                result.lossSumSq[i] += loss * loss;
+                for (size_t j = 0; j < numPlayers; ++j) {
+                    int64_t diff = loss - losses[j];
+                    result.diffSum[i * numPlayers + j] += diff;
+                    result.diffSumSq[i * numPlayers + j] += diff * diff;
+                }
+            }
+            ++result.numDeals;
+        }
+    });
+
+    DuplicateResult total;
+    for (const auto& result : partial) {
+        total.merge(result);
+    }
+    return total;
+}
+
+template class BasicDuplicateMatch<cards::Std24CardTraits>;
+template class BasicDuplicateMatch<cards::Std36CardTraits>;
+template class BasicDuplicateMatch<cards::Std52CardTraits>;
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "simulator.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Loss rates of players in duplicate play, paired by deal.
+ * A player's loss on a deal is the share of its replays it lost,
+ * a draw counts as half a loss for everyone.
+ *
+ * Sums are exact integers, losses counted in halves of a round
+ * (loss_i * 2 * numReplays per deal), so that merging results in any
+ * grouping, by threads, checkpoints or shards, gives the same bits
+ */
+struct DuplicateResult {
+    size_t numPlayers = 0;
+    size_t numReplays = 0;
+    size_t numDeals = 0;
+    size_t draws = 0;
+
+    // Sums over deals of loss_i and loss_i^2
+    std::vector<int64_t> lossSum;
+    std::vector<int64_t> lossSumSq;
+    // [i * numPlayers + j]: sums over deals of loss_i - loss_j and its square
+    std::vector<int64_t> diffSum;
+    std::vector<int64_t> diffSumSq;
+    // Same over single rounds, as if every round was dealt independently
+    std::vector<int64_t> roundDiffSumSq;
+
+    void init(size_t numPlayers, size_t numReplays);
+    void merge(const DuplicateResult& other);
+
+    size_t numRounds() const { return numDeals * numReplays; }
+
+    double meanLoss(size_t i) const;
+    double lossStdErr(size_t i) const;
+
+    // Mean of loss_i - loss_j and its standard error over paired deals
+    double meanDiff(size_t i, size_t j) const;
+    double diffStdErr(size_t i, size_t j) const;
+
+    // Standard error of the same difference from as many independently dealt rounds
+    double unpairedDiffStdErr(size_t i, size_t j) const;
+};
+
+/**
+ * Plays every shuffled deck once per permutation of players over seats and
+ * per first attacker, so that each player gets every hand in every position.
+ * Deal luck cancels out in the differences between players.
+ * Deal i is shuffled from (seed, i), the result does not depend on the number of threads
+ */
+template <typename CardTraits>
+class BasicDuplicateMatch {
+public:
+    using PlayersFactory = BasicPlayersFactory<CardTraits>;
+
+    // Players of permutations are created by the factory and reseated
+    explicit BasicDuplicateMatch(PlayersFactory factory, size_t numThreads = defaultNumThreads(),
+                                 Rules rules = Rules());
+
+    // Take deal i from the corpus instead of shuffling
+    void setDeals(std::shared_ptr<const DealCorpus> deals) { deals_ = std::move(deals); }
+
+    DuplicateResult run(uint64_t seed, size_t firstDeal, size_t numDeals) const;
+
+private:
+    PlayersFactory factory_;
+    size_t numThreads_;
+    Rules rules_;
+    std::shared_ptr<const DealCorpus> deals_;
+};
+
+// Standard 36 card game
+using DuplicateMatch = BasicDuplicateMatch<cards::Std36CardTraits>;
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,476 @@
+#include "exploit.h"
+#include "exception.h"
+#include "game.h"
+#include "canonical.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <optional>
+#include <random>
+#include <unordered_map>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr size_t NUM_PLAYERS = 2;
+constexpr size_t RESPONDER = 0;
+constexpr size_t EVALUATED = 1;
+// Deeper endgame lines count as over the node budget
+constexpr size_t MAX_SEARCH_DEPTH = 512;
+
+// Endgame position: hands, table and bout progress. Pairs of defended cards
+// are kept as two sets, which does not change the legal moves
+struct PositionKey {
+    uint64_t hands[NUM_PLAYERS];
+    uint64_t undefended;
+    uint64_t defendedAttacking;
+    uint64_t defendedDefending;
+    uint8_t firstUndefended;
+    uint8_t mainAttackerIdx;
+    bool resigned;
+
+    bool operator== (const PositionKey& other) const = default;
+};
+
+struct PositionHash {
+    size_t operator() (const PositionKey& key) const
+    {
+        uint64_t h = mixSeed(key.hands[0], key.hands[1]);
+        h = mixSeed(h, key.undefended ^ key.defendedAttacking << 1 ^ key.defendedDefending << 2);
+        return mixSeed(h, key.firstUndefended | key.mainAttackerIdx << 8 | key.resigned << 16);
+    }
+};
+
+/**
+ * Game driven one decision at a time, so that rounds can be branched
+ * and replayed from any decision
+ */
+class ResponseGame : public Game {
+public:
+    using Game::Game;
+
+    void start(size_t firstAttackerIdx, const Deck::Order& order)
+    {
+        startRound(firstAttackerIdx, &order);
+        known_[0] = known_[1] = CardSet();
+        resigned_ = false;
+        finished_ = isFinished();
+        if (!finished_) {
+            beginBout();
+            advance();
+        }
+    }
+
+    // Return cards to the deck for the next start()
+    void finish() { finishRound(); }
+
+    void copyFrom(const ResponseGame& other)
+    {
+        assignRound(other);
+        known_[0] = other.known_[0];
+        known_[1] = other.known_[1];
+        resigned_ = other.resigned_;
+        finished_ = other.finished_;
+    }
+
+    bool finished() const { return finished_; }
+
+    // Payoff of the responder in a finished round
+    double payoff() const
+    {
+        bool responderHolds = players()[RESPONDER].numCards() > 0;
+        bool evaluatedHolds = players()[EVALUATED].numCards() > 0;
+        if (responderHolds == evaluatedHolds) {
+            return 0.0;
+        }
+        return responderHolds ? -1.0 : 1.0;
+    }
+
+    bool isEndgame() const { return deck().isEmpty(); }
+
+    size_t actor() const { return needsDefense() ? defenderIdx() : curAttackerIdx(); }
+
+    // Decision of the actor's strategy
+    int ask()
+    {
+        return needsDefense() ? defender().defend(state()) : curAttacker().attack(state());
+    }
+
+    // Hand indices the actor may play, -1 to fold or resign
+    void legalDecisions(std::vector<int>& decisions) const
+    {
+        auto kind = needsDefense() ? DecisionKind::Defend : DecisionKind::Attack;
+        const auto& hand = players()[actor()].hand();
+        uint64_t legal = legalActions(kind, state(), hand);
+
+        decisions.clear();
+        if (legal >> Card::Traits::radix() & 1) {
+            decisions.push_back(-1);
+        }
+        for (size_t idx = 0; idx < hand.size(); ++idx) {
+            if (legal >> hand[idx].code() & 1) {
+                decisions.push_back(idx);
+            }
+        }
+    }
+
+    void apply(int cardIdx)
+    {
+        size_t playerIdx = actor();
+        if (cardIdx != -1) {
+            known_[playerIdx].erase(players()[playerIdx].hand()[cardIdx]);
+        }
+        if (needsDefense()) {
+            resigned_ = resigned_ || cardIdx == -1;
+            applyDefense(cardIdx);
+        } else {
+            applyAttack(cardIdx);
+        }
+        advance();
+    }
+
+    // Redeal the cards the responder cannot see: the evaluated player's cards
+    // that were not picked up from the table and the deck above its open bottom card
+    void determinize(std::mt19937_64& random)
+    {
+        auto& evaluated = player(EVALUATED);
+        Cards kept;
+        Cards hidden;
+        for (auto& card : evaluated.discardHand()) {
+            (known_[EVALUATED].contains(card) ? kept : hidden).push_back(std::move(card));
+        }
+        size_t numHidden = hidden.size();
+        if (deck().size() > 1) {
+            auto cards = deck().getFromTop(deck().size() - 1);
+            hidden.insert(hidden.end(), std::make_move_iterator(cards.begin()), std::make_move_iterator(cards.end()));
+        }
+        std::shuffle(hidden.begin(), hidden.end(), random);
+
+        kept.insert(kept.end(), std::make_move_iterator(hidden.begin()),
+                    std::make_move_iterator(hidden.begin() + numHidden));
+        evaluated.assignHand(std::move(kept));
+        deck().putOnTop(Cards(std::make_move_iterator(hidden.begin() + numHidden),
+                              std::make_move_iterator(hidden.end())));
+    }
+
+    PositionKey key() const
+    {
+        PositionKey key{};
+        for (size_t idx = 0; idx < NUM_PLAYERS; ++idx) {
+            key.hands[idx] = CardSet::of(players()[idx].hand()).mask();
+        }
+        key.undefended = CardSet::of(undefendedCards()).mask();
+        for (const auto& pair : defendedCards()) {
+            key.defendedAttacking |= uint64_t(1) << pair.attacking.code();
+            key.defendedDefending |= uint64_t(1) << pair.defending.code();
+        }
+        key.firstUndefended = undefendedCards().empty() ? 0xff : undefendedCards().front().code();
+        key.mainAttackerIdx = mainAttackerIdx();
+        key.resigned = resigned_;
+        return key;
+    }
+
+private:
+    // Play forced steps and bout ends until a decision or the end of the round,
+    // the defender shows the cards it picks up
+    void advance()
+    {
+        finished_ = advanceToDecision([this] {
+            if (resigned_) {
+                known_[defenderIdx()] |= CardSet::of(undefendedCards());
+                for (const auto& pair : defendedCards()) {
+                    known_[defenderIdx()].insert(pair.attacking);
+                    known_[defenderIdx()].insert(pair.defending);
+                }
+            }
+            resigned_ = false;
+        });
+    }
+
+    // Cards of each player seen by the other one
+    CardSet known_[NUM_PLAYERS];
+    bool resigned_ = false;
+    bool finished_ = false;
+};
+
+Players makePlayers(const StrategyFactory& responder, const StrategyFactory& evaluated)
+{
+    Players players;
+    players.emplace_back("Responder", responder());
+    players.emplace_back("Evaluated", evaluated());
+    return players;
+}
+
+/**
+ * Exact search of deck-empty endgames against the evaluated strategy.
+ * Positions are memoized for a whole round, later decisions reuse them
+ */
+class EndgameSearch {
+public:
+    EndgameSearch(const StrategyFactory& evaluated, const StrategyFactory& base,
+                  const Rules& rules, size_t maxNodes)
+        : evaluated_(evaluated)
+        , base_(base)
+        , rules_(rules)
+        , maxNodes_(maxNodes)
+    {
+    }
+
+    void reset(uint64_t seed)
+    {
+        memo_.clear();
+        numNodes_ = 0;
+        overBudget_ = false;
+        seed_ = seed;
+        for (auto& game : pool_) {
+            game->seed(seed_);
+        }
+    }
+
+    // Best decision of the responder, none if the endgame is over the budget
+    std::optional<int> bestDecision(const ResponseGame& game)
+    {
+        std::vector<int> decisions;
+        game.legalDecisions(decisions);
+
+        std::optional<int> best;
+        double bestValue = -2.0;
+        for (int decision : decisions) {
+            auto& child = at(0);
+            child.copyFrom(game);
+            child.apply(decision);
+            double value = solve(0);
+            if (overBudget_) {
+                return std::nullopt;
+            }
+            if (value > bestValue) {
+                bestValue = value;
+                best = decision;
+            }
+            if (bestValue >= 1.0) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    bool overBudget() const { return overBudget_; }
+    size_t numNodes() const { return numNodes_; }
+
+private:
+    static constexpr int8_t IN_PROGRESS = 2;
+
+    ResponseGame& at(size_t depth)
+    {
+        while (pool_.size() <= depth) {
+            pool_.push_back(std::make_unique<ResponseGame>(makePlayers(base_, evaluated_), rules_));
+            pool_.back()->seed(seed_);
+        }
+        return *pool_[depth];
+    }
+
+    // Payoff of the responder with best play against the evaluated strategy
+    int8_t solve(size_t depth)
+    {
+        auto& game = at(depth);
+        if (game.finished()) {
+            return static_cast<int8_t>(game.payoff());
+        }
+        if (++numNodes_ > maxNodes_ || depth >= MAX_SEARCH_DEPTH) {
+            overBudget_ = true;
+            return 0;
+        }
+
+        auto key = game.key();
+        auto [itr, inserted] = memo_.try_emplace(key, IN_PROGRESS);
+        if (!inserted) {
+            // A position repeated on the current line can be played forever
+            return itr->second == IN_PROGRESS ? 0 : itr->second;
+        }
+
+        int8_t value;
+        if (game.actor() == EVALUATED) {
+            int decision = game.ask();
+            auto& child = at(depth + 1);
+            child.copyFrom(game);
+            child.apply(decision);
+            value = solve(depth + 1);
+        } else {
+            std::vector<int> decisions;
+            game.legalDecisions(decisions);
+            value = -1;
+            for (int decision : decisions) {
+                auto& child = at(depth + 1);
+                child.copyFrom(game);
+                child.apply(decision);
+                value = std::max(value, solve(depth + 1));
+                if (value == 1 || overBudget_) {
+                    break;
+                }
+            }
+        }
+        memo_[key] = value;
+        return value;
+    }
+
+    const StrategyFactory& evaluated_;
+    const StrategyFactory& base_;
+    Rules rules_;
+    size_t maxNodes_;
+    uint64_t seed_ = 0;
+
+    std::vector<std::unique_ptr<ResponseGame>> pool_;
+    std::unordered_map<PositionKey, int8_t, PositionHash> memo_;
+    size_t numNodes_ = 0;
+    bool overBudget_ = false;
+};
+
+} // namespace
+
+void ExploitabilityResult::merge(const ExploitabilityResult& other)
+{
+    numRounds += other.numRounds;
+    payoffSum += other.payoffSum;
+    payoffSumSq += other.payoffSumSq;
+    basePayoffSum += other.basePayoffSum;
+    basePayoffSumSq += other.basePayoffSumSq;
+    gainSum += other.gainSum;
+    gainSumSq += other.gainSumSq;
+    numEndgames += other.numEndgames;
+    numUnsolved += other.numUnsolved;
+    numNodes += other.numNodes;
+}
+
+double ExploitabilityResult::exploitability() const
+{
+    return numRounds ? payoffSum / numRounds : 0.0;
+}
+
+double ExploitabilityResult::stdErr() const
+{
+    return standardError(payoffSum, payoffSumSq, numRounds);
+}
+
+double ExploitabilityResult::baseValue() const
+{
+    return numRounds ? basePayoffSum / numRounds : 0.0;
+}
+
+double ExploitabilityResult::baseStdErr() const
+{
+    return standardError(basePayoffSum, basePayoffSumSq, numRounds);
+}
+
+double ExploitabilityResult::gain() const
+{
+    return numRounds ? gainSum / numRounds : 0.0;
+}
+
+double ExploitabilityResult::gainStdErr() const
+{
+    return standardError(gainSum, gainSumSq, numRounds);
+}
+
+ExploitabilityEvaluator::ExploitabilityEvaluator(StrategyFactory evaluated, StrategyFactory base,
+                                                 ExploitabilityOptions options, Rules rules)
+    : evaluated_(std::move(evaluated))
+    , base_(std::move(base))
+    , options_(options)
+    , rules_(rules)
+{
+    REQUIRE(!rules_.transfer && !rules_.batchedAttacks && rules_.numTeams == 0,
+            "Best responses are computed for the classic two player game only");
+}
+
+ExploitabilityResult ExploitabilityEvaluator::run(uint64_t seed, size_t firstRound, size_t numRounds) const
+{
+    std::vector<ExploitabilityResult> partial(std::max<size_t>(1, options_.numThreads));
+
+    parallelFor(numRounds, options_.numThreads, [&](size_t threadIdx, size_t begin, size_t end) {
+        auto& result = partial[threadIdx];
+        Game baseGame(makePlayers(base_, evaluated_), rules_);
+        ResponseGame game(makePlayers(base_, evaluated_), rules_);
+        ResponseGame playout(makePlayers(base_, evaluated_), rules_);
+        EndgameSearch search(evaluated_, base_, rules_, options_.maxEndgameNodes);
+
+        // Creating a deck seeds it from std::random_device, reuse one
+        auto deck = Deck::create();
+        const auto initial = deck.order();
+        std::vector<int> decisions;
+
+        for (size_t round = firstRound + begin; round < firstRound + end; ++round) {
+            uint64_t roundSeed = mixSeed(seed, round);
+            deck.arrange(initial);
+            deck.seed(roundSeed);
+            deck.shuffle();
+            auto order = deck.order();
+            size_t firstAttackerIdx = round % NUM_PLAYERS;
+
+            baseGame.seed(roundSeed);
+            auto baseResult = baseGame.playRound(firstAttackerIdx, order);
+            double basePayoff = !baseResult.losingPlayerIdx ? 0.0
+                              : *baseResult.losingPlayerIdx == RESPONDER ? -1.0 : 1.0;
+
+            game.seed(roundSeed);
+            playout.seed(roundSeed);
+            search.reset(roundSeed);
+            std::mt19937_64 random(roundSeed);
+            bool searched = false;
+
+            game.start(firstAttackerIdx, order);
+            while (!game.finished()) {
+                int decision = game.ask();
+                if (game.actor() == RESPONDER && game.isEndgame() && !search.overBudget()) {
+                    searched = true;
+                    if (auto best = search.bestDecision(game)) {
+                        decision = *best;
+                    }
+                } else if (game.actor() == RESPONDER && options_.numRollouts > 0) {
+                    game.legalDecisions(decisions);
+                    int baseDecision = decision;
+                    double bestValue = -2.0;
+                    for (int candidate : decisions) {
+                        double value = 0;
+                        for (size_t idx = 0; idx < options_.numRollouts; ++idx) {
+                            playout.copyFrom(game);
+                            playout.determinize(random);
+                            playout.apply(candidate);
+                            while (!playout.finished()) {
+                                playout.apply(playout.ask());
+                            }
+                            value += playout.payoff();
+                        }
+                        // The base strategy's own decision wins ties
+                        if (value > bestValue || (value == bestValue && candidate == baseDecision)) {
+                            bestValue = value;
+                            decision = candidate;
+                        }
+                    }
+                }
+                game.apply(decision);
+            }
+            double payoff = game.payoff();
+            game.finish();
+
+            ++result.numRounds;
+            result.payoffSum += payoff;
+            result.payoffSumSq += payoff * payoff;
+            result.basePayoffSum += basePayoff;
+            result.basePayoffSumSq += basePayoff * basePayoff;
+            result.gainSum += payoff - basePayoff;
+            result.gainSumSq += (payoff - basePayoff) * (payoff - basePayoff);
+            result.numEndgames += searched;
+            result.numUnsolved += search.overBudget();
+            result.numNodes += search.numNodes();
+        }
+    });
+
+    ExploitabilityResult total;
+    for (const auto& result : partial) {
+        total.merge(result);
+    }
+    return total;
+}
+
+} // namespace miplot::cardgame::durak
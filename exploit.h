@@ -0,0 +1,85 @@
+#pragma once
+
+#include "simulator.h"
+#include "strategy.h"
+
+#include <functional>
+#include <memory>
+
+namespace miplot::cardgame::durak {
+
+using StrategyFactory = std::function<std::unique_ptr<Strategy>()>;
+
+struct ExploitabilityOptions {
+    size_t numThreads = defaultNumThreads();
+    // Determinized playouts per decision while the deck is not empty,
+    // 0 to play the base strategy there
+    size_t numRollouts = 0;
+    // Endgame positions searched per round, larger endgames are played
+    // by the base strategy
+    size_t maxEndgameNodes = 200000;
+};
+
+/**
+ * Payoffs of the responder against the evaluated strategy: +1 for a win,
+ * -1 for a loss, 0 for a draw. The game is symmetric over first attackers,
+ * so its value is 0 and the mean payoff of any responder is a lower bound
+ * on exploitability of the evaluated strategy
+ */
+struct ExploitabilityResult {
+    size_t numRounds = 0;
+    double payoffSum = 0;
+    double payoffSumSq = 0;
+    // The base strategy alone on the same deals, and the paired gain of the search
+    double basePayoffSum = 0;
+    double basePayoffSumSq = 0;
+    double gainSum = 0;
+    double gainSumSq = 0;
+
+    // Rounds reaching an endgame with the responder to move, and those over the node budget
+    size_t numEndgames = 0;
+    size_t numUnsolved = 0;
+    size_t numNodes = 0;
+
+    void merge(const ExploitabilityResult& other);
+
+    double exploitability() const;
+    double stdErr() const;
+
+    double baseValue() const;
+    double baseStdErr() const;
+
+    double gain() const;
+    double gainStdErr() const;
+};
+
+/**
+ * Estimates a best response to a strategy in two player games with classic
+ * rules, driving Game one decision at a time. The responder plays the base
+ * strategy while the deck is not empty, optionally improved by Monte Carlo
+ * search: every legal decision is scored by playouts of the base and the
+ * evaluated strategy over redeals of the cards the responder cannot see.
+ * Once the deck is empty both hands are known, and the responder searches
+ * the endgame exactly against the evaluated strategy's answers, with
+ * positions memoized per round and repeated positions scored as draws.
+ *
+ * The evaluated strategy must decide from the game state alone, as it is
+ * asked in branched positions. Stochastic strategies are sampled once per
+ * searched position. Round i is dealt and seeded from (seed, i)
+ */
+class ExploitabilityEvaluator {
+public:
+    ExploitabilityEvaluator(StrategyFactory evaluated, StrategyFactory base,
+                            ExploitabilityOptions options = ExploitabilityOptions(),
+                            Rules rules = Rules());
+
+    ExploitabilityResult run(uint64_t seed, size_t firstRound, size_t numRounds) const;
+
+private:
+    StrategyFactory evaluated_;
+    StrategyFactory base_;
+    ExploitabilityOptions options_;
+    Rules rules_;
+};
+
+} // namespace miplot::cardgame::durak
@@ -1,13 +1,18 @@
 #include "game.h"
 #include "exception.h"
-#include "logging/logging.h"
+#include "logging/deferred.h"
 #include "serialize.h"
+#include "strategy/helper.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <set>
+#include <type_traits>
 
 namespace miplot::cardgame::durak {
 
@@ -15,11 +20,78 @@ namespace {
 
 constexpr size_t NUM_INITIAL_CARDS = 6;
 constexpr size_t MIN_PLAYERS = 2;
-constexpr size_t MAX_PLAYERS = 5;
+
+/*
+ * Game snapshot: magic, version, deck radix and number of players,
+ * then uint8 trump, main attacker, current attacker, defender, resign flag,
+ * number of folds and of attackers, uint32 number of bouts, uint32 bout
+ * after which each player ran out of cards (0 if not yet), card lists
+ * (uint8 size and codes) of hands, undefended cards, defended pairs,
+ * discard and deck from top, and the raw random generator of the deck.
+ * Integers are in host byte order
+ */
+constexpr char SNAPSHOT_MAGIC[4] = {'D', 'K', 'G', 'S'};
+constexpr uint8_t SNAPSHOT_VERSION = 2;
+
+static_assert(std::is_trivially_copyable_v<std::mt19937>, "Random generator is saved as raw bytes");
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::string& out) : out_(out) {}
+
+    void u8(size_t value) { out_.push_back(static_cast<char>(value)); }
+    void raw(const void* data, size_t size) { out_.append(static_cast<const char*>(data), size); }
+
+    // Writes count codes with their number, advancing codes
+    void codes(const uint8_t*& codes, size_t count)
+    {
+        u8(count);
+        raw(codes, count);
+        codes += count;
+    }
+
+private:
+    std::string& out_;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data) : data_(data) {}
+
+    uint8_t u8()
+    {
+        REQUIRE(pos_ < data_.size(), "Game snapshot is truncated");
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+
+    void raw(void* data, size_t size)
+    {
+        REQUIRE(size <= data_.size() - pos_, "Game snapshot is truncated");
+        std::memcpy(data, data_.data() + pos_, size);
+        pos_ += size;
+    }
+
+    // Reads count codes into codes at pos, advancing pos
+    template <size_t N>
+    void codes(std::array<uint8_t, N>& codes, size_t& pos, size_t count)
+    {
+        REQUIRE(count <= N - pos, "Game snapshot has more than " << N << " cards");
+        for (size_t i = 0; i < count; ++i) {
+            codes[pos++] = u8();
+        }
+    }
+
+    bool atEnd() const { return pos_ == data_.size(); }
+
+private:
+    std::string_view data_;
+    size_t pos_ = 0;
+};
 
 } // namespace
 
-GameState::GameState(const Game& game)
+template <typename CardTraits>
+BasicGameState<CardTraits>::BasicGameState(const Game& game)
     : game_(game)
 {
     opponents_.reserve(game.players().size());
@@ -28,7 +100,8 @@ GameState::GameState(const Game& game)
     }
 }
 
-const Opponents& GameState::opponents() const
+template <typename CardTraits>
+const Opponents& BasicGameState<CardTraits>::opponents() const
 {
     const auto& players = game_.players();
     for (size_t idx = 0; idx < players.size(); ++idx) {
@@ -38,138 +111,578 @@ const Opponents& GameState::opponents() const
     return opponents_;
 }
 
-Suit GameState::trumpSuit() const
+template <typename CardTraits>
+const Rules& BasicGameState<CardTraits>::rules() const
+{
+    return game_.rules();
+}
+
+template <typename CardTraits>
+auto BasicGameState<CardTraits>::trumpSuit() const -> Suit
 {
     return game_.trumpSuit();
 }
 
-size_t GameState::mainAttackerIdx() const
+template <typename CardTraits>
+size_t BasicGameState<CardTraits>::mainAttackerIdx() const
 {
     return game_.mainAttackerIdx();
 }
 
-size_t GameState::defenderIdx() const
+template <typename CardTraits>
+size_t BasicGameState<CardTraits>::defenderIdx() const
 {
     return game_.defenderIdx();
 }
 
-size_t GameState::curAttackerIdx() const
+template <typename CardTraits>
+size_t BasicGameState<CardTraits>::curAttackerIdx() const
 {
     return game_.curAttackerIdx();
 }
 
-const Cards& GameState::undefendedCards() const
+template <typename CardTraits>
+auto BasicGameState<CardTraits>::undefendedCards() const -> const Cards&
 {
     return game_.undefendedCards();
 }
 
-const CardPairs& GameState::defendedCards() const
+template <typename CardTraits>
+auto BasicGameState<CardTraits>::defendedCards() const -> const CardPairs&
 {
     return game_.defendedCards();
 }
 
-const Cards& GameState::discard() const
+template <typename CardTraits>
+auto BasicGameState<CardTraits>::discard() const -> const Cards&
 {
     return game_.discard();
 }
 
 
-Game::Game(std::vector<Player>&& players)
+template <typename CardTraits>
+BasicGame<CardTraits>::BasicGame(Players&& players, Rules rules)
     : players_(std::move(players))
+    , rules_(rules)
     , deck_(Deck::create())
 {
-    REQUIRE(players_.size() >= MIN_PLAYERS && players_.size() <= MAX_PLAYERS,
+    REQUIRE(players_.size() >= MIN_PLAYERS && players_.size() <= Position::MAX_PLAYERS
+            && players_.size() * NUM_INITIAL_CARDS <= Deck::RADIX,
             "Invalid number of players: " << players_.size());
+    REQUIRE(rules_.numTeams == 0
+            || (rules_.numTeams >= 2 && players_.size() % rules_.numTeams == 0
+                && players_.size() / rules_.numTeams >= 2),
+            "Cannot split " << players_.size() << " players into " << rules_.numTeams << " teams");
+
+    // Also a game before its first round has a valid snapshot
+    outAfterBout_.assign(players_.size(), 0);
+
+    // Rounds do not allocate: any container may have to hold the whole deck
+    for (auto& player : players_) {
+        player.reserveHand(Deck::RADIX);
+    }
+    undefended_.reserve(NUM_INITIAL_CARDS);
+    defended_.reserve(NUM_INITIAL_CARDS);
+    discard_.reserve(Deck::RADIX);
+    drawn_.reserve(NUM_INITIAL_CARDS);
+
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        if (auto* observer = players_[idx].strategy().observer()) {
+            observers_.push_back({idx, observer});
+        }
+    }
 }
 
-RoundResult Game::playRound(size_t firstAttackerIdx)
+template <typename CardTraits>
+RoundResult BasicGame<CardTraits>::playRound(size_t firstAttackerIdx)
 {
-    deal(firstAttackerIdx);
-    printDeck();
-    INFO() << "Playing a round, trump suit: " << trumpSuit_;
+    return playRound(firstAttackerIdx, nullptr);
+}
+
+template <typename CardTraits>
+RoundResult BasicGame<CardTraits>::playRound(size_t firstAttackerIdx, const typename Deck::Order& order)
+{
+    return playRound(firstAttackerIdx, &order);
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::seed(uint64_t value)
+{
+    deck_.seed(value);
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        players_[idx].seed(value + idx + 1);
+    }
+}
+
+template <typename CardTraits>
+size_t BasicGame<CardTraits>::footprint() const
+{
+    size_t result = players_.capacity() * sizeof(Player);
+    for (const auto& player : players_) {
+        result += player.hand().capacity() * sizeof(Card);
+    }
+    result += undefended_.capacity() * sizeof(Card) + defended_.capacity() * sizeof(CardPair)
+            + discard_.capacity() * sizeof(Card) + drawn_.capacity() * sizeof(Card);
+
+    result += outAfterBout_.capacity() * sizeof(uint32_t) + observers_.capacity() * sizeof(Subscriber);
+    if (state_) {
+        result += sizeof(GameState) + players_.size() * sizeof(Opponent);
+    }
+    return result;
+}
 
-    BoutResult boutResult;
+template <typename CardTraits>
+RoundResult BasicGame<CardTraits>::playRound(size_t firstAttackerIdx, const typename Deck::Order* order)
+{
+    startRound(firstAttackerIdx, order);
 
     while (!isFinished()) {
-        boutResult = playBout();
-        refill();
+        finishBout(playBout());
+    }
+
+    return finishRound();
+}
 
-        if (!isFinished()) {
-            shiftTurn(boutResult);
+template <typename CardTraits>
+void BasicGame<CardTraits>::startRound(size_t firstAttackerIdx, const typename Deck::Order* order)
+{
+    deal(firstAttackerIdx, order);
+    printDeck();
+    INFOF("Playing a round, trump suit: {}", cards::name(trumpSuit_));
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::finishBout(BoutResult boutResult)
+{
+    refill();
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        if (players_[idx].numCards() == 0 && !outAfterBout_[idx]) {
+            outAfterBout_[idx] = numBouts_;
         }
+    }
 
+    if (!isFinished()) {
+        shiftTurn(boutResult);
     }
+}
 
+template <typename CardTraits>
+RoundResult BasicGame<CardTraits>::finishRound()
+{
     RoundResult result = getRoundResult();
 
     cleanup();
     return result;
 }
 
-void Game::deal(size_t firstAttackerIdx)
+template <typename CardTraits>
+void BasicGame<CardTraits>::assignRound(const BasicGame& other)
+{
+    REQUIRE(players_.size() == other.players_.size(), "Cannot copy a round of a different game");
+    // Cards are not copyable, so that players cannot duplicate them:
+    // own cards take the places of the other game's
+    setPosition(other.position());
+}
+
+template <typename CardTraits>
+auto BasicGame<CardTraits>::position() const -> Position
+{
+    Position result;
+    result.numPlayers = players_.size();
+    result.trump = trumpSuit_;
+    result.mainAttackerIdx = mainAttackerIdx_;
+    result.curAttackerIdx = curAttackerIdx_;
+    result.defenderIdx = defenderIdx_;
+    result.resign = resign_;
+    result.numFolds = numFolds_;
+    result.numAttackers = numAttackers_;
+    result.numBouts = numBouts_;
+    std::copy(outAfterBout_.begin(), outAfterBout_.end(), result.outAfterBout.begin());
+
+    size_t pos = 0;
+    auto add = [&](const Card& card) { result.codes[pos++] = static_cast<uint8_t>(card.code()); };
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        const auto& hand = players_[idx].hand();
+        result.handSizes[idx] = hand.size();
+        std::for_each(hand.begin(), hand.end(), add);
+    }
+    result.numUndefended = undefended_.size();
+    std::for_each(undefended_.begin(), undefended_.end(), add);
+    result.numDefended = defended_.size();
+    for (const auto& pair : defended_) {
+        add(pair.attacking);
+        add(pair.defending);
+    }
+    result.numDiscarded = discard_.size();
+    std::for_each(discard_.begin(), discard_.end(), add);
+    std::for_each(deck_.cards().begin(), deck_.cards().end(), add);
+    return result;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::setPosition(const Position& position)
 {
-    deck_.shuffle();
+    size_t numPlayers = position.numPlayers;
+    REQUIRE(numPlayers == players_.size(), "Position of " << numPlayers << " players");
+    REQUIRE(static_cast<size_t>(position.trump) < CardTraits::numSuits() && position.mainAttackerIdx < numPlayers
+            && position.curAttackerIdx < numPlayers && position.defenderIdx < numPlayers,
+            "Invalid position");
+    size_t numPlaced = position.numUndefended + 2 * position.numDefended + position.numDiscarded;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        numPlaced += position.handSizes[idx];
+    }
+    REQUIRE(numPlaced <= Deck::RADIX, "Position places " << numPlaced << " of " << Deck::RADIX << " cards");
+
+    arrangeCards(position);
+    trumpSuit_ = position.trump;
+    mainAttackerIdx_ = position.mainAttackerIdx;
+    curAttackerIdx_ = position.curAttackerIdx;
+    defenderIdx_ = position.defenderIdx;
+    resign_ = position.resign;
+    numFolds_ = position.numFolds;
+    numAttackers_ = position.numAttackers;
+    numBouts_ = position.numBouts;
+    outAfterBout_.assign(position.outAfterBout.begin(), position.outAfterBout.begin() + numPlayers);
+    if (!state_) {
+        state_ = std::make_unique<GameState>(*this);
+    }
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::arrangeCards(const Position& position)
+{
+    // Cards go one by one, so that hands and the table keep their storage
+    // when a search branches rounds over and over. Their order in the deck
+    // does not matter, arrange() relabels them
     for (auto& player : players_) {
-        player.assignHand(deck_.getFromTop(NUM_INITIAL_CARDS));
+        while (player.numCards()) {
+            deck_.putOnTop(player.playCard(player.numCards() - 1));
+        }
+    }
+    auto gather = [this](Cards& cards) {
+        for (auto& card : cards) {
+            deck_.putOnTop(std::move(card));
+        }
+        cards.clear();
+    };
+    gather(undefended_);
+    for (auto& pair : defended_) {
+        deck_.putOnTop(std::move(pair.attacking));
+        deck_.putOnTop(std::move(pair.defending));
+    }
+    defended_.clear();
+    gather(discard_);
+    // Validates the order before relabeling
+    deck_.arrange(position.codes);
+
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        for (size_t i = 0; i < position.handSizes[idx]; ++i) {
+            players_[idx].addToHand(deck_.getOneFromTop());
+        }
+    }
+    for (size_t i = 0; i < position.numUndefended; ++i) {
+        undefended_.push_back(deck_.getOneFromTop());
+    }
+    for (size_t i = 0; i < position.numDefended; ++i) {
+        auto attacking = deck_.getOneFromTop();
+        defended_.push_back({std::move(attacking), deck_.getOneFromTop()});
+    }
+    for (size_t i = 0; i < position.numDiscarded; ++i) {
+        discard_.push_back(deck_.getOneFromTop());
+    }
+}
+
+template <typename CardTraits>
+std::string BasicGame<CardTraits>::snapshot() const
+{
+    auto position = this->position();
+    std::string result;
+    SnapshotWriter out(result);
+    out.raw(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out.u8(SNAPSHOT_VERSION);
+    out.u8(Deck::RADIX);
+    out.u8(position.numPlayers);
+
+    out.u8(static_cast<size_t>(position.trump));
+    out.u8(position.mainAttackerIdx);
+    out.u8(position.curAttackerIdx);
+    out.u8(position.defenderIdx);
+    out.u8(position.resign);
+    out.u8(position.numFolds);
+    out.u8(position.numAttackers);
+    out.raw(&position.numBouts, sizeof(position.numBouts));
+    out.raw(position.outAfterBout.data(), position.numPlayers * sizeof(uint32_t));
+
+    const uint8_t* codes = position.codes.data();
+    for (size_t idx = 0; idx < position.numPlayers; ++idx) {
+        out.codes(codes, position.handSizes[idx]);
+    }
+    out.codes(codes, position.numUndefended);
+    out.u8(position.numDefended);
+    out.raw(codes, 2 * position.numDefended);
+    codes += 2 * position.numDefended;
+    out.codes(codes, position.numDiscarded);
+    out.codes(codes, position.deckSize());
+    out.raw(&deck_.generator(), sizeof(std::mt19937));
+    return result;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::restore(std::string_view snapshot)
+{
+    SnapshotReader in(snapshot);
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    in.raw(magic, sizeof(magic));
+    REQUIRE(std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC), "Not a game snapshot");
+    uint8_t version = in.u8();
+    REQUIRE(version == SNAPSHOT_VERSION, "Unsupported game snapshot version: " << (int)version);
+    uint8_t radix = in.u8();
+    REQUIRE(radix == Deck::RADIX, "Game snapshot of a " << (int)radix << " card deck");
+    uint8_t numPlayers = in.u8();
+    REQUIRE(numPlayers == players_.size(), "Game snapshot of " << (int)numPlayers << " players");
+
+    Position position;
+    position.numPlayers = numPlayers;
+    position.trump = static_cast<Suit>(in.u8());
+    position.mainAttackerIdx = in.u8();
+    position.curAttackerIdx = in.u8();
+    position.defenderIdx = in.u8();
+    position.resign = in.u8();
+    position.numFolds = in.u8();
+    position.numAttackers = in.u8();
+    in.raw(&position.numBouts, sizeof(position.numBouts));
+    in.raw(position.outAfterBout.data(), numPlayers * sizeof(uint32_t));
+
+    size_t numCards = 0;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        position.handSizes[idx] = in.u8();
+        in.codes(position.codes, numCards, position.handSizes[idx]);
+    }
+    position.numUndefended = in.u8();
+    in.codes(position.codes, numCards, position.numUndefended);
+    position.numDefended = in.u8();
+    in.codes(position.codes, numCards, 2 * position.numDefended);
+    position.numDiscarded = in.u8();
+    in.codes(position.codes, numCards, position.numDiscarded);
+    in.codes(position.codes, numCards, in.u8());
+    std::mt19937 generator;
+    in.raw(&generator, sizeof(generator));
+    REQUIRE(in.atEnd(), "Game snapshot has trailing data");
+    REQUIRE(numCards == Deck::RADIX, "Game snapshot has " << numCards << " cards");
+
+    setPosition(position);
+    deck_.setGenerator(generator);
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::deal(size_t firstAttackerIdx, const typename Deck::Order* order)
+{
+    if (order) {
+        deck_.arrange(*order);
+    } else {
+        // A round depends only on the seed, not on the rounds played before
+        deck_.sort();
+        deck_.shuffle();
+    }
+    for (auto& player : players_) {
+        for (size_t i = 0; i < NUM_INITIAL_CARDS; ++i) {
+            player.addToHand(deck_.getOneFromTop());
+        }
+    }
+    if (deck_.isEmpty()) {
+        // Everything is dealt, the last dealt card shows the trump suit
+        trumpSuit_ = players_.back().hand().back().suit();
+    } else {
+        trumpSuit_ = deck_.top().suit();
+        deck_.putOnBottom(deck_.getOneFromTop());
     }
-    trumpSuit_ = deck_.top().suit();
-    deck_.putOnBottom(deck_.getOneFromTop());
 
     mainAttackerIdx_ = firstAttackerIdx;
     curAttackerIdx_ = firstAttackerIdx;
+    numBouts_ = 0;
+    outAfterBout_.assign(players_.size(), 0);
     defenderIdx_ = nextPlayerIdx(mainAttackerIdx_);
 
-    state_ = std::make_unique<GameState>(*this);
+    if (!state_) {
+        state_ = std::make_unique<GameState>(*this);
+    }
+
+    const Card& trumpCard = deck_.isEmpty() ? players_.back().hand().back() : deck_.bottom();
+    for (const auto& s : observers_) {
+        s.observer->onDeal(s.playerIdx, players_.size(), players_[s.playerIdx].hand(), trumpCard, deck_.size());
+    }
 }
 
-BoutResult Game::playBout()
+template <typename CardTraits>
+BoutResult BasicGame<CardTraits>::playBout()
 {
-    bool resign = false;
-    size_t numFolds = 0;
-
-    DEBUG() << "Start bout, player " << curAttackerIdx_ << " to attack";
-    printHands();
+    beginBout();
 
-    while (numFolds < numPlayers() - 1
-            && undefended_.size() < defender().numCards()
-            && undefended_.size() + defended_.size() < NUM_INITIAL_CARDS)
-    {
+    while (boutContinues()) {
         // attack
-        int attackIdx = -1;
-        if (curAttacker().numCards() > 0) {
-            attackIdx = curAttacker().attack(*state_);
-            validateAttack(attackIdx);
+        bool attacked;
+        if (rules_.batchedAttacks) {
+            AttackBatch batch;
+            if (curAttacker().numCards() > 0) {
+                batch = curAttacker().attackBatch(*state_);
+            }
+            attacked = applyAttackBatch(batch);
+        } else {
+            int attackIdx = -1;
+            if (curAttacker().numCards() > 0) {
+                attackIdx = curAttacker().attack(*state_);
+            }
+            attacked = applyAttack(attackIdx);
         }
-        if (attackIdx == -1) {
-            DEBUG() << "Player " << curAttackerIdx_ << " folds";
-            ++numFolds;
-            curAttackerIdx_= nextAttackerIdx(curAttackerIdx_);
+        if (!attacked) {
             continue;
-        } else {
-            DEBUG() << "Player " << curAttackerIdx_ << " attack: " << curAttacker().hand()[attackIdx];
-            undefended_.push_back(curAttacker().playCard(attackIdx));
-            numFolds = 0;
         }
 
         // defend
-        if (!resign) {
-            int defenseIdx = defender().defend(*state_);
-
-            if (defenseIdx == -1) {
-                DEBUG() << "Player " << defenderIdx_ << " resigns";
-                resign = true;
-            } else {
-                validateDefense(defenseIdx);
-                DEBUG() << "Player " << defenderIdx_ << " defense: " << defender().hand()[defenseIdx];
-                defended_.push_back({std::move(undefended_[0]), defender().playCard(defenseIdx)});
-                undefended_.clear();
+        while (needsDefense()) {
+            if (canTransfer() && applyTransfer(defender().transfer(*state_))) {
+                continue;
             }
+            applyDefense(defender().defend(*state_));
         }
 
         printTable();
     }
 
-    if (resign) {
+    return endBout();
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::beginBout()
+{
+    resign_ = false;
+    numFolds_ = 0;
+    numAttackers_ = countAttackers();
+
+    DEBUGF("Start bout, player {} to attack", curAttackerIdx_);
+    printHands();
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::boutContinues() const
+{
+    return numFolds_ < numAttackers_
+        && undefended_.size() < defender().numCards()
+        && undefended_.size() + defended_.size() < NUM_INITIAL_CARDS;
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::applyAttack(int cardIdx)
+{
+    if (curAttacker().numCards() > 0) {
+        validateAttack(cardIdx);
+    }
+    if (cardIdx == -1) {
+        fold();
+        return false;
+    }
+
+    DEBUGF("Player {} attack: {}", curAttackerIdx_, curAttacker().hand()[cardIdx]);
+    undefended_.push_back(curAttacker().playCard(cardIdx));
+    for (const auto& s : observers_) {
+        s.observer->onAttack(curAttackerIdx_, undefended_.back());
+    }
+    numFolds_ = 0;
+    return true;
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::applyAttackBatch(const AttackBatch& batch)
+{
+    if (curAttacker().numCards() > 0) {
+        validateAttackBatch(batch);
+    }
+    if (batch.empty()) {
+        fold();
+        return false;
+    }
+
+    // Play from the highest index so that lower indices stay valid,
+    // then restore the order of the batch
+    std::array<size_t, MAX_ATTACK_SIZE> indices;
+    std::copy(batch.begin(), batch.end(), indices.begin());
+    std::sort(indices.begin(), indices.begin() + batch.size(), std::greater<size_t>());
+
+    size_t first = undefended_.size();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        DEBUGF("Player {} attack: {}", curAttackerIdx_, curAttacker().hand()[indices[i]]);
+        undefended_.push_back(curAttacker().playCard(indices[i]));
+    }
+    std::reverse(undefended_.begin() + first, undefended_.end());
+    for (const auto& s : observers_) {
+        for (size_t idx = first; idx < undefended_.size(); ++idx) {
+            s.observer->onAttack(curAttackerIdx_, undefended_[idx]);
+        }
+    }
+    numFolds_ = 0;
+    return true;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::fold()
+{
+    DEBUGF("Player {} folds", curAttackerIdx_);
+    ++numFolds_;
+    curAttackerIdx_= nextAttackerIdx(curAttackerIdx_);
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::needsDefense() const
+{
+    return !resign_ && !undefended_.empty();
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::applyTransfer(int cardIdx)
+{
+    if (cardIdx == -1) {
+        return false;
+    }
+
+    validateTransfer(cardIdx);
+    DEBUGF("Player {} transfers: {}", defenderIdx_, defender().hand()[cardIdx]);
+    undefended_.push_back(defender().playCard(cardIdx));
+    for (const auto& s : observers_) {
+        s.observer->onAttack(defenderIdx_, undefended_.back());
+    }
+    mainAttackerIdx_ = defenderIdx_;
+    curAttackerIdx_ = defenderIdx_;
+    defenderIdx_ = nextPlayerWithCardsIdx(defenderIdx_);
+    numFolds_ = 0;
+    numAttackers_ = countAttackers();
+    return true;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::applyDefense(int cardIdx)
+{
+    validateDefense(cardIdx);
+    if (cardIdx == -1) {
+        DEBUGF("Player {} resigns", defenderIdx_);
+        resign_ = true;
+        for (const auto& s : observers_) {
+            s.observer->onDefense(defenderIdx_, undefended_.front(), nullptr);
+        }
+    } else {
+        DEBUGF("Player {} defense: {}", defenderIdx_, defender().hand()[cardIdx]);
+        defended_.push_back({std::move(undefended_.front()), defender().playCard(cardIdx)});
+        undefended_.erase(undefended_.begin());
+        for (const auto& s : observers_) {
+            s.observer->onDefense(defenderIdx_, defended_.back().attacking, &defended_.back().defending);
+        }
+    }
+}
+
+template <typename CardTraits>
+BoutResult BasicGame<CardTraits>::endBout()
+{
+    ++numBouts_;
+    if (resign_) {
         resignPickup();
         return BoutResult::Resigned;
     } else {
@@ -178,9 +691,13 @@ BoutResult Game::playBout()
     }
 }
 
-void Game::beatenDiscard()
+template <typename CardTraits>
+void BasicGame<CardTraits>::beatenDiscard()
 {
-    DEBUG() << "beatenDiscard";
+    DEBUGF("beatenDiscard");
+    for (const auto& s : observers_) {
+        s.observer->onDiscard(defended_);
+    }
     for (auto& pair : defended_) {
         discard_.push_back(std::move(pair.attacking));
         discard_.push_back(std::move(pair.defending));
@@ -189,18 +706,23 @@ void Game::beatenDiscard()
     defended_.clear();
 }
 
-void Game::resignPickup()
+template <typename CardTraits>
+void BasicGame<CardTraits>::resignPickup()
 {
-    DEBUG() << "resignPickup";
+    DEBUGF("resignPickup");
+    for (const auto& s : observers_) {
+        s.observer->onPickup(defenderIdx_, undefended_, defended_);
+    }
     defender().addToHand(std::move(undefended_));
     defender().addToHand(std::move(defended_));
     undefended_.clear();
     defended_.clear();
 }
 
-void Game::refill()
+template <typename CardTraits>
+void BasicGame<CardTraits>::refill()
 {
-    DEBUG() << "refill";
+    DEBUGF("refill");
     for (size_t i = 0, idx = mainAttackerIdx_;
             i < numPlayers() && !deck_.isEmpty();
             ++i, idx = nextPlayerIdx(idx))
@@ -211,13 +733,23 @@ void Game::refill()
         }
 
         size_t n = std::min(NUM_INITIAL_CARDS - player.numCards(), deck_.size());
-        player.addToHand(deck_.getFromTop(n));
+        drawn_.clear();
+        for (size_t i = 0; i < n; ++i) {
+            drawn_.push_back(deck_.getOneFromTop());
+        }
+        for (const auto& s : observers_) {
+            static const Cards HIDDEN;
+            s.observer->onRefill(idx, n, s.playerIdx == idx ? drawn_ : HIDDEN);
+        }
+        player.addToHand(std::move(drawn_));
+        drawn_.clear();
     }
 }
 
-void Game::shiftTurn(BoutResult prevBoutResult)
+template <typename CardTraits>
+void BasicGame<CardTraits>::shiftTurn(BoutResult prevBoutResult)
 {
-    DEBUG() << "shiftTurn";
+    DEBUGF("shiftTurn");
     mainAttackerIdx_ = prevBoutResult == BoutResult::Resigned
                      ? nextPlayerWithCardsIdx(defenderIdx_)
                      : defenderIdx_;
@@ -225,19 +757,26 @@ void Game::shiftTurn(BoutResult prevBoutResult)
     defenderIdx_ = nextPlayerWithCardsIdx(mainAttackerIdx_);
 }
 
-void Game::cleanup()
+template <typename CardTraits>
+void BasicGame<CardTraits>::cleanup()
 {
-    DEBUG() << "cleanup";
+    DEBUGF("cleanup");
     // Discard all cards and put them back to the deck
+    // Card by card, so that hands and discard keep their storage
     for (auto& player : players_) {
-        deck_.putOnTop(player.discardHand());
+        while (player.numCards()) {
+            deck_.putOnTop(player.playCard(0));
+        }
+    }
+    for (auto& card : discard_) {
+        deck_.putOnTop(std::move(card));
     }
-    deck_.putOnTop(std::move(discard_));
     discard_.clear();
 }
 
 
-void Game::validateAttack(int cardIdx) const
+template <typename CardTraits>
+void BasicGame<CardTraits>::validateAttack(int cardIdx) const
 {
     REQUIRE(cardIdx < (int)curAttacker().numCards(),
             "Invalid attacking card index: " << cardIdx);
@@ -252,15 +791,7 @@ void Game::validateAttack(int cardIdx) const
 
     const auto& card = curAttacker().hand()[cardIdx];
 
-    bool isOneOfDefended = std::any_of(defended_.begin(), defended_.end(),
-        [&](const CardPair& p) {
-            return p.attacking.rank() == card.rank()
-                || p.defending.rank() == card.rank();
-            });
-    bool isOnOfUndefended = std::any_of(undefended_.begin(), undefended_.end(),
-        [&](const Card& c) { return c.rank() == card.rank(); });
-
-    REQUIRE(isOneOfDefended || isOnOfUndefended,
+    REQUIRE(isRankOnTable(card.rank()),
             "Attacking with a rank not seen before: " << card);
 
     REQUIRE(undefended_.size() + 1 <= defender().numCards(),
@@ -269,7 +800,50 @@ void Game::validateAttack(int cardIdx) const
             "Attacking with more than maximum allowed cards");
 }
 
-void Game::validateDefense(int cardIdx) const
+template <typename CardTraits>
+void BasicGame<CardTraits>::validateAttackBatch(const AttackBatch& batch) const
+{
+    bool initial = defended_.empty() && undefended_.empty();
+    REQUIRE(!initial || !batch.empty(), "Empty initial attack");
+
+    const auto& hand = curAttacker().hand();
+    uint64_t seen = 0;
+    for (size_t cardIdx : batch) {
+        REQUIRE(cardIdx < hand.size() && !(seen >> cardIdx & 1),
+                "Invalid attacking card index: " << cardIdx);
+        seen |= uint64_t(1) << cardIdx;
+
+        const auto& card = hand[cardIdx];
+        if (initial) {
+            REQUIRE(card.rank() == hand[batch[0]].rank(),
+                    "Initial attack with different ranks: " << card);
+        } else {
+            REQUIRE(isRankOnTable(card.rank()),
+                    "Attacking with a rank not seen before: " << card);
+        }
+    }
+
+    REQUIRE(undefended_.size() + batch.size() <= defender().numCards(),
+            "Attacking with more cards than defender has");
+    REQUIRE(undefended_.size() + defended_.size() + batch.size() <= NUM_INITIAL_CARDS,
+            "Attacking with more than maximum allowed cards");
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::isRankOnTable(Rank rank) const
+{
+    bool isOneOfDefended = std::any_of(defended_.begin(), defended_.end(),
+        [&](const CardPair& p) {
+            return p.attacking.rank() == rank
+                || p.defending.rank() == rank;
+            });
+    bool isOnOfUndefended = std::any_of(undefended_.begin(), undefended_.end(),
+        [&](const Card& c) { return c.rank() == rank; });
+    return isOneOfDefended || isOnOfUndefended;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::validateDefense(int cardIdx) const
 {
     if (cardIdx == -1) {
         return;
@@ -285,12 +859,38 @@ void Game::validateDefense(int cardIdx) const
             "Invalid defense of " << attacker << " by " << card);
 }
 
-size_t Game::nextPlayerIdx(size_t playerIdx) const
+template <typename CardTraits>
+bool BasicGame<CardTraits>::canTransfer() const
+{
+    if (!rules_.transfer || !defended_.empty() || undefended_.size() + 1 > NUM_INITIAL_CARDS) {
+        return false;
+    }
+    size_t nextDefenderIdx = nextPlayerWithCardsIdx(defenderIdx_);
+    return nextDefenderIdx != defenderIdx_
+        && players_[nextDefenderIdx].numCards() >= undefended_.size() + 1;
+}
+
+template <typename CardTraits>
+void BasicGame<CardTraits>::validateTransfer(int cardIdx) const
+{
+    REQUIRE(rules_.transfer, "Transfers are not allowed");
+    REQUIRE(cardIdx >= 0 && cardIdx < (int)defender().numCards(),
+            "Invalid transfer card index: " << cardIdx);
+    REQUIRE(canTransfer(), "Cannot transfer at this point");
+
+    const auto& card = defender().hand()[cardIdx];
+    REQUIRE(card.rank() == undefended_.front().rank(),
+            "Transfer with a different rank: " << card);
+}
+
+template <typename CardTraits>
+size_t BasicGame<CardTraits>::nextPlayerIdx(size_t playerIdx) const
 {
     return (playerIdx + 1) % players_.size();
 }
 
-size_t Game::nextPlayerWithCardsIdx(size_t playerIdx) const
+template <typename CardTraits>
+size_t BasicGame<CardTraits>::nextPlayerWithCardsIdx(size_t playerIdx) const
 {
     do {
         playerIdx = (playerIdx + 1) % players_.size();
@@ -298,59 +898,187 @@ size_t Game::nextPlayerWithCardsIdx(size_t playerIdx) const
     return playerIdx;
 }
 
-size_t Game::nextAttackerIdx(size_t playerIdx) const
+template <typename CardTraits>
+size_t BasicGame<CardTraits>::nextAttackerIdx(size_t playerIdx) const
 {
     do {
         playerIdx = (playerIdx + 1) % players_.size();
-    } while (playerIdx != defenderIdx_);
+    } while (!isAttacker(playerIdx));
     return playerIdx;
 }
 
-bool Game::isFinished() const
+template <typename CardTraits>
+bool BasicGame<CardTraits>::isAttacker(size_t playerIdx) const
+{
+    if (playerIdx == defenderIdx_) {
+        return false;
+    }
+    // Defender's partners do not pile on, unless one of them leads the attack
+    return playerIdx == mainAttackerIdx_
+        || rules_.numTeams == 0
+        || teamOf(playerIdx) != teamOf(defenderIdx_);
+}
+
+template <typename CardTraits>
+size_t BasicGame<CardTraits>::countAttackers() const
+{
+    size_t count = 0;
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        count += isAttacker(idx);
+    }
+    return count;
+}
+
+template <typename CardTraits>
+bool BasicGame<CardTraits>::isFinished() const
 {
     auto numActivePlayers = std::count_if(players_.begin(), players_.end(),
         [](const Player& p) { return p.numCards() > 0; });
-    return numActivePlayers < 2;
+    return numActivePlayers < 2 || (rules_.maxBouts && numBouts_ >= rules_.maxBouts);
 }
 
-RoundResult Game::getRoundResult() const
+template <typename CardTraits>
+RoundResult BasicGame<CardTraits>::getRoundResult() const
 {
     auto itr = std::find_if(players_.begin(), players_.end(),
         [](const Player& p) { return p.numCards() > 0; });
+    auto numActivePlayers = std::count_if(players_.begin(), players_.end(),
+        [](const Player& p) { return p.numCards() > 0; });
 
     RoundResult result;
-    if (itr != players_.end()) {
+    if (numActivePlayers == 1) {
         result.losingPlayerIdx = std::distance(players_.begin(), itr);
+        if (rules_.numTeams) {
+            result.losingTeamIdx = teamOf(*result.losingPlayerIdx);
+        }
     } else {
         result.losingPlayerIdx = std::nullopt;
     }
+
+    size_t numOut = players_.size() - numActivePlayers;
+    result.places.resize(players_.size());
+    for (size_t idx = 0; idx < players_.size(); ++idx) {
+        if (!outAfterBout_[idx]) {
+            result.places[idx] = numOut;
+            continue;
+        }
+        result.places[idx] = std::count_if(outAfterBout_.begin(), outAfterBout_.end(),
+            [&](uint32_t bout) { return bout && bout < outAfterBout_[idx]; });
+    }
     return result;
 }
 
 
-void Game::printDeck() const
+template <typename CardTraits>
+void BasicGame<CardTraits>::printDeck() const
 {
-    DEBUG() << "Deck: {" << join(deck_.cards()) << "}";
+    DEBUGF("Deck: {{}}", deck_.cards());
 }
 
-void Game::printHands() const
+template <typename CardTraits>
+void BasicGame<CardTraits>::printHands() const
 {
     for (size_t i = 0; i < players_.size(); ++i) {
         const auto& p = players_[i];
-        DEBUG() << "Player " << i << " hand: {" << join(p.hand()) << "}";
+        DEBUGF("Player {} hand: {{}}", i, p.hand());
     }
 }
 
-void Game::printTable() const
+template <typename CardTraits>
+void BasicGame<CardTraits>::printTable() const
 {
-    DEBUG() << "Undefended: {" << join(undefended_) << "}"
-            << ". Defended: {" << join(defended_) << "}";
+    DEBUGF("Undefended: {{}}. Defended: {{}}", undefended_, defended_);
 }
 
-void Game::printDiscard() const
+template <typename CardTraits>
+void BasicGame<CardTraits>::printDiscard() const
 {
-    DEBUG() << "Discard: {" << join(discard_) << "}";
+    DEBUGF("Discard: {{}}", discard_);
 }
 
-} // namespace miplot::cardgame::durak
+template <typename CardTraits>
+uint64_t legalActions(DecisionKind kind, const BasicGameState<CardTraits>& state,
+                      const typename CardTypes<CardTraits>::Cards& hand)
+{
+    static_assert(CardTraits::radix() < 64, "Actions do not fit the mask");
+
+    const auto bit = [](size_t action) { return uint64_t{1} << action; };
+    const auto& undefended = state.undefendedCards();
+    const auto& defended = state.defendedCards();
+    const uint64_t pass = bit(CardTraits::radix());
+    uint64_t actions = 0;
+
+    switch (kind) {
+        case DecisionKind::Attack: {
+            if (undefended.empty() && defended.empty()) {
+                for (const auto& card : hand) {
+                    actions |= bit(card.code());
+                }
+                return actions;
+            }
+            uint32_t ranks = 0;
+            for (const auto& card : undefended) {
+                ranks |= 1u << static_cast<size_t>(card.rank());
+            }
+            for (const auto& pair : defended) {
+                ranks |= 1u << static_cast<size_t>(pair.attacking.rank());
+                ranks |= 1u << static_cast<size_t>(pair.defending.rank());
+            }
+            for (const auto& card : hand) {
+                if (ranks & (1u << static_cast<size_t>(card.rank()))) {
+                    actions |= bit(card.code());
+                }
+            }
+            return actions | pass;
+        }
+        case DecisionKind::Defend:
+            for (const auto& card : hand) {
+                if (canDefend(undefended.front(), card, state.trumpSuit())) {
+                    actions |= bit(card.code());
+                }
+            }
+            return actions | pass;
+        case DecisionKind::Transfer:
+            for (const auto& card : hand) {
+                if (card.rank() == undefended.front().rank()) {
+                    actions |= bit(card.code());
+                }
+            }
+            return actions | pass;
+    }
+    return actions;
+}
 
+template <typename CardTraits>
+bool isLegalDecision(DecisionKind kind, const BasicGameState<CardTraits>& state,
+                     const typename CardTypes<CardTraits>::Cards& hand, int cardIdx)
+{
+    if (cardIdx < -1 || cardIdx >= (int)hand.size()) {
+        return false;
+    }
+    size_t action = cardIdx == -1 ? CardTraits::radix() : hand[cardIdx].code();
+    return (legalActions(kind, state, hand) >> action & 1) != 0;
+}
+
+template class BasicGameState<cards::Std24CardTraits>;
+template class BasicGameState<cards::Std36CardTraits>;
+template class BasicGameState<cards::Std52CardTraits>;
+
+template class BasicGame<cards::Std24CardTraits>;
+template class BasicGame<cards::Std36CardTraits>;
+template class BasicGame<cards::Std52CardTraits>;
+
+template uint64_t legalActions(DecisionKind, const BasicGameState<cards::Std24CardTraits>&,
+                               const CardTypes<cards::Std24CardTraits>::Cards&);
+template uint64_t legalActions(DecisionKind, const BasicGameState<cards::Std36CardTraits>&,
+                               const CardTypes<cards::Std36CardTraits>::Cards&);
+template uint64_t legalActions(DecisionKind, const BasicGameState<cards::Std52CardTraits>&,
+                               const CardTypes<cards::Std52CardTraits>::Cards&);
+template bool isLegalDecision(DecisionKind, const BasicGameState<cards::Std24CardTraits>&,
+                              const CardTypes<cards::Std24CardTraits>::Cards&, int);
+template bool isLegalDecision(DecisionKind, const BasicGameState<cards::Std36CardTraits>&,
+                              const CardTypes<cards::Std36CardTraits>::Cards&, int);
+template bool isLegalDecision(DecisionKind, const BasicGameState<cards::Std52CardTraits>&,
+                              const CardTypes<cards::Std52CardTraits>::Cards&, int);
+
+} // namespace miplot::cardgame::durak
@@ -2,10 +2,14 @@
 
 #include "card.h"
 #include "deck.h"
+#include "game_observer.h"
 #include "player.h"
 
+#include <array>
 #include <memory>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace miplot::cardgame::durak {
@@ -20,19 +24,97 @@ using Opponents = std::vector<Opponent>;
 
 enum class BoutResult { Beaten, Resigned };
 
+// Decision asked of a player
+enum class DecisionKind : uint8_t { Attack, Defend, Transfer };
+
+// Optional rules on top of the classic (podkidnoy) game
+struct Rules {
+    // Defender may pass the attack on to the next player by adding a card
+    // of the same rank before beating anything (perevodnoy)
+    bool transfer = false;
+
+    // Attackers play several cards per decision through Strategy::attackBatch
+    bool batchedAttacks = false;
+
+    // Players are split into teams by seat: player i plays for team i % numTeams.
+    // Defender's partners do not pile on. 0 means everyone plays alone
+    size_t numTeams = 0;
+
+    // Round is a draw after this many bouts, 0 means no limit. Deterministic
+    // strategies may pass the same cards around forever once the deck is empty
+    size_t maxBouts = 0;
+};
+
 struct RoundResult {
     std::optional<size_t> losingPlayerIdx;
+    // Team of the losing player when playing in teams
+    std::optional<size_t> losingTeamIdx;
+    // Finishing place of every player, 0 for the first to run out of cards.
+    // Players running out in the same bout share a place, those left with cards share the last
+    std::vector<uint8_t> places;
 };
 
-class Game;
+template <typename CardTraits>
+class BasicGame;
+
+/**
+ * Round in progress as plain values, read and set by BasicGame::position()
+ * and setPosition() for formats of their own. Card codes are listed by place:
+ * hands in turn, undefended cards, defended pairs (attacking card first),
+ * discard, then the deck from top. Strategies and the deck's random
+ * generator are not included
+ */
+template <typename CardTraits>
+struct BasicPosition {
+    using Suit = typename CardTypes<CardTraits>::Suit;
+
+    static constexpr size_t MAX_PLAYERS = 6;
+
+    size_t numPlayers = 0;
+    Suit trump{};
+    size_t mainAttackerIdx = 0;
+    size_t curAttackerIdx = 0;
+    size_t defenderIdx = 0;
+
+    // Bout progress
+    bool resign = false;
+    size_t numFolds = 0;
+    size_t numAttackers = 0;
+    uint32_t numBouts = 0;
+    // Bout after which each player ran out of cards, 0 while still playing
+    std::array<uint32_t, MAX_PLAYERS> outAfterBout{};
+
+    std::array<uint8_t, MAX_PLAYERS> handSizes{};
+    size_t numUndefended = 0;
+    size_t numDefended = 0;
+    size_t numDiscarded = 0;
+    std::array<uint8_t, CardTraits::radix()> codes{};
+
+    size_t deckSize() const
+    {
+        size_t numPlaced = numUndefended + 2 * numDefended + numDiscarded;
+        for (size_t idx = 0; idx < numPlayers; ++idx) {
+            numPlaced += handSizes[idx];
+        }
+        return codes.size() - numPlaced;
+    }
+};
 
 // Game state seen by a player
-class GameState {
+template <typename CardTraits>
+class BasicGameState {
 public:
-    GameState(const Game& game);
+    using Game = BasicGame<CardTraits>;
+    using Suit = typename CardTypes<CardTraits>::Suit;
+    using Cards = typename CardTypes<CardTraits>::Cards;
+    using CardPairs = typename CardTypes<CardTraits>::CardPairs;
+
+    BasicGameState(const Game& game);
 
     const Opponents& opponents() const;
 
+    const Rules& rules() const;
+
     Suit trumpSuit() const;
 
     // Indices in opponents() container
@@ -52,15 +134,63 @@ private:
     mutable Opponents opponents_;
 };
 
-class Game {
+/**
+ * Legal answers to a decision by the rules BasicGame validates, as a bit mask
+ * over card codes in hand with bit CardTraits::radix() for passing
+ * (folding, resigning or not transferring)
+ */
+template <typename CardTraits>
+uint64_t legalActions(DecisionKind kind, const BasicGameState<CardTraits>& state,
+                      const typename CardTypes<CardTraits>::Cards& hand);
+
+// Whether cardIdx in hand (-1 to pass) is a legal answer
+template <typename CardTraits>
+bool isLegalDecision(DecisionKind kind, const BasicGameState<CardTraits>& state,
+                     const typename CardTypes<CardTraits>::Cards& hand, int cardIdx);
+
+/**
+ * Durak game engine for the deck described by CardTraits.
+ * Card sets, deck orders, positions and the deck are fixed-size, sized
+ * from CardTraits::radix() at compile time. Hands, the table and discard
+ * are vectors reserved for the whole deck up front, so rounds do not allocate
+ */
+template <typename CardTraits>
+class BasicGame {
 public:
-    Game(Players&& players);
+    using Suit = typename CardTypes<CardTraits>::Suit;
+    using Rank = typename CardTypes<CardTraits>::Rank;
+    using Card = typename CardTypes<CardTraits>::Card;
+    using Cards = typename CardTypes<CardTraits>::Cards;
+    using CardPair = typename CardTypes<CardTraits>::CardPair;
+    using CardPairs = typename CardTypes<CardTraits>::CardPairs;
+    using Deck = cards::Deck<CardTraits>;
+    using Player = BasicPlayer<CardTraits>;
+    using Players = BasicPlayers<CardTraits>;
+    using GameState = BasicGameState<CardTraits>;
+    using Observer = BasicGameObserver<CardTraits>;
+    using Position = BasicPosition<CardTraits>;
+
+    BasicGame(Players&& players, Rules rules = Rules());
 
     RoundResult playRound(size_t firstAttackerIdx);
 
+    // Play a round dealt from the given deck order instead of a shuffled one
+    RoundResult playRound(size_t firstAttackerIdx, const typename Deck::Order& order);
+
+    // Reseed the deck and players' strategies
+    void seed(uint64_t value);
+
+    // Heap bytes held by the game for its players, cards and table, without
+    // strategies. The deck is counted by the 512 byte blocks of its deque
+    size_t footprint() const;
+
+    const Rules& rules() const { return rules_; }
+
     const Players& players() const { return players_; }
     size_t numPlayers() const { return players_.size(); }
 
+    size_t teamOf(size_t playerIdx) const { return rules_.numTeams ? playerIdx % rules_.numTeams : playerIdx; }
+
     // Bottom card of the deck
     Suit trumpSuit() const { return trumpSuit_; }
 
@@ -73,11 +203,110 @@ public:
 
     const Cards& discard() const { return discard_; }
 
+    /**
+     * Compact binary snapshot of the round in progress: hands, table, discard,
+     * deck order, trump, turn indices, bout progress and the deck's random
+     * generator. Strategies keep their own state and are not included
+     */
+    std::string snapshot() const;
+
+    // Restore a snapshot of a game with as many players and the same deck.
+    // Own cards are moved and relabeled like in Deck::arrange(), none is created
+    void restore(std::string_view snapshot);
+
+    // Round in progress without the deck's random generator
+    Position position() const;
+
+    // Set a position of a game with as many players, like restore()
+    // but keeping the deck's random generator
+    void setPosition(const Position& position);
+
+protected:
+    /*
+     * Round steps, shared by the synchronous loop in playRound() and
+     * other drivers asking players for decisions in their own way.
+     * A round is startRound(), then until isFinished(): a bout, finishBout().
+     * A bout is beginBout(), then while boutContinues(): an attack and,
+     * while needsDefense(), a transfer or a defense; then endBout()
+     */
+    void startRound(size_t firstAttackerIdx, const typename Deck::Order* order);
+    void finishBout(BoutResult boutResult);
+    RoundResult finishRound();
+
+    void beginBout();
+    bool boutContinues() const;
+    // Return false if the current attacker folds
+    bool applyAttack(int cardIdx);
+    bool applyAttackBatch(const AttackBatch& batch);
+    bool needsDefense() const;
+    // Return false if the defender does not transfer
+    bool applyTransfer(int cardIdx);
+    void applyDefense(int cardIdx);
+    BoutResult endBout();
+
+    /**
+     * Play the steps without a decision, folds of attackers out of cards and
+     * bout ends, up to the next attack or defense. Returns true instead if
+     * the round ends, which is known only at the end of a bout: a player may
+     * run out of cards mid-bout. beforeBoutEnd() sees the table of every bout
+     * before it ends
+     */
+    template <typename BeforeBoutEnd>
+    bool advanceToDecision(BeforeBoutEnd&& beforeBoutEnd)
+    {
+        for (;;) {
+            if (needsDefense()) {
+                return false;
+            }
+            if (boutContinues()) {
+                if (curAttacker().numCards() > 0) {
+                    return false;
+                }
+                applyAttack(-1);
+                continue;
+            }
+            beforeBoutEnd();
+            finishBout(endBout());
+            if (isFinished()) {
+                return true;
+            }
+            beginBout();
+        }
+    }
+
+    bool advanceToDecision() { return advanceToDecision([] {}); }
+
+    // Defender may transfer the attack to the next player
+    bool canTransfer() const;
+
+    // Copy the round in progress of another game with as many players,
+    // keeping own players' strategies, to branch a round for search
+    void assignRound(const BasicGame& other);
+
+    const Deck& deck() const { return deck_; }
+    Deck& deck() { return deck_; }
+    Player& player(size_t playerIdx) { return players_[playerIdx]; }
+
+    bool isFinished() const;
+
+    const GameState& state() const { return *state_; }
+
+    const Player& curAttacker() const { return players_[curAttackerIdx_]; }
+    const Player& defender() const { return players_[defenderIdx_]; }
+    Player& curAttacker() { return players_[curAttackerIdx_]; }
+    Player& defender() { return players_[defenderIdx_]; }
+
+    void printTable() const;
+
 private:
-    void deal(size_t firstAttackerIdx);
+    RoundResult playRound(size_t firstAttackerIdx, const typename Deck::Order* order);
+
+    void deal(size_t firstAttackerIdx, const typename Deck::Order* order);
 
     BoutResult playBout();
 
+    void fold();
+
     // Move all defended cards to discard
     void beatenDiscard();
     // Defender picks up all cards from the table
@@ -92,38 +321,44 @@ private:
     // Restore the deck
     void cleanup();
 
+    // Gather all cards back into the deck and hand them out as in position.
+    // Cards are moved and relabeled like in Deck::arrange(), none is created
+    void arrangeCards(const Position& position);
+
 
     void validateAttack(int cardIdx) const;
+    void validateAttackBatch(const AttackBatch& batch) const;
+    bool isRankOnTable(Rank rank) const;
     void validateDefense(int cardIdx) const;
+    void validateTransfer(int cardIdx) const;
 
     size_t nextPlayerIdx(size_t playerIdx) const;
     size_t nextPlayerWithCardsIdx(size_t playerIdx) const;
     size_t nextAttackerIdx(size_t playerIdx) const;
-    bool isFinished() const;
+    // Whether the player may attack the current defender
+    bool isAttacker(size_t playerIdx) const;
+    size_t countAttackers() const;
     RoundResult getRoundResult() const;
 
     // helpers
     const Player& mainAttacker() const { return players_[mainAttackerIdx_]; }
-    const Player& curAttacker() const { return players_[curAttackerIdx_]; }
-    const Player& defender() const { return players_[defenderIdx_]; }
     Player& mainAttacker() { return players_[mainAttackerIdx_]; }
-    Player& curAttacker() { return players_[curAttackerIdx_]; }
-    Player& defender() { return players_[defenderIdx_]; }
 
     // Logging
     void printDeck() const;
     void printHands() const;
-    void printTable() const;
     void printDiscard() const;
 
 private:
     Players players_;
 
-    Suit trumpSuit_;
+    Rules rules_;
+
+    Suit trumpSuit_{};
 
-    size_t mainAttackerIdx_;
-    size_t curAttackerIdx_;
-    size_t defenderIdx_;
+    size_t mainAttackerIdx_ = 0;
+    size_t curAttackerIdx_ = 0;
+    size_t defenderIdx_ = 1;
 
     Cards undefended_;
     CardPairs defended_;
@@ -131,10 +366,34 @@ private:
     Deck deck_;
 
     Cards discard_;
+    // Cards of a refill, kept for their storage
+    Cards drawn_;
+
+    // Bout progress
+    bool resign_ = false;
+    size_t numFolds_ = 0;
+    size_t numAttackers_ = 0;
+    size_t numBouts_ = 0;
+    // Bout after which each player ran out of cards, 0 while still playing
+    std::vector<uint32_t> outAfterBout_;
 
     std::unique_ptr<GameState> state_;
 
+    // Strategies subscribed to game events and their seats
+    struct Subscriber {
+        size_t playerIdx;
+        Observer* observer;
+    };
+    std::vector<Subscriber> observers_;
+
     // todo: total score of all rounds?
 };
 
+// Standard 36 card game
+using Game = BasicGame<cards::Std36CardTraits>;
+
+// Variants with 24 and 52 cards
+using Game24 = BasicGame<cards::Std24CardTraits>;
+using Game52 = BasicGame<cards::Std52CardTraits>;
+
 } // namespace miplot::cardgame::durak
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "card.h"
+
+#include <cstddef>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Game events in the order they happen, for strategies keeping incremental
+ * state instead of rescanning the table and the discard on every decision.
+ * A strategy subscribes by returning an observer from Strategy::observer(),
+ * which the game asks once when it is created, so games without observers
+ * only test an empty list per event. Other players' drawn cards stay hidden.
+ * Observers see every event of their game, including forced folds
+ */
+template <typename CardTraits>
+class BasicGameObserver {
+public:
+    using Card = typename CardTypes<CardTraits>::Card;
+    using Cards = typename CardTypes<CardTraits>::Cards;
+    using CardPairs = typename CardTypes<CardTraits>::CardPairs;
+
+    virtual ~BasicGameObserver() = default;
+
+    /**
+     * New round
+     * @param selfIdx seat of the observing player
+     * @param hand its dealt hand
+     * @param trumpCard open card at the bottom of the deck, the last dealt card if the deck is empty
+     * @param deckSize cards left in the deck after dealing
+     */
+    virtual void onDeal(size_t /*selfIdx*/, size_t /*numPlayers*/, const Cards& /*hand*/,
+                        const Card& /*trumpCard*/, size_t /*deckSize*/) {}
+
+    // Card put on the table to beat, also by a defender transferring the attack
+    virtual void onAttack(size_t /*playerIdx*/, const Card& /*card*/) {}
+
+    // defense is nullptr if the defender resigned
+    virtual void onDefense(size_t /*playerIdx*/, const Card& /*attack*/, const Card* /*defense*/) {}
+
+    // Defender takes every card from the table
+    virtual void onPickup(size_t /*playerIdx*/, const Cards& /*undefended*/, const CardPairs& /*defended*/) {}
+
+    // Beaten cards leave the table
+    virtual void onDiscard(const CardPairs& /*defended*/) {}
+
+    // Player drew numCards from the deck. drawn holds them for the observing player only
+    virtual void onRefill(size_t /*playerIdx*/, size_t /*numCards*/, const Cards& /*drawn*/) {}
+};
+
+// Standard 36 card game
+using GameObserver = BasicGameObserver<cards::Std36CardTraits>;
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,182 @@
+#include "deferred.h"
+
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace miplot::log {
+
+namespace {
+
+constexpr size_t FLUSH_SIZE = 1 << 16;
+
+std::atomic<uint32_t> nextFormatId{0};
+std::atomic<uint32_t> nextThread{0};
+
+int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // Nowhere to report it, the log is the error channel
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void putString(std::string& out, std::string_view text)
+{
+    uint16_t size = std::min<size_t>(text.size(), UINT16_MAX);
+    detail::put(out, size);
+    out.append(text.data(), size);
+}
+
+struct ThreadBuffer {
+    uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    std::string entries;
+
+    ThreadBuffer() { entries.reserve(FLUSH_SIZE + 256); }
+    ~ThreadBuffer() { write(); }
+
+    void write()
+    {
+        if (entries.empty()) {
+            return;
+        }
+        auto& logger = getLogger();
+        if (logger.isBinary()) {
+            static_cast<BinaryLogger&>(logger).write(thread, entries);
+        }
+        entries.clear();
+    }
+};
+
+ThreadBuffer& threadBufferImpl()
+{
+    thread_local ThreadBuffer buffer;
+    return buffer;
+}
+
+} // namespace
+
+Format::Format(Level level, const char* text, const char* file, uint32_t line)
+    : id_(nextFormatId.fetch_add(1, std::memory_order_relaxed))
+    , level_(level)
+    , text_(text)
+    , file_(file)
+    , line_(line)
+{
+}
+
+BinaryLogger::BinaryLogger(const char* fileName)
+    : startNs_(nowNs())
+{
+    fd_ = ::open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Cannot open log ") + fileName);
+    }
+    std::string header(binary::MAGIC, sizeof(binary::MAGIC));
+    detail::put(header, binary::VERSION);
+    writeAll(fd_, header.data(), header.size());
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    ::close(fd_);
+}
+
+void BinaryLogger::logImpl(const Message& message)
+{
+    // Messages of LOG() keep their text, under a format of their level
+    static Format formats[] = {
+        {Level::Fatal, "{}", "", 0},
+        {Level::Error, "{}", "", 0},
+        {Level::Warn, "{}", "", 0},
+        {Level::Info, "{}", "", 0},
+        {Level::Debug, "{}", "", 0},
+    };
+    Format& format = formats[static_cast<size_t>(message.level())];
+    if (format.claimDefinition()) {
+        define(format);
+    }
+
+    // Buffered with the thread's other messages to keep their order
+    auto& out = threadBufferImpl().entries;
+    detail::put(out, binary::MESSAGE);
+    detail::put(out, format.id());
+    detail::put(out, elapsedNs());
+    detail::put(out, uint8_t(1));
+    detail::putArg(out, message.text());
+    if (message.level() <= Level::Error) {
+        threadBufferImpl().write();
+    } else {
+        detail::commit(out);
+    }
+}
+
+void BinaryLogger::define(const Format& format)
+{
+    std::string entries;
+    detail::put(entries, binary::DEFINE);
+    detail::put(entries, format.id());
+    detail::put(entries, static_cast<uint8_t>(format.level()));
+    putString(entries, format.text());
+    putString(entries, format.file());
+    detail::put(entries, format.line());
+    write(threadBufferImpl().thread, entries);
+}
+
+void BinaryLogger::write(uint32_t thread, const std::string& entries)
+{
+    uint32_t size = entries.size();
+    std::lock_guard<std::mutex> lock(mutex_);
+    writeAll(fd_, reinterpret_cast<const char*>(&thread), sizeof(thread));
+    writeAll(fd_, reinterpret_cast<const char*>(&size), sizeof(size));
+    writeAll(fd_, entries.data(), entries.size());
+}
+
+uint64_t BinaryLogger::elapsedNs() const
+{
+    return nowNs() - startNs_;
+}
+
+LoggerPtr toBinaryFile(const char* fileName)
+{
+    return std::make_shared<BinaryLogger>(fileName);
+}
+
+void flush()
+{
+    threadBufferImpl().write();
+}
+
+namespace detail {
+
+std::string& threadBuffer()
+{
+    return threadBufferImpl().entries;
+}
+
+void commit(std::string& buffer)
+{
+    if (buffer.size() >= FLUSH_SIZE) {
+        threadBufferImpl().write();
+    }
+}
+
+} // namespace detail
+
+} // namespace miplot::log
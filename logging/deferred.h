@@ -0,0 +1,249 @@
+#pragma once
+
+#include "logging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace miplot::log {
+
+/*
+ * Deferred formatting: a call site of LOGF() has a static Format, and a message
+ * is its id and raw arguments. With a binary logger they are appended to a
+ * buffer of the calling thread and rendered later by durak-logdecode, other
+ * loggers get the message formatted at once. "{}" in a format is replaced by
+ * the next argument.
+ *
+ * Binary log, host byte order:
+ *   header: "DKBL", uint32 version
+ *   chunks: uint32 thread number, uint32 size, then entries of the thread:
+ *     definition: uint8 DEFINE, uint32 format id, uint8 level,
+ *                 format, file (uint16 size and bytes each), uint32 line
+ *     message: uint8 MESSAGE, uint32 format id, uint64 ns since the log was opened,
+ *              uint8 number of arguments, each a uint8 ArgType and its value
+ * A format is defined before its first message in the log, not always in
+ * chunk order, so a reader collects definitions first
+ */
+namespace binary {
+
+constexpr char MAGIC[4] = {'D', 'K', 'B', 'L'};
+constexpr uint32_t VERSION = 1;
+
+enum Entry : uint8_t { DEFINE, MESSAGE };
+
+enum class ArgType : uint8_t {
+    Int,        // int64
+    Uint,       // uint64
+    Double,     // double
+    String,     // uint16 size and bytes
+    Card,       // uint8 deck radix, uint8 code
+    Cards,      // uint8 deck radix, uint8 count, codes
+    CardPairs   // uint8 deck radix, uint8 count, attacking and defending codes of each
+};
+
+} // namespace binary
+
+class Format {
+public:
+    Format(Level level, const char* text, const char* file, uint32_t line);
+
+    uint32_t id() const { return id_; }
+    Level level() const { return level_; }
+    const char* text() const { return text_; }
+    const char* file() const { return file_; }
+    uint32_t line() const { return line_; }
+
+    // Whether the definition is to be written to the log now, true once
+    bool claimDefinition() { return !defined_.exchange(true, std::memory_order_relaxed); }
+
+private:
+    uint32_t id_;
+    Level level_;
+    const char* text_;
+    const char* file_;
+    uint32_t line_;
+    std::atomic<bool> defined_{false};
+};
+
+/**
+ * Writes messages of LOGF() in the binary format, other messages
+ * as their text. Buffers of threads are flushed when full, when their
+ * thread ends and by flush()
+ */
+class BinaryLogger : public Logger {
+public:
+    explicit BinaryLogger(const char* fileName);
+    ~BinaryLogger() override;
+
+    bool isBinary() const override { return true; }
+
+    void logImpl(const Message& message) override;
+
+    void define(const Format& format);
+
+    // Append a chunk of a thread's messages
+    void write(uint32_t thread, const std::string& entries);
+
+    uint64_t elapsedNs() const;
+
+private:
+    std::mutex mutex_;
+    int fd_ = -1;
+    int64_t startNs_ = 0;
+};
+
+LoggerPtr toBinaryFile(const char* fileName);
+
+// Write out messages the calling thread buffered
+void flush();
+
+namespace detail {
+
+// Buffer of the calling thread, flushed when full
+std::string& threadBuffer();
+void commit(std::string& buffer);
+
+template <typename T>
+void put(std::string& out, const T& value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void putType(std::string& out, binary::ArgType type)
+{
+    out.push_back(static_cast<char>(type));
+}
+
+template <typename T>
+concept CardLike = requires(const T& card) { card.code(); std::remove_cvref_t<T>::Traits::radix(); };
+
+template <typename T>
+concept CardRange = requires(const T& range) { { *range.begin() } -> CardLike; range.size(); };
+
+template <typename T>
+concept CardPairRange = requires(const T& range) { { range.begin()->attacking } -> CardLike; range.size(); };
+
+template <typename T>
+void putArg(std::string& out, const T& value)
+{
+    using binary::ArgType;
+    if constexpr (std::is_same_v<T, bool> || (std::is_integral_v<T> && std::is_unsigned_v<T>)) {
+        putType(out, ArgType::Uint);
+        put(out, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+        putType(out, ArgType::Int);
+        put(out, static_cast<int64_t>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        putType(out, ArgType::Double);
+        put(out, static_cast<double>(value));
+    } else if constexpr (CardLike<T>) {
+        putType(out, ArgType::Card);
+        put(out, static_cast<uint8_t>(T::Traits::radix()));
+        put(out, static_cast<uint8_t>(value.code()));
+    } else if constexpr (CardRange<T>) {
+        using Card = std::decay_t<decltype(*value.begin())>;
+        putType(out, ArgType::Cards);
+        put(out, static_cast<uint8_t>(Card::Traits::radix()));
+        put(out, static_cast<uint8_t>(value.size()));
+        for (const auto& card : value) {
+            put(out, static_cast<uint8_t>(card.code()));
+        }
+    } else if constexpr (CardPairRange<T>) {
+        using Card = std::decay_t<decltype(value.begin()->attacking)>;
+        putType(out, ArgType::CardPairs);
+        put(out, static_cast<uint8_t>(Card::Traits::radix()));
+        put(out, static_cast<uint8_t>(value.size()));
+        for (const auto& pair : value) {
+            put(out, static_cast<uint8_t>(pair.attacking.code()));
+            put(out, static_cast<uint8_t>(pair.defending.code()));
+        }
+    } else {
+        // Strings are kept as they are, anything else is formatted now
+        std::string text;
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            text = std::string_view(value);
+        } else {
+            std::ostringstream os;
+            os << value;
+            text = os.str();
+        }
+        uint16_t size = std::min<size_t>(text.size(), UINT16_MAX);
+        putType(out, ArgType::String);
+        put(out, size);
+        out.append(text.data(), size);
+    }
+}
+
+// Text up to the next "{}" of a format, then the argument
+template <typename T>
+void formatArg(Message& message, std::string_view& rest, const T& value)
+{
+    auto pos = rest.find("{}");
+    message << rest.substr(0, pos);
+    if (pos == std::string_view::npos) {
+        rest = {};
+        return;
+    }
+    rest.remove_prefix(pos + 2);
+    if constexpr (CardRange<T> || CardPairRange<T>) {
+        bool first = true;
+        for (const auto& item : value) {
+            if (!first) {
+                message << ",";
+            }
+            if constexpr (CardRange<T>) {
+                message << item;
+            } else {
+                message << "(" << item.attacking << "," << item.defending << ")";
+            }
+            first = false;
+        }
+    } else {
+        message << value;
+    }
+}
+
+} // namespace detail
+
+template <typename... Args>
+void write(Format& format, const Args&... args)
+{
+    auto& logger = getLogger();
+    if (!logger.isBinary()) {
+        Message message(format.level());
+        std::string_view rest = format.text();
+        (detail::formatArg(message, rest, args), ...);
+        message << rest;
+        return;
+    }
+
+    auto& binaryLogger = static_cast<BinaryLogger&>(logger);
+    if (format.claimDefinition()) {
+        binaryLogger.define(format);
+    }
+    auto& out = detail::threadBuffer();
+    detail::put(out, binary::MESSAGE);
+    detail::put(out, format.id());
+    detail::put(out, binaryLogger.elapsedNs());
+    detail::put(out, static_cast<uint8_t>(sizeof...(Args)));
+    (detail::putArg(out, args), ...);
+    detail::commit(out);
+}
+
+#define LOGF(level, format, ...)                                                        \
+    do {                                                                                \
+        if ((level) <= miplot::log::getLogLevel()) {                                    \
+            static miplot::log::Format logFormat_(level, format, __FILE__, __LINE__);   \
+            miplot::log::write(logFormat_ __VA_OPT__(,) __VA_ARGS__);                   \
+        }                                                                               \
+    } while (false)
+
+#define INFOF(format, ...)  LOGF(miplot::log::Level::Info, format __VA_OPT__(,) __VA_ARGS__)
+#define DEBUGF(format, ...) LOGF(miplot::log::Level::Debug, format __VA_OPT__(,) __VA_ARGS__)
+
+} // namespace miplot::log
@@ -41,6 +41,7 @@ std::string Message::text() const
 void Logger::log(const Message& message)
 {
     if (message.level() <= level()) {
+        std::lock_guard<std::mutex> lock(mutex_);
         this->logImpl(message);
     }
 }
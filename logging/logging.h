@@ -3,6 +3,7 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 
 namespace miplot::log {
@@ -36,18 +37,24 @@ class Logger;
 using LoggerPtr = std::shared_ptr<Logger>;
 using LoggerFactory = std::function<LoggerPtr()>;
 
-// Simple non-threadsafe logger
+// Simple logger, writes are serialized with a mutex
 class Logger {
 public:
+    virtual ~Logger() = default;
+
     void log(const Message&);
     Level level() const { return level_; }
     void setLevel(Level level) { level_ = level; }
 
     virtual void logImpl(const Message&) = 0;
 
+    // Whether messages of LOGF() are stored unformatted, see deferred.h
+    virtual bool isBinary() const { return false; }
+
     static LoggerFactory createLogger;
 private:
     Level level_ = Level::Info;
+    std::mutex mutex_;
 };
 
 LoggerPtr toStdout();
@@ -59,7 +66,14 @@ Logger& getLogger();
 void setLogLevel(Level level);
 Level getLogLevel();
 
-#define LOG(level) miplot::log::Message(level)
+// Lower precedence than <<, so that a whole message is skipped below the log level
+struct Voidify {
+    void operator&(const Message&) {}
+};
+
+#define LOG(level)                                                      \
+    !((level) <= miplot::log::getLogLevel()) ? (void)0 :                \
+        miplot::log::Voidify() & miplot::log::Message(level)
 
 #define FATAL() LOG(miplot::log::Level::Fatal)
 #define ERROR() LOG(miplot::log::Level::Error)
@@ -1,44 +1,565 @@
+#include "cached_strategy.h"
+#include "checkpoint.h"
+#include "duplicate.h"
 #include "exception.h"
 #include "game.h"
-#include "logging/logging.h"
+#include "logging/deferred.h"
+#include "rating.h"
+#include "shards.h"
+#include "simulator.h"
+#include "utils.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
 #include <unistd.h>
 
 using namespace miplot;
 using namespace miplot::cardgame::durak;
 
-int main() try
+namespace {
+
+template <typename CardTraits>
+BasicPlayers<CardTraits> makePlayers(size_t numPlayers, bool cached)
 {
-    log::setLogger(log::toFile("durak.log"));
-    log::setLogLevel(log::Level::Info);
+    BasicPlayers<CardTraits> players;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        auto name = "Player " + std::to_string(idx + 1);
+        if (idx % 2 == 0) {
+            players.emplace_back(name, std::make_unique<BasicRandomStrategy<CardTraits>>());
+        } else if (cached) {
+            players.emplace_back(name, std::make_unique<CachedStrategy<BasicMinCardStrategy<CardTraits>>>());
+        } else {
+            players.emplace_back(name, std::make_unique<BasicMinCardStrategy<CardTraits>>());
+        }
+    }
+    return players;
+}
 
-    Players players;
-    players.emplace_back("Player 1", std::make_unique<RandomStrategy>());
-    players.emplace_back("Player 2", std::make_unique<MinCardStrategy>());
-    std::vector<size_t> playersStat(players.size(), 0);
+struct Options {
+    size_t deckSize = 36;
+    size_t numPlayers = 2;
+    size_t totalRounds = 1000;
+    bool duplicate = false;
+    bool cached = false;
+    Rules rules;
+    std::shared_ptr<const DealCorpus> deals;
+    std::string dealsPath;
+    uint64_t seed = std::random_device{}();
+    // Progress is appended to the checkpoint log every checkpointEvery rounds or deals
+    std::string checkpointPath;
+    size_t checkpointEvery = 10000;
+    bool resume = false;
+    // Rounds or deals [firstRound, totalRounds) are played, a shard worker plays only its range
+    size_t firstRound = 0;
+    size_t numThreads = defaultNumThreads();
+    // A coordinator starts numShards workers, worker shardIdx writes checkpointPath.shardIdx
+    size_t numShards = 0;
+    std::optional<size_t> shardIdx;
+    bool pinNuma = false;
+    // Result files to combine instead of playing
+    bool merge = false;
+    std::vector<std::string> mergePaths;
+    // Results of every round, for ratings. Workers write resultsPath.shardIdx
+    std::string resultsPath;
+    std::optional<RatingMethod> ratingMethod;
+    // Log to durak.blog for durak-logdecode instead of the text durak.log
+    bool binaryLog = false;
+    bool debugLog = false;
+    // Arguments as given, passed on to shard workers
+    std::vector<std::string> args;
 
-    Game game{std::move(players)};
+    // Settings a resumed run must share with the checkpointed one
+    std::string config() const
+    {
+        std::ostringstream out;
+        out << (duplicate ? "duplicate" : "play") << " deck " << deckSize << " players " << numPlayers
+            << " teams " << rules.numTeams << " transfer " << rules.transfer
+            << " batched " << rules.batchedAttacks << " cached " << cached
+            << " deals '" << dealsPath << "' every " << checkpointEvery;
+        return out.str();
+    }
+};
 
-    size_t totalRounds = 1000;
+std::string shardPath(const std::string& path, size_t shardIdx)
+{
+    return path + "." + std::to_string(shardIdx);
+}
+
+// Checkpoint log of the run, if asked for. A log with progress is only continued with --resume
+std::unique_ptr<CheckpointLog> openCheckpoints(const Options& options)
+{
+    if (options.checkpointPath.empty()) {
+        return nullptr;
+    }
+    auto log = std::make_unique<CheckpointLog>(options.checkpointPath);
+    if (const auto& last = log->last()) {
+        REQUIRE(options.resume, "Checkpoint log " << log->path() << " has progress, pass --resume to continue");
+        REQUIRE(last->config == options.config() && last->begin == options.firstRound,
+                "Checkpoint log " << log->path() << " belongs to another run: " << last->config);
+        INFO() << "Resuming from " << log->path() << " after " << last->end;
+    }
+    return log;
+}
+
+// Rated entrants are seats with their strategies
+template <typename CardTraits>
+std::vector<std::string> entrantNames(const BasicPlayers<CardTraits>& players)
+{
+    std::vector<std::string> names;
+    for (size_t index = 0; index < players.size(); ++index) {
+        names.push_back("Player " + std::to_string(index) + " (" + players[index].strategyName() + ")");
+    }
+    return names;
+}
+
+// Updates ratings inline if given
+template <typename CardTraits>
+Checkpoint play(const Options& options, RatingTable* ratings)
+{
+    auto players = makePlayers<CardTraits>(options.numPlayers, options.cached);
+    size_t numPlayers = players.size();
+    auto names = entrantNames(players);
+
+    Checkpoint result;
+    result.config = options.config();
+    result.seed = options.seed;
+    result.begin = result.end = options.firstRound;
+    // Losses of every player, then of every team
+    result.counters.assign(numPlayers + options.rules.numTeams, 0);
+
+    BasicGame<CardTraits> game{std::move(players), options.rules};
+
+    auto checkpoints = openCheckpoints(options);
+    if (checkpoints && checkpoints->last()) {
+        const auto& last = *checkpoints->last();
+        REQUIRE(last.counters.size() == result.counters.size()
+                && last.states.size() == game.numPlayers(), "Invalid checkpoint");
+        result = last;
+        game.restore(last.game);
+        for (size_t index = 0; index < game.numPlayers(); ++index) {
+            game.players()[index].strategy().loadState(last.states[index]);
+        }
+    }
+
+    std::unique_ptr<ResultStreamWriter> results;
+    if (!options.resultsPath.empty()) {
+        // Results past the checkpoint are played again
+        results = std::make_unique<ResultStreamWriter>(options.resultsPath, names, numPlayers,
+                                                       result.end - result.begin);
+    }
+    // Entrants of the result stream are seats, those of ratings are indices in the table
+    std::vector<uint16_t> seats(numPlayers);
+    std::iota(seats.begin(), seats.end(), 0);
+    std::vector<uint16_t> rated(numPlayers);
+    if (ratings) {
+        for (size_t index = 0; index < numPlayers; ++index) {
+            rated[index] = ratings->add(names[index]);
+        }
+        if (result.end > result.begin) {
+            REQUIRE(results, "Resumed ratings are recomputed from --results");
+            results->sync();
+            ratings->update(ResultStream::open(options.resultsPath));
+        }
+    }
+
+    auto save = [&] {
+        if (results) {
+            results->sync();
+        }
+        result.game = game.snapshot();
+        result.states.clear();
+        for (const auto& player : game.players()) {
+            result.states.push_back(player.strategy().saveState());
+        }
+        checkpoints->append(result);
+    };
 
-    for (size_t round = 0; round < totalRounds; ++round) {
-        auto result = game.playRound(0);
-        if (result.losingPlayerIdx) {
-            auto index = *result.losingPlayerIdx;
+    typename cards::Deck<CardTraits>::Order order;
+    for (size_t round = result.end; round < options.totalRounds; ++round) {
+        // Strategies are reseeded every round, they are not in game snapshots
+        game.seed(mixSeed(result.seed, round));
+        if (options.deals) {
+            options.deals->order<CardTraits>(round, order);
+        }
+        auto outcome = options.deals ? game.playRound(0, order) : game.playRound(0);
+        if (outcome.losingPlayerIdx) {
+            auto index = *outcome.losingPlayerIdx;
             INFO() << "Player " << index << " lost";
-            ++playersStat[index];
+            ++result.counters[index];
+            if (outcome.losingTeamIdx) {
+                ++result.counters[numPlayers + *outcome.losingTeamIdx];
+            }
         } else {
             INFO() << "There was a draw";
         }
+        if (results) {
+            results->append(seats.data(), outcome.places.data());
+        }
+        if (ratings) {
+            ratings->update(rated.data(), outcome.places.data(), numPlayers);
+        }
+        result.end = round + 1;
+        if (checkpoints && (result.end % options.checkpointEvery == 0 || result.end == options.totalRounds)) {
+            save();
+        }
+    }
+    if (results) {
+        results->sync();
     }
     INFO() << "Done\n";
 
-    for (size_t index = 0; index < playersStat.size(); ++index) {
+    if (options.cached && !options.shardIdx) {
+        auto stats = CachedStrategy<BasicMinCardStrategy<CardTraits>>::threadStats();
+        std::cout << "Decision cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+                  << stats.hitRate() * 100 << " %)\n";
+    }
+    return result;
+}
+
+template <typename CardTraits>
+void reportPlay(const Options& options, const Checkpoint& result)
+{
+    auto players = makePlayers<CardTraits>(options.numPlayers, options.cached);
+    REQUIRE(result.counters.size() == players.size() + options.rules.numTeams, "Invalid result");
+
+    for (size_t index = 0; index < players.size(); ++index) {
         std::cout << "Player " << index
-                  << " (" << game.players()[index].strategyName() << ")"
-                  << " lost " << (playersStat[index] * 100.0 / totalRounds) << " % of games\n";
+                  << " (" << players[index].strategyName() << ")"
+                  << " lost " << (result.counters[index] * 100.0 / options.totalRounds) << " % of games\n";
+    }
+    for (size_t index = 0; index < options.rules.numTeams; ++index) {
+        std::cout << "Team " << index
+                  << " lost " << (result.counters[players.size() + index] * 100.0 / options.totalRounds)
+                  << " % of games\n";
+    }
+}
+
+// Sums of a duplicate result in the order they are kept in checkpoints
+std::vector<std::vector<int64_t>*> sumsOf(DuplicateResult& result)
+{
+    return {&result.lossSum, &result.lossSumSq, &result.diffSum, &result.diffSumSq, &result.roundDiffSumSq};
+}
+
+// Sums are integers and go to counters after the 4 sizes, so that they merge exactly
+void storeDuplicate(DuplicateResult& from, Checkpoint& to)
+{
+    to.counters = {from.numPlayers, from.numReplays, from.numDeals, from.draws};
+    to.sums.clear();
+    for (auto* sums : sumsOf(from)) {
+        for (int64_t sum : *sums) {
+            to.counters.push_back(static_cast<uint64_t>(sum));
+        }
+    }
+}
+
+DuplicateResult loadDuplicate(const Checkpoint& from)
+{
+    REQUIRE(from.counters.size() >= 4, "Invalid duplicate result");
+    DuplicateResult result;
+    result.init(from.counters[0], from.counters[1]);
+    result.numDeals = from.counters[2];
+    result.draws = from.counters[3];
+    size_t pos = 4;
+    for (auto* sums : sumsOf(result)) {
+        REQUIRE(pos + sums->size() <= from.counters.size(), "Invalid duplicate result");
+        for (auto& sum : *sums) {
+            sum = static_cast<int64_t>(from.counters[pos++]);
+        }
+    }
+    REQUIRE(pos == from.counters.size(), "Invalid duplicate result");
+    return result;
+}
+
+// Every deal is replayed for all seatings and first attackers, losses are compared deal by deal
+template <typename CardTraits>
+Checkpoint playDuplicate(const Options& options)
+{
+    size_t numPlayers = options.numPlayers;
+    bool cached = options.cached;
+    BasicDuplicateMatch<CardTraits> match([numPlayers, cached] { return makePlayers<CardTraits>(numPlayers, cached); },
+                                          options.numThreads, options.rules);
+    match.setDeals(options.deals);
+
+    Checkpoint result;
+    result.config = options.config();
+    result.seed = options.seed;
+    result.begin = result.end = options.firstRound;
+
+    DuplicateResult sums;
+    auto checkpoints = openCheckpoints(options);
+    if (!checkpoints) {
+        sums = match.run(result.seed, result.begin, options.totalRounds - result.begin);
+        result.end = options.totalRounds;
+    } else {
+        if (checkpoints->last()) {
+            result = *checkpoints->last();
+            sums = loadDuplicate(result);
+        }
+        // Chunks of deals end at multiples of checkpointEvery, so that
+        // a resumed run merges the same chunks as an uninterrupted one
+        while (result.end < options.totalRounds) {
+            size_t end = std::min((result.end / options.checkpointEvery + 1) * options.checkpointEvery,
+                                  options.totalRounds);
+            sums.merge(match.run(result.seed, result.end, end - result.end));
+            result.end = end;
+            storeDuplicate(sums, result);
+            checkpoints->append(result);
+        }
+    }
+    storeDuplicate(sums, result);
+    return result;
+}
+
+template <typename CardTraits>
+void reportDuplicate(const Options& options, const Checkpoint& checkpoint)
+{
+    size_t numPlayers = options.numPlayers;
+    auto names = makePlayers<CardTraits>(numPlayers, options.cached);
+    auto result = loadDuplicate(checkpoint);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << result.numDeals << " deals, " << result.numReplays << " replays each, "
+              << result.numRounds() << " rounds, " << result.draws << " draws\n";
+    for (size_t i = 0; i < numPlayers; ++i) {
+        std::cout << "Player " << i << " (" << names[i].strategyName() << ")"
+                  << " lost " << result.meanLoss(i) * 100 << " +- " << result.lossStdErr(i) * 100
+                  << " % of games\n";
+    }
+    for (size_t i = 0; i < numPlayers; ++i) {
+        for (size_t j = i + 1; j < numPlayers; ++j) {
+            double paired = result.diffStdErr(i, j);
+            double unpaired = result.unpairedDiffStdErr(i, j);
+            std::cout << "Player " << i << " - player " << j << ": "
+                      << result.meanDiff(i, j) * 100 << " +- " << paired * 100 << " %"
+                      << " (independent deals: +- " << unpaired * 100 << " %, "
+                      << (paired > 0 ? unpaired * unpaired / (paired * paired) : 0.0)
+                      << "x rounds for the same error)\n";
+        }
+    }
+}
+
+// Combines result files of shards which together cover all rounds of the run
+Checkpoint mergeResults(const Options& options, const std::vector<std::string>& paths)
+{
+    REQUIRE(!paths.empty(), "No result files to merge");
+    std::vector<Checkpoint> parts;
+    for (const auto& path : paths) {
+        auto part = CheckpointLog::read(path);
+        REQUIRE(part, "No results in " << path);
+        REQUIRE(part->config == options.config(), "Result file " << path << " belongs to another run: " << part->config);
+        REQUIRE(parts.empty() || part->seed == parts.front().seed, "Result file " << path << " has another seed");
+        parts.push_back(std::move(*part));
+    }
+    std::sort(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs.begin < rhs.begin; });
+
+    Checkpoint result;
+    result.config = options.config();
+    result.seed = parts.front().seed;
+    DuplicateResult sums;
+    for (const auto& part : parts) {
+        REQUIRE(part.begin == result.end, "Results miss rounds from " << result.end << " to " << part.begin);
+        result.end = part.end;
+        if (options.duplicate) {
+            sums.merge(loadDuplicate(part));
+        } else {
+            REQUIRE(result.counters.empty() || result.counters.size() == part.counters.size(), "Invalid result");
+            result.counters.resize(part.counters.size());
+            std::transform(result.counters.begin(), result.counters.end(), part.counters.begin(),
+                           result.counters.begin(), std::plus<uint64_t>());
+        }
+    }
+    REQUIRE(result.end == options.totalRounds,
+            "Results cover " << result.end << " of " << options.totalRounds << " rounds");
+    if (options.duplicate) {
+        storeDuplicate(sums, result);
+    }
+    return result;
+}
+
+// Starts a worker per shard and merges their result files
+Checkpoint playShards(const Options& options)
+{
+    // Workers continuing a run must share its seed, also those that have not saved yet
+    uint64_t seed = options.seed;
+    for (size_t idx = 0; options.resume && idx < options.numShards; ++idx) {
+        auto path = shardPath(options.checkpointPath, idx);
+        if (std::ifstream(path).peek() != EOF) {
+            if (auto last = CheckpointLog::read(path)) {
+                seed = last->seed;
+                break;
+            }
+        }
+    }
+
+    runShards(options.numShards, options.pinNuma, [&](size_t idx) {
+        auto args = options.args;
+        args.insert(args.end(), {"--shard", std::to_string(idx), "--seed", std::to_string(seed)});
+        return args;
+    });
+
+    std::vector<std::string> paths;
+    for (size_t idx = 0; idx < options.numShards; ++idx) {
+        paths.push_back(shardPath(options.checkpointPath, idx));
+    }
+    return mergeResults(options, paths);
+}
+
+template <typename CardTraits>
+void run(const Options& options)
+{
+    // A worker's results are in its files
+    std::optional<RatingTable> ratings;
+    if (options.ratingMethod && !options.shardIdx) {
+        ratings.emplace(*options.ratingMethod);
+    }
+
+    Checkpoint result;
+    if (options.merge) {
+        result = mergeResults(options, options.mergePaths);
+    } else if (options.numShards > 0 && !options.shardIdx) {
+        result = playShards(options);
+        // Shards cover the rounds in order, their results are rated as if played inline
+        for (size_t idx = 0; ratings && idx < options.numShards; ++idx) {
+            ratings->update(ResultStream::open(shardPath(options.resultsPath, idx)));
+        }
+    } else if (options.duplicate) {
+        result = playDuplicate<CardTraits>(options);
+    } else {
+        result = play<CardTraits>(options, ratings ? &*ratings : nullptr);
+    }
+
+    if (!options.shardIdx) {
+        (options.duplicate ? reportDuplicate<CardTraits> : reportPlay<CardTraits>)(options, result);
+    }
+    if (ratings) {
+        std::cout << "Ratings:\n";
+        ratings->print(std::cout);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    Options options;
+    int first = 1;
+    if (argc > 1 && std::strcmp(argv[1], "merge") == 0) {
+        // durak merge [options] files...: the report of a sharded run from its result files
+        options.merge = true;
+        first = 2;
+    }
+    for (int i = first; i < argc; ++i) {
+        int start = i;
+        if (std::strcmp(argv[i], "--deck") == 0 && i + 1 < argc) {
+            options.deckSize = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            options.numPlayers = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--teams") == 0 && i + 1 < argc) {
+            options.rules.numTeams = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--transfer") == 0) {
+            options.rules.transfer = true;
+        } else if (std::strcmp(argv[i], "--batched") == 0) {
+            options.rules.batchedAttacks = true;
+        } else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            options.totalRounds = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--duplicate") == 0) {
+            // Rounds are the number of deals
+            options.duplicate = true;
+        } else if (std::strcmp(argv[i], "--cached") == 0) {
+            // Memoize decisions of the minimal card strategy
+            options.cached = true;
+        } else if (std::strcmp(argv[i], "--deals") == 0 && i + 1 < argc) {
+            options.dealsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            options.checkpointPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            options.checkpointEvery = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--resume") == 0) {
+            options.resume = true;
+        } else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            options.numShards = std::stoul(argv[++i]);
+        } else if (std::strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+            // Set by the coordinator for its workers
+            options.shardIdx = std::stoul(argv[++i]);
+            continue;
+        } else if (std::strcmp(argv[i], "--numa") == 0) {
+            // Pin shard workers to NUMA nodes in turn
+            options.pinNuma = true;
+        } else if (std::strcmp(argv[i], "--results") == 0 && i + 1 < argc) {
+            options.resultsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ratings") == 0 && i + 1 < argc) {
+            std::string method = argv[++i];
+            REQUIRE(method == "elo" || method == "glicko", "Unknown rating method: " << method);
+            options.ratingMethod = method == "elo" ? RatingMethod::Elo : RatingMethod::Glicko;
+        } else if (std::strcmp(argv[i], "--binary-log") == 0) {
+            options.binaryLog = true;
+        } else if (std::strcmp(argv[i], "--debug") == 0) {
+            options.debugLog = true;
+        } else if (options.merge && argv[i][0] != '-') {
+            options.mergePaths.push_back(argv[i]);
+            continue;
+        } else {
+            throw Exception() << "Unknown argument: " << argv[i];
+        }
+        options.args.insert(options.args.end(), argv + start, argv + i + 1);
+    }
+    REQUIRE(options.checkpointEvery > 0, "Checkpoint interval must be positive");
+    REQUIRE(!options.resume || !options.checkpointPath.empty(), "--resume needs --checkpoint");
+    REQUIRE(!options.numShards || !options.checkpointPath.empty(),
+            "--shards needs --checkpoint, the base path of result files of shards");
+    REQUIRE(options.numShards <= options.totalRounds, "More shards than rounds");
+    REQUIRE(!options.shardIdx || *options.shardIdx < options.numShards, "Invalid shard " << *options.shardIdx);
+    REQUIRE(!options.duplicate || (options.resultsPath.empty() && !options.ratingMethod),
+            "Results and ratings are not kept in duplicate play");
+    REQUIRE(!options.merge || !options.ratingMethod, "Rate result streams of a merged run with durak-rate");
+    REQUIRE(!options.numShards || !options.ratingMethod || !options.resultsPath.empty(),
+            "Ratings of shards are computed from their --results");
+
+    if (options.shardIdx) {
+        // Workers share the CPUs they are pinned to
+        size_t numSharing = options.numShards;
+        if (auto nodes = options.pinNuma ? numaNodeCpus() : std::vector<std::vector<int>>(); !nodes.empty()) {
+            numSharing = (options.numShards + nodes.size() - 1) / nodes.size();
+        }
+        options.numThreads = std::max<size_t>(1, defaultNumThreads() / numSharing);
+        std::tie(options.firstRound, options.totalRounds) =
+            shardRange(options.totalRounds, *options.shardIdx, options.numShards);
+        options.checkpointPath = shardPath(options.checkpointPath, *options.shardIdx);
+        if (!options.resultsPath.empty()) {
+            options.resultsPath = shardPath(options.resultsPath, *options.shardIdx);
+        }
+    }
+
+    std::string logPath = options.binaryLog ? "durak.blog" : "durak.log";
+    if (options.shardIdx) {
+        logPath = shardPath(logPath, *options.shardIdx);
+    }
+    log::setLogger(options.binaryLog ? log::toBinaryFile(logPath.c_str()) : log::toFile(logPath.c_str()));
+    log::setLogLevel(options.debugLog ? log::Level::Debug : log::Level::Info);
+
+    if (!options.dealsPath.empty()) {
+        options.deals = std::make_shared<const DealCorpus>(DealCorpus::open(options.dealsPath));
+    }
+
+    switch (options.deckSize) {
+        case 24: run<cards::Std24CardTraits>(options); break;
+        case 36: run<cards::Std36CardTraits>(options); break;
+        case 52: run<cards::Std52CardTraits>(options); break;
+        default: throw Exception() << "Unsupported deck size: " << options.deckSize;
     }
 
     sleep(1);
@@ -50,4 +571,3 @@ int main() try
     FATAL() << e.what();
     return EXIT_FAILURE;
 }
-
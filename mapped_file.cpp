@@ -0,0 +1,115 @@
+#include "mapped_file.h"
+#include "exception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace miplot {
+
+namespace {
+
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : fd_(fd) {}
+    ~FileDescriptor() { if (fd_ >= 0) ::close(fd_); }
+    int get() const { return fd_; }
+private:
+    int fd_;
+};
+
+} // namespace
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(other.data_)
+    , size_(other.size_)
+    , writable_(other.writable_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator= (MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        writable_ = other.writable_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+MappedFile MappedFile::open(const std::string& path)
+{
+    FileDescriptor fd(::open(path.c_str(), O_RDONLY));
+    REQUIRE(fd.get() >= 0, "Cannot open " << path << ": " << std::strerror(errno));
+
+    struct stat st;
+    REQUIRE(::fstat(fd.get(), &st) == 0, "Cannot stat " << path << ": " << std::strerror(errno));
+    REQUIRE(st.st_size > 0, "File is empty: " << path);
+
+    void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    REQUIRE(addr != MAP_FAILED, "Cannot map " << path << ": " << std::strerror(errno));
+
+    MappedFile file;
+    file.data_ = static_cast<uint8_t*>(addr);
+    file.size_ = st.st_size;
+    return file;
+}
+
+MappedFile MappedFile::openWritable(const std::string& path, size_t size, uint8_t fill)
+{
+    REQUIRE(size > 0, "Cannot map an empty file: " << path);
+
+    FileDescriptor fd(::open(path.c_str(), O_RDWR | O_CREAT, 0644));
+    REQUIRE(fd.get() >= 0, "Cannot open " << path << ": " << std::strerror(errno));
+
+    struct stat st;
+    REQUIRE(::fstat(fd.get(), &st) == 0, "Cannot stat " << path << ": " << std::strerror(errno));
+    size_t oldSize = st.st_size;
+    if (oldSize < size) {
+        REQUIRE(::ftruncate(fd.get(), size) == 0,
+                "Cannot resize " << path << ": " << std::strerror(errno));
+    }
+
+    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    REQUIRE(addr != MAP_FAILED, "Cannot map " << path << ": " << std::strerror(errno));
+
+    MappedFile file;
+    file.data_ = static_cast<uint8_t*>(addr);
+    file.size_ = size;
+    file.writable_ = true;
+    if (oldSize < size && fill != 0) {
+        std::memset(file.data_ + oldSize, fill, size - oldSize);
+    }
+    return file;
+}
+
+void MappedFile::sync()
+{
+    if (data_ && writable_) {
+        REQUIRE(::msync(data_, size_, MS_SYNC) == 0, "msync failed: " << std::strerror(errno));
+    }
+}
+
+void MappedFile::close()
+{
+    if (data_) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+} // namespace miplot
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace miplot {
+
+/**
+ * Memory-mapped file, unmapped on destruction
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator= (MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    // Map an existing file read-only
+    static MappedFile open(const std::string& path);
+
+    // Map a file for writing, creating it or growing it to the given size.
+    // New bytes are filled with fill
+    static MappedFile openWritable(const std::string& path, size_t size, uint8_t fill = 0);
+
+    const uint8_t* data() const { return data_; }
+    uint8_t* mutableData() { return writable_ ? data_ : nullptr; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+    // Flush written pages to disk
+    void sync();
+
+private:
+    void close();
+
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool writable_ = false;
+};
+
+} // namespace miplot
@@ -0,0 +1,87 @@
+#include "features.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr size_t HAND_PLANE = 0;
+constexpr size_t UNDEFENDED_PLANE = NUM_CARD_CODES;
+constexpr size_t ATTACKING_PLANE = 2 * NUM_CARD_CODES;
+constexpr size_t DEFENDING_PLANE = 3 * NUM_CARD_CODES;
+constexpr size_t DISCARD_PLANE = 4 * NUM_CARD_CODES;
+constexpr size_t TRUMP_OFFSET = 5 * NUM_CARD_CODES;
+constexpr size_t KIND_OFFSET = TRUMP_OFFSET + 4;
+constexpr size_t SCALARS_OFFSET = KIND_OFFSET + 3;
+
+} // namespace
+
+DecisionRecord describeDecision(DecisionKind kind, const GameState& state, const Cards& hand)
+{
+    DecisionRecord record;
+    record.kind = kind;
+    record.trump = static_cast<uint8_t>(state.trumpSuit());
+    record.numPlayers = static_cast<uint8_t>(state.opponents().size());
+    record.hand = CardSet::of(hand);
+    record.undefended = CardSet::of(state.undefendedCards());
+    for (const auto& pair : state.defendedCards()) {
+        record.attacking.insert(pair.attacking);
+        record.defending.insert(pair.defending);
+    }
+    record.discard = CardSet::of(state.discard());
+
+    size_t numCardsInHands = 0;
+    for (const auto& opponent : state.opponents()) {
+        numCardsInHands += opponent.numCards;
+    }
+    record.numOtherCards = static_cast<uint8_t>(numCardsInHands - std::min(numCardsInHands, hand.size()));
+
+    size_t numOnTable = state.undefendedCards().size() + 2 * state.defendedCards().size();
+    size_t numSeen = numCardsInHands + numOnTable + state.discard().size();
+    record.deckSize = static_cast<uint8_t>(numSeen < NUM_CARD_CODES ? NUM_CARD_CODES - numSeen : 0);
+    return record;
+}
+
+DecisionRecord canonicalize(const DecisionRecord& record, SuitPermutation& permutation)
+{
+    permutation = canonicalPermutation(static_cast<Suit>(record.trump),
+        {record.hand, record.undefended, record.attacking, record.defending, record.discard});
+
+    DecisionRecord result = record;
+    result.trump = static_cast<uint8_t>(Suit::Clubs);
+    result.hand = permutation(record.hand);
+    result.undefended = permutation(record.undefended);
+    result.attacking = permutation(record.attacking);
+    result.defending = permutation(record.defending);
+    result.discard = permutation(record.discard);
+    return result;
+}
+
+void encodeFeatures(const DecisionRecord& record, float* features)
+{
+    std::fill(features, features + NUM_FEATURES, 0.0f);
+
+    auto encodePlane = [features](size_t plane, CardSet cards) {
+        for (auto mask = cards.mask(); mask != 0; mask &= mask - 1) {
+            features[plane + std::countr_zero(mask)] = 1.0f;
+        }
+    };
+    encodePlane(HAND_PLANE, record.hand);
+    encodePlane(UNDEFENDED_PLANE, record.undefended);
+    encodePlane(ATTACKING_PLANE, record.attacking);
+    encodePlane(DEFENDING_PLANE, record.defending);
+    encodePlane(DISCARD_PLANE, record.discard);
+    features[TRUMP_OFFSET + record.trump] = 1.0f;
+    features[KIND_OFFSET + static_cast<size_t>(record.kind)] = 1.0f;
+
+    float* scalars = features + SCALARS_OFFSET;
+    scalars[0] = record.hand.size() / 6.0f;
+    scalars[1] = record.numOtherCards / float(NUM_CARD_CODES);
+    scalars[2] = record.deckSize / float(NUM_CARD_CODES);
+    scalars[3] = record.numPlayers / 6.0f;
+    scalars[4] = 1.0f;
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "canonical.h"
+#include "protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace miplot::cardgame::durak {
+
+/*
+ * Input encoding of 36 card game decisions for neural policies.
+ * Card planes are one-hot over card codes:
+ *   hand, undefended, defended attacking, defended defending, discard,
+ * then trump suit and decision kind one-hot, then scalars:
+ *   own hand size / 6, cards of other players / 36, cards left in the deck / 36,
+ *   number of players / 6 and a constant 1
+ */
+constexpr size_t NUM_CARD_CODES = Card::Traits::radix();
+constexpr size_t NUM_FEATURES = 5 * NUM_CARD_CODES + 4 + 3 + 5;
+
+// Policy outputs: one per card code, then passing (fold or resign).
+// Same as the bits of legalActions()
+constexpr size_t NUM_ACTIONS = NUM_CARD_CODES + 1;
+constexpr size_t PASS_ACTION = NUM_CARD_CODES;
+
+// Compact description of a decision, enough to rebuild its features
+struct DecisionRecord {
+    protocol::DecisionKind kind = protocol::DecisionKind::Attack;
+    uint8_t trump = 0;
+    uint8_t numPlayers = 0;
+    uint8_t numOtherCards = 0;
+    uint8_t deckSize = 0;
+    CardSet hand;
+    CardSet undefended;
+    CardSet attacking;
+    CardSet defending;
+    CardSet discard;
+};
+
+DecisionRecord describeDecision(protocol::DecisionKind kind, const GameState& state, const Cards& hand);
+
+// The decision with suits relabeled canonically. permutation maps card codes
+// of the original decision to the canonical one. Samples are recorded and
+// networks queried canonically
+DecisionRecord canonicalize(const DecisionRecord& record, SuitPermutation& permutation);
+
+// Write NUM_FEATURES values
+void encodeFeatures(const DecisionRecord& record, float* features);
+
+} // namespace miplot::cardgame::durak
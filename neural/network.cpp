@@ -0,0 +1,370 @@
+#include "network.h"
+#include "exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+namespace miplot::nn {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'N', 'N'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t ALIGNMENT = 64;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numLayers;
+    uint32_t reserved;
+};
+
+struct LayerHeader {
+    uint32_t inSize;
+    uint32_t outSize;
+    uint8_t type;
+    uint8_t activation;
+    uint16_t reserved;
+    uint32_t reserved2;
+    uint64_t offset;
+};
+
+static_assert(sizeof(Header) == 16, "Unexpected network header size");
+static_assert(sizeof(LayerHeader) == 24, "Unexpected layer header size");
+
+size_t align(size_t offset)
+{
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/*
+ * Kernels use GCC vector extensions, compiled for AVX2 and for the baseline
+ * instruction set and picked at load time
+ */
+#if defined(__GNUC__) && defined(__x86_64__)
+#define NN_SIMD __attribute__((target_clones("avx2", "default")))
+#else
+#define NN_SIMD
+#endif
+
+constexpr size_t LANES = 8;
+typedef float FloatLanes __attribute__((vector_size(LANES * sizeof(float))));
+typedef int32_t IntLanes __attribute__((vector_size(LANES * sizeof(int32_t))));
+typedef int64_t QuadLanes __attribute__((vector_size(LANES * sizeof(int32_t))));
+
+/*
+ * Dense layers multiply rows in blocks of ROWS: every weight vector loaded
+ * is used for all rows of the block while the sums stay in registers.
+ * Only inputs nonzero in some row are visited, so sparse layers such as
+ * one-hot features go row by row. The batch goes through all layers in chunks
+ * of CHUNK rows to keep activations in cache
+ */
+constexpr size_t ROWS = 4;
+constexpr size_t CHUNK = 64;
+
+// Outputs are padded to whole vectors in the file and in activations
+size_t stride(const LayerSpec& spec)
+{
+    return (spec.outSize + LANES - 1) / LANES * LANES;
+}
+
+size_t weightsSize(const LayerSpec& spec)
+{
+    size_t count = spec.inSize * stride(spec);
+    return spec.type == LayerType::Float32 ? count * sizeof(float) : count;
+}
+
+size_t dataSize(const LayerSpec& spec)
+{
+    size_t numVectors = spec.type == LayerType::Float32 ? 1 : 2;
+    return weightsSize(spec) + numVectors * stride(spec) * sizeof(float);
+}
+
+// Indices of inputs nonzero in at least one of the rows
+template <size_t Rows>
+size_t findActive(const float* rows, size_t rowStride, size_t inSize, uint32_t* active)
+{
+    size_t numActive = 0;
+    for (size_t i = 0; i < inSize; ++i) {
+        bool nonzero = false;
+        for (size_t r = 0; r < Rows; ++r) {
+            nonzero |= rows[r * rowStride + i] != 0;
+        }
+        // Branchless, the pattern of zeros is not predictable
+        active[numActive] = i;
+        numActive += nonzero;
+    }
+    return numActive;
+}
+
+// y = x * W + bias for a block of rows
+template <size_t Rows>
+NN_SIMD void multiplyFloat(const float* weights, const float* bias, size_t outStride,
+                           const float* x, size_t xStride, const uint32_t* active, size_t numActive,
+                           float* y)
+{
+    for (size_t o = 0; o < outStride; o += LANES) {
+        FloatLanes sums[Rows];
+#pragma GCC unroll 4
+        for (size_t r = 0; r < Rows; ++r) {
+            std::memcpy(&sums[r], bias + o, sizeof(FloatLanes));
+        }
+        for (size_t k = 0; k < numActive; ++k) {
+            size_t i = active[k];
+            FloatLanes w;
+            std::memcpy(&w, weights + i * outStride + o, sizeof(w));
+#pragma GCC unroll 4
+            for (size_t r = 0; r < Rows; ++r) {
+                sums[r] += x[r * xStride + i] * w;
+            }
+        }
+#pragma GCC unroll 4
+        for (size_t r = 0; r < Rows; ++r) {
+            std::memcpy(y + r * outStride + o, &sums[r], sizeof(FloatLanes));
+        }
+    }
+}
+
+// Sign-extend LANES bytes to floats: every lane takes its 32-bit word of the
+// bytes and shifts the byte into the top. Direct conversion of a vector of bytes
+// compiles to scalar code
+inline void widen(const int8_t* bytes, FloatLanes& floats)
+{
+    const IntLanes WORDS = {0, 0, 0, 0, 1, 1, 1, 1};
+    const IntLanes SHIFTS = {24, 16, 8, 0, 24, 16, 8, 0};
+
+    int64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    QuadLanes quads = {value, value, value, value};
+    IntLanes words;
+    std::memcpy(&words, &quads, sizeof(words));
+    words = __builtin_shuffle(words, WORDS);
+    floats = __builtin_convertvector((words << SHIFTS) >> 24, FloatLanes);
+}
+
+// Same with int8 weights scaled per output
+template <size_t Rows>
+NN_SIMD void multiplyInt8(const int8_t* weights, const float* scale, const float* bias, size_t outStride,
+                          const float* x, size_t xStride, const uint32_t* active, size_t numActive,
+                          float* y)
+{
+    for (size_t o = 0; o < outStride; o += LANES) {
+        FloatLanes sums[Rows] = {};
+        for (size_t k = 0; k < numActive; ++k) {
+            size_t i = active[k];
+            FloatLanes w;
+            widen(weights + i * outStride + o, w);
+#pragma GCC unroll 4
+            for (size_t r = 0; r < Rows; ++r) {
+                sums[r] += x[r * xStride + i] * w;
+            }
+        }
+        FloatLanes scales, biases;
+        std::memcpy(&scales, scale + o, sizeof(scales));
+        std::memcpy(&biases, bias + o, sizeof(biases));
+#pragma GCC unroll 4
+        for (size_t r = 0; r < Rows; ++r) {
+            FloatLanes values = sums[r] * scales + biases;
+            std::memcpy(y + r * outStride + o, &values, sizeof(FloatLanes));
+        }
+    }
+}
+
+void activate(Activation activation, float* values, size_t size)
+{
+    if (activation == Activation::Relu) {
+        for (size_t i = 0; i < size; ++i) {
+            values[i] = std::max(values[i], 0.0f);
+        }
+    }
+}
+
+template <size_t Rows>
+void multiply(const LayerSpec& spec, const void* weights, const float* scale, const float* bias,
+              const float* x, size_t xStride, const uint32_t* active, size_t numActive, float* y)
+{
+    size_t outStride = stride(spec);
+    if (spec.type == LayerType::Float32) {
+        multiplyFloat<Rows>(static_cast<const float*>(weights), bias, outStride, x, xStride, active, numActive, y);
+    } else {
+        multiplyInt8<Rows>(static_cast<const int8_t*>(weights), scale, bias, outStride,
+                           x, xStride, active, numActive, y);
+    }
+    activate(spec.activation, y, Rows * outStride);
+}
+
+void dense(const LayerSpec& spec, const void* weights, const float* scale, const float* bias,
+           const float* x, size_t xStride, size_t numRows, float* y, Workspace& workspace)
+{
+    size_t outStride = stride(spec);
+    uint32_t* active = workspace.active.data();
+
+    // A step over a block costs about 2.5 steps over a row, while a block
+    // visits inputs nonzero in any of its rows. Sparse rows are cheaper one by one
+    size_t numNonzero = 0;
+    for (size_t row = 0; row < numRows; ++row) {
+        for (size_t i = 0; i < spec.inSize; ++i) {
+            numNonzero += x[row * xStride + i] != 0.0f;
+        }
+    }
+    double density = double(numNonzero) / (numRows * spec.inSize);
+    double blockDensity = 1.0 - std::pow(1.0 - density, ROWS);
+    bool useBlocks = 5 * blockDensity <= 2 * ROWS * density;
+
+    size_t row = 0;
+    for (; useBlocks && row + ROWS <= numRows; row += ROWS) {
+        const float* xs = x + row * xStride;
+        size_t numActive = findActive<ROWS>(xs, xStride, spec.inSize, active);
+        multiply<ROWS>(spec, weights, scale, bias, xs, xStride, active, numActive, y + row * outStride);
+    }
+    for (; row < numRows; ++row) {
+        const float* xr = x + row * xStride;
+        size_t numActive = findActive<1>(xr, xStride, spec.inSize, active);
+        multiply<1>(spec, weights, scale, bias, xr, xStride, active, numActive, y + row * outStride);
+    }
+}
+
+} // namespace
+
+Network Network::load(const std::string& path)
+{
+    Network network;
+    network.file_ = MappedFile::open(path);
+    const uint8_t* data = network.file_.data();
+    size_t size = network.file_.size();
+
+    REQUIRE(size >= sizeof(Header), "Network file is too short: " << path);
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    REQUIRE(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a network file: " << path);
+    REQUIRE(header.version == VERSION, "Unsupported network version: " << header.version);
+    REQUIRE(header.numLayers > 0 && sizeof(Header) + header.numLayers * sizeof(LayerHeader) <= size,
+            "Network file is truncated: " << path);
+
+    for (size_t idx = 0; idx < header.numLayers; ++idx) {
+        LayerHeader layerHeader;
+        std::memcpy(&layerHeader, data + sizeof(Header) + idx * sizeof(LayerHeader), sizeof(layerHeader));
+
+        LayerSpec spec{layerHeader.inSize, layerHeader.outSize,
+                       static_cast<LayerType>(layerHeader.type),
+                       static_cast<Activation>(layerHeader.activation)};
+        REQUIRE(spec.type == LayerType::Float32 || spec.type == LayerType::Int8,
+                "Unknown type of layer " << idx);
+        REQUIRE(spec.activation == Activation::None || spec.activation == Activation::Relu,
+                "Unknown activation of layer " << idx);
+        REQUIRE(spec.inSize > 0 && spec.outSize > 0, "Empty layer " << idx);
+        REQUIRE(idx == 0 || network.layers_.back().spec.outSize == spec.inSize,
+                "Layer " << idx << " does not match the previous one");
+        REQUIRE(layerHeader.offset % ALIGNMENT == 0 && layerHeader.offset <= size
+                && dataSize(spec) <= size - layerHeader.offset,
+                "Data of layer " << idx << " is out of the file");
+
+        const uint8_t* weights = data + layerHeader.offset;
+        const auto* vectors = reinterpret_cast<const float*>(weights + weightsSize(spec));
+        Layer layer{spec, weights, nullptr, vectors};
+        if (spec.type == LayerType::Int8) {
+            layer.scale = vectors;
+            layer.bias = vectors + stride(spec);
+        }
+        network.layers_.push_back(layer);
+        network.maxWidth_ = std::max({network.maxWidth_, spec.inSize, stride(spec)});
+    }
+    return network;
+}
+
+void Network::writeRandom(const std::string& path, const std::vector<LayerSpec>& layers, uint64_t seed)
+{
+    REQUIRE(!layers.empty(), "Network has no layers");
+    std::mt19937_64 rng(seed);
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.numLayers = layers.size();
+
+    std::vector<uint8_t> data(align(sizeof(Header) + layers.size() * sizeof(LayerHeader)));
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    for (size_t idx = 0; idx < layers.size(); ++idx) {
+        const auto& spec = layers[idx];
+        REQUIRE(idx == 0 || layers[idx - 1].outSize == spec.inSize,
+                "Layer " << idx << " does not match the previous one");
+
+        LayerHeader layerHeader{};
+        layerHeader.inSize = spec.inSize;
+        layerHeader.outSize = spec.outSize;
+        layerHeader.type = static_cast<uint8_t>(spec.type);
+        layerHeader.activation = static_cast<uint8_t>(spec.activation);
+        layerHeader.offset = data.size();
+        std::memcpy(data.data() + sizeof(Header) + idx * sizeof(LayerHeader), &layerHeader, sizeof(layerHeader));
+
+        // Padding outputs get zero weights and stay zero
+        size_t outStride = stride(spec);
+        std::normal_distribution<float> init(0.0f, std::sqrt(2.0f / spec.inSize));
+        std::vector<float> weights(spec.inSize * outStride, 0.0f);
+        for (size_t i = 0; i < spec.inSize; ++i) {
+            for (size_t o = 0; o < spec.outSize; ++o) {
+                weights[i * outStride + o] = init(rng);
+            }
+        }
+        std::vector<float> bias(outStride, 0.0f);
+
+        size_t offset = data.size();
+        data.resize(align(offset + dataSize(spec)));
+        uint8_t* out = data.data() + offset;
+        if (spec.type == LayerType::Float32) {
+            std::memcpy(out, weights.data(), weights.size() * sizeof(float));
+            std::memcpy(out + weightsSize(spec), bias.data(), bias.size() * sizeof(float));
+        } else {
+            // Symmetric quantization per output
+            std::vector<float> scale(outStride, 0.0f);
+            for (size_t i = 0; i < weights.size(); ++i) {
+                scale[i % outStride] = std::max(scale[i % outStride], std::fabs(weights[i]) / 127.0f);
+            }
+            for (size_t i = 0; i < weights.size(); ++i) {
+                float s = scale[i % outStride];
+                out[i] = static_cast<uint8_t>(static_cast<int8_t>(s > 0 ? std::lrint(weights[i] / s) : 0));
+            }
+            std::memcpy(out + weightsSize(spec), scale.data(), scale.size() * sizeof(float));
+            std::memcpy(out + weightsSize(spec) + scale.size() * sizeof(float),
+                        bias.data(), bias.size() * sizeof(float));
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    REQUIRE(file, "Cannot create " << path);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    REQUIRE(file, "Cannot write " << path);
+}
+
+void Network::forward(const float* inputs, size_t batchSize, float* outputs, Workspace& workspace) const
+{
+    size_t inSize = inputSize();
+    for (auto& buffer : workspace.activations) {
+        buffer.resize(CHUNK * maxWidth_);
+    }
+    workspace.active.resize(maxWidth_);
+
+    for (size_t start = 0; start < batchSize; start += CHUNK) {
+        size_t numRows = std::min(CHUNK, batchSize - start);
+        const float* x = inputs + start * inSize;
+        size_t xStride = inSize;
+        for (size_t idx = 0; idx < layers_.size(); ++idx) {
+            const auto& layer = layers_[idx];
+            float* y = workspace.activations[idx % 2].data();
+            dense(layer.spec, layer.weights, layer.scale, layer.bias, x, xStride, numRows, y, workspace);
+            x = y;
+            xStride = stride(layer.spec);
+        }
+
+        size_t outSize = outputSize();
+        for (size_t row = 0; row < numRows; ++row) {
+            std::copy(x + row * xStride, x + row * xStride + outSize, outputs + (start + row) * outSize);
+        }
+    }
+}
+
+} // namespace miplot::nn
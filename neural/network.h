@@ -0,0 +1,72 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace miplot::nn {
+
+enum class LayerType : uint8_t { Float32, Int8 };
+enum class Activation : uint8_t { None, Relu };
+
+struct LayerSpec {
+    size_t inSize;
+    size_t outSize;
+    LayerType type = LayerType::Float32;
+    Activation activation = Activation::Relu;
+};
+
+// Scratch buffers of forward passes, reused between calls
+struct Workspace {
+    std::vector<float> activations[2];
+    std::vector<uint32_t> active;
+};
+
+/**
+ * Multilayer perceptron evaluated on CPU, with weights used in place from
+ * a memory-mapped file. Weights of a layer are stored input-major, so that
+ * a forward pass adds scaled weight rows and skips zero inputs. Rows of dense
+ * layers share weight loads within a batch.
+ *
+ * File layout, host byte order:
+ *   header: "DKNN", uint32 version, uint32 number of layers, uint32 reserved
+ *   layer headers: uint32 in, uint32 out, uint8 type, uint8 activation,
+ *                  uint16 reserved, uint32 reserved, uint64 data offset
+ *   layer data at 64 byte aligned offsets, outputs padded with zeros to a multiple of 8:
+ *     Float32: float weights[in][out], float bias[out]
+ *     Int8: int8 weights[in][out], float scale[out], float bias[out]
+ * Int8 layers keep a quarter of the weights in memory and cache: weights are
+ * quantized per output and widened to float on the fly
+ */
+class Network {
+public:
+    static Network load(const std::string& path);
+
+    // Write a network with random weights (He initialization)
+    static void writeRandom(const std::string& path, const std::vector<LayerSpec>& layers, uint64_t seed);
+
+    size_t inputSize() const { return layers_.front().spec.inSize; }
+    size_t outputSize() const { return layers_.back().spec.outSize; }
+    size_t numLayers() const { return layers_.size(); }
+    const LayerSpec& layer(size_t idx) const { return layers_[idx].spec; }
+
+    // inputs are [batchSize][inputSize], outputs are [batchSize][outputSize]
+    void forward(const float* inputs, size_t batchSize, float* outputs, Workspace& workspace) const;
+
+private:
+    struct Layer {
+        LayerSpec spec;
+        const void* weights;
+        const float* scale;
+        const float* bias;
+    };
+
+    MappedFile file_;
+    std::vector<Layer> layers_;
+    size_t maxWidth_ = 0;
+};
+
+} // namespace miplot::nn
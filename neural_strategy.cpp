@@ -0,0 +1,131 @@
+#include "neural_strategy.h"
+#include "exception.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+using protocol::DecisionKind;
+
+int cardIdxOf(size_t action, const Cards& hand)
+{
+    if (action == PASS_ACTION) {
+        return -1;
+    }
+    for (size_t idx = 0; idx < hand.size(); ++idx) {
+        if (hand[idx].code() == action) {
+            return idx;
+        }
+    }
+    throw Exception() << "Action " << action << " is not in hand";
+}
+
+} // namespace
+
+InferenceBatcher::InferenceBatcher(std::shared_ptr<const nn::Network> network, size_t maxBatchSize)
+    : network_(std::move(network))
+    , maxBatchSize_(maxBatchSize)
+{
+    REQUIRE(network_->inputSize() == NUM_FEATURES,
+            "Network takes " << network_->inputSize() << " inputs instead of " << NUM_FEATURES);
+    REQUIRE(network_->outputSize() == NUM_ACTIONS,
+            "Network has " << network_->outputSize() << " outputs instead of " << NUM_ACTIONS);
+    REQUIRE(maxBatchSize_ > 0, "Batch size must be positive");
+}
+
+void InferenceBatcher::enqueue(DecisionKind kind, const GameState& state, const Cards& hand,
+                               uint64_t legal, async::DecisionSlot<int>& slot)
+{
+    size_t row = queued_.size();
+    inputs_.resize((row + 1) * NUM_FEATURES);
+    // The network sees suits relabeled as in the samples it was trained on
+    SuitPermutation permutation;
+    DecisionRecord record = canonicalize(describeDecision(kind, state, hand), permutation);
+    encodeFeatures(record, inputs_.data() + row * NUM_FEATURES);
+
+    uint64_t passBit = uint64_t(1) << PASS_ACTION;
+    uint64_t canonicalLegal = permutation(CardSet(legal & ~passBit)).mask() | (legal & passBit);
+    queued_.push_back(Queued{&hand, canonicalLegal, permutation.inverse(), &slot});
+}
+
+void InferenceBatcher::evaluate()
+{
+    // Resolving slots does not resume games, so the queue stays intact until the end
+    for (size_t start = 0; start < queued_.size(); start += maxBatchSize_) {
+        size_t batchSize = std::min(maxBatchSize_, queued_.size() - start);
+        outputs_.resize(batchSize * NUM_ACTIONS);
+        network_->forward(inputs_.data() + start * NUM_FEATURES, batchSize, outputs_.data(), workspace_);
+        ++stats_.batches;
+
+        for (size_t row = 0; row < batchSize; ++row) {
+            const auto& queued = queued_[start + row];
+            const float* scores = outputs_.data() + row * NUM_ACTIONS;
+
+            size_t best = PASS_ACTION;
+            float bestScore = -std::numeric_limits<float>::infinity();
+            for (uint64_t legal = queued.legal; legal != 0; legal &= legal - 1) {
+                size_t action = std::countr_zero(legal);
+                if (scores[action] > bestScore) {
+                    bestScore = scores[action];
+                    best = action;
+                }
+            }
+            if (best != PASS_ACTION) {
+                best = queued.toOriginal(best);
+            }
+            queued.slot->resolve(cardIdxOf(best, *queued.hand));
+        }
+    }
+    stats_.decisions += queued_.size();
+    queued_.clear();
+    inputs_.clear();
+}
+
+
+NeuralStrategy::NeuralStrategy(std::shared_ptr<InferenceBatcher> batcher)
+    : batcher_(std::move(batcher))
+{
+}
+
+async::Decision<int> NeuralStrategy::attackAsync(const GameState& state, const Cards& hand,
+                                                 async::DecisionSlot<int>& slot)
+{
+    return decide(DecisionKind::Attack, state, hand, slot);
+}
+
+async::Decision<int> NeuralStrategy::defendAsync(const GameState& state, const Cards& hand,
+                                                 async::DecisionSlot<int>& slot)
+{
+    return decide(DecisionKind::Defend, state, hand, slot);
+}
+
+async::Decision<int> NeuralStrategy::transferAsync(const GameState& state, const Cards& hand,
+                                                   async::DecisionSlot<int>& slot)
+{
+    return decide(DecisionKind::Transfer, state, hand, slot);
+}
+
+const std::string& NeuralStrategy::name() const
+{
+    static const std::string NAME = "Neural";
+    return NAME;
+}
+
+async::Decision<int> NeuralStrategy::decide(DecisionKind kind, const GameState& state, const Cards& hand,
+                                            async::DecisionSlot<int>& slot)
+{
+    uint64_t legal = legalActions(kind, state, hand);
+    if (std::has_single_bit(legal)) {
+        ++batcher_->stats_.decisions;
+        ++batcher_->stats_.forced;
+        return cardIdxOf(std::countr_zero(legal), hand);
+    }
+    batcher_->enqueue(kind, state, hand, legal, slot);
+    return slot.pending();
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "async_game.h"
+#include "neural/features.h"
+#include "neural/network.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+struct InferenceStats {
+    size_t decisions = 0;
+    // Decisions taken without the network: a single legal action
+    size_t forced = 0;
+    size_t batches = 0;
+};
+
+/**
+ * Collects decisions of many concurrent games and evaluates them with one
+ * forward pass per batch. Games have to be driven by a loop running the
+ * scheduler until it has nothing ready and calling evaluate()
+ */
+class InferenceBatcher {
+public:
+    explicit InferenceBatcher(std::shared_ptr<const nn::Network> network, size_t maxBatchSize = 1024);
+
+    // Queue a decision, the slot is resolved by evaluate()
+    void enqueue(protocol::DecisionKind kind, const GameState& state, const Cards& hand,
+                 uint64_t legal, async::DecisionSlot<int>& slot);
+
+    // Evaluate all queued decisions and resolve their slots
+    void evaluate();
+
+    size_t numQueued() const { return queued_.size(); }
+
+    const InferenceStats& stats() const { return stats_; }
+
+private:
+    friend class NeuralStrategy;
+
+    struct Queued {
+        const Cards* hand;
+        // Legal actions in canonical codes, toOriginal maps the chosen one back
+        uint64_t legal;
+        SuitPermutation toOriginal;
+        async::DecisionSlot<int>* slot;
+    };
+
+    std::shared_ptr<const nn::Network> network_;
+    size_t maxBatchSize_;
+
+    std::vector<Queued> queued_;
+    std::vector<float> inputs_;
+    std::vector<float> outputs_;
+    nn::Workspace workspace_;
+
+    InferenceStats stats_;
+};
+
+/**
+ * Plays the legal action with the highest network output. Seats of any
+ * number of games may share one batcher
+ */
+class NeuralStrategy : public AsyncStrategy {
+public:
+    explicit NeuralStrategy(std::shared_ptr<InferenceBatcher> batcher);
+
+    async::Decision<int> attackAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override;
+
+    async::Decision<int> defendAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override;
+
+    async::Decision<int> transferAsync(const GameState& state, const Cards& hand,
+                                       async::DecisionSlot<int>& slot) override;
+
+    const std::string& name() const override;
+
+private:
+    async::Decision<int> decide(protocol::DecisionKind kind, const GameState& state, const Cards& hand,
+                                async::DecisionSlot<int>& slot);
+
+    std::shared_ptr<InferenceBatcher> batcher_;
+};
+
+} // namespace miplot::cardgame::durak
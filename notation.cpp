@@ -0,0 +1,329 @@
+#include "notation.h"
+
+namespace miplot::cardgame::durak::notation {
+
+namespace {
+
+void appendNumber(std::string& out, size_t value)
+{
+    char digits[20];
+    size_t size = 0;
+    do {
+        digits[size++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (size) {
+        out += digits[--size];
+    }
+}
+
+// Appends size cards from codes, advancing codes
+template <typename CardTraits>
+void appendCodes(std::string& out, const uint8_t*& codes, size_t size)
+{
+    if (size == 0) {
+        out += '-';
+    }
+    for (size_t i = 0; i < size; ++i) {
+        CardNotation<CardTraits>::append(out, *codes++);
+    }
+}
+
+} // namespace
+
+template <typename CardTraits>
+void appendPosition(std::string& out, const BasicPosition<CardTraits>& position)
+{
+    out += SUITS[static_cast<size_t>(position.trump)];
+    out += ' ';
+    const uint8_t* codes = position.codes.data();
+    for (size_t idx = 0; idx < position.numPlayers; ++idx) {
+        if (idx > 0) {
+            out += '/';
+        }
+        appendCodes<CardTraits>(out, codes, position.handSizes[idx]);
+    }
+    for (size_t size : {position.numUndefended, 2 * position.numDefended, position.numDiscarded,
+                        position.deckSize()}) {
+        out += ' ';
+        appendCodes<CardTraits>(out, codes, size);
+    }
+
+    // Main attacker, current attacker, defender
+    out += ' ';
+    appendNumber(out, position.mainAttackerIdx);
+    out += ',';
+    appendNumber(out, position.curAttackerIdx);
+    out += ',';
+    appendNumber(out, position.defenderIdx);
+    // Bouts, folds, attackers, resign flag
+    out += ' ';
+    appendNumber(out, position.numBouts);
+    for (size_t value : {position.numFolds, position.numAttackers, size_t(position.resign)}) {
+        out += ',';
+        appendNumber(out, value);
+    }
+    out += ' ';
+    for (size_t idx = 0; idx < position.numPlayers; ++idx) {
+        if (idx > 0) {
+            out += '/';
+        }
+        appendNumber(out, position.outAfterBout[idx]);
+    }
+}
+
+template <typename CardTraits>
+void parsePosition(std::string_view text, BasicPosition<CardTraits>& position)
+{
+    using Position = BasicPosition<CardTraits>;
+
+    Parser<CardTraits> in(text);
+    REQUIRE(!in.atEnd(), "Empty position");
+    size_t trump = SUITS.find(text[0]);
+    REQUIRE(trump != std::string_view::npos, "Invalid trump suit '" << text[0] << "'");
+    in.skip(text[0]);
+    in.expect(' ');
+    position = Position();
+    position.trump = static_cast<typename Position::Suit>(trump);
+
+    size_t numCards = 0;
+    auto cards = [&]() {
+        size_t size = in.cards(position.codes.data() + numCards, position.codes.size() - numCards);
+        numCards += size;
+        return size;
+    };
+    do {
+        REQUIRE(position.numPlayers < Position::MAX_PLAYERS,
+                "More than " << Position::MAX_PLAYERS << " hands at " << in.pos());
+        position.handSizes[position.numPlayers++] = cards();
+    } while (in.skip('/'));
+    in.expect(' ');
+    position.numUndefended = cards();
+    in.expect(' ');
+    size_t numDefended = cards();
+    REQUIRE(numDefended % 2 == 0, "Defended cards without their defense");
+    position.numDefended = numDefended / 2;
+    in.expect(' ');
+    position.numDiscarded = cards();
+    in.expect(' ');
+    cards();
+    REQUIRE(numCards == position.codes.size(), "Position has " << numCards << " of " << position.codes.size() << " cards");
+
+    auto player = [&]() {
+        size_t idx = in.number();
+        REQUIRE(idx < position.numPlayers, "Invalid player at " << in.pos());
+        return idx;
+    };
+    in.expect(' ');
+    position.mainAttackerIdx = player();
+    in.expect(',');
+    position.curAttackerIdx = player();
+    in.expect(',');
+    position.defenderIdx = player();
+
+    in.expect(' ');
+    position.numBouts = in.number();
+    for (size_t* value : {&position.numFolds, &position.numAttackers}) {
+        in.expect(',');
+        *value = in.number();
+        REQUIRE(*value <= UINT8_MAX, "Invalid bout progress at " << in.pos());
+    }
+    in.expect(',');
+    size_t resign = in.number();
+    REQUIRE(resign <= 1, "Invalid resign flag");
+    position.resign = resign;
+
+    in.expect(' ');
+    for (size_t idx = 0; idx < position.numPlayers; ++idx) {
+        if (idx > 0) {
+            in.expect('/');
+        }
+        position.outAfterBout[idx] = in.number();
+    }
+    REQUIRE(in.atEnd(), "Trailing characters in position at " << in.pos());
+}
+
+template void appendPosition(std::string& out, const BasicPosition<cards::Std24CardTraits>& position);
+template void appendPosition(std::string& out, const BasicPosition<cards::Std36CardTraits>& position);
+template void appendPosition(std::string& out, const BasicPosition<cards::Std52CardTraits>& position);
+
+template void parsePosition(std::string_view text, BasicPosition<cards::Std24CardTraits>& position);
+template void parsePosition(std::string_view text, BasicPosition<cards::Std36CardTraits>& position);
+template void parsePosition(std::string_view text, BasicPosition<cards::Std52CardTraits>& position);
+
+template <typename CardTraits>
+BasicNotatedGame<CardTraits>::BasicNotatedGame(Players&& players, Rules rules)
+    : Base(std::move(players), rules)
+    , clean_(this->position())
+{
+    REQUIRE(!rules.batchedAttacks, "Batched attacks have no notation");
+}
+
+template <typename CardTraits>
+RoundResult BasicNotatedGame<CardTraits>::playRound(size_t firstAttackerIdx, std::string& out)
+{
+    return playRound(firstAttackerIdx, nullptr, out);
+}
+
+template <typename CardTraits>
+RoundResult BasicNotatedGame<CardTraits>::playRound(size_t firstAttackerIdx, const typename Deck::Order& order,
+                                                    std::string& out)
+{
+    return playRound(firstAttackerIdx, &order, out);
+}
+
+template <typename CardTraits>
+RoundResult BasicNotatedGame<CardTraits>::playRound(size_t firstAttackerIdx, const typename Deck::Order* order,
+                                                    std::string& out)
+{
+    using Notation = CardNotation<CardTraits>;
+
+    reset();
+    this->startRound(firstAttackerIdx, order);
+
+    // The deck before dealing: hands in turn, then the trump card, which was
+    // moved from the top to the bottom, and the rest of the deck
+    for (const auto& player : this->players()) {
+        for (const auto& card : player.hand()) {
+            Notation::append(out, card.code());
+        }
+    }
+    const auto& deck = this->deck().cards();
+    if (!deck.empty()) {
+        Notation::append(out, deck.back().code());
+        for (size_t i = 0; i + 1 < deck.size(); ++i) {
+            Notation::append(out, deck[i].code());
+        }
+    }
+    out += ' ';
+    appendNumber(out, firstAttackerIdx);
+
+    // Steps of BasicGame::playBout(), writing down every decision
+    while (!this->isFinished()) {
+        this->beginBout();
+        while (this->boutContinues()) {
+            int attackIdx = -1;
+            bool decides = this->curAttacker().numCards() > 0;
+            if (decides) {
+                attackIdx = this->curAttacker().attack(this->state());
+            }
+            if (!this->applyAttack(attackIdx)) {
+                if (decides) {
+                    out += " -";
+                }
+                continue;
+            }
+            out += ' ';
+            Notation::append(out, this->undefendedCards().back().code());
+
+            while (this->needsDefense()) {
+                if (this->canTransfer() && this->applyTransfer(this->defender().transfer(this->state()))) {
+                    out += " >";
+                    Notation::append(out, this->undefendedCards().back().code());
+                    continue;
+                }
+                int defenseIdx = this->defender().defend(this->state());
+                this->applyDefense(defenseIdx);
+                if (defenseIdx == -1) {
+                    out += " -";
+                } else {
+                    out += ' ';
+                    Notation::append(out, this->defendedCards().back().defending.code());
+                }
+            }
+        }
+        this->finishBout(this->endBout());
+    }
+    return this->finishRound();
+}
+
+template <typename CardTraits>
+RoundResult BasicNotatedGame<CardTraits>::replay(std::string_view round)
+{
+    REQUIRE(seek(round, SIZE_MAX), "Round is not over after its moves");
+    inRound_ = false;
+    return this->finishRound();
+}
+
+template <typename CardTraits>
+bool BasicNotatedGame<CardTraits>::seek(std::string_view round, size_t numMoves)
+{
+    reset();
+    Parser<CardTraits> in(round);
+    typename Deck::Order order;
+    size_t numCards = in.cards(order.data(), order.size());
+    REQUIRE(numCards == order.size(), "Round deals " << numCards << " of " << order.size() << " cards");
+    in.expect(' ');
+    size_t firstAttackerIdx = in.number();
+    REQUIRE(firstAttackerIdx < this->numPlayers(), "Invalid first attacker " << firstAttackerIdx);
+
+    this->startRound(firstAttackerIdx, &order);
+    inRound_ = true;
+    this->beginBout();
+    finished_ = this->advanceToDecision();
+
+    for (size_t i = 0; i < numMoves && in.separator(); ++i) {
+        REQUIRE(!finished_, "Move after the end of the round at " << in.pos());
+        size_t pos = in.pos();
+        Move move = in.move();
+        try {
+            apply(move);
+        } catch (const Exception& e) {
+            throw Exception() << "Move " << i + 1 << " at " << pos << ": " << e.what();
+        }
+        finished_ = this->advanceToDecision();
+    }
+    return finished_;
+}
+
+template <typename CardTraits>
+void BasicNotatedGame<CardTraits>::reset()
+{
+    if (inRound_) {
+        // Gather the cards of an unfinished replay
+        this->setPosition(clean_);
+        inRound_ = false;
+    }
+}
+
+template <typename CardTraits>
+int BasicNotatedGame<CardTraits>::cardIdx(size_t playerIdx, uint8_t code) const
+{
+    const auto& hand = this->players()[playerIdx].hand();
+    for (size_t idx = 0; idx < hand.size(); ++idx) {
+        if (hand[idx].code() == code) {
+            return idx;
+        }
+    }
+    std::string card;
+    CardNotation<CardTraits>::append(card, code);
+    throw Exception() << "Player " << playerIdx << " has no " << card;
+}
+
+template <typename CardTraits>
+void BasicNotatedGame<CardTraits>::apply(const Move& move)
+{
+    if (!this->needsDefense()) {
+        REQUIRE(move.type != MoveType::Transfer, "Transfer without an attack");
+        this->applyAttack(move.type == MoveType::Pass ? -1 : cardIdx(this->curAttackerIdx(), move.code));
+        return;
+    }
+    switch (move.type) {
+        case MoveType::Transfer:
+            REQUIRE(this->canTransfer(), "Transfer is not allowed");
+            this->applyTransfer(cardIdx(this->defenderIdx(), move.code));
+            break;
+        case MoveType::Pass:
+            this->applyDefense(-1);
+            break;
+        case MoveType::Card:
+            this->applyDefense(cardIdx(this->defenderIdx(), move.code));
+            break;
+    }
+}
+
+template class BasicNotatedGame<cards::Std24CardTraits>;
+template class BasicNotatedGame<cards::Std36CardTraits>;
+template class BasicNotatedGame<cards::Std52CardTraits>;
+
+} // namespace miplot::cardgame::durak::notation
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "exception.h"
+#include "game.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace miplot::cardgame::durak::notation {
+
+/*
+ * Compact ASCII notation of cards, moves, rounds and positions.
+ *
+ * Card: rank 2-9, T, J, Q, K or A, then suit c, d, h or s: "Th" is the ten of hearts.
+ * Card list: cards without separators, "-" if empty: "6c7cTh".
+ *
+ * Move, moves are separated by a space:
+ *   card   attack, or defense of the oldest undefended card
+ *   >card  transfer
+ *   -      attacker folds or defender takes the cards
+ * Attackers without cards fold without a move.
+ *
+ * Round: the deck before dealing from the top, the first attacker and the
+ * moves: "6c7c...As 0 7c 8c - ...". Players and rules are not included.
+ *
+ * Position, fields separated by a space:
+ *   trump suit, hands separated by "/", undefended cards, defended cards
+ *   (every attacking card followed by its defense), discard, deck from the top,
+ *   "main attacker,current attacker,defender", "bouts,folds,attackers,resigned"
+ *   and the bout after which every player ran out of cards, separated by "/":
+ *   "d 6c7h/9s - - - Ah... 0,0,1 3,0,1,0 0/0"
+ * A position is BasicGame::position(), without the deck's random generator.
+ *
+ * Cards are formatted from tables, nothing is formatted through a stream and
+ * parsing allocates nothing. Errors throw Exception
+ */
+
+constexpr std::string_view RANKS = "23456789TJQKA";
+constexpr std::string_view SUITS = "cdhs";
+
+template <typename CardTraits>
+class CardNotation {
+public:
+    static constexpr size_t RADIX = CardTraits::radix();
+
+    // Two characters of a card
+    static char* format(char* out, size_t code)
+    {
+        out[0] = NAMES[code][0];
+        out[1] = NAMES[code][1];
+        return out + 2;
+    }
+
+    static void append(std::string& out, size_t code) { out.append(NAMES[code].data(), 2); }
+
+    // Code of a card, -1 if the characters are not a card of the deck
+    static int parse(char rank, char suit)
+    {
+        int rankIdx = rank >= 0 ? RANK_CODES[static_cast<uint8_t>(rank)] : -1;
+        int suitIdx = suit >= 0 ? SUIT_CODES[static_cast<uint8_t>(suit)] : -1;
+        if (rankIdx < 0 || suitIdx < 0) {
+            return -1;
+        }
+        return suitIdx * CardTraits::numRanks() + rankIdx;
+    }
+
+private:
+    // Lowest ranks are missing from short decks
+    static constexpr size_t FIRST_RANK = RANKS.size() - CardTraits::numRanks();
+
+    static constexpr std::array<std::array<char, 2>, RADIX> makeNames()
+    {
+        std::array<std::array<char, 2>, RADIX> names{};
+        for (size_t code = 0; code < RADIX; ++code) {
+            names[code][0] = RANKS[FIRST_RANK + code % CardTraits::numRanks()];
+            names[code][1] = SUITS[code / CardTraits::numRanks()];
+        }
+        return names;
+    }
+
+    static constexpr std::array<int8_t, 128> makeCodes(std::string_view chars, size_t first)
+    {
+        std::array<int8_t, 128> codes{};
+        codes.fill(-1);
+        for (size_t idx = first; idx < chars.size(); ++idx) {
+            codes[static_cast<uint8_t>(chars[idx])] = idx - first;
+        }
+        return codes;
+    }
+
+    static constexpr auto NAMES = makeNames();
+    static constexpr auto RANK_CODES = makeCodes(RANKS, FIRST_RANK);
+    static constexpr auto SUIT_CODES = makeCodes(SUITS, 0);
+};
+
+enum class MoveType { Card, Transfer, Pass };
+
+struct Move {
+    MoveType type = MoveType::Pass;
+    uint8_t code = 0;
+};
+
+/**
+ * Reads notation from a string without copying it. Fields and moves are
+ * separated by single spaces
+ */
+template <typename CardTraits>
+class Parser {
+public:
+    using Notation = CardNotation<CardTraits>;
+
+    explicit Parser(std::string_view text) : text_(text) {}
+
+    bool atEnd() const { return pos_ == text_.size(); }
+    size_t pos() const { return pos_; }
+
+    uint8_t card()
+    {
+        REQUIRE(text_.size() - pos_ >= 2, "Card expected at " << pos_);
+        int code = Notation::parse(text_[pos_], text_[pos_ + 1]);
+        REQUIRE(code >= 0, "Invalid card '" << text_.substr(pos_, 2) << "' at " << pos_);
+        pos_ += 2;
+        return code;
+    }
+
+    // Reads a card list to codes, returns their number
+    size_t cards(uint8_t* codes, size_t capacity)
+    {
+        if (skip('-')) {
+            return 0;
+        }
+        size_t size = 0;
+        while (pos_ < text_.size() && text_[pos_] != ' ' && text_[pos_] != '/') {
+            REQUIRE(size < capacity, "Too many cards at " << pos_);
+            codes[size++] = card();
+        }
+        REQUIRE(size > 0, "Cards expected at " << pos_);
+        return size;
+    }
+
+    size_t number()
+    {
+        size_t start = pos_;
+        size_t value = 0;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') {
+            value = value * 10 + (text_[pos_++] - '0');
+        }
+        REQUIRE(pos_ > start, "Number expected at " << start);
+        return value;
+    }
+
+    Move move()
+    {
+        if (skip('-')) {
+            return {MoveType::Pass, 0};
+        }
+        if (skip('>')) {
+            return {MoveType::Transfer, card()};
+        }
+        return {MoveType::Card, card()};
+    }
+
+    bool skip(char c)
+    {
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        REQUIRE(skip(c), "'" << c << "' expected at " << pos_);
+    }
+
+    // Space between fields or moves, false at the end
+    bool separator()
+    {
+        if (atEnd()) {
+            return false;
+        }
+        expect(' ');
+        return true;
+    }
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+};
+
+template <typename Cards>
+void appendCards(std::string& out, const Cards& cards)
+{
+    using Notation = CardNotation<typename Cards::value_type::Traits>;
+    if (cards.empty()) {
+        out += '-';
+    }
+    for (const auto& card : cards) {
+        Notation::append(out, card.code());
+    }
+}
+
+template <typename CardTraits>
+void appendMove(std::string& out, const Move& move)
+{
+    if (move.type == MoveType::Pass) {
+        out += '-';
+        return;
+    }
+    if (move.type == MoveType::Transfer) {
+        out += '>';
+    }
+    CardNotation<CardTraits>::append(out, move.code);
+}
+
+// Appends the notation of a game's position
+template <typename CardTraits>
+void appendPosition(std::string& out, const BasicPosition<CardTraits>& position);
+
+// Replaces position with a parsed one, to be set on a game with as many players
+template <typename CardTraits>
+void parsePosition(std::string_view text, BasicPosition<CardTraits>& position);
+
+template <typename CardTraits>
+BasicPosition<CardTraits> parsePosition(std::string_view text)
+{
+    BasicPosition<CardTraits> result;
+    parsePosition(text, result);
+    return result;
+}
+
+/**
+ * Game that writes down its rounds and replays written ones, driven through
+ * the round steps like ExploitabilityEvaluator. Batched attacks have no notation
+ */
+template <typename CardTraits>
+class BasicNotatedGame : public BasicGame<CardTraits> {
+public:
+    using Base = BasicGame<CardTraits>;
+    using typename Base::Deck;
+    using typename Base::Players;
+
+    BasicNotatedGame(Players&& players, Rules rules = Rules());
+
+    // Play a round like playRound(), appending its notation to out
+    RoundResult playRound(size_t firstAttackerIdx, std::string& out);
+    RoundResult playRound(size_t firstAttackerIdx, const typename Deck::Order& order, std::string& out);
+
+    // Replay a whole round, checking its moves against the rules
+    RoundResult replay(std::string_view round);
+
+    /**
+     * Replay the first numMoves moves of a round, or all of them, and stay at
+     * the next decision or the end of the round for snapshot().
+     * Returns whether the round is over
+     */
+    bool seek(std::string_view round, size_t numMoves);
+
+private:
+    RoundResult playRound(size_t firstAttackerIdx, const typename Deck::Order* order, std::string& out);
+
+    // Gather the cards of a round left unfinished by seek()
+    void reset();
+
+    int cardIdx(size_t playerIdx, uint8_t code) const;
+    void apply(const Move& move);
+
+    // Position of the game before any round
+    typename Base::Position clean_;
+    bool inRound_ = false;
+    // Whether the round of seek() is over, a player may run out of cards mid-bout
+    bool finished_ = false;
+};
+
+using NotatedGame = BasicNotatedGame<cards::Std36CardTraits>;
+
+} // namespace miplot::cardgame::durak::notation
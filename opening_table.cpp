@@ -0,0 +1,160 @@
+#include "opening_table.h"
+#include "canonical.h"
+#include "exception.h"
+
+#include <array>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'O', 'T'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t RADIX = Card::Traits::radix();
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t minPlayers;
+    uint32_t maxPlayers;
+    uint64_t numHands;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(Header) == 32, "Unexpected opening table header size");
+
+using BinomialTable = std::array<std::array<uint64_t, OpeningTable::HAND_SIZE + 1>, RADIX + 1>;
+
+constexpr BinomialTable makeBinomials()
+{
+    BinomialTable c{};
+    for (size_t n = 0; n <= RADIX; ++n) {
+        c[n][0] = 1;
+        for (size_t k = 1; k <= OpeningTable::HAND_SIZE && k <= n; ++k) {
+            c[n][k] = c[n - 1][k - 1] + (k < n ? c[n - 1][k] : 0);
+        }
+    }
+    return c;
+}
+
+constexpr BinomialTable BINOMIALS = makeBinomials();
+
+const Header& header(const MappedFile& file)
+{
+    return *reinterpret_cast<const Header*>(file.data());
+}
+
+} // namespace
+
+OpeningTable::OpeningTable(MappedFile file)
+    : file_(std::move(file))
+{
+    REQUIRE(file_.size() >= sizeof(Header), "Opening table is too short");
+    const auto& h = header(file_);
+    REQUIRE(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0, "Not an opening table");
+    REQUIRE(h.version == VERSION, "Unsupported opening table version: " << h.version);
+    REQUIRE(h.numHands == numHands(), "Opening table has unexpected number of hands");
+    REQUIRE(h.minPlayers <= h.maxPlayers
+            && file_.size() >= sizeof(Header) + (h.maxPlayers - h.minPlayers + 1) * h.numHands,
+            "Opening table is truncated");
+}
+
+OpeningTable OpeningTable::open(const std::string& path)
+{
+    return OpeningTable(MappedFile::open(path));
+}
+
+OpeningTable OpeningTable::openWritable(const std::string& path)
+{
+    struct stat st;
+    bool exists = ::stat(path.c_str(), &st) == 0 && st.st_size > 0;
+    size_t size = sizeof(Header) + (MAX_PLAYERS - MIN_PLAYERS + 1) * numHands();
+
+    auto file = MappedFile::openWritable(path, exists ? st.st_size : size, NO_ENTRY);
+    if (!exists) {
+        Header h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.minPlayers = MIN_PLAYERS;
+        h.maxPlayers = MAX_PLAYERS;
+        h.numHands = numHands();
+        std::memcpy(file.mutableData(), &h, sizeof(h));
+    }
+    return OpeningTable(std::move(file));
+}
+
+size_t OpeningTable::numHands()
+{
+    return BINOMIALS[RADIX][HAND_SIZE];
+}
+
+size_t OpeningTable::handIndex(CardSet canonicalHand)
+{
+    size_t index = 0;
+    size_t k = 1;
+    canonicalHand.forEach([&](size_t code) {
+        index += BINOMIALS[code][k++];
+    });
+    return index;
+}
+
+CardSet OpeningTable::handAt(size_t handIdx)
+{
+    CardSet hand;
+    size_t code = RADIX;
+    for (size_t k = HAND_SIZE; k > 0; --k) {
+        do {
+            --code;
+        } while (BINOMIALS[code][k] > handIdx);
+        handIdx -= BINOMIALS[code][k];
+        hand.insert(code);
+    }
+    return hand;
+}
+
+bool OpeningTable::isCanonical(CardSet hand)
+{
+    return canonicalize(hand, Suit::Clubs).hand == hand;
+}
+
+size_t OpeningTable::minPlayers() const
+{
+    return header(file_).minPlayers;
+}
+
+size_t OpeningTable::maxPlayers() const
+{
+    return header(file_).maxPlayers;
+}
+
+uint8_t OpeningTable::lookup(CardSet hand, Suit trump, size_t numPlayers) const
+{
+    if (hand.size() != HAND_SIZE || numPlayers < minPlayers() || numPlayers > maxPlayers()) {
+        return NO_ENTRY;
+    }
+    auto canonical = canonicalize(hand, trump);
+    uint8_t code = entry(numPlayers, handIndex(canonical.hand));
+    return code == NO_ENTRY ? NO_ENTRY : static_cast<uint8_t>(canonical.permutation.inverse()(size_t(code)));
+}
+
+uint8_t OpeningTable::entry(size_t numPlayers, size_t handIdx) const
+{
+    return file_.data()[sizeof(Header) + (numPlayers - minPlayers()) * numHands() + handIdx];
+}
+
+void OpeningTable::setEntry(size_t numPlayers, size_t handIdx, uint8_t canonicalCode)
+{
+    REQUIRE(file_.mutableData(), "Opening table is read-only");
+    REQUIRE(numPlayers >= minPlayers() && numPlayers <= maxPlayers() && handIdx < numHands(),
+            "Opening table entry out of range");
+    file_.mutableData()[sizeof(Header) + (numPlayers - minPlayers()) * numHands() + handIdx] = canonicalCode;
+}
+
+void OpeningTable::sync()
+{
+    file_.sync();
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "card.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Precomputed first attack of a round, indexed by the initial hand,
+ * the trump suit and the number of players.
+ *
+ * Hands are canonicalized (see canonical.h), so that the trump is Clubs,
+ * and ranked in the combinatorial number system. The file is a fixed header
+ * followed by one byte per (number of players, hand): canonical code of the card
+ * to attack with, or NO_ENTRY. It is used directly through mmap. Only entries
+ * of canonical hands are looked up, the rest may stay empty.
+ */
+class OpeningTable {
+public:
+    static constexpr uint8_t NO_ENTRY = 0xff;
+    static constexpr size_t HAND_SIZE = 6;
+    static constexpr size_t MIN_PLAYERS = 2;
+    static constexpr size_t MAX_PLAYERS = 5;
+
+    static OpeningTable open(const std::string& path);
+
+    // Open for building, creating an empty table if the file does not exist
+    static OpeningTable openWritable(const std::string& path);
+
+    static size_t numHands();
+    static size_t handIndex(CardSet canonicalHand);
+    static CardSet handAt(size_t handIdx);
+
+    // Whether the hand is its own canonical form for a Clubs trump
+    static bool isCanonical(CardSet hand);
+
+    size_t minPlayers() const;
+    size_t maxPlayers() const;
+
+    // Code of the card to attack with, NO_ENTRY if the table has no answer
+    uint8_t lookup(CardSet hand, Suit trump, size_t numPlayers) const;
+
+    uint8_t entry(size_t numPlayers, size_t handIdx) const;
+    void setEntry(size_t numPlayers, size_t handIdx, uint8_t canonicalCode);
+
+    void sync();
+
+private:
+    explicit OpeningTable(MappedFile file);
+
+    MappedFile file_;
+};
+
+} // namespace miplot::cardgame::durak
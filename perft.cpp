@@ -0,0 +1,437 @@
+#include "perft.h"
+#include "exception.h"
+#include "game.h"
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr size_t MAX_DESCRIBED_MISMATCHES = 10;
+
+struct Decision {
+    DecisionKind kind;
+    // -1 to fold, resign or not to transfer
+    int cardIdx;
+};
+
+template <typename CardTraits>
+BasicPlayers<CardTraits> makePlayers(size_t numPlayers)
+{
+    BasicPlayers<CardTraits> players;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        players.emplace_back("Player " + std::to_string(idx + 1),
+                             std::make_unique<BasicMinCardStrategy<CardTraits>>());
+    }
+    return players;
+}
+
+/**
+ * Game driven one decision at a time, like the one of ExploitabilityEvaluator,
+ * for any number of players and with transfers
+ */
+template <typename CardTraits>
+class PerftGame : public BasicGame<CardTraits> {
+    using Base = BasicGame<CardTraits>;
+
+public:
+    using typename Base::Cards;
+    using typename Base::GameState;
+    using Base::Base;
+    using Base::curAttackerIdx;
+    using Base::defenderIdx;
+    using Base::players;
+    using Base::state;
+
+    void start(size_t firstAttackerIdx)
+    {
+        this->startRound(firstAttackerIdx, nullptr);
+        finished_ = this->isFinished();
+        if (!finished_) {
+            this->beginBout();
+            finished_ = this->advanceToDecision();
+        }
+    }
+
+    void load(const std::string& snapshot)
+    {
+        this->restore(snapshot);
+        finished_ = this->isFinished();
+        if (!finished_) {
+            finished_ = this->advanceToDecision();
+        }
+    }
+
+    void copyFrom(const PerftGame& other)
+    {
+        this->assignRound(other);
+        finished_ = other.finished_;
+    }
+
+    bool finished() const { return finished_; }
+
+    size_t actor() const { return this->needsDefense() ? defenderIdx() : curAttackerIdx(); }
+
+    const Cards& hand() const { return players()[actor()].hand(); }
+
+    bool defending() const { return this->needsDefense(); }
+
+    bool transferable() const { return this->needsDefense() && this->canTransfer(); }
+
+    const GameState& gameState() const { return state(); }
+
+    // Attacks of the current attacker, or transfers and defenses of the defender
+    void decisions(std::vector<Decision>& result) const
+    {
+        result.clear();
+        if (!this->needsDefense()) {
+            add(DecisionKind::Attack, true, result);
+            return;
+        }
+        if (this->canTransfer()) {
+            // Not transferring is not a decision of its own, the defender goes on to defend
+            add(DecisionKind::Transfer, false, result);
+        }
+        add(DecisionKind::Defend, true, result);
+    }
+
+    void apply(const Decision& decision)
+    {
+        play(decision);
+        finished_ = this->advanceToDecision();
+    }
+
+    // Whether Game takes a decision, the error if not. Leaves the game mid-step
+    bool accepts(const Decision& decision, std::string& error)
+    {
+        try {
+            play(decision);
+            return true;
+        } catch (const Exception& e) {
+            error = e.what();
+            return false;
+        }
+    }
+
+private:
+    void add(DecisionKind kind, bool withPass, std::vector<Decision>& result) const
+    {
+        const auto& cards = hand();
+        uint64_t legal = legalActions(kind, state(), cards);
+        if (withPass && (legal >> CardTraits::radix() & 1)) {
+            result.push_back({kind, -1});
+        }
+        for (size_t idx = 0; idx < cards.size(); ++idx) {
+            if (legal >> cards[idx].code() & 1) {
+                result.push_back({kind, static_cast<int>(idx)});
+            }
+        }
+    }
+
+    void play(const Decision& decision)
+    {
+        switch (decision.kind) {
+            case DecisionKind::Attack: this->applyAttack(decision.cardIdx); break;
+            case DecisionKind::Transfer: this->applyTransfer(decision.cardIdx); break;
+            case DecisionKind::Defend: this->applyDefense(decision.cardIdx); break;
+        }
+    }
+
+    bool finished_ = false;
+};
+
+template <typename CardTraits>
+std::string describe(const PerftGame<CardTraits>& game, const Decision& decision)
+{
+    std::ostringstream out;
+    if (decision.cardIdx == -1) {
+        out << (decision.kind == DecisionKind::Attack ? "fold"
+              : decision.kind == DecisionKind::Defend ? "resign" : "keep");
+        return out.str();
+    }
+    out << (decision.kind == DecisionKind::Attack ? "attack "
+          : decision.kind == DecisionKind::Defend ? "defend " : "transfer ")
+        << game.hand()[decision.cardIdx];
+    return out.str();
+}
+
+// Counts subtrees on one thread, with a game per ply
+template <typename CardTraits>
+class Walker {
+public:
+    using Game = PerftGame<CardTraits>;
+
+    Walker(const Game& root, size_t numPlayers, const Rules& rules,
+           const PerftOptions& options, PerftResult& result)
+        : root_(root)
+        , depth_(options.depth)
+        , validate_(options.validate)
+        , result_(result)
+        , decisions_(depth_ + 1)
+        , line_(depth_ + 1)
+    {
+        for (size_t ply = 0; ply <= depth_; ++ply) {
+            pool_.push_back(std::make_unique<Game>(makePlayers<CardTraits>(numPlayers), rules));
+        }
+        if (validate_) {
+            scratch_ = std::make_unique<Game>(makePlayers<CardTraits>(numPlayers), rules);
+            strategies_.push_back(std::make_unique<BasicMinCardStrategy<CardTraits>>());
+            strategies_.push_back(std::make_unique<BasicWeightedHeuristicStrategy<CardTraits>>());
+            strategies_.push_back(std::make_unique<BasicRandomStrategy<CardTraits>>());
+            strategies_.back()->seed(1);
+        }
+    }
+
+    // Count the position after a decision at ply - 1
+    void play(const Game& game, const Decision& decision, size_t ply)
+    {
+        line_[ply - 1] = decision;
+        auto& child = *pool_[ply];
+        child.copyFrom(game);
+        child.apply(decision);
+        count(child, ply);
+    }
+
+    void count(const Game& game, size_t ply)
+    {
+        ++result_.nodes[ply];
+        if (ply == depth_) {
+            return;
+        }
+        if (game.finished()) {
+            ++result_.finished;
+            return;
+        }
+        if (validate_) {
+            check(game, ply);
+        }
+
+        auto& decisions = decisions_[ply];
+        game.decisions(decisions);
+        if (ply + 1 == depth_) {
+            // Leaves are not played
+            result_.nodes[depth_] += decisions.size();
+            return;
+        }
+        for (const auto& decision : decisions) {
+            play(game, decision, ply + 1);
+        }
+    }
+
+    // Compare legal decisions with the ones Game accepts and strategies choose
+    void check(const Game& game, size_t ply)
+    {
+        const auto& legal = decisions_[ply];
+        game.decisions(decisions_[ply]);
+        auto isLegal = [&](const Decision& decision) {
+            for (const auto& other : legal) {
+                if (other.kind == decision.kind && other.cardIdx == decision.cardIdx) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        std::vector<Decision> candidates;
+        int numCards = game.hand().size();
+        if (!game.defending()) {
+            for (int idx = -1; idx < numCards; ++idx) {
+                candidates.push_back({DecisionKind::Attack, idx});
+            }
+        } else {
+            for (int idx = 0; game.rules().transfer && idx < numCards; ++idx) {
+                candidates.push_back({DecisionKind::Transfer, idx});
+            }
+            for (int idx = -1; idx < numCards; ++idx) {
+                candidates.push_back({DecisionKind::Defend, idx});
+            }
+        }
+        std::string error;
+        for (const auto& candidate : candidates) {
+            scratch_->copyFrom(game);
+            bool accepted = scratch_->accepts(candidate, error);
+            if (accepted != isLegal(candidate)) {
+                mismatch(game, ply, describe(game, candidate) + (accepted
+                    ? ": Game accepts it, legalActions() does not"
+                    : ": legalActions() allows it, Game does not: " + error));
+            }
+        }
+
+        for (const auto& strategy : strategies_) {
+            std::vector<Decision> chosen;
+            try {
+                if (!game.defending()) {
+                    chosen.push_back({DecisionKind::Attack, strategy->attack(game.gameState(), game.hand())});
+                } else {
+                    if (game.transferable()) {
+                        int cardIdx = strategy->transfer(game.gameState(), game.hand());
+                        if (cardIdx != -1) {
+                            chosen.push_back({DecisionKind::Transfer, cardIdx});
+                        }
+                    }
+                    chosen.push_back({DecisionKind::Defend, strategy->defend(game.gameState(), game.hand())});
+                }
+            } catch (const Exception& e) {
+                mismatch(game, ply, strategy->name() + " failed: " + e.what());
+                continue;
+            }
+            for (const auto& decision : chosen) {
+                if (!isLegal(decision)) {
+                    bool inHand = decision.cardIdx >= -1 && decision.cardIdx < numCards;
+                    mismatch(game, ply, strategy->name() + " chooses to "
+                             + (inHand ? describe(game, decision) : "play card " + std::to_string(decision.cardIdx))
+                             + ", which is not legal");
+                }
+            }
+        }
+    }
+
+private:
+    void mismatch(const Game& game, size_t ply, const std::string& what)
+    {
+        if (result_.numMismatches++ >= MAX_DESCRIBED_MISMATCHES) {
+            return;
+        }
+        std::ostringstream out;
+        out << "Ply " << ply << ", player " << game.actor() << " after";
+        for (size_t idx = 0; idx < ply; ++idx) {
+            out << (idx ? ", " : " ") << describe(idx ? *pool_[idx] : root_, line_[idx]);
+        }
+        out << (ply ? "" : " the root") << ": " << what;
+        result_.mismatches.push_back(out.str());
+    }
+
+    const Game& root_;
+    size_t depth_;
+    bool validate_;
+    PerftResult& result_;
+
+    std::vector<std::unique_ptr<Game>> pool_;
+    std::vector<std::vector<Decision>> decisions_;
+    // Decisions leading to the current position
+    std::vector<Decision> line_;
+
+    std::unique_ptr<Game> scratch_;
+    std::vector<std::unique_ptr<BasicStrategy<CardTraits>>> strategies_;
+};
+
+template <typename CardTraits>
+std::string dealRound(size_t numPlayers, const Rules& rules, uint64_t seed, size_t firstAttackerIdx)
+{
+    PerftGame<CardTraits> game(makePlayers<CardTraits>(numPlayers), rules);
+    game.seed(seed);
+    game.start(firstAttackerIdx);
+    return game.snapshot();
+}
+
+template <typename CardTraits>
+PerftResult countFrom(const std::string& snapshot, size_t numPlayers, const Rules& rules,
+                      const PerftOptions& options)
+{
+    PerftGame<CardTraits> root(makePlayers<CardTraits>(numPlayers), rules);
+    root.load(snapshot);
+
+    PerftResult total;
+    total.nodes.assign(options.depth + 1, 0);
+    if (options.depth == 0 || root.finished()) {
+        Walker<CardTraits>(root, numPlayers, rules, options, total).count(root, 0);
+        return total;
+    }
+
+    // The root is counted here, its moves by threads in turn
+    ++total.nodes[0];
+    Walker<CardTraits> walker(root, numPlayers, rules, options, total);
+    if (options.validate) {
+        walker.check(root, 0);
+    }
+    std::vector<Decision> decisions;
+    root.decisions(decisions);
+
+    size_t numThreads = std::max<size_t>(1, std::min(options.numThreads, decisions.size()));
+    std::vector<PerftResult> partial(numThreads);
+    std::vector<uint64_t> leaves(decisions.size());
+    std::atomic<size_t> next{0};
+    parallelFor(numThreads, numThreads, [&](size_t threadIdx, size_t, size_t) {
+        auto& result = partial[threadIdx];
+        result.nodes.assign(options.depth + 1, 0);
+        Walker<CardTraits> walker(root, numPlayers, rules, options, result);
+        for (size_t idx; (idx = next++) < decisions.size(); ) {
+            uint64_t before = result.nodes[options.depth];
+            walker.play(root, decisions[idx], 1);
+            leaves[idx] = result.nodes[options.depth] - before;
+        }
+    });
+
+    for (const auto& result : partial) {
+        total.merge(result);
+    }
+    if (options.divide) {
+        for (size_t idx = 0; idx < decisions.size(); ++idx) {
+            total.divide.emplace_back(describe(root, decisions[idx]), leaves[idx]);
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+void PerftResult::merge(const PerftResult& other)
+{
+    if (nodes.size() < other.nodes.size()) {
+        nodes.resize(other.nodes.size());
+    }
+    for (size_t ply = 0; ply < other.nodes.size(); ++ply) {
+        nodes[ply] += other.nodes[ply];
+    }
+    finished += other.finished;
+    divide.insert(divide.end(), other.divide.begin(), other.divide.end());
+    numMismatches += other.numMismatches;
+    for (const auto& mismatch : other.mismatches) {
+        if (mismatches.size() < MAX_DESCRIBED_MISMATCHES) {
+            mismatches.push_back(mismatch);
+        }
+    }
+}
+
+uint64_t PerftResult::numNodes() const
+{
+    uint64_t total = 0;
+    for (uint64_t count : nodes) {
+        total += count;
+    }
+    return total;
+}
+
+Perft::Perft(size_t numPlayers, Rules rules, PerftOptions options)
+    : numPlayers_(numPlayers)
+    , rules_(rules)
+    , options_(options)
+{
+    REQUIRE(!rules_.batchedAttacks, "Perft does not enumerate batched attacks");
+    REQUIRE(options_.deckSize == 24 || options_.deckSize == 36 || options_.deckSize == 52,
+            "Unsupported deck size: " << options_.deckSize);
+}
+
+std::string Perft::deal(uint64_t seed, size_t firstAttackerIdx) const
+{
+    switch (options_.deckSize) {
+        case 24: return dealRound<cards::Std24CardTraits>(numPlayers_, rules_, seed, firstAttackerIdx);
+        case 52: return dealRound<cards::Std52CardTraits>(numPlayers_, rules_, seed, firstAttackerIdx);
+        default: return dealRound<cards::Std36CardTraits>(numPlayers_, rules_, seed, firstAttackerIdx);
+    }
+}
+
+PerftResult Perft::run(const std::string& snapshot) const
+{
+    switch (options_.deckSize) {
+        case 24: return countFrom<cards::Std24CardTraits>(snapshot, numPlayers_, rules_, options_);
+        case 52: return countFrom<cards::Std52CardTraits>(snapshot, numPlayers_, rules_, options_);
+        default: return countFrom<cards::Std36CardTraits>(snapshot, numPlayers_, rules_, options_);
+    }
+}
+
+} // namespace miplot::cardgame::durak
+
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "simulator.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+struct PerftOptions {
+    size_t depth = 4;
+    // Cards in the deck: 24, 36 or 52
+    size_t deckSize = 36;
+    size_t numThreads = defaultNumThreads();
+    // Count root moves separately
+    bool divide = false;
+    // Check every node, see Perft
+    bool validate = false;
+};
+
+struct PerftResult {
+    // Positions at every ply, nodes[0] is the root
+    std::vector<uint64_t> nodes;
+    // Rounds over before the depth
+    uint64_t finished = 0;
+    // Positions at the depth under every root move, with divide
+    std::vector<std::pair<std::string, uint64_t>> divide;
+    // Disagreements found with validate, the first few of them described
+    uint64_t numMismatches = 0;
+    std::vector<std::string> mismatches;
+
+    void merge(const PerftResult& other);
+
+    uint64_t numNodes() const;
+};
+
+/**
+ * Enumerates every legal sequence of decisions of a round up to a depth,
+ * like perft of chess engines: a correctness oracle for changes of the rules
+ * code and a benchmark of move generation. Legal decisions are those of
+ * legalActions(), a transfer and a defense being separate decisions of the
+ * defender. Steps without a choice are played on the way.
+ *
+ * With validate, every node also checks that Game accepts exactly the legal
+ * decisions, trying every card of the hand, and that the built-in strategies
+ * only choose legal ones. Work is split between threads by root move.
+ * Games without batched attacks
+ */
+class Perft {
+public:
+    Perft(size_t numPlayers, Rules rules = Rules(), PerftOptions options = PerftOptions());
+
+    // Snapshot of the first decision of the round dealt from seed
+    std::string deal(uint64_t seed, size_t firstAttackerIdx = 0) const;
+
+    // Count from a snapshot of a game with numPlayers players and the deck of options
+    PerftResult run(const std::string& snapshot) const;
+
+private:
+    size_t numPlayers_;
+    Rules rules_;
+    PerftOptions options_;
+};
+
+} // namespace miplot::cardgame::durak
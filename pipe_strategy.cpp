@@ -0,0 +1,283 @@
+#include "pipe_strategy.h"
+#include "exception.h"
+#include "logging/logging.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using protocol::DecisionKind;
+
+constexpr size_t READ_CHUNK = 4096;
+constexpr auto EXIT_GRACE = std::chrono::milliseconds(100);
+
+} // namespace
+
+BotProcess::BotProcess(const std::string& command, std::chrono::milliseconds timeout)
+    : timeout_(timeout)
+{
+    // A socket instead of pipes, so that writing to a dead bot does not raise SIGPIPE
+    int fds[2];
+    REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) == 0,
+            "Cannot create socket pair: " << std::strerror(errno));
+
+    pid_ = ::fork();
+    if (pid_ == 0) {
+        ::dup2(fds[1], STDIN_FILENO);
+        ::dup2(fds[1], STDOUT_FILENO);
+        ::execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+    ::close(fds[1]);
+    if (pid_ < 0) {
+        ::close(fds[0]);
+        throw Exception() << "Cannot start bot: " << std::strerror(errno);
+    }
+
+    fd_ = fds[0];
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+}
+
+BotProcess::~BotProcess()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (pid_ > 0) {
+        // The bot sees the end of its input and should exit by itself
+        auto deadline = Clock::now() + EXIT_GRACE;
+        while (::waitpid(pid_, nullptr, WNOHANG) == 0) {
+            if (Clock::now() > deadline) {
+                ::kill(pid_, SIGKILL);
+                ::waitpid(pid_, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+std::optional<int> BotProcess::ask(PipeStrategy& strategy, DecisionKind kind,
+                                   const GameState& state, const Cards& hand,
+                                   async::DecisionSlot<int>& slot)
+{
+    if (!alive()) {
+        return strategy.fallback(kind, state, hand);
+    }
+
+    uint32_t id = ++nextId_;
+    protocol::Writer writer(output_);
+    protocol::writeRequest(writer, id, kind, state, hand, 0);
+
+    pending_.emplace(id, Pending{&strategy, &slot, kind, &state, &hand, Clock::now() + timeout_});
+    sent_.push_back(id);
+    ++stats_.requests;
+    return std::nullopt;
+}
+
+void BotProcess::flush()
+{
+    size_t sent = 0;
+    while (alive() && sent < output_.size()) {
+        ssize_t numWritten = ::send(fd_, output_.data() + sent, output_.size() - sent, MSG_NOSIGNAL);
+        if (numWritten >= 0) {
+            sent += numWritten;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            crash(std::string("Cannot write to bot: ") + std::strerror(errno));
+            break;
+        }
+
+        // Keep reading while waiting, the bot may be blocked writing responses
+        pollfd fd{fd_, POLLIN | POLLOUT, 0};
+        int numReady = ::poll(&fd, 1, timeout_.count());
+        if (numReady == 0) {
+            crash("Bot does not read requests");
+        } else if (numReady > 0 && (fd.revents & (POLLIN | POLLHUP | POLLERR))) {
+            poll(0);
+        }
+    }
+
+    if (sent > 0) {
+        ++stats_.batches;
+    }
+    output_.clear();
+}
+
+void BotProcess::poll(int timeoutMs)
+{
+    // Do not sleep past the earliest deadline
+    for (uint32_t id : sent_) {
+        auto itr = pending_.find(id);
+        if (itr != pending_.end()) {
+            auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+                itr->second.deadline - Clock::now());
+            timeoutMs = std::max<int>(0, std::min<int>(timeoutMs, untilDeadline.count() + 1));
+            break;
+        }
+    }
+
+    if (alive()) {
+        pollfd fd{fd_, POLLIN, 0};
+        int numReady = ::poll(&fd, 1, timeoutMs);
+        while (alive() && numReady > 0) {
+            size_t size = input_.size();
+            input_.resize(size + READ_CHUNK);
+            ssize_t numRead = ::read(fd_, input_.data() + size, READ_CHUNK);
+            input_.resize(size + std::max<ssize_t>(numRead, 0));
+
+            if (numRead == 0) {
+                crash("Bot exited");
+            } else if (numRead < 0 && errno != EINTR) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    crash(std::string("Cannot read from bot: ") + std::strerror(errno));
+                }
+                break;
+            }
+        }
+
+        size_t pos = 0;
+        try {
+            while (size_t frameSize = protocol::frameSize(input_.data() + pos, input_.size() - pos)) {
+                const uint8_t* frame = input_.data() + pos;
+                pos += frameSize;
+                REQUIRE(protocol::frameType(frame) == protocol::MessageType::Response,
+                        "Unexpected message type " << static_cast<int>(protocol::frameType(frame)));
+                auto payload = protocol::framePayload(frame, frameSize);
+                onResponse(protocol::readResponse(payload));
+            }
+            input_.erase(input_.begin(), input_.begin() + pos);
+        } catch (const Exception& e) {
+            crash(std::string("Malformed response: ") + e.what());
+        }
+    }
+
+    expire();
+}
+
+void BotProcess::onResponse(const protocol::Response& response)
+{
+    auto itr = pending_.find(response.id);
+    if (itr == pending_.end()) {
+        // Answered by the fallback after a timeout
+        return;
+    }
+    Pending pending = itr->second;
+    pending_.erase(itr);
+    ++stats_.responses;
+
+    if (!isLegalDecision(pending.kind, *pending.state, *pending.hand, response.cardIdx)) {
+        ++stats_.invalid;
+        resolveByFallback(pending);
+        return;
+    }
+    pending.slot->resolve(response.cardIdx);
+}
+
+void BotProcess::expire()
+{
+    auto now = Clock::now();
+    while (!sent_.empty()) {
+        auto itr = pending_.find(sent_.front());
+        if (itr != pending_.end()) {
+            if (itr->second.deadline > now) {
+                break;
+            }
+            Pending pending = itr->second;
+            pending_.erase(itr);
+            ++stats_.timeouts;
+            resolveByFallback(pending);
+        }
+        sent_.pop_front();
+    }
+}
+
+void BotProcess::crash(const std::string& reason)
+{
+    WARN() << "Bot " << pid_ << " is disabled: " << reason;
+    ++stats_.crashed;
+
+    ::close(fd_);
+    fd_ = -1;
+    ::kill(pid_, SIGKILL);
+
+    auto pending = std::move(pending_);
+    pending_.clear();
+    sent_.clear();
+    for (auto& [id, request] : pending) {
+        resolveByFallback(request);
+    }
+}
+
+void BotProcess::resolveByFallback(const Pending& pending)
+{
+    pending.slot->resolve(pending.strategy->fallback(pending.kind, *pending.state, *pending.hand));
+}
+
+
+PipeStrategy::PipeStrategy(std::shared_ptr<BotProcess> bot)
+    : bot_(std::move(bot))
+{
+}
+
+async::Decision<int> PipeStrategy::attackAsync(const GameState& state, const Cards& hand,
+                                               async::DecisionSlot<int>& slot)
+{
+    return ask(DecisionKind::Attack, state, hand, slot);
+}
+
+async::Decision<int> PipeStrategy::defendAsync(const GameState& state, const Cards& hand,
+                                               async::DecisionSlot<int>& slot)
+{
+    return ask(DecisionKind::Defend, state, hand, slot);
+}
+
+async::Decision<int> PipeStrategy::transferAsync(const GameState& state, const Cards& hand,
+                                                 async::DecisionSlot<int>& slot)
+{
+    return ask(DecisionKind::Transfer, state, hand, slot);
+}
+
+const std::string& PipeStrategy::name() const
+{
+    static const std::string NAME = "Pipe";
+    return NAME;
+}
+
+async::Decision<int> PipeStrategy::ask(DecisionKind kind, const GameState& state, const Cards& hand,
+                                       async::DecisionSlot<int>& slot)
+{
+    if (auto cardIdx = bot_->ask(*this, kind, state, hand, slot)) {
+        return *cardIdx;
+    }
+    return slot.pending();
+}
+
+int PipeStrategy::fallback(DecisionKind kind, const GameState& state, const Cards& hand)
+{
+    switch (kind) {
+        case DecisionKind::Attack: return fallback_.attack(state, hand);
+        case DecisionKind::Defend: return fallback_.defend(state, hand);
+        case DecisionKind::Transfer: return fallback_.transfer(state, hand);
+    }
+    return -1;
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "async_game.h"
+#include "protocol.h"
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace miplot::cardgame::durak {
+
+class PipeStrategy;
+
+struct BotStats {
+    size_t requests = 0;
+    size_t responses = 0;
+    // Requests answered by the fallback strategy
+    size_t timeouts = 0;
+    size_t invalid = 0;
+    size_t crashed = 0;
+    // Writes to the bot, each carrying all requests queued since the previous one
+    size_t batches = 0;
+};
+
+/**
+ * External bot process speaking the binary protocol over its stdin and stdout.
+ * Requests of all games are pipelined: each carries an id, the bot may answer
+ * them in any order. Requests are queued until flush() and responses are
+ * delivered by poll(). Unanswered requests time out, and if the bot dies
+ * all its decisions are taken by fallback strategies
+ */
+class BotProcess {
+public:
+    // Command is run with /bin/sh -c
+    explicit BotProcess(const std::string& command,
+                        std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+    ~BotProcess();
+
+    BotProcess(const BotProcess&) = delete;
+    BotProcess& operator= (const BotProcess&) = delete;
+
+    // Send all queued requests at once
+    void flush();
+
+    // Wait up to timeoutMs for responses, resolve answered and expired requests
+    void poll(int timeoutMs);
+
+    bool alive() const { return fd_ >= 0; }
+    size_t numPending() const { return pending_.size(); }
+
+    const BotStats& stats() const { return stats_; }
+
+private:
+    friend class PipeStrategy;
+
+    struct Pending {
+        PipeStrategy* strategy;
+        async::DecisionSlot<int>* slot;
+        protocol::DecisionKind kind;
+        const GameState* state;
+        const Cards* hand;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // Return the decision if it is taken right away
+    std::optional<int> ask(PipeStrategy& strategy, protocol::DecisionKind kind,
+                           const GameState& state, const Cards& hand, async::DecisionSlot<int>& slot);
+
+    void onResponse(const protocol::Response& response);
+    void expire();
+    void crash(const std::string& reason);
+    void resolveByFallback(const Pending& pending);
+
+    std::chrono::milliseconds timeout_;
+    int fd_ = -1;
+    pid_t pid_ = -1;
+
+    std::vector<uint8_t> input_;
+    std::vector<uint8_t> output_;
+    uint32_t nextId_ = 0;
+    std::unordered_map<uint32_t, Pending> pending_;
+    // Ids in the order of sending, which is also the order of deadlines
+    std::deque<uint32_t> sent_;
+
+    BotStats stats_;
+};
+
+/**
+ * Seat played by an external bot. Many seats of many games may share one
+ * bot process. Games have to be driven by a loop running the scheduler and
+ * calling flush() and poll() of the bot. The whole discard is sent with every
+ * request, so the bot does not have to follow the games
+ */
+class PipeStrategy : public AsyncStrategy {
+public:
+    explicit PipeStrategy(std::shared_ptr<BotProcess> bot);
+
+    async::Decision<int> attackAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override;
+
+    async::Decision<int> defendAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override;
+
+    async::Decision<int> transferAsync(const GameState& state, const Cards& hand,
+                                       async::DecisionSlot<int>& slot) override;
+
+    const std::string& name() const override;
+
+private:
+    friend class BotProcess;
+
+    async::Decision<int> ask(protocol::DecisionKind kind, const GameState& state, const Cards& hand,
+                             async::DecisionSlot<int>& slot);
+
+    int fallback(protocol::DecisionKind kind, const GameState& state, const Cards& hand);
+
+    std::shared_ptr<BotProcess> bot_;
+    MinCardStrategy fallback_;
+};
+
+} // namespace miplot::cardgame::durak
@@ -4,40 +4,53 @@
 
 namespace miplot::cardgame::durak {
 
-Player::Player(PlayerId name, std::unique_ptr<Strategy>&& strategy)
+template <typename CardTraits>
+BasicPlayer<CardTraits>::BasicPlayer(PlayerId name, std::unique_ptr<Strategy>&& strategy)
     : name_(std::move(name))
     , strategy_(std::move(strategy))
 {}
 
-const PlayerId Player::name() const
+template <typename CardTraits>
+const PlayerId BasicPlayer<CardTraits>::name() const
 {
     return name_;
 }
 
-const Cards& Player::hand() const
+template <typename CardTraits>
+auto BasicPlayer<CardTraits>::hand() const -> const Cards&
 {
     return hand_;
 }
 
-size_t Player::numCards() const
+template <typename CardTraits>
+size_t BasicPlayer<CardTraits>::numCards() const
 {
     return hand_.size();
 }
 
 
-void Player::assignHand(Cards&& cards)
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::assignHand(Cards&& cards)
 {
     //hand_ = std::move(cards);
     hand_.clear();
     std::move(cards.begin(), cards.end(), std::back_inserter(hand_));
 }
 
-void Player::addToHand(Cards&& cards)
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::addToHand(Card&& card)
+{
+    hand_.push_back(std::move(card));
+}
+
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::addToHand(Cards&& cards)
 {
     std::move(cards.begin(), cards.end(), std::back_inserter(hand_));
 }
 
-void Player::addToHand(CardPairs&& pairs)
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::addToHand(CardPairs&& pairs)
 {
     for (auto&& pair : pairs) {
         hand_.push_back(std::move(pair.attacking));
@@ -45,7 +58,8 @@ void Player::addToHand(CardPairs&& pairs)
     }
 }
 
-Card Player::playCard(size_t cardIdx)
+template <typename CardTraits>
+auto BasicPlayer<CardTraits>::playCard(size_t cardIdx) -> Card
 {
     REQUIRE(cardIdx < hand_.size(), "Card index outside hand range");
     auto card = std::move(hand_[cardIdx]);
@@ -53,27 +67,58 @@ Card Player::playCard(size_t cardIdx)
     return card;
 }
 
-Cards Player::discardHand()
+template <typename CardTraits>
+auto BasicPlayer<CardTraits>::discardHand() -> Cards
 {
     Cards cards = std::move(hand_);
     hand_.clear();
     return cards;
 }
 
-int Player::attack(const GameState& state)
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::reserveHand(size_t numCards)
+{
+    hand_.reserve(numCards);
+}
+
+template <typename CardTraits>
+int BasicPlayer<CardTraits>::attack(const GameState& state)
 {
     return strategy_->attack(state, hand_);
 }
 
-int Player::defend(const GameState& state)
+template <typename CardTraits>
+AttackBatch BasicPlayer<CardTraits>::attackBatch(const GameState& state)
+{
+    return strategy_->attackBatch(state, hand_);
+}
+
+template <typename CardTraits>
+int BasicPlayer<CardTraits>::defend(const GameState& state)
 {
     return strategy_->defend(state, hand_);
 }
 
-const std::string& Player::strategyName() const
+template <typename CardTraits>
+int BasicPlayer<CardTraits>::transfer(const GameState& state)
+{
+    return strategy_->transfer(state, hand_);
+}
+
+template <typename CardTraits>
+void BasicPlayer<CardTraits>::seed(uint64_t value)
+{
+    strategy_->seed(value);
+}
+
+template <typename CardTraits>
+const std::string& BasicPlayer<CardTraits>::strategyName() const
 {
     return strategy_->name();
 }
 
-} // namespace miplot::cardgame::durak
+template class BasicPlayer<cards::Std24CardTraits>;
+template class BasicPlayer<cards::Std36CardTraits>;
+template class BasicPlayer<cards::Std52CardTraits>;
 
+} // namespace miplot::cardgame::durak
@@ -11,21 +11,28 @@ namespace miplot::cardgame::durak {
 
 using PlayerId = std::string;
 
-class GameState;
-
-
-class Player {
+template <typename CardTraits>
+class BasicPlayer {
 public:
-    Player(PlayerId name, std::unique_ptr<Strategy>&& strategy);
+    using GameState = BasicGameState<CardTraits>;
+    using Strategy = BasicStrategy<CardTraits>;
+    using Card = typename CardTypes<CardTraits>::Card;
+    using Cards = typename CardTypes<CardTraits>::Cards;
+    using CardPairs = typename CardTypes<CardTraits>::CardPairs;
+
+    BasicPlayer(PlayerId name, std::unique_ptr<Strategy>&& strategy);
 
     const PlayerId name() const;
     const std::string& strategyName() const;
 
+    Strategy& strategy() const { return *strategy_; }
+
     const Cards& hand() const;
 
     size_t numCards() const;
 
     void assignHand(Cards&& cards);
+    void addToHand(Card&& card);
     void addToHand(Cards&& cards);
     void addToHand(CardPairs&& pairs);
 
@@ -33,18 +40,34 @@ public:
 
     Cards discardHand();
 
+    // Room for as many cards, so that the hand does not grow while playing
+    void reserveHand(size_t numCards);
+
     // Return index of card in hand, or -1 on fold
     int attack(const GameState& state);
 
+    // Return indices of cards in hand, empty on fold
+    AttackBatch attackBatch(const GameState& state);
+
     // Return index of card in hand, or -1 on resign
     int defend(const GameState& state);
 
+    // Return index of card in hand, or -1 to defend instead
+    int transfer(const GameState& state);
+
+    void seed(uint64_t value);
+
 private:
     PlayerId name_;
     std::unique_ptr<Strategy> strategy_;
     Cards hand_;
 };
 
-using Players = std::vector<Player>;
+template <typename CardTraits>
+using BasicPlayers = std::vector<BasicPlayer<CardTraits>>;
+
+// Standard 36 card game
+using Player = BasicPlayer<cards::Std36CardTraits>;
+using Players = BasicPlayers<cards::Std36CardTraits>;
 
 } // namespace miplot::cardgame::durak
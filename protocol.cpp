@@ -0,0 +1,218 @@
+#include "protocol.h"
+#include "exception.h"
+
+#include <cstring>
+
+namespace miplot::cardgame::durak::protocol {
+
+namespace {
+
+constexpr uint8_t TRANSFER_FLAG = 1;
+constexpr uint8_t BATCHED_ATTACKS_FLAG = 2;
+
+} // namespace
+
+void Writer::beginFrame(MessageType type)
+{
+    frameStart_ = buffer_.size();
+    u32(0);
+    u8(static_cast<uint8_t>(type));
+}
+
+void Writer::endFrame()
+{
+    size_t size = buffer_.size() - frameStart_;
+    REQUIRE(size <= MAX_FRAME_SIZE, "Frame is too large: " << size);
+    uint32_t rest = static_cast<uint32_t>(size - sizeof(uint32_t));
+    std::memcpy(buffer_.data() + frameStart_, &rest, sizeof(rest));
+}
+
+void Writer::string(const std::string& value)
+{
+    u16(static_cast<uint16_t>(value.size()));
+    raw(value.data(), value.size());
+}
+
+void Writer::raw(const void* data, size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+uint8_t Reader::u8()
+{
+    uint8_t value;
+    raw(&value, sizeof(value));
+    return value;
+}
+
+uint16_t Reader::u16()
+{
+    uint16_t value;
+    raw(&value, sizeof(value));
+    return value;
+}
+
+uint32_t Reader::u32()
+{
+    uint32_t value;
+    raw(&value, sizeof(value));
+    return value;
+}
+
+uint64_t Reader::u64()
+{
+    uint64_t value;
+    raw(&value, sizeof(value));
+    return value;
+}
+
+std::string Reader::string()
+{
+    std::string value(u16(), '\0');
+    raw(value.data(), value.size());
+    return value;
+}
+
+std::vector<uint8_t> Reader::bytes()
+{
+    std::vector<uint8_t> value(u8());
+    raw(value.data(), value.size());
+    return value;
+}
+
+void Reader::raw(void* data, size_t size)
+{
+    REQUIRE(size <= size_ - pos_, "Truncated message");
+    std::memcpy(data, data_ + pos_, size);
+    pos_ += size;
+}
+
+size_t frameSize(const uint8_t* data, size_t size)
+{
+    if (size < FRAME_HEADER_SIZE) {
+        return 0;
+    }
+    uint32_t rest;
+    std::memcpy(&rest, data, sizeof(rest));
+    size_t total = sizeof(rest) + rest;
+    REQUIRE(total >= FRAME_HEADER_SIZE && total <= MAX_FRAME_SIZE, "Invalid frame size: " << total);
+    return total <= size ? total : 0;
+}
+
+MessageType frameType(const uint8_t* frame)
+{
+    return static_cast<MessageType>(frame[sizeof(uint32_t)]);
+}
+
+Reader framePayload(const uint8_t* frame, size_t frameSize)
+{
+    return Reader(frame + FRAME_HEADER_SIZE, frameSize - FRAME_HEADER_SIZE);
+}
+
+void writeJoin(Writer& writer, const Join& join)
+{
+    writer.beginFrame(MessageType::Join);
+    writer.u8(join.numPlayers);
+    writer.u32(join.numRounds);
+    writer.u64(join.seed);
+    writer.u8((join.rules.transfer ? TRANSFER_FLAG : 0)
+              | (join.rules.batchedAttacks ? BATCHED_ATTACKS_FLAG : 0));
+    writer.u8(static_cast<uint8_t>(join.rules.numTeams));
+    writer.endFrame();
+}
+
+Join readJoin(Reader& reader)
+{
+    Join join;
+    join.numPlayers = reader.u8();
+    join.numRounds = reader.u32();
+    join.seed = reader.u64();
+    uint8_t flags = reader.u8();
+    join.rules.transfer = flags & TRANSFER_FLAG;
+    join.rules.batchedAttacks = flags & BATCHED_ATTACKS_FLAG;
+    join.rules.numTeams = reader.u8();
+    return join;
+}
+
+Request readRequest(Reader& reader)
+{
+    Request request;
+    request.id = reader.u32();
+    request.kind = static_cast<DecisionKind>(reader.u8());
+
+    auto& delta = request.delta;
+    delta.trump = reader.u8();
+    delta.mainAttackerIdx = reader.u8();
+    delta.defenderIdx = reader.u8();
+    delta.curAttackerIdx = reader.u8();
+    delta.numCards = reader.bytes();
+    delta.undefended = reader.bytes();
+    delta.defended.resize(reader.u8());
+    for (auto& pair : delta.defended) {
+        pair.first = reader.u8();
+        pair.second = reader.u8();
+    }
+    delta.newDiscard = reader.bytes();
+
+    request.hand = reader.bytes();
+    return request;
+}
+
+void writeResponse(Writer& writer, const Response& response)
+{
+    writer.beginFrame(MessageType::Response);
+    writer.u32(response.id);
+    writer.i8(response.cardIdx);
+    writer.endFrame();
+}
+
+Response readResponse(Reader& reader)
+{
+    Response response;
+    response.id = reader.u32();
+    response.cardIdx = reader.i8();
+    return response;
+}
+
+void writeRoundOver(Writer& writer, const RoundOver& roundOver)
+{
+    writer.beginFrame(MessageType::RoundOver);
+    writer.u32(roundOver.roundIdx);
+    writer.i8(roundOver.losingPlayerIdx);
+    writer.endFrame();
+}
+
+RoundOver readRoundOver(Reader& reader)
+{
+    RoundOver roundOver;
+    roundOver.roundIdx = reader.u32();
+    roundOver.losingPlayerIdx = reader.i8();
+    return roundOver;
+}
+
+void writeTableClosed(Writer& writer, uint32_t numRounds)
+{
+    writer.beginFrame(MessageType::TableClosed);
+    writer.u32(numRounds);
+    writer.endFrame();
+}
+
+uint32_t readTableClosed(Reader& reader)
+{
+    return reader.u32();
+}
+
+void writeError(Writer& writer, const std::string& message)
+{
+    writer.beginFrame(MessageType::Error);
+    writer.string(message.substr(0, MAX_FRAME_SIZE - FRAME_HEADER_SIZE - sizeof(uint16_t)));
+    writer.endFrame();
+}
+
+std::string readError(Reader& reader)
+{
+    return reader.string();
+}
+
+} // namespace miplot::cardgame::durak::protocol
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "game.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace miplot::cardgame::durak::protocol {
+
+/*
+ * Binary protocol between the game server and remote players.
+ * A frame is a uint32 size of the rest of the frame, a uint8 message type
+ * and the payload. Integers are in host byte order as peers are local.
+ * Cards are sent as uint8 codes (CardTraits::code), lists as a uint8 size
+ * followed by the elements
+ */
+
+constexpr size_t FRAME_HEADER_SIZE = 5;
+constexpr size_t MAX_FRAME_SIZE = 4096;
+
+enum class MessageType : uint8_t {
+    Join = 1,       // client -> server: start a table
+    Request,        // server -> client: a decision is needed
+    Response,       // client -> server: the decision
+    RoundOver,      // server -> client
+    TableClosed,    // server -> client: all rounds are played
+    Error,          // server -> client: the connection is closed after it
+};
+
+using DecisionKind = durak::DecisionKind;
+
+// Appends frames to a buffer
+class Writer {
+public:
+    explicit Writer(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+    void beginFrame(MessageType type);
+    void endFrame();
+
+    void u8(uint8_t value) { buffer_.push_back(value); }
+    void i8(int8_t value) { buffer_.push_back(static_cast<uint8_t>(value)); }
+    void u16(uint16_t value) { raw(&value, sizeof(value)); }
+    void u32(uint32_t value) { raw(&value, sizeof(value)); }
+    void u64(uint64_t value) { raw(&value, sizeof(value)); }
+    void string(const std::string& value);
+
+    template <typename Collection>
+    void cards(const Collection& cards)
+    {
+        u8(static_cast<uint8_t>(cards.size()));
+        for (const auto& card : cards) {
+            u8(static_cast<uint8_t>(card.code()));
+        }
+    }
+
+private:
+    void raw(const void* data, size_t size);
+
+    std::vector<uint8_t>& buffer_;
+    size_t frameStart_ = 0;
+};
+
+// Reads a payload, throws on reading past its end
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t u8();
+    int8_t i8() { return static_cast<int8_t>(u8()); }
+    uint16_t u16();
+    uint32_t u32();
+    uint64_t u64();
+    std::string string();
+    std::vector<uint8_t> bytes();
+
+    bool atEnd() const { return pos_ == size_; }
+
+private:
+    void raw(void* data, size_t size);
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+// Size of the whole frame at the start of the buffer, 0 if it is not complete yet
+size_t frameSize(const uint8_t* data, size_t size);
+
+MessageType frameType(const uint8_t* frame);
+
+// Payload of a complete frame
+Reader framePayload(const uint8_t* frame, size_t frameSize);
+
+struct Join {
+    // The client takes seat 0, the server fills others with bots
+    uint8_t numPlayers = 2;
+    uint32_t numRounds = 1;
+    uint64_t seed = 0;
+    Rules rules;
+};
+
+/**
+ * Table state sent with every request. Only cards discarded since
+ * the previous request to the same seat are sent
+ */
+struct StateDelta {
+    uint8_t trump = 0;
+    uint8_t mainAttackerIdx = 0;
+    uint8_t defenderIdx = 0;
+    uint8_t curAttackerIdx = 0;
+    std::vector<uint8_t> numCards;
+    std::vector<uint8_t> undefended;
+    std::vector<std::pair<uint8_t, uint8_t>> defended;
+    std::vector<uint8_t> newDiscard;
+};
+
+struct Request {
+    uint32_t id = 0;
+    DecisionKind kind = DecisionKind::Attack;
+    StateDelta delta;
+    std::vector<uint8_t> hand;
+};
+
+struct Response {
+    uint32_t id = 0;
+    int8_t cardIdx = -1;
+};
+
+struct RoundOver {
+    uint32_t roundIdx = 0;
+    int8_t losingPlayerIdx = -1; // -1 on draw
+};
+
+void writeJoin(Writer& writer, const Join& join);
+Join readJoin(Reader& reader);
+
+template <typename CardTraits>
+void writeRequest(Writer& writer, uint32_t id, DecisionKind kind,
+                  const BasicGameState<CardTraits>& state,
+                  const typename CardTypes<CardTraits>::Cards& hand,
+                  size_t discardFrom)
+{
+    writer.beginFrame(MessageType::Request);
+    writer.u32(id);
+    writer.u8(static_cast<uint8_t>(kind));
+
+    writer.u8(static_cast<uint8_t>(state.trumpSuit()));
+    writer.u8(static_cast<uint8_t>(state.mainAttackerIdx()));
+    writer.u8(static_cast<uint8_t>(state.defenderIdx()));
+    writer.u8(static_cast<uint8_t>(state.curAttackerIdx()));
+    const auto& opponents = state.opponents();
+    writer.u8(static_cast<uint8_t>(opponents.size()));
+    for (const auto& opponent : opponents) {
+        writer.u8(static_cast<uint8_t>(opponent.numCards));
+    }
+    writer.cards(state.undefendedCards());
+    writer.u8(static_cast<uint8_t>(state.defendedCards().size()));
+    for (const auto& pair : state.defendedCards()) {
+        writer.u8(static_cast<uint8_t>(pair.attacking.code()));
+        writer.u8(static_cast<uint8_t>(pair.defending.code()));
+    }
+    const auto& discard = state.discard();
+    writer.u8(static_cast<uint8_t>(discard.size() - discardFrom));
+    for (size_t idx = discardFrom; idx < discard.size(); ++idx) {
+        writer.u8(static_cast<uint8_t>(discard[idx].code()));
+    }
+
+    writer.cards(hand);
+    writer.endFrame();
+}
+
+Request readRequest(Reader& reader);
+
+void writeResponse(Writer& writer, const Response& response);
+Response readResponse(Reader& reader);
+
+void writeRoundOver(Writer& writer, const RoundOver& roundOver);
+RoundOver readRoundOver(Reader& reader);
+
+void writeTableClosed(Writer& writer, uint32_t numRounds);
+uint32_t readTableClosed(Reader& reader);
+
+void writeError(Writer& writer, const std::string& message);
+std::string readError(Reader& reader);
+
+} // namespace miplot::cardgame::durak::protocol
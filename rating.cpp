@@ -0,0 +1,272 @@
+#include "rating.h"
+#include "exception.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+#include <unistd.h>
+
+namespace miplot {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'R', 'S'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t FLUSH_SIZE = 1 << 16;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numSeats;
+    uint32_t numEntrants;
+};
+
+static_assert(sizeof(Header) == 16, "Unexpected result stream header size");
+
+constexpr double Q = 0.0057564627324851142; // ln(10) / 400
+constexpr double PI = 3.14159265358979323846;
+
+// Expected score against an opponent rated diff points lower, of deviation g
+double expected(double diff, double g = 1.0)
+{
+    return 1.0 / (1.0 + std::exp(-g * diff * Q));
+}
+
+double glickoG(double deviation)
+{
+    return 1.0 / std::sqrt(1.0 + 3.0 * Q * Q * deviation * deviation / (PI * PI));
+}
+
+void writeAll(int fd, const std::string& data, const std::string& path)
+{
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        REQUIRE(n > 0, "Cannot write " << path << ": " << std::strerror(errno));
+        written += n;
+    }
+}
+
+} // namespace
+
+ResultStream::ResultStream(MappedFile file, const std::string& path)
+    : file_(std::move(file))
+{
+    REQUIRE(file_.size() >= sizeof(Header), "Result stream " << path << " is too short");
+    Header h;
+    std::memcpy(&h, file_.data(), sizeof(h));
+    REQUIRE(std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a result stream: " << path);
+    REQUIRE(h.version == VERSION, "Unsupported result stream version: " << h.version);
+    REQUIRE(h.numSeats > 0 && h.numEntrants <= 65536, "Invalid result stream " << path);
+
+    size_t pos = sizeof(Header);
+    for (uint32_t i = 0; i < h.numEntrants; ++i) {
+        uint32_t size;
+        REQUIRE(file_.size() - pos >= sizeof(size), "Result stream " << path << " is truncated");
+        std::memcpy(&size, file_.data() + pos, sizeof(size));
+        pos += sizeof(size);
+        REQUIRE(file_.size() - pos >= size, "Result stream " << path << " is truncated");
+        names_.emplace_back(reinterpret_cast<const char*>(file_.data() + pos), size);
+        pos += size;
+    }
+    numSeats_ = h.numSeats;
+    dataOffset_ = pos;
+    // A record torn by a crash is not counted
+    numRecords_ = (file_.size() - pos) / recordSize();
+}
+
+ResultStream ResultStream::open(const std::string& path)
+{
+    return ResultStream(MappedFile::open(path), path);
+}
+
+ResultStreamWriter::ResultStreamWriter(const std::string& path, const std::vector<std::string>& names,
+                                       size_t numSeats, size_t keepRecords)
+    : path_(path)
+    , numSeats_(numSeats)
+{
+    REQUIRE(numSeats > 0 && names.size() <= 65536, "Invalid result stream");
+    if (keepRecords > 0) {
+        size_t size;
+        {
+            auto stream = ResultStream::open(path);
+            REQUIRE(stream.numSeats() == numSeats && stream.names() == names,
+                    "Result stream " << path << " belongs to another run");
+            REQUIRE(stream.numRecords() >= keepRecords,
+                    "Result stream " << path << " has " << stream.numRecords() << " of " << keepRecords << " records");
+            size = stream.fileSize(keepRecords);
+        }
+        fd_ = ::open(path.c_str(), O_WRONLY);
+        REQUIRE(fd_ >= 0, "Cannot open " << path << ": " << std::strerror(errno));
+        REQUIRE(::ftruncate(fd_, size) == 0, "Cannot truncate " << path << ": " << std::strerror(errno));
+        REQUIRE(::lseek(fd_, size, SEEK_SET) >= 0, "Cannot seek " << path << ": " << std::strerror(errno));
+        return;
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    REQUIRE(fd_ >= 0, "Cannot open " << path << ": " << std::strerror(errno));
+    Header h;
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.numSeats = numSeats;
+    h.numEntrants = names.size();
+    buffer_.append(reinterpret_cast<const char*>(&h), sizeof(h));
+    for (const auto& name : names) {
+        uint32_t size = name.size();
+        buffer_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        buffer_.append(name);
+    }
+    flush();
+}
+
+ResultStreamWriter::~ResultStreamWriter()
+{
+    try {
+        flush();
+    } catch (const Exception& e) {
+        ERROR() << e.what();
+    }
+    ::close(fd_);
+}
+
+void ResultStreamWriter::append(const uint16_t* entrants, const uint8_t* places)
+{
+    buffer_.append(reinterpret_cast<const char*>(entrants), numSeats_ * sizeof(uint16_t));
+    buffer_.append(reinterpret_cast<const char*>(places), numSeats_);
+    if (buffer_.size() >= FLUSH_SIZE) {
+        flush();
+    }
+}
+
+void ResultStreamWriter::flush()
+{
+    writeAll(fd_, buffer_, path_);
+    buffer_.clear();
+}
+
+void ResultStreamWriter::sync()
+{
+    flush();
+    REQUIRE(::fdatasync(fd_) == 0, "Cannot sync " << path_ << ": " << std::strerror(errno));
+}
+
+RatingTable::RatingTable(RatingMethod method, double k, double minDeviation)
+    : method_(method)
+    , k_(k)
+    , minDeviation_(minDeviation)
+{
+}
+
+uint16_t RatingTable::add(const std::string& name)
+{
+    auto [itr, inserted] = indices_.emplace(name, ratings_.size());
+    if (inserted) {
+        REQUIRE(ratings_.size() < 65536, "Too many rated entrants");
+        names_.push_back(name);
+        ratings_.emplace_back();
+    }
+    return itr->second;
+}
+
+void RatingTable::update(const uint16_t* entrants, const uint8_t* places, size_t numSeats)
+{
+    REQUIRE(numSeats <= MAX_SEATS, "Games of up to " << MAX_SEATS << " seats are rated");
+    if (numSeats < 2) {
+        return;
+    }
+
+    // All changes are computed from the ratings before the game
+    std::array<Rating, MAX_SEATS> before;
+    for (size_t i = 0; i < numSeats; ++i) {
+        before[i] = ratings_[entrants[i]];
+    }
+    std::array<double, MAX_SEATS> g;
+    if (method_ == RatingMethod::Glicko) {
+        for (size_t i = 0; i < numSeats; ++i) {
+            g[i] = glickoG(before[i].deviation);
+        }
+    }
+
+    for (size_t i = 0; i < numSeats; ++i) {
+        double surprise = 0.0;
+        double information = 0.0;
+        for (size_t j = 0; j < numSeats; ++j) {
+            if (j == i) {
+                continue;
+            }
+            double score = places[i] < places[j] ? 1.0 : places[i] == places[j] ? 0.5 : 0.0;
+            double diff = before[i].value - before[j].value;
+            if (method_ == RatingMethod::Elo) {
+                surprise += score - expected(diff);
+            } else {
+                double e = expected(diff, g[j]);
+                surprise += g[j] * (score - e);
+                information += g[j] * g[j] * e * (1.0 - e);
+            }
+        }
+
+        Rating& rating = ratings_[entrants[i]];
+        if (method_ == RatingMethod::Elo) {
+            rating.value += k_ / (numSeats - 1) * surprise;
+        } else {
+            // 1 / RD'^2 = 1 / RD^2 + 1 / d^2
+            double precision = 1.0 / (before[i].deviation * before[i].deviation) + Q * Q * information;
+            rating.value += Q / precision * surprise;
+            rating.deviation = std::max(std::sqrt(1.0 / precision), minDeviation_);
+        }
+        ++rating.games;
+    }
+}
+
+void RatingTable::update(const ResultStream& stream)
+{
+    size_t numSeats = stream.numSeats();
+    REQUIRE(numSeats <= MAX_SEATS, "Games of up to " << MAX_SEATS << " seats are rated");
+
+    std::vector<uint16_t> indices;
+    for (const auto& name : stream.names()) {
+        indices.push_back(add(name));
+    }
+    std::array<uint16_t, MAX_SEATS> entrants;
+    for (size_t idx = 0; idx < stream.numRecords(); ++idx) {
+        const uint8_t* record = stream.record(idx);
+        std::memcpy(entrants.data(), record, numSeats * sizeof(uint16_t));
+        for (size_t i = 0; i < numSeats; ++i) {
+            REQUIRE(entrants[i] < indices.size(), "Invalid entrant in result " << idx);
+            entrants[i] = indices[entrants[i]];
+        }
+        update(entrants.data(), record + numSeats * sizeof(uint16_t), numSeats);
+    }
+}
+
+void RatingTable::print(std::ostream& out) const
+{
+    std::vector<size_t> order(ratings_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+        return ratings_[lhs].value > ratings_[rhs].value;
+    });
+
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (size_t rank = 0; rank < order.size(); ++rank) {
+        const auto& rating = ratings_[order[rank]];
+        out << std::setw(4) << rank + 1 << ". " << names_[order[rank]] << ": " << rating.value;
+        if (method_ == RatingMethod::Glicko) {
+            out << " +- " << 2 * rating.deviation;
+        }
+        out << " (" << rating.games << " games)\n";
+    }
+    out.flags(flags);
+}
+
+} // namespace miplot
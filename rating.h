@@ -0,0 +1,124 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miplot {
+
+/**
+ * Per-round results of a run as a binary file: who sat at every seat and in
+ * which place each finished. Records have a fixed size, so a stream is read
+ * through mmap and truncated to a checkpoint by its number of records.
+ *
+ * File layout, host byte order:
+ *   header: "DKRS", uint32 version, uint32 number of seats, uint32 number of entrants,
+ *           then every entrant's name as a uint32 size and its bytes
+ *   records: uint16 entrant of every seat, then uint8 place of every seat
+ */
+class ResultStream {
+public:
+    static ResultStream open(const std::string& path);
+
+    size_t numSeats() const { return numSeats_; }
+    size_t numRecords() const { return numRecords_; }
+    size_t recordSize() const { return 3 * numSeats_; }
+    const std::vector<std::string>& names() const { return names_; }
+
+    const uint8_t* record(size_t idx) const { return file_.data() + fileSize(idx); }
+
+    // Size of the file up to the end of the first numRecords records
+    size_t fileSize(size_t numRecords) const { return dataOffset_ + numRecords * recordSize(); }
+
+private:
+    explicit ResultStream(MappedFile file, const std::string& path);
+
+    MappedFile file_;
+    size_t numSeats_ = 0;
+    size_t numRecords_ = 0;
+    size_t dataOffset_ = 0;
+    std::vector<std::string> names_;
+};
+
+// Appends records to a result stream, buffered until sync()
+class ResultStreamWriter {
+public:
+    // Creates the stream, or keeps the first keepRecords records of an
+    // existing one with the same seats and entrants and appends after them
+    ResultStreamWriter(const std::string& path, const std::vector<std::string>& names,
+                       size_t numSeats, size_t keepRecords = 0);
+    ~ResultStreamWriter();
+
+    ResultStreamWriter(const ResultStreamWriter&) = delete;
+    ResultStreamWriter& operator= (const ResultStreamWriter&) = delete;
+
+    void append(const uint16_t* entrants, const uint8_t* places);
+
+    // Writes buffered records and syncs them to disk
+    void sync();
+
+    const std::string& path() const { return path_; }
+
+private:
+    void flush();
+
+    std::string path_;
+    size_t numSeats_;
+    int fd_ = -1;
+    std::string buffer_;
+};
+
+enum class RatingMethod { Elo, Glicko };
+
+struct Rating {
+    double value = 1500;
+    // Glicko rating deviation, Elo keeps the initial one
+    double deviation = 350;
+    uint64_t games = 0;
+};
+
+/**
+ * Ratings of named entrants, updated one game at a time. A game of n seats
+ * counts as a game between every pair of its entrants, scored by their
+ * finishing places, with Elo's K split between the n - 1 opponents.
+ * Glicko (Glickman 1999) treats every game as a rating period and keeps
+ * deviations above minDeviation, so that ratings still follow changes.
+ * An update allocates nothing and costs O(n^2) exponentials
+ */
+class RatingTable {
+public:
+    static constexpr size_t MAX_SEATS = 8;
+
+    explicit RatingTable(RatingMethod method = RatingMethod::Elo, double k = 16, double minDeviation = 30);
+
+    // Index of an entrant, added with the initial rating if new
+    uint16_t add(const std::string& name);
+
+    size_t size() const { return ratings_.size(); }
+    const std::string& name(size_t idx) const { return names_[idx]; }
+    const Rating& rating(size_t idx) const { return ratings_[idx]; }
+
+    // entrants[i] finished in places[i], lower places are better and equal ones tie
+    void update(const uint16_t* entrants, const uint8_t* places, size_t numSeats);
+
+    // Applies all records of a stream in order, entrants are matched by name
+    void update(const ResultStream& stream);
+
+    // Entrants from the highest rating down
+    void print(std::ostream& out) const;
+
+private:
+    RatingMethod method_;
+    double k_;
+    double minDeviation_;
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint16_t> indices_;
+    std::vector<Rating> ratings_;
+};
+
+} // namespace miplot
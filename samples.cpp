@@ -0,0 +1,359 @@
+#include "samples.h"
+#include "exception.h"
+
+#include <algorithm>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'K', 'S', 'P'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t numColumns;
+    uint32_t reserved;
+};
+
+struct Footer {
+    uint64_t indexOffset;
+    uint64_t numChunks;
+    uint64_t numRows;
+    char magic[4];
+    uint32_t version;
+};
+
+constexpr size_t INDEX_ENTRY_SIZE = 16;
+constexpr size_t CHUNK_HEADER_SIZE = sizeof(uint32_t) * (1 + NUM_SAMPLE_COLUMNS);
+
+static_assert(sizeof(Header) == 16, "Unexpected sample header size");
+static_assert(sizeof(Footer) == 32, "Unexpected sample footer size");
+
+/*
+ * Zero run encoding: a token below 0x80 is followed by token + 1 literal
+ * bytes, a token from 0x80 stands for token - 0x7f zero bytes
+ */
+constexpr size_t MAX_RUN = 0x80;
+
+void encodeZeroRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    size_t pos = 0;
+    while (pos < size) {
+        size_t run = 0;
+        while (pos + run < size && data[pos + run] == 0 && run < MAX_RUN) {
+            ++run;
+        }
+        if (run > 0) {
+            out.push_back(static_cast<uint8_t>(0x7f + run));
+            pos += run;
+            continue;
+        }
+
+        // Literals up to a pair of zeros, a single zero is cheaper inline
+        size_t end = pos;
+        while (end < size && end - pos < MAX_RUN
+               && !(data[end] == 0 && (end + 1 == size || data[end + 1] == 0))) {
+            ++end;
+        }
+        out.push_back(static_cast<uint8_t>(end - pos - 1));
+        out.insert(out.end(), data + pos, data + end);
+        pos = end;
+    }
+}
+
+void decodeZeroRuns(const uint8_t* data, size_t size, uint8_t* out, size_t outSize)
+{
+    size_t pos = 0;
+    size_t outPos = 0;
+    while (pos < size) {
+        uint8_t token = data[pos++];
+        if (token >= 0x80) {
+            size_t run = token - 0x7f;
+            REQUIRE(outPos + run <= outSize, "Sample column overflows");
+            std::fill(out + outPos, out + outPos + run, 0);
+            outPos += run;
+        } else {
+            size_t run = token + 1;
+            REQUIRE(pos + run <= size && outPos + run <= outSize, "Sample column overflows");
+            std::copy(data + pos, data + pos + run, out + outPos);
+            pos += run;
+            outPos += run;
+        }
+    }
+    REQUIRE(outPos == outSize, "Sample column is truncated");
+}
+
+// Group bytes of values by their position in the value
+void shuffleBytes(const uint8_t* values, size_t numValues, size_t width, uint8_t* out)
+{
+    for (size_t b = 0; b < width; ++b) {
+        for (size_t idx = 0; idx < numValues; ++idx) {
+            out[b * numValues + idx] = values[idx * width + b];
+        }
+    }
+}
+
+void unshuffleBytes(const uint8_t* shuffled, size_t numValues, size_t width, uint8_t* out)
+{
+    for (size_t b = 0; b < width; ++b) {
+        for (size_t idx = 0; idx < numValues; ++idx) {
+            out[idx * width + b] = shuffled[b * numValues + idx];
+        }
+    }
+}
+
+template <typename T>
+T load(const uint8_t* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void store(std::vector<uint8_t>& out, size_t pos, T value)
+{
+    std::memcpy(out.data() + pos, &value, sizeof(T));
+}
+
+} // namespace
+
+size_t columnWidth(SampleColumn column)
+{
+    switch (column) {
+        case SampleColumn::Round:
+        case SampleColumn::Hand:
+        case SampleColumn::Undefended:
+        case SampleColumn::Attacking:
+        case SampleColumn::Defending:
+        case SampleColumn::Discard:
+            return sizeof(uint64_t);
+        default:
+            return sizeof(uint8_t);
+    }
+}
+
+void SampleChunk::clear()
+{
+    resize(0);
+}
+
+void SampleChunk::resize(size_t numRows)
+{
+    numRows_ = numRows;
+    for (size_t idx = 0; idx < NUM_SAMPLE_COLUMNS; ++idx) {
+        columns_[idx].resize(numRows * columnWidth(static_cast<SampleColumn>(idx)));
+    }
+}
+
+void SampleChunk::set(size_t row, size_t seat, const DecisionRecord& record, size_t action)
+{
+    put<uint64_t>(SampleColumn::Round, row, 0);
+    put<uint8_t>(SampleColumn::Seat, row, seat);
+    put<uint8_t>(SampleColumn::Kind, row, static_cast<uint8_t>(record.kind));
+    put<uint8_t>(SampleColumn::Trump, row, record.trump);
+    put<uint8_t>(SampleColumn::NumPlayers, row, record.numPlayers);
+    put<uint8_t>(SampleColumn::NumOtherCards, row, record.numOtherCards);
+    put<uint8_t>(SampleColumn::DeckSize, row, record.deckSize);
+    put<uint64_t>(SampleColumn::Hand, row, record.hand.mask());
+    put<uint64_t>(SampleColumn::Undefended, row, record.undefended.mask());
+    put<uint64_t>(SampleColumn::Attacking, row, record.attacking.mask());
+    put<uint64_t>(SampleColumn::Defending, row, record.defending.mask());
+    put<uint64_t>(SampleColumn::Discard, row, record.discard.mask());
+    put<uint8_t>(SampleColumn::Action, row, action);
+    put<int8_t>(SampleColumn::Outcome, row, 0);
+}
+
+void SampleChunk::setRound(size_t row, uint64_t round)
+{
+    put<uint64_t>(SampleColumn::Round, row, round);
+}
+
+void SampleChunk::setOutcome(size_t row, int outcome)
+{
+    put<int8_t>(SampleColumn::Outcome, row, outcome);
+}
+
+DecisionRecord SampleChunk::record(size_t row) const
+{
+    DecisionRecord record;
+    record.kind = static_cast<protocol::DecisionKind>(get<uint8_t>(SampleColumn::Kind, row));
+    record.trump = get<uint8_t>(SampleColumn::Trump, row);
+    record.numPlayers = get<uint8_t>(SampleColumn::NumPlayers, row);
+    record.numOtherCards = get<uint8_t>(SampleColumn::NumOtherCards, row);
+    record.deckSize = get<uint8_t>(SampleColumn::DeckSize, row);
+    record.hand = CardSet(get<uint64_t>(SampleColumn::Hand, row));
+    record.undefended = CardSet(get<uint64_t>(SampleColumn::Undefended, row));
+    record.attacking = CardSet(get<uint64_t>(SampleColumn::Attacking, row));
+    record.defending = CardSet(get<uint64_t>(SampleColumn::Defending, row));
+    record.discard = CardSet(get<uint64_t>(SampleColumn::Discard, row));
+    return record;
+}
+
+std::vector<uint8_t> compressChunk(const SampleChunk& chunk)
+{
+    std::vector<uint8_t> out(CHUNK_HEADER_SIZE);
+    store<uint32_t>(out, 0, chunk.numRows());
+
+    std::vector<uint8_t> shuffled;
+    for (size_t idx = 0; idx < NUM_SAMPLE_COLUMNS; ++idx) {
+        auto column = static_cast<SampleColumn>(idx);
+        const auto& values = chunk.column(column);
+        shuffled.resize(values.size());
+        shuffleBytes(values.data(), chunk.numRows(), columnWidth(column), shuffled.data());
+
+        size_t start = out.size();
+        encodeZeroRuns(shuffled.data(), shuffled.size(), out);
+        store<uint32_t>(out, sizeof(uint32_t) * (1 + idx), out.size() - start);
+    }
+    return out;
+}
+
+
+SampleWriter::SampleWriter(const std::string& path)
+    : file_(path, std::ios::binary | std::ios::trunc)
+{
+    REQUIRE(file_, "Cannot create " << path);
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.numColumns = NUM_SAMPLE_COLUMNS;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset_ = sizeof(header);
+}
+
+SampleWriter::~SampleWriter()
+{
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void SampleWriter::append(const std::vector<uint8_t>& compressedChunk, size_t numRows)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    REQUIRE(file_.is_open(), "Sample file is closed");
+    file_.write(reinterpret_cast<const char*>(compressedChunk.data()), compressedChunk.size());
+    REQUIRE(file_, "Cannot write samples");
+    index_.push_back(IndexEntry{offset_, static_cast<uint32_t>(compressedChunk.size()),
+                                static_cast<uint32_t>(numRows)});
+    offset_ += compressedChunk.size();
+    numRows_ += numRows;
+}
+
+void SampleWriter::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+
+    Footer footer{};
+    footer.indexOffset = offset_;
+    footer.numChunks = index_.size();
+    footer.numRows = numRows_;
+    std::memcpy(footer.magic, MAGIC, sizeof(MAGIC));
+    footer.version = VERSION;
+
+    for (const auto& entry : index_) {
+        file_.write(reinterpret_cast<const char*>(&entry.offset), sizeof(entry.offset));
+        file_.write(reinterpret_cast<const char*>(&entry.size), sizeof(entry.size));
+        file_.write(reinterpret_cast<const char*>(&entry.numRows), sizeof(entry.numRows));
+    }
+    file_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    offset_ += index_.size() * INDEX_ENTRY_SIZE + sizeof(footer);
+    file_.close();
+    REQUIRE(file_, "Cannot write samples");
+}
+
+size_t SampleWriter::numRows() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return numRows_;
+}
+
+size_t SampleWriter::numBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return offset_;
+}
+
+
+SampleReader::SampleReader(const std::string& path)
+    : file_(MappedFile::open(path))
+{
+    const uint8_t* data = file_.data();
+    size_t size = file_.size();
+    REQUIRE(size >= sizeof(Header) + sizeof(Footer), "Sample file is too short: " << path);
+
+    auto header = load<Header>(data);
+    REQUIRE(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0, "Not a sample file: " << path);
+    REQUIRE(header.version == VERSION, "Unsupported sample file version: " << header.version);
+    REQUIRE(header.numColumns == NUM_SAMPLE_COLUMNS, "Unexpected number of columns: " << header.numColumns);
+
+    auto footer = load<Footer>(data + size - sizeof(Footer));
+    REQUIRE(std::memcmp(footer.magic, MAGIC, sizeof(MAGIC)) == 0,
+            "Sample file is not closed: " << path);
+    REQUIRE(footer.indexOffset >= sizeof(Header)
+            && footer.indexOffset + footer.numChunks * INDEX_ENTRY_SIZE + sizeof(Footer) == size,
+            "Sample index is out of the file");
+
+    numChunks_ = footer.numChunks;
+    numRows_ = footer.numRows;
+    indexOffset_ = footer.indexOffset;
+
+    for (size_t idx = 0; idx < numChunks_; ++idx) {
+        const uint8_t* entry = indexEntry(idx);
+        uint64_t offset = load<uint64_t>(entry);
+        uint32_t chunkSize = load<uint32_t>(entry + 8);
+        REQUIRE(offset >= sizeof(Header) && chunkSize >= CHUNK_HEADER_SIZE
+                && offset + chunkSize <= indexOffset_,
+                "Sample chunk " << idx << " is out of the file");
+    }
+}
+
+const uint8_t* SampleReader::indexEntry(size_t chunkIdx) const
+{
+    REQUIRE(chunkIdx < numChunks_, "No sample chunk " << chunkIdx);
+    return file_.data() + indexOffset_ + chunkIdx * INDEX_ENTRY_SIZE;
+}
+
+size_t SampleReader::chunkRows(size_t chunkIdx) const
+{
+    return load<uint32_t>(indexEntry(chunkIdx) + 12);
+}
+
+size_t SampleReader::chunkBytes(size_t chunkIdx) const
+{
+    return load<uint32_t>(indexEntry(chunkIdx) + 8);
+}
+
+void SampleReader::read(size_t chunkIdx, SampleChunk& chunk) const
+{
+    const uint8_t* entry = indexEntry(chunkIdx);
+    const uint8_t* data = file_.data() + load<uint64_t>(entry);
+    size_t size = load<uint32_t>(entry + 8);
+
+    size_t numRows = load<uint32_t>(data);
+    REQUIRE(numRows == chunkRows(chunkIdx), "Sample chunk " << chunkIdx << " does not match the index");
+    chunk.resize(numRows);
+
+    std::vector<uint8_t> shuffled;
+    size_t pos = CHUNK_HEADER_SIZE;
+    for (size_t idx = 0; idx < NUM_SAMPLE_COLUMNS; ++idx) {
+        auto column = static_cast<SampleColumn>(idx);
+        size_t columnSize = load<uint32_t>(data + sizeof(uint32_t) * (1 + idx));
+        REQUIRE(pos + columnSize <= size, "Sample chunk " << chunkIdx << " is truncated");
+
+        auto& values = chunk.column(column);
+        shuffled.resize(values.size());
+        decodeZeroRuns(data + pos, columnSize, shuffled.data(), shuffled.size());
+        unshuffleBytes(shuffled.data(), numRows, columnWidth(column), values.data());
+        pos += columnSize;
+    }
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "neural/features.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Columns of training samples, one row per decision
+ */
+enum class SampleColumn : uint8_t {
+    Round,          // uint64 index of the round
+    Seat,           // uint8 seat of the deciding player
+    Kind,           // uint8 protocol::DecisionKind
+    Trump,          // uint8
+    NumPlayers,     // uint8
+    NumOtherCards,  // uint8 cards in other players' hands
+    DeckSize,       // uint8
+    Hand,           // uint64 card masks
+    Undefended,
+    Attacking,
+    Defending,
+    Discard,
+    Action,         // uint8 card code or PASS_ACTION
+    Outcome,        // int8 1 if the seat did not lose the round, -1 if it lost, 0 on draw
+};
+
+constexpr size_t NUM_SAMPLE_COLUMNS = static_cast<size_t>(SampleColumn::Outcome) + 1;
+
+// Width of a column value in bytes
+size_t columnWidth(SampleColumn column);
+
+/**
+ * Rows of a chunk stored column by column
+ */
+class SampleChunk {
+public:
+    size_t numRows() const { return numRows_; }
+
+    void clear();
+    void resize(size_t numRows);
+
+    // Outcome and round are set when the round ends
+    void set(size_t row, size_t seat, const DecisionRecord& record, size_t action);
+    void setRound(size_t row, uint64_t round);
+    void setOutcome(size_t row, int outcome);
+
+    uint64_t round(size_t row) const { return get<uint64_t>(SampleColumn::Round, row); }
+    size_t seat(size_t row) const { return get<uint8_t>(SampleColumn::Seat, row); }
+    size_t action(size_t row) const { return get<uint8_t>(SampleColumn::Action, row); }
+    int outcome(size_t row) const { return get<int8_t>(SampleColumn::Outcome, row); }
+    DecisionRecord record(size_t row) const;
+
+    // Write NUM_FEATURES values of the row
+    void features(size_t row, float* features) const { encodeFeatures(record(row), features); }
+
+    const std::vector<uint8_t>& column(SampleColumn column) const { return columns_[index(column)]; }
+    std::vector<uint8_t>& column(SampleColumn column) { return columns_[index(column)]; }
+
+private:
+    static size_t index(SampleColumn column) { return static_cast<size_t>(column); }
+
+    template <typename T>
+    T get(SampleColumn column, size_t row) const
+    {
+        T value;
+        std::memcpy(&value, columns_[index(column)].data() + row * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void put(SampleColumn column, size_t row, T value)
+    {
+        std::memcpy(columns_[index(column)].data() + row * sizeof(T), &value, sizeof(T));
+    }
+
+    size_t numRows_ = 0;
+    std::vector<uint8_t> columns_[NUM_SAMPLE_COLUMNS];
+};
+
+/*
+ * Sample file layout, host byte order:
+ *   header: "DKSP", uint32 version, uint32 number of columns, uint32 reserved
+ *   chunks: uint32 number of rows, uint32 compressed size of every column,
+ *           compressed columns
+ *   index: uint64 offset, uint32 size, uint32 number of rows per chunk
+ *   footer: uint64 index offset, uint64 number of chunks, uint64 number of rows,
+ *           "DKSP", uint32 version
+ * A column is compressed by grouping the bytes of its values by position
+ * (all first bytes, then all second bytes...), which turns high zero bytes
+ * of small values and card masks into long runs, and encoding zero runs.
+ */
+
+// Compressed chunk
+std::vector<uint8_t> compressChunk(const SampleChunk& chunk);
+
+/**
+ * Appends compressed chunks to a file from any number of threads.
+ * The index is written by close()
+ */
+class SampleWriter {
+public:
+    explicit SampleWriter(const std::string& path);
+    ~SampleWriter();
+
+    SampleWriter(const SampleWriter&) = delete;
+    SampleWriter& operator= (const SampleWriter&) = delete;
+
+    void append(const std::vector<uint8_t>& compressedChunk, size_t numRows);
+
+    void close();
+
+    size_t numRows() const;
+    size_t numBytes() const;
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t numRows;
+    };
+
+    mutable std::mutex mutex_;
+    std::ofstream file_;
+    std::vector<IndexEntry> index_;
+    uint64_t offset_ = 0;
+    uint64_t numRows_ = 0;
+};
+
+/**
+ * Reads chunks of a sample file through mmap
+ */
+class SampleReader {
+public:
+    explicit SampleReader(const std::string& path);
+
+    size_t numChunks() const { return numChunks_; }
+    size_t numRows() const { return numRows_; }
+    size_t chunkRows(size_t chunkIdx) const;
+    size_t chunkBytes(size_t chunkIdx) const;
+
+    void read(size_t chunkIdx, SampleChunk& chunk) const;
+
+private:
+    const uint8_t* indexEntry(size_t chunkIdx) const;
+
+    MappedFile file_;
+    size_t numChunks_ = 0;
+    size_t numRows_ = 0;
+    size_t indexOffset_ = 0;
+};
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,163 @@
+#include "selfplay.h"
+#include "exception.h"
+
+#include <algorithm>
+
+namespace miplot::cardgame::durak {
+
+using protocol::DecisionKind;
+
+SampleRecorder::SampleRecorder(SampleWriter& writer, Rules rules, size_t chunkRows)
+    : writer_(writer)
+    , rules_(rules)
+    , chunkRows_(chunkRows)
+{
+    REQUIRE(chunkRows_ > 0, "Chunk size must be positive");
+}
+
+void SampleRecorder::record(size_t seat, DecisionKind kind, const GameState& state, const Cards& hand,
+                            int cardIdx)
+{
+    // Grow geometrically, a round may run past the chunk size
+    if (numRows_ == chunk_.numRows()) {
+        chunk_.resize(std::max<size_t>(numRows_ * 2, 1024));
+    }
+    SuitPermutation permutation;
+    DecisionRecord decision = canonicalize(describeDecision(kind, state, hand), permutation);
+    size_t action = cardIdx == -1 ? PASS_ACTION : permutation(static_cast<size_t>(hand[cardIdx].code()));
+    chunk_.set(numRows_++, seat, decision, action);
+}
+
+void SampleRecorder::finishRound(size_t round, const RoundResult& result)
+{
+    for (size_t row = roundStart_; row < numRows_; ++row) {
+        size_t seat = chunk_.seat(row);
+        int outcome = 0;
+        if (result.losingPlayerIdx) {
+            bool lost = rules_.numTeams && result.losingTeamIdx
+                ? seat % rules_.numTeams == *result.losingTeamIdx
+                : seat == *result.losingPlayerIdx;
+            outcome = lost ? -1 : 1;
+        }
+        chunk_.setRound(row, round);
+        chunk_.setOutcome(row, outcome);
+    }
+    roundStart_ = numRows_;
+
+    if (numRows_ >= chunkRows_) {
+        flush();
+    }
+}
+
+void SampleRecorder::flush()
+{
+    REQUIRE(roundStart_ == numRows_, "Round is not finished");
+    if (numRows_ == 0) {
+        return;
+    }
+    chunk_.resize(numRows_);
+    writer_.append(compressChunk(chunk_), numRows_);
+    numRows_ = 0;
+    roundStart_ = 0;
+}
+
+
+RecordingStrategy::RecordingStrategy(std::unique_ptr<Strategy> strategy, size_t seat, SampleRecorder& recorder)
+    : strategy_(std::move(strategy))
+    , seat_(seat)
+    , recorder_(recorder)
+{
+}
+
+int RecordingStrategy::attack(const GameState& state, const Cards& hand)
+{
+    int cardIdx = strategy_->attack(state, hand);
+    recorder_.record(seat_, DecisionKind::Attack, state, hand, cardIdx);
+    return cardIdx;
+}
+
+AttackBatch RecordingStrategy::attackBatch(const GameState& state, const Cards& hand)
+{
+    auto batch = strategy_->attackBatch(state, hand);
+    recorder_.record(seat_, DecisionKind::Attack, state, hand, batch.empty() ? -1 : int(batch[0]));
+    return batch;
+}
+
+int RecordingStrategy::defend(const GameState& state, const Cards& hand)
+{
+    int cardIdx = strategy_->defend(state, hand);
+    recorder_.record(seat_, DecisionKind::Defend, state, hand, cardIdx);
+    return cardIdx;
+}
+
+int RecordingStrategy::transfer(const GameState& state, const Cards& hand)
+{
+    int cardIdx = strategy_->transfer(state, hand);
+    recorder_.record(seat_, DecisionKind::Transfer, state, hand, cardIdx);
+    return cardIdx;
+}
+
+const std::string& RecordingStrategy::name() const
+{
+    return strategy_->name();
+}
+
+void RecordingStrategy::seed(uint64_t value)
+{
+    strategy_->seed(value);
+}
+
+GameObserver* RecordingStrategy::observer()
+{
+    return strategy_->observer();
+}
+
+std::string RecordingStrategy::saveState() const
+{
+    return strategy_->saveState();
+}
+
+void RecordingStrategy::loadState(const std::string& state)
+{
+    strategy_->loadState(state);
+}
+
+
+SelfPlay::SelfPlay(size_t numPlayers, SeatStrategyFactory factory, SampleWriter& writer,
+                   size_t numThreads, Rules rules, size_t chunkRows)
+    : numPlayers_(numPlayers)
+    , factory_(std::move(factory))
+    , writer_(writer)
+    , numThreads_(std::max<size_t>(1, numThreads))
+    , rules_(rules)
+    , chunkRows_(chunkRows)
+{
+}
+
+SimulationResult SelfPlay::run(uint64_t seed, size_t firstRound, size_t numRounds)
+{
+    std::vector<std::unique_ptr<SampleRecorder>> recorders;
+    for (size_t idx = 0; idx < numThreads_; ++idx) {
+        recorders.push_back(std::make_unique<SampleRecorder>(writer_, rules_, chunkRows_));
+    }
+
+    Simulator simulator([&](size_t threadIdx) {
+        Players players;
+        for (size_t seat = 0; seat < numPlayers_; ++seat) {
+            auto strategy = std::make_unique<RecordingStrategy>(factory_(seat), seat, *recorders[threadIdx]);
+            players.emplace_back("Player " + std::to_string(seat + 1), std::move(strategy));
+        }
+        return players;
+    }, numThreads_, rules_);
+
+    auto onRound = [&](size_t threadIdx, size_t round, const RoundResult& roundResult) {
+        recorders[threadIdx]->finishRound(round, roundResult);
+    };
+    auto result = simulator.run(seed, firstRound, numRounds, onRound);
+    for (auto& recorder : recorders) {
+        recorder->flush();
+    }
+    return result;
+}
+
+} // namespace miplot::cardgame::durak
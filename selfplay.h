@@ -0,0 +1,98 @@
+#pragma once
+
+#include "samples.h"
+#include "simulator.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Collects the decisions of one simulation thread into a chunk.
+ * Outcomes are filled in when the round ends, and a full chunk is compressed
+ * and written only between rounds. So it holds at most one chunk and never
+ * keeps finished rounds
+ */
+class SampleRecorder {
+public:
+    static constexpr size_t DEFAULT_CHUNK_ROWS = 1 << 16;
+
+    SampleRecorder(SampleWriter& writer, Rules rules, size_t chunkRows = DEFAULT_CHUNK_ROWS);
+
+    void record(size_t seat, protocol::DecisionKind kind, const GameState& state, const Cards& hand, int cardIdx);
+
+    // Set outcomes of the round's decisions, write the chunk if it is full
+    void finishRound(size_t round, const RoundResult& result);
+
+    // Write the rest, the round in progress must be finished
+    void flush();
+
+private:
+    SampleWriter& writer_;
+    Rules rules_;
+    size_t chunkRows_;
+
+    SampleChunk chunk_;
+    size_t numRows_ = 0;
+    size_t roundStart_ = 0;
+};
+
+/**
+ * Passes decisions of another strategy through, recording them.
+ * A batched attack is recorded by its first card
+ */
+class RecordingStrategy : public Strategy {
+public:
+    RecordingStrategy(std::unique_ptr<Strategy> strategy, size_t seat, SampleRecorder& recorder);
+
+    int attack(const GameState& state, const Cards& hand) override;
+
+    AttackBatch attackBatch(const GameState& state, const Cards& hand) override;
+
+    int defend(const GameState& state, const Cards& hand) override;
+
+    int transfer(const GameState& state, const Cards& hand) override;
+
+    const std::string& name() const override;
+
+    void seed(uint64_t value) override;
+
+    GameObserver* observer() override;
+
+    std::string saveState() const override;
+    void loadState(const std::string& state) override;
+
+private:
+    std::unique_ptr<Strategy> strategy_;
+    size_t seat_;
+    SampleRecorder& recorder_;
+};
+
+// Creates the strategy of a seat for every simulation thread
+using SeatStrategyFactory = std::function<std::unique_ptr<Strategy>(size_t seat)>;
+
+/**
+ * Plays rounds on the parallel simulator and writes every decision
+ * of every seat as a training sample
+ */
+class SelfPlay {
+public:
+    SelfPlay(size_t numPlayers, SeatStrategyFactory factory, SampleWriter& writer,
+             size_t numThreads = defaultNumThreads(), Rules rules = Rules(),
+             size_t chunkRows = SampleRecorder::DEFAULT_CHUNK_ROWS);
+
+    // Chunks are flushed at the end, the writer stays open for more runs
+    SimulationResult run(uint64_t seed, size_t firstRound, size_t numRounds);
+
+private:
+    size_t numPlayers_;
+    SeatStrategyFactory factory_;
+    SampleWriter& writer_;
+    size_t numThreads_;
+    Rules rules_;
+    size_t chunkRows_;
+};
+
+} // namespace miplot::cardgame::durak
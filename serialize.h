@@ -7,6 +7,10 @@
 
 namespace miplot::cardgame::durak {
 
-std::ostream& operator<< (std::ostream& os, const CardPair& pair);
+template <typename CardTraits>
+std::ostream& operator<< (std::ostream& os, const BasicCardPair<CardTraits>& pair)
+{
+    return os << "(" << pair.attacking << "," << pair.defending << ")";
+}
 
-} // namespace miplot::cardgame::durak
\ No newline at end of file
+} // namespace miplot::cardgame::durak
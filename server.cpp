@@ -0,0 +1,662 @@
+#include "server.h"
+#include "async_game.h"
+#include "exception.h"
+#include "logging/logging.h"
+#include "protocol.h"
+#include "simulator.h"
+
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+using protocol::DecisionKind;
+using protocol::MessageType;
+
+constexpr uint64_t LISTENER_ID = 0;
+constexpr int MAX_EVENTS = 256;
+constexpr int POLL_TIMEOUT_MS = 100;
+constexpr size_t READ_CHUNK = 4096;
+
+class RemoteStrategy;
+struct Table;
+
+struct Connection {
+    uint64_t id;
+    int fd;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    size_t outputSent = 0;
+
+    // Peer is gone, the table plays on with bots until the round ends
+    bool closed = false;
+    // Close once the output is flushed
+    bool closing = false;
+    bool dirty = false;
+    bool pollingOut = false;
+
+    std::unique_ptr<Table> table;
+
+    std::vector<Connection*>* dirtyList;
+
+    void markDirty()
+    {
+        if (!dirty) {
+            dirty = true;
+            dirtyList->push_back(this);
+        }
+    }
+
+    size_t footprint() const;
+};
+
+/**
+ * Seat of the remote client. Requests are written to the connection and
+ * answered when the response arrives. Once the client is gone, decisions
+ * are taken by the fallback strategy
+ */
+class RemoteStrategy : public AsyncStrategy {
+public:
+    explicit RemoteStrategy(Connection& connection) : connection_(connection) {}
+
+    async::Decision<int> attackAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override
+    {
+        return ask(DecisionKind::Attack, state, hand, slot);
+    }
+
+    async::Decision<int> defendAsync(const GameState& state, const Cards& hand,
+                                     async::DecisionSlot<int>& slot) override
+    {
+        return ask(DecisionKind::Defend, state, hand, slot);
+    }
+
+    async::Decision<int> transferAsync(const GameState& state, const Cards& hand,
+                                       async::DecisionSlot<int>& slot) override
+    {
+        return ask(DecisionKind::Transfer, state, hand, slot);
+    }
+
+    const std::string& name() const override
+    {
+        static const std::string NAME = "Remote";
+        return NAME;
+    }
+
+    void newRound() { discardSent_ = 0; }
+
+    // Return false if the response does not answer the pending request
+    bool respond(const protocol::Response& response)
+    {
+        if (!slot_ || response.id != requestId_
+                || response.cardIdx < -1 || response.cardIdx >= (int)hand_->size()) {
+            return false;
+        }
+        std::exchange(slot_, nullptr)->resolve(response.cardIdx);
+        return true;
+    }
+
+    void abandon()
+    {
+        if (slot_) {
+            std::exchange(slot_, nullptr)->resolve(fallback(kind_, *state_, *hand_));
+        }
+    }
+
+private:
+    async::Decision<int> ask(DecisionKind kind, const GameState& state, const Cards& hand,
+                             async::DecisionSlot<int>& slot)
+    {
+        if (connection_.closed) {
+            return fallback(kind, state, hand);
+        }
+
+        protocol::Writer writer(connection_.output);
+        protocol::writeRequest(writer, ++requestId_, kind, state, hand, discardSent_);
+        connection_.markDirty();
+        discardSent_ = state.discard().size();
+
+        slot_ = &slot;
+        kind_ = kind;
+        state_ = &state;
+        hand_ = &hand;
+        return slot.pending();
+    }
+
+    int fallback(DecisionKind kind, const GameState& state, const Cards& hand)
+    {
+        switch (kind) {
+            case DecisionKind::Attack: return fallback_.attack(state, hand);
+            case DecisionKind::Defend: return fallback_.defend(state, hand);
+            case DecisionKind::Transfer: return fallback_.transfer(state, hand);
+        }
+        return -1;
+    }
+
+    Connection& connection_;
+    MinCardStrategy fallback_;
+    size_t discardSent_ = 0;
+    uint32_t requestId_ = 0;
+
+    // Pending request
+    async::DecisionSlot<int>* slot_ = nullptr;
+    DecisionKind kind_ = DecisionKind::Attack;
+    const GameState* state_ = nullptr;
+    const Cards* hand_ = nullptr;
+};
+
+Players makePlayers(Connection& connection, size_t numPlayers, RemoteStrategy*& remote)
+{
+    auto strategy = std::make_unique<RemoteStrategy>(connection);
+    remote = strategy.get();
+
+    Players players;
+    players.emplace_back("Remote", std::move(strategy));
+    for (size_t idx = 1; idx < numPlayers; ++idx) {
+        players.emplace_back("Bot " + std::to_string(idx), std::make_unique<MinCardStrategy>());
+    }
+    return players;
+}
+
+struct Table {
+    Table(Connection& connection, const protocol::Join& join, async::Scheduler& scheduler)
+        : game(makePlayers(connection, join.numPlayers, remote), scheduler, join.rules)
+        , numRounds(join.numRounds)
+    {
+        game.seed(join.seed);
+    }
+
+    RemoteStrategy* remote;
+    AsyncGame game;
+    uint32_t numRounds;
+};
+
+size_t Connection::footprint() const
+{
+    size_t result = sizeof(Connection) + input.capacity() + output.capacity();
+    if (table) {
+        // The remote seat and min-card bots, see makePlayers()
+        result += sizeof(Table) + table->game.footprint() + sizeof(RemoteStrategy)
+                + (table->game.numPlayers() - 1) * sizeof(MinCardStrategy);
+    }
+    return result;
+}
+
+void setNonBlocking(int fd)
+{
+    int flags = ::fcntl(fd, F_GETFL);
+    REQUIRE(flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0,
+            "Cannot make socket non-blocking: " << std::strerror(errno));
+}
+
+} // namespace
+
+class Server::Worker {
+public:
+    Worker(Server& server);
+    ~Worker();
+
+    void run();
+
+    const ServerStats& stats() const { return stats_; }
+
+private:
+    void accept();
+    void onEvent(Connection& connection, uint32_t events);
+    void onReadable(Connection& connection);
+    void onFrame(Connection& connection, MessageType type, protocol::Reader& payload);
+    void startTable(Connection& connection, protocol::Join join);
+    async::Task<uint32_t> playTable(Connection& connection);
+
+    // Send an error and close the connection
+    void fail(Connection& connection, const std::string& message);
+    void disconnect(Connection& connection);
+
+    void flush();
+    void flush(Connection& connection);
+    void updatePolling(Connection& connection, bool pollOut);
+
+    // Remove finished tables and closed connections
+    void reap();
+
+    void shutdown();
+
+    Server& server_;
+    int epoll_ = -1;
+    async::Scheduler scheduler_;
+
+    uint64_t nextId_ = LISTENER_ID + 1;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections_;
+    std::vector<Connection*> dirty_;
+    std::vector<uint64_t> finished_;
+    std::vector<uint64_t> closed_;
+    size_t numTables_ = 0;
+
+    ServerStats stats_;
+};
+
+Server::Worker::Worker(Server& server)
+    : server_(server)
+    , epoll_(::epoll_create1(EPOLL_CLOEXEC))
+{
+    REQUIRE(epoll_ >= 0, "Cannot create epoll: " << std::strerror(errno));
+
+    // Every worker accepts its own connections
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = LISTENER_ID;
+    REQUIRE(::epoll_ctl(epoll_, EPOLL_CTL_ADD, server_.listener_, &event) == 0,
+            "Cannot poll the listening socket: " << std::strerror(errno));
+}
+
+Server::Worker::~Worker()
+{
+    for (auto& [id, connection] : connections_) {
+        if (connection->fd >= 0) {
+            ::close(connection->fd);
+        }
+    }
+    ::close(epoll_);
+}
+
+void Server::Worker::run()
+{
+    epoll_event events[MAX_EVENTS];
+    while (!server_.stopping_) {
+        int numEvents = ::epoll_wait(epoll_, events, MAX_EVENTS, POLL_TIMEOUT_MS);
+        if (numEvents < 0) {
+            REQUIRE(errno == EINTR, "epoll_wait failed: " << std::strerror(errno));
+            continue;
+        }
+
+        for (int i = 0; i < numEvents; ++i) {
+            if (events[i].data.u64 == LISTENER_ID) {
+                accept();
+                continue;
+            }
+            auto itr = connections_.find(events[i].data.u64);
+            if (itr != connections_.end()) {
+                onEvent(*itr->second, events[i].events);
+            }
+        }
+
+        scheduler_.run();
+        flush();
+        reap();
+    }
+    shutdown();
+}
+
+void Server::Worker::accept()
+{
+    while (true) {
+        int fd = ::accept4(server_.listener_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            REQUIRE(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR
+                    || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE,
+                    "accept failed: " << std::strerror(errno));
+            if (errno == EMFILE || errno == ENFILE) {
+                WARN() << "Out of file descriptors, connection is not accepted";
+            }
+            return;
+        }
+
+        auto connection = std::make_unique<Connection>();
+        connection->id = nextId_++;
+        connection->fd = fd;
+        connection->dirtyList = &dirty_;
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = connection->id;
+        REQUIRE(::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) == 0,
+                "Cannot poll a connection: " << std::strerror(errno));
+
+        connections_.emplace(connection->id, std::move(connection));
+        ++stats_.connections;
+    }
+}
+
+void Server::Worker::onEvent(Connection& connection, uint32_t events)
+{
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        onReadable(connection);
+    }
+    if ((events & EPOLLOUT) && !connection.closed) {
+        connection.markDirty();
+    }
+}
+
+void Server::Worker::onReadable(Connection& connection)
+{
+    // Input never grows past the budget: the rest is read once the frames
+    // already read are handled, sockets are polled level-triggered
+    size_t budget = server_.options_.tableBudget;
+    while (!connection.closed) {
+        size_t size = connection.input.size();
+        if (size + READ_CHUNK > budget) {
+            break;
+        }
+        connection.input.resize(size + READ_CHUNK);
+        ssize_t numRead = ::read(connection.fd, connection.input.data() + size, READ_CHUNK);
+        connection.input.resize(size + std::max<ssize_t>(numRead, 0));
+
+        if (numRead == 0 || (numRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            disconnect(connection);
+            return;
+        }
+        if (numRead < 0) {
+            break;
+        }
+    }
+
+    size_t pos = 0;
+    try {
+        while (!connection.closing) {
+            size_t frameSize = protocol::frameSize(connection.input.data() + pos,
+                                                   connection.input.size() - pos);
+            if (frameSize == 0) {
+                break;
+            }
+            const uint8_t* frame = connection.input.data() + pos;
+            auto payload = protocol::framePayload(frame, frameSize);
+            onFrame(connection, protocol::frameType(frame), payload);
+            pos += frameSize;
+        }
+    } catch (const Exception& e) {
+        fail(connection, std::string("Malformed message: ") + e.what());
+        return;
+    }
+    connection.input.erase(connection.input.begin(), connection.input.begin() + pos);
+
+    if (connection.input.size() + READ_CHUNK > budget || connection.footprint() > budget) {
+        fail(connection, "Memory budget exceeded");
+    }
+}
+
+void Server::Worker::onFrame(Connection& connection, MessageType type, protocol::Reader& payload)
+{
+    switch (type) {
+        case MessageType::Join: {
+            auto join = protocol::readJoin(payload);
+            startTable(connection, join);
+            break;
+        }
+        case MessageType::Response: {
+            auto response = protocol::readResponse(payload);
+            if (!connection.table || !connection.table->remote->respond(response)) {
+                fail(connection, "Unexpected response " + std::to_string(response.id));
+            } else {
+                ++stats_.decisions;
+            }
+            break;
+        }
+        default:
+            fail(connection, "Unexpected message type " + std::to_string(static_cast<int>(type)));
+    }
+}
+
+void Server::Worker::startTable(Connection& connection, protocol::Join join)
+{
+    if (connection.table) {
+        fail(connection, "Table is already running");
+        return;
+    }
+    if (numTables_ >= server_.options_.maxTablesPerThread) {
+        fail(connection, "Server is full");
+        return;
+    }
+
+    try {
+        REQUIRE(join.numRounds > 0, "No rounds to play");
+        join.rules.maxBouts = server_.options_.maxBoutsPerRound;
+        connection.table = std::make_unique<Table>(connection, join, scheduler_);
+    } catch (const Exception& e) {
+        fail(connection, e.what());
+        return;
+    }
+
+    ++numTables_;
+    ++stats_.tables;
+    uint64_t id = connection.id;
+    scheduler_.spawn(playTable(connection), [this, id](uint32_t) { finished_.push_back(id); });
+}
+
+async::Task<uint32_t> Server::Worker::playTable(Connection& connection)
+{
+    Table& table = *connection.table;
+
+    uint32_t roundIdx = 0;
+    for (; roundIdx < table.numRounds && !connection.closed; ++roundIdx) {
+        table.remote->newRound();
+
+        RoundResult result;
+        std::string error;
+        try {
+            result = co_await table.game.playRound(roundIdx % table.game.numPlayers());
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        if (!error.empty()) {
+            // The game is left in the middle of a round, the table cannot go on
+            fail(connection, "Table aborted: " + error);
+            co_return roundIdx;
+        }
+
+        ++stats_.rounds;
+        if (!connection.closed) {
+            protocol::Writer writer(connection.output);
+            protocol::writeRoundOver(writer, {roundIdx,
+                static_cast<int8_t>(result.losingPlayerIdx ? *result.losingPlayerIdx : -1)});
+            connection.markDirty();
+        }
+    }
+
+    if (!connection.closed) {
+        protocol::Writer writer(connection.output);
+        protocol::writeTableClosed(writer, roundIdx);
+        connection.markDirty();
+    }
+    co_return roundIdx;
+}
+
+void Server::Worker::fail(Connection& connection, const std::string& message)
+{
+    ++stats_.errors;
+    WARN() << "Connection " << connection.id << ": " << message;
+    if (connection.closed) {
+        return;
+    }
+    protocol::Writer writer(connection.output);
+    protocol::writeError(writer, message);
+    connection.closing = true;
+    connection.markDirty();
+}
+
+void Server::Worker::disconnect(Connection& connection)
+{
+    if (connection.closed) {
+        return;
+    }
+    ::epoll_ctl(epoll_, EPOLL_CTL_DEL, connection.fd, nullptr);
+    ::close(connection.fd);
+    connection.fd = -1;
+    connection.closed = true;
+    connection.input = {};
+    connection.output = {};
+
+    if (connection.table) {
+        connection.table->remote->abandon();
+    }
+    closed_.push_back(connection.id);
+}
+
+void Server::Worker::flush()
+{
+    // Flushing may fail connections, which marks them dirty again
+    for (size_t i = 0; i < dirty_.size(); ++i) {
+        Connection& connection = *dirty_[i];
+        connection.dirty = false;
+        if (!connection.closed) {
+            flush(connection);
+        }
+    }
+    dirty_.clear();
+}
+
+void Server::Worker::flush(Connection& connection)
+{
+    if (connection.footprint() > server_.options_.tableBudget) {
+        // The client does not read, there is no point in telling it
+        WARN() << "Connection " << connection.id << " exceeded memory budget";
+        ++stats_.errors;
+        disconnect(connection);
+        return;
+    }
+
+    while (connection.outputSent < connection.output.size()) {
+        ssize_t numWritten = ::send(connection.fd, connection.output.data() + connection.outputSent,
+                                    connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+        if (numWritten < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                updatePolling(connection, true);
+                return;
+            }
+            if (errno != EINTR) {
+                disconnect(connection);
+                return;
+            }
+            continue;
+        }
+        connection.outputSent += numWritten;
+    }
+
+    connection.output.clear();
+    connection.outputSent = 0;
+    updatePolling(connection, false);
+
+    if (connection.closing) {
+        disconnect(connection);
+    }
+}
+
+void Server::Worker::updatePolling(Connection& connection, bool pollOut)
+{
+    if (connection.pollingOut == pollOut) {
+        return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | (pollOut ? EPOLLOUT : 0);
+    event.data.u64 = connection.id;
+    REQUIRE(::epoll_ctl(epoll_, EPOLL_CTL_MOD, connection.fd, &event) == 0,
+            "Cannot poll a connection: " << std::strerror(errno));
+    connection.pollingOut = pollOut;
+}
+
+void Server::Worker::reap()
+{
+    for (uint64_t id : finished_) {
+        auto& connection = connections_.at(id);
+        connection->table.reset();
+        --numTables_;
+        if (connection->closed) {
+            connections_.erase(id);
+        }
+    }
+    finished_.clear();
+
+    for (uint64_t id : closed_) {
+        auto itr = connections_.find(id);
+        if (itr != connections_.end() && !itr->second->table) {
+            connections_.erase(itr);
+        }
+    }
+    closed_.clear();
+}
+
+void Server::Worker::shutdown()
+{
+    // Bots finish the rounds in progress, then the tables stop
+    for (auto& [id, connection] : connections_) {
+        disconnect(*connection);
+    }
+    while (scheduler_.numActive() > 0 && scheduler_.hasReady()) {
+        scheduler_.run();
+    }
+    reap();
+}
+
+Server::Server(ServerOptions options)
+    : options_(std::move(options))
+{
+    REQUIRE(options_.numThreads > 0, "Server needs at least one thread");
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    REQUIRE(options_.socketPath.size() < sizeof(address.sun_path),
+            "Socket path is too long: " << options_.socketPath);
+    std::strcpy(address.sun_path, options_.socketPath.c_str());
+
+    listener_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    REQUIRE(listener_ >= 0, "Cannot create socket: " << std::strerror(errno));
+    setNonBlocking(listener_);
+
+    ::unlink(options_.socketPath.c_str());
+    REQUIRE(::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0,
+            "Cannot bind " << options_.socketPath << ": " << std::strerror(errno));
+    REQUIRE(::listen(listener_, SOMAXCONN) == 0,
+            "Cannot listen on " << options_.socketPath << ": " << std::strerror(errno));
+
+    for (size_t idx = 0; idx < options_.numThreads; ++idx) {
+        workers_.push_back(std::make_unique<Worker>(*this));
+    }
+}
+
+Server::~Server()
+{
+    workers_.clear();
+    if (listener_ >= 0) {
+        ::close(listener_);
+        ::unlink(options_.socketPath.c_str());
+    }
+}
+
+void Server::run()
+{
+    parallelFor(workers_.size(), workers_.size(), [this](size_t, size_t begin, size_t end) {
+        try {
+            for (size_t idx = begin; idx < end; ++idx) {
+                workers_[idx]->run();
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    });
+}
+
+ServerStats Server::stats() const
+{
+    ServerStats total;
+    for (const auto& worker : workers_) {
+        const auto& stats = worker->stats();
+        total.connections += stats.connections;
+        total.tables += stats.tables;
+        total.rounds += stats.rounds;
+        total.decisions += stats.decisions;
+        total.errors += stats.errors;
+    }
+    return total;
+}
+
+} // namespace miplot::cardgame::durak
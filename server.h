@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+struct ServerOptions {
+    std::string socketPath;
+    size_t numThreads = 1;
+    // Connection is dropped when it takes more bytes: its buffers, the table
+    // with its game's players, cards and strategies. Coroutine frames of a
+    // table are not counted, their number and sizes are fixed
+    size_t tableBudget = 64 * 1024;
+    // Joins beyond this number of running tables per thread are refused
+    size_t maxTablesPerThread = 100000;
+    // Rounds taking more bouts are a draw, so that bots cannot loop forever
+    size_t maxBoutsPerRound = 1000;
+};
+
+struct ServerStats {
+    size_t connections = 0;
+    size_t tables = 0;
+    size_t rounds = 0;
+    size_t decisions = 0;
+    size_t errors = 0;
+};
+
+/**
+ * Hosts tables where a remote client plays against bots over the binary
+ * protocol on a Unix socket. Each thread runs its own epoll loop and
+ * multiplexes all its tables on one scheduler
+ */
+class Server {
+public:
+    explicit Server(ServerOptions options);
+    ~Server();
+
+    // Serve until stop() is called
+    void run();
+
+    // Safe to call from a signal handler
+    void stop() { stopping_ = true; }
+
+    ServerStats stats() const;
+
+private:
+    class Worker;
+
+    ServerOptions options_;
+    int listener_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,125 @@
+#include "shards.h"
+#include "exception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace miplot {
+
+namespace {
+
+const char* NODES_DIR = "/sys/devices/system/node/";
+
+// Parse a kernel list like "0-3,8,10-11"
+std::vector<int> parseList(const std::string& text)
+{
+    std::vector<int> result;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty() || item == "\n") {
+            continue;
+        }
+        auto dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+        for (int i = first; i <= last; ++i) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+std::string readLine(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+bool pinToCpus(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+} // namespace
+
+std::pair<size_t, size_t> shardRange(size_t count, size_t shardIdx, size_t numShards)
+{
+    return {count * shardIdx / numShards, count * (shardIdx + 1) / numShards};
+}
+
+std::vector<std::vector<int>> numaNodeCpus()
+{
+    std::vector<std::vector<int>> nodes;
+    for (int node : parseList(readLine(std::string(NODES_DIR) + "online"))) {
+        auto cpus = parseList(readLine(std::string(NODES_DIR) + "node" + std::to_string(node) + "/cpulist"));
+        if (!cpus.empty()) {
+            nodes.push_back(std::move(cpus));
+        }
+    }
+    return nodes;
+}
+
+void runShards(size_t numShards, bool pinNuma,
+               const std::function<std::vector<std::string>(size_t shardIdx)>& args)
+{
+    auto nodes = pinNuma ? numaNodeCpus() : std::vector<std::vector<int>>();
+    if (pinNuma && nodes.empty()) {
+        WARN() << "No NUMA nodes found, shards are not pinned";
+    }
+
+    // Arguments are prepared before forking, a child only pins itself and executes
+    std::vector<std::vector<std::string>> shardArgs;
+    for (size_t idx = 0; idx < numShards; ++idx) {
+        shardArgs.push_back(args(idx));
+    }
+    std::cout.flush();
+
+    std::vector<pid_t> workers;
+    for (size_t idx = 0; idx < numShards; ++idx) {
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>("/proc/self/exe"));
+        for (auto& arg : shardArgs[idx]) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+
+        pid_t pid = ::fork();
+        REQUIRE(pid >= 0, "Cannot start shard " << idx << ": " << std::strerror(errno));
+        if (pid == 0) {
+            // Only async-signal-safe calls between fork and exec
+            if (!nodes.empty() && !pinToCpus(nodes[idx % nodes.size()])) {
+                ::_exit(126);
+            }
+            ::execv(argv[0], argv.data());
+            ::_exit(127);
+        }
+        workers.push_back(pid);
+    }
+
+    size_t numFailed = 0;
+    for (size_t idx = 0; idx < workers.size(); ++idx) {
+        int status = 0;
+        while (::waitpid(workers[idx], &status, 0) < 0 && errno == EINTR) {
+        }
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            ERROR() << "Shard " << idx << " failed with status " << status;
+            ++numFailed;
+        }
+    }
+    REQUIRE(numFailed == 0, numFailed << " of " << numShards << " shards failed");
+}
+
+} // namespace miplot
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace miplot {
+
+// Range of shard shardIdx when [0, count) is split into numShards contiguous ranges
+std::pair<size_t, size_t> shardRange(size_t count, size_t shardIdx, size_t numShards);
+
+// CPUs of every NUMA node, empty if the system does not report nodes
+std::vector<std::vector<int>> numaNodeCpus();
+
+/**
+ * Forks a worker process per shard and waits for all of them. Worker i runs
+ * this program again with arguments args(i), pinned to the CPUs of NUMA node
+ * i % numNodes if pinNuma is set. Throws if any worker fails
+ */
+void runShards(size_t numShards, bool pinNuma,
+               const std::function<std::vector<std::string>(size_t shardIdx)>& args);
+
+} // namespace miplot
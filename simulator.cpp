@@ -0,0 +1,130 @@
+#include "simulator.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <sched.h>
+#include <thread>
+
+namespace miplot::cardgame::durak {
+
+void SimulationResult::merge(const SimulationResult& other)
+{
+    if (losses.size() < other.losses.size()) {
+        losses.resize(other.losses.size(), 0);
+    }
+    for (size_t idx = 0; idx < other.losses.size(); ++idx) {
+        losses[idx] += other.losses[idx];
+    }
+    draws += other.draws;
+    numRounds += other.numRounds;
+}
+
+size_t defaultNumThreads()
+{
+    // CPUs the process may run on, fewer than all when pinned to a NUMA node
+    cpu_set_t set;
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        return std::max(1, CPU_COUNT(&set));
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallelFor(size_t count, size_t numThreads,
+                 const std::function<void(size_t, size_t, size_t)>& fn)
+{
+    numThreads = std::max<size_t>(1, std::min(numThreads, count));
+    if (numThreads == 1) {
+        fn(0, 0, count);
+        return;
+    }
+
+    std::mutex mutex;
+    std::exception_ptr error;
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+
+    for (size_t t = 0; t < numThreads; ++t) {
+        size_t begin = count * t / numThreads;
+        size_t end = count * (t + 1) / numThreads;
+        threads.emplace_back([&, t, begin, end] {
+            try {
+                fn(t, begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template <typename CardTraits>
+BasicSimulator<CardTraits>::BasicSimulator(PlayersFactory factory, size_t numThreads,
+                                           Rules rules)
+    : BasicSimulator([factory = std::move(factory)](size_t) { return factory(); }, numThreads, rules)
+{
+}
+
+template <typename CardTraits>
+BasicSimulator<CardTraits>::BasicSimulator(ThreadPlayersFactory factory, size_t numThreads,
+                                           Rules rules)
+    : factory_(std::move(factory))
+    , numThreads_(numThreads)
+    , rules_(rules)
+{
+}
+
+template <typename CardTraits>
+SimulationResult BasicSimulator<CardTraits>::run(uint64_t seed, size_t firstRound, size_t numRounds,
+                                                 const RoundCallback& onRound) const
+{
+    std::vector<SimulationResult> partial(std::max<size_t>(1, numThreads_));
+
+    parallelFor(numRounds, numThreads_, [&](size_t threadIdx, size_t begin, size_t end) {
+        BasicGame<CardTraits> game{factory_(threadIdx), rules_};
+        auto& result = partial[threadIdx];
+        result.losses.assign(game.numPlayers(), 0);
+        typename cards::Deck<CardTraits>::Order order;
+
+        for (size_t round = firstRound + begin; round < firstRound + end; ++round) {
+            game.seed(mixSeed(seed, round));
+            RoundResult roundResult;
+            if (deals_) {
+                deals_->order<CardTraits>(round, order);
+                roundResult = game.playRound(round % game.numPlayers(), order);
+            } else {
+                roundResult = game.playRound(round % game.numPlayers());
+            }
+            if (roundResult.losingPlayerIdx) {
+                ++result.losses[*roundResult.losingPlayerIdx];
+            } else {
+                ++result.draws;
+            }
+            ++result.numRounds;
+            if (onRound) {
+                onRound(threadIdx, round, roundResult);
+            }
+        }
+    });
+
+    SimulationResult total;
+    for (const auto& result : partial) {
+        total.merge(result);
+    }
+    return total;
+}
+
+template class BasicSimulator<cards::Std24CardTraits>;
+template class BasicSimulator<cards::Std36CardTraits>;
+template class BasicSimulator<cards::Std52CardTraits>;
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "deal_corpus.h"
+#include "game.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+// Creates a fresh set of players for every simulation thread
+template <typename CardTraits>
+using BasicPlayersFactory = std::function<BasicPlayers<CardTraits>()>;
+
+// Same, given the index of the thread
+template <typename CardTraits>
+using BasicThreadPlayersFactory = std::function<BasicPlayers<CardTraits>(size_t threadIdx)>;
+
+// Called on the simulation thread after every round
+using RoundCallback = std::function<void(size_t threadIdx, size_t round, const RoundResult& result)>;
+
+struct SimulationResult {
+    std::vector<size_t> losses;
+    size_t draws = 0;
+    size_t numRounds = 0;
+
+    void merge(const SimulationResult& other);
+};
+
+size_t defaultNumThreads();
+
+// Split [0, count) into contiguous ranges and call fn(threadIdx, begin, end)
+// for each range on its own thread. Rethrows the first exception thrown by fn
+void parallelFor(size_t count, size_t numThreads,
+                 const std::function<void(size_t, size_t, size_t)>& fn);
+
+/**
+ * Plays many rounds in parallel, one Game per thread.
+ * Round i is seeded from (seed, i) and starts with player i % numPlayers,
+ * so the result does not depend on the number of threads.
+ */
+template <typename CardTraits>
+class BasicSimulator {
+public:
+    using PlayersFactory = BasicPlayersFactory<CardTraits>;
+    using ThreadPlayersFactory = BasicThreadPlayersFactory<CardTraits>;
+
+    explicit BasicSimulator(PlayersFactory factory, size_t numThreads = defaultNumThreads(),
+                            Rules rules = Rules());
+
+    // For players sharing per-thread state, such as sample recorders
+    explicit BasicSimulator(ThreadPlayersFactory factory, size_t numThreads = defaultNumThreads(),
+                            Rules rules = Rules());
+
+    // Deal round i from deal i of the corpus instead of shuffling.
+    // Seeds still reseed players' strategies
+    void setDeals(std::shared_ptr<const DealCorpus> deals) { deals_ = std::move(deals); }
+
+    SimulationResult run(uint64_t seed, size_t firstRound, size_t numRounds,
+                         const RoundCallback& onRound = RoundCallback()) const;
+
+    size_t numThreads() const { return numThreads_; }
+
+private:
+    ThreadPlayersFactory factory_;
+    size_t numThreads_;
+    Rules rules_;
+    std::shared_ptr<const DealCorpus> deals_;
+};
+
+// Standard 36 card game
+using PlayersFactory = BasicPlayersFactory<cards::Std36CardTraits>;
+using ThreadPlayersFactory = BasicThreadPlayersFactory<cards::Std36CardTraits>;
+using Simulator = BasicSimulator<cards::Std36CardTraits>;
+
+} // namespace miplot::cardgame::durak
@@ -1,19 +1,76 @@
 #pragma once
 
 #include "card.h"
+#include "exception.h"
+#include "game_observer.h"
 
+#include <array>
+#include <cstdint>
+
+#include <memory>
+#include <optional>
 #include <random>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace miplot::cardgame::durak {
 
 constexpr size_t MAX_ATTACK_SIZE = 6;
 
-class GameState;
+/**
+ * Indices of cards in hand played in one attack decision
+ */
+class AttackBatch {
+public:
+    void push_back(size_t cardIdx)
+    {
+        REQUIRE(size_ < MAX_ATTACK_SIZE, "Attack batch is full");
+        indices_[size_++] = static_cast<uint8_t>(cardIdx);
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t operator[] (size_t i) const { return indices_[i]; }
+
+    const uint8_t* begin() const { return indices_.data(); }
+    const uint8_t* end() const { return indices_.data() + size_; }
+
+private:
+    std::array<uint8_t, MAX_ATTACK_SIZE> indices_;
+    uint8_t size_ = 0;
+};
+
+/**
+ * Parts of a decision a deterministic strategy reads, see CachedStrategy
+ */
+enum DecisionInput : uint32_t {
+    INPUT_HAND = 1 << 0,            // cards in hand
+    INPUT_HAND_ORDER = 1 << 1,      // positions of cards in hand, when ties go to the first card
+    INPUT_TABLE = 1 << 2,           // cards on the table and the first undefended one
+    INPUT_TRUMP = 1 << 3,
+    INPUT_DEFENDER_CARDS = 1 << 4,  // number of cards of the defender
+    INPUT_NUM_PLAYERS = 1 << 5,
+    INPUT_DECK_SIZE = 1 << 6,
+    INPUT_SUIT_NAMES = 1 << 7,      // which non-trump suit is which, not only how cards relate
+};
+
+template <typename CardTraits>
+class BasicGameState;
+
+class OpeningTable;
 
-class Strategy {
+namespace cfr {
+class Policy;
+}
+
+template <typename CardTraits>
+class BasicStrategy {
 public:
+    using GameState = BasicGameState<CardTraits>;
+    using Cards = typename CardTypes<CardTraits>::Cards;
+
+    virtual ~BasicStrategy() = default;
 
     /**
      * @param state game state
@@ -22,6 +79,23 @@ public:
      */
     virtual int attack(const GameState& state, const Cards& hand) = 0;
 
+    /**
+     * Used instead of attack() when the rules enable batched attacks.
+     * Initial attack cards must share a rank, others must match ranks on the table
+     * @param state game state
+     * @param hand player's hand.
+     * @return indices of cards in hand to attack with. Empty if folds
+     */
+    virtual AttackBatch attackBatch(const GameState& state, const Cards& hand)
+    {
+        AttackBatch batch;
+        int cardIdx = attack(state, hand);
+        if (cardIdx != -1) {
+            batch.push_back(cardIdx);
+        }
+        return batch;
+    }
+
     /**
      * @param state game state
      * @param hand player's hand.
@@ -29,32 +103,209 @@ public:
      */
     virtual int defend(const GameState& state, const Cards& hand) = 0;
 
+    /**
+     * Called before defend() when the rules allow transferring the attack
+     * @param state game state
+     * @param hand player's hand.
+     * @return index of card in hand of the attacking rank to transfer with.
+     *         -1 to defend instead
+     */
+    virtual int transfer(const GameState& /*state*/, const Cards& /*hand*/) { return -1; }
+
     virtual const std::string& name() const {
         static const std::string NAME = "Noname strategy";
         return NAME;
     }
+
+    /**
+     * Reseed internal random generators, if any, to make rounds reproducible
+     */
+    virtual void seed(uint64_t /*value*/) {}
+
+    /**
+     * Events of the games the strategy plays, asked once per game. nullptr if not interested
+     */
+    virtual BasicGameObserver<CardTraits>* observer() { return nullptr; }
+
+    /**
+     * What the strategy has learned over rounds, kept in checkpoints of long runs.
+     * Empty if it does not learn
+     */
+    virtual std::string saveState() const { return {}; }
+    virtual void loadState(const std::string& /*state*/) {}
 };
 
 
-class RandomStrategy : public Strategy {
+template <typename CardTraits>
+class BasicRandomStrategy : public BasicStrategy<CardTraits> {
 public:
-    RandomStrategy();
+    using typename BasicStrategy<CardTraits>::GameState;
+    using typename BasicStrategy<CardTraits>::Cards;
+
+    BasicRandomStrategy();
 
     int attack(const GameState& state, const Cards& hand) override;
 
     int defend(const GameState& state, const Cards& hand) override;
 
+    int transfer(const GameState& state, const Cards& hand) override;
+
     const std::string& name() const override;
+
+    void seed(uint64_t value) override;
 private:
     std::mt19937 randGenerator_;
 };
 
-class MinCardStrategy : public Strategy {
+template <typename CardTraits>
+class BasicMinCardStrategy : public BasicStrategy<CardTraits> {
+public:
+    using typename BasicStrategy<CardTraits>::GameState;
+    using typename BasicStrategy<CardTraits>::Cards;
+
+    // Picks the lowest card, the first one in hand on ties
+    static constexpr uint32_t CACHED_INPUTS =
+        INPUT_HAND | INPUT_HAND_ORDER | INPUT_TABLE | INPUT_TRUMP | INPUT_DEFENDER_CARDS;
+
+    int attack(const GameState& state, const Cards& hand) override;
+
+    // Lead with all cards of the lowest rank, pile on with all matching non-trumps
+    AttackBatch attackBatch(const GameState& state, const Cards& hand) override;
+
+    int defend(const GameState& state, const Cards& hand) override;
+
+    int transfer(const GameState& state, const Cards& hand) override;
+
+    const std::string& name() const override;
+};
+
+/**
+ * Weights of WeightedHeuristicStrategy. A card is valued by its rank scaled
+ * to [0, 1], trumps are worth trumpValue more. Limits are compared with the
+ * value of the cheapest card that fits a decision and grow by endgameAggression
+ * as the deck runs out
+ */
+struct HeuristicWeights {
+    double trumpValue = 1.0;        // how reluctantly trumps are played
+    double leadPairBonus = 0.2;     // lead with a rank held several times, per extra card
+    double pileOnLimit = 1.0;       // most valuable card to pile on with
+    double resignLimit = 2.0;       // most valuable card to beat with, resigns otherwise
+    double transferLimit = 0.5;     // most valuable card to transfer with
+    double endgameAggression = 0.5;
+
+    static constexpr size_t SIZE = 6;
+
+    std::vector<double> toVector() const;
+    static HeuristicWeights fromVector(const std::vector<double>& values);
+
+    // Comma separated values in declaration order
+    std::string toString() const;
+    static HeuristicWeights parse(const std::string& text);
+};
+
+/**
+ * Plays the cheapest card that fits a decision, like MinCardStrategy,
+ * but folds, resigns and keeps trumps according to weights
+ */
+template <typename CardTraits>
+class BasicWeightedHeuristicStrategy : public BasicStrategy<CardTraits> {
+public:
+    using typename BasicStrategy<CardTraits>::GameState;
+    using typename BasicStrategy<CardTraits>::Cards;
+    using Card = typename CardTypes<CardTraits>::Card;
+
+    explicit BasicWeightedHeuristicStrategy(const HeuristicWeights& weights = HeuristicWeights());
+
+    int attack(const GameState& state, const Cards& hand) override;
+
+    int defend(const GameState& state, const Cards& hand) override;
+
+    int transfer(const GameState& state, const Cards& hand) override;
+
+    const std::string& name() const override;
+
+    const HeuristicWeights& weights() const { return weights_; }
+
+private:
+    double value(const GameState& state, const Card& card) const;
+
+    // Limit raised by the share of the deck dealt since the start of the round
+    double limit(const GameState& state, double base) const;
+
+    HeuristicWeights weights_;
+};
+
+// Standard 36 card game
+using GameState = BasicGameState<cards::Std36CardTraits>;
+using Strategy = BasicStrategy<cards::Std36CardTraits>;
+using RandomStrategy = BasicRandomStrategy<cards::Std36CardTraits>;
+using MinCardStrategy = BasicMinCardStrategy<cards::Std36CardTraits>;
+using WeightedHeuristicStrategy = BasicWeightedHeuristicStrategy<cards::Std36CardTraits>;
+
+/**
+ * Plays the first attack of a round from a precomputed opening table
+ * and delegates all other decisions to the fallback strategy
+ */
+class TableStrategy : public Strategy {
+public:
+    TableStrategy(std::shared_ptr<const OpeningTable> table,
+                  std::unique_ptr<Strategy> fallback);
+
+    int attack(const GameState& state, const Cards& hand) override;
+
+    AttackBatch attackBatch(const GameState& state, const Cards& hand) override;
+
+    int defend(const GameState& state, const Cards& hand) override;
+
+    int transfer(const GameState& state, const Cards& hand) override;
+
+    const std::string& name() const override;
+
+    void seed(uint64_t value) override;
+
+    GameObserver* observer() override;
+
+    std::string saveState() const override;
+    void loadState(const std::string& state) override;
+private:
+    std::shared_ptr<const OpeningTable> table_;
+    std::unique_ptr<Strategy> fallback_;
+};
+
+/**
+ * Plays the average strategy of a CFR policy (see cfr/trainer.h) in two player
+ * games with classic rules, sampling abstract actions by their probabilities.
+ * Other games and information sets missing from the policy go to the fallback
+ */
+class CfrStrategy : public Strategy {
+public:
+    CfrStrategy(std::shared_ptr<const cfr::Policy> policy,
+                std::unique_ptr<Strategy> fallback);
+
     int attack(const GameState& state, const Cards& hand) override;
 
+    AttackBatch attackBatch(const GameState& state, const Cards& hand) override;
+
     int defend(const GameState& state, const Cards& hand) override;
 
+    int transfer(const GameState& state, const Cards& hand) override;
+
     const std::string& name() const override;
+
+    void seed(uint64_t value) override;
+
+    GameObserver* observer() override;
+
+    std::string saveState() const override;
+    void loadState(const std::string& state) override;
+private:
+    bool isSupported(const GameState& state) const;
+    // Index in hand, -1 to pass, or nothing if the policy has no answer
+    std::optional<int> decide(const GameState& state, const Cards& hand, bool defending);
+
+    std::shared_ptr<const cfr::Policy> policy_;
+    std::unique_ptr<Strategy> fallback_;
+    std::mt19937 randGenerator_;
 };
 
 } // namespace miplot::cardgame::durak
@@ -0,0 +1,126 @@
+#include "strategy.h"
+#include "cfr/abstraction.h"
+#include "cfr/policy.h"
+#include "game.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace miplot::cardgame::durak {
+
+CfrStrategy::CfrStrategy(std::shared_ptr<const cfr::Policy> policy,
+                         std::unique_ptr<Strategy> fallback)
+    : policy_(std::move(policy))
+    , fallback_(std::move(fallback))
+    , randGenerator_(std::random_device{}())
+{
+}
+
+bool CfrStrategy::isSupported(const GameState& state) const
+{
+    const auto& rules = state.rules();
+    return state.opponents().size() == cfr::NUM_PLAYERS && !rules.transfer
+        && !rules.batchedAttacks && rules.numTeams == 0;
+}
+
+std::optional<int> CfrStrategy::decide(const GameState& state, const Cards& hand, bool defending)
+{
+    auto observation = cfr::observe(state, hand, defending);
+    auto actions = cfr::abstractActions(observation);
+    if (actions.available == 0) {
+        return std::nullopt;
+    }
+
+    size_t action = std::countr_zero(actions.available);
+    if (!std::has_single_bit(actions.available)) {
+        const uint8_t* probs = policy_->lookup(cfr::infoKey(observation));
+        if (!probs) {
+            return std::nullopt;
+        }
+        unsigned total = 0;
+        for (size_t a = 0; a < cfr::NUM_ACTIONS; ++a) {
+            total += (actions.available >> a & 1) ? probs[a] : 0;
+        }
+        if (total == 0) {
+            return std::nullopt;
+        }
+        unsigned r = std::uniform_int_distribution<unsigned>(0, total - 1)(randGenerator_);
+        for (size_t a = 0; a < cfr::NUM_ACTIONS; ++a) {
+            unsigned p = (actions.available >> a & 1) ? probs[a] : 0;
+            if (r < p) {
+                action = a;
+                break;
+            }
+            r -= p;
+        }
+    }
+
+    int code = actions.codes[action];
+    if (code == -1) {
+        return -1;
+    }
+    auto itr = std::find_if(hand.begin(), hand.end(), [&](const Card& c) { return int(c.code()) == code; });
+    if (itr == hand.end()) {
+        return std::nullopt;
+    }
+    return std::distance(hand.begin(), itr);
+}
+
+int CfrStrategy::attack(const GameState& state, const Cards& hand)
+{
+    if (isSupported(state)) {
+        if (auto cardIdx = decide(state, hand, false)) {
+            return *cardIdx;
+        }
+    }
+    return fallback_->attack(state, hand);
+}
+
+AttackBatch CfrStrategy::attackBatch(const GameState& state, const Cards& hand)
+{
+    return fallback_->attackBatch(state, hand);
+}
+
+int CfrStrategy::defend(const GameState& state, const Cards& hand)
+{
+    if (isSupported(state)) {
+        if (auto cardIdx = decide(state, hand, true)) {
+            return *cardIdx;
+        }
+    }
+    return fallback_->defend(state, hand);
+}
+
+int CfrStrategy::transfer(const GameState& state, const Cards& hand)
+{
+    return fallback_->transfer(state, hand);
+}
+
+const std::string& CfrStrategy::name() const
+{
+    static const std::string NAME = "CFR strategy";
+    return NAME;
+}
+
+void CfrStrategy::seed(uint64_t value)
+{
+    randGenerator_.seed(static_cast<std::mt19937::result_type>(value ^ (value >> 32)));
+    fallback_->seed(value);
+}
+
+GameObserver* CfrStrategy::observer()
+{
+    return fallback_->observer();
+}
+
+std::string CfrStrategy::saveState() const
+{
+    return fallback_->saveState();
+}
+
+void CfrStrategy::loadState(const std::string& state)
+{
+    fallback_->loadState(state);
+}
+
+} // namespace miplot::cardgame::durak
@@ -4,13 +4,42 @@
 
 namespace miplot::cardgame::durak {
 
-bool less(const Card& lhs, const Card& rhs, Suit trump);
+template <typename CardTraits>
+bool less(const cards::Card<CardTraits>& lhs, const cards::Card<CardTraits>& rhs,
+          typename CardTraits::SuitType trump)
+{
+    if (lhs.suit() == rhs.suit()) {
+        return lhs.rank() < rhs.rank();
+    }
+
+    if (rhs.suit() == trump) {
+        return true;
+    }
 
-bool canDefend(const Card& attack, const Card& defense, Suit trump);
+    if (lhs.suit() == trump) {
+        return false;
+    }
 
-struct CardComparator {
+    return lhs.rank() < rhs.rank();
+}
+
+template <typename CardTraits>
+bool canDefend(const cards::Card<CardTraits>& attack, const cards::Card<CardTraits>& defense,
+               typename CardTraits::SuitType trump)
+{
+    return
+        (attack.suit() == defense.suit() && attack.rank() < defense.rank())
+        ||
+        (attack.suit() != defense.suit() && defense.suit() == trump);
+}
+
+template <typename CardTraits>
+struct BasicCardComparator {
 public:
-    CardComparator(Suit trump) : trump_(trump)
+    using Card = cards::Card<CardTraits>;
+    using Suit = typename CardTraits::SuitType;
+
+    BasicCardComparator(Suit trump) : trump_(trump)
     {}
 
     bool operator()(const Card& lhs, const Card& rhs) const
@@ -21,5 +50,6 @@ private:
     Suit trump_;
 };
 
-} // namespace miplot::cardgame::durak
+using CardComparator = BasicCardComparator<cards::Std36CardTraits>;
 
+} // namespace miplot::cardgame::durak
@@ -8,7 +8,8 @@
 
 namespace miplot::cardgame::durak {
 
-int MinCardStrategy::attack(const GameState& state, const Cards& hand)
+template <typename CardTraits>
+int BasicMinCardStrategy<CardTraits>::attack(const GameState& state, const Cards& hand)
 {
     if (hand.empty()) {
         return -1;
@@ -16,7 +17,7 @@ int MinCardStrategy::attack(const GameState& state, const Cards& hand)
 
     if (state.defendedCards().empty() && state.undefendedCards().empty()) {
         auto itr = std::min_element(hand.begin(), hand.end(),
-                                    CardComparator(state.trumpSuit()));
+                                    BasicCardComparator<CardTraits>(state.trumpSuit()));
         return std::distance(hand.begin(), itr);
     } else {
         // Safety check
@@ -29,7 +30,7 @@ int MinCardStrategy::attack(const GameState& state, const Cards& hand)
         for (size_t i = 0; i < hand.size(); ++i) {
             if (std::any_of(state.defendedCards().begin(),
                             state.defendedCards().end(),
-                            [&](const CardPair& pair){
+                            [&](const typename CardTypes<CardTraits>::CardPair& pair){
                                 return pair.attacking.rank() == hand[i].rank()
                                     || pair.defending.rank() == hand[i].rank();
                             }))
@@ -39,7 +40,7 @@ int MinCardStrategy::attack(const GameState& state, const Cards& hand)
 
             if (std::any_of(state.undefendedCards().begin(),
                             state.undefendedCards().end(),
-                            [&](const Card& c){
+                            [&](const typename CardTypes<CardTraits>::Card& c){
                                 return c.rank() == hand[i].rank()
                                     || c.rank() == hand[i].rank();
                             }))
@@ -48,7 +49,7 @@ int MinCardStrategy::attack(const GameState& state, const Cards& hand)
             }
         }
 
-        CardComparator cmp(state.trumpSuit());
+        BasicCardComparator<CardTraits> cmp(state.trumpSuit());
         auto itr = std::min_element(candidates.begin(), candidates.end(),
                 [&](int lhsInd, int rhsInd) {
                     return cmp(hand[lhsInd], hand[rhsInd]);
@@ -58,7 +59,48 @@ int MinCardStrategy::attack(const GameState& state, const Cards& hand)
     }
 }
 
-int MinCardStrategy::defend(const GameState& state, const Cards& hand)
+template <typename CardTraits>
+AttackBatch BasicMinCardStrategy<CardTraits>::attackBatch(const GameState& state, const Cards& hand)
+{
+    AttackBatch batch;
+    int lowestIdx = attack(state, hand);
+    if (lowestIdx == -1) {
+        return batch;
+    }
+
+    bool initial = state.defendedCards().empty() && state.undefendedCards().empty();
+    size_t room = std::min(
+        MAX_ATTACK_SIZE - state.defendedCards().size() - state.undefendedCards().size(),
+        state.opponents()[state.defenderIdx()].numCards - state.undefendedCards().size());
+
+    batch.push_back(lowestIdx);
+    const auto& lowest = hand[lowestIdx];
+
+    for (size_t i = 0; i < hand.size() && batch.size() < room; ++i) {
+        const auto& card = hand[i];
+        if ((int)i == lowestIdx || card.suit() == state.trumpSuit()) {
+            continue;
+        }
+        bool matches = initial
+            ? card.rank() == lowest.rank()
+            : std::any_of(state.defendedCards().begin(), state.defendedCards().end(),
+                          [&](const typename CardTypes<CardTraits>::CardPair& pair) {
+                              return pair.attacking.rank() == card.rank()
+                                  || pair.defending.rank() == card.rank();
+                          })
+              || std::any_of(state.undefendedCards().begin(), state.undefendedCards().end(),
+                             [&](const typename CardTypes<CardTraits>::Card& c) {
+                                 return c.rank() == card.rank();
+                             });
+        if (matches) {
+            batch.push_back(i);
+        }
+    }
+    return batch;
+}
+
+template <typename CardTraits>
+int BasicMinCardStrategy<CardTraits>::defend(const GameState& state, const Cards& hand)
 {
     if (hand.empty()) {
         return -1;
@@ -75,7 +117,31 @@ int MinCardStrategy::defend(const GameState& state, const Cards& hand)
         }
     }
 
-    CardComparator cmp(state.trumpSuit());
+    BasicCardComparator<CardTraits> cmp(state.trumpSuit());
+    auto itr = std::min_element(candidates.begin(), candidates.end(),
+            [&](int lhsInd, int rhsInd) {
+                return cmp(hand[lhsInd], hand[rhsInd]);
+            });
+
+    return itr == candidates.end() ? -1 : *itr;
+}
+
+template <typename CardTraits>
+int BasicMinCardStrategy<CardTraits>::transfer(const GameState& state, const Cards& hand)
+{
+    const auto& attacker = state.undefendedCards().front();
+
+    // Transfer with the lowest card of the attacking rank, but keep trumps
+    std::vector<int> candidates;
+
+    for (size_t i = 0; i < hand.size(); ++i) {
+        const auto& card = hand[i];
+        if (card.rank() == attacker.rank() && card.suit() != state.trumpSuit()) {
+            candidates.push_back(i);
+        }
+    }
+
+    BasicCardComparator<CardTraits> cmp(state.trumpSuit());
     auto itr = std::min_element(candidates.begin(), candidates.end(),
             [&](int lhsInd, int rhsInd) {
                 return cmp(hand[lhsInd], hand[rhsInd]);
@@ -84,11 +150,15 @@ int MinCardStrategy::defend(const GameState& state, const Cards& hand)
     return itr == candidates.end() ? -1 : *itr;
 }
 
-const std::string& MinCardStrategy::name() const
+template <typename CardTraits>
+const std::string& BasicMinCardStrategy<CardTraits>::name() const
 {
     static const std::string NAME = "Minimal card strategy";
     return NAME;
 }
 
-} // namespace miplot::cardgame::durak
+template class BasicMinCardStrategy<cards::Std24CardTraits>;
+template class BasicMinCardStrategy<cards::Std36CardTraits>;
+template class BasicMinCardStrategy<cards::Std52CardTraits>;
 
+} // namespace miplot::cardgame::durak
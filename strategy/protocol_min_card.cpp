@@ -0,0 +1,72 @@
+#include "protocol_min_card.h"
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+using Traits = cards::Std36CardTraits;
+
+// Lower is cheaper to give away: non-trumps first, then by rank
+size_t cost(uint8_t code, uint8_t trump)
+{
+    bool isTrump = static_cast<uint8_t>(Traits::suitOf(code)) == trump;
+    return isTrump * Traits::numRanks() + static_cast<size_t>(Traits::rankOf(code));
+}
+
+bool beats(uint8_t defending, uint8_t attacking, uint8_t trump)
+{
+    auto suit = static_cast<uint8_t>(Traits::suitOf(defending));
+    auto attackingSuit = static_cast<uint8_t>(Traits::suitOf(attacking));
+    if (suit == attackingSuit) {
+        return Traits::rankOf(defending) > Traits::rankOf(attacking);
+    }
+    return suit == trump;
+}
+
+template <typename Predicate>
+int cheapest(const protocol::Request& request, Predicate allowed)
+{
+    int best = -1;
+    for (size_t idx = 0; idx < request.hand.size(); ++idx) {
+        uint8_t code = request.hand[idx];
+        if (allowed(code) && (best == -1
+                || cost(code, request.delta.trump) < cost(request.hand[best], request.delta.trump))) {
+            best = idx;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+int minCardDecision(const protocol::Request& request)
+{
+    const auto& delta = request.delta;
+    switch (request.kind) {
+        case protocol::DecisionKind::Attack: {
+            if (delta.undefended.empty() && delta.defended.empty()) {
+                return cheapest(request, [](uint8_t) { return true; });
+            }
+            uint32_t ranks = 0;
+            for (uint8_t code : delta.undefended) {
+                ranks |= 1u << static_cast<size_t>(Traits::rankOf(code));
+            }
+            for (auto [attacking, defending] : delta.defended) {
+                ranks |= 1u << static_cast<size_t>(Traits::rankOf(attacking));
+                ranks |= 1u << static_cast<size_t>(Traits::rankOf(defending));
+            }
+            return cheapest(request, [&](uint8_t code) {
+                return (ranks >> static_cast<size_t>(Traits::rankOf(code))) & 1;
+            });
+        }
+        case protocol::DecisionKind::Defend:
+            return cheapest(request, [&](uint8_t code) {
+                return beats(code, delta.undefended.front(), delta.trump);
+            });
+        case protocol::DecisionKind::Transfer:
+            return -1;
+    }
+    return -1;
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "protocol.h"
+
+namespace miplot::cardgame::durak {
+
+/**
+ * Lowest allowed card for a protocol request of the 36 card game, never transfers.
+ * Used by reference clients which see the game only through the protocol
+ * @return index of card in the request's hand, -1 to fold or resign
+ */
+int minCardDecision(const protocol::Request& request);
+
+} // namespace miplot::cardgame::durak
@@ -8,12 +8,14 @@
 
 namespace miplot::cardgame::durak {
 
-RandomStrategy::RandomStrategy()
+template <typename CardTraits>
+BasicRandomStrategy<CardTraits>::BasicRandomStrategy()
     : randGenerator_(std::random_device{}())
 {
 }
 
-int RandomStrategy::attack(const GameState& state, const Cards& hand)
+template <typename CardTraits>
+int BasicRandomStrategy<CardTraits>::attack(const GameState& state, const Cards& hand)
 {
     if (hand.empty()) {
         return -1;
@@ -36,7 +38,7 @@ int RandomStrategy::attack(const GameState& state, const Cards& hand)
         for (size_t i = 0; i < hand.size(); ++i) {
             if (std::any_of(state.defendedCards().begin(),
                             state.defendedCards().end(),
-                            [&](const CardPair& pair){
+                            [&](const typename CardTypes<CardTraits>::CardPair& pair){
                                 return pair.attacking.rank() == hand[i].rank()
                                     || pair.defending.rank() == hand[i].rank();
                             }))
@@ -46,7 +48,7 @@ int RandomStrategy::attack(const GameState& state, const Cards& hand)
 
             if (std::any_of(state.undefendedCards().begin(),
                             state.undefendedCards().end(),
-                            [&](const Card& c){
+                            [&](const typename CardTypes<CardTraits>::Card& c){
                                 return c.rank() == hand[i].rank()
                                     || c.rank() == hand[i].rank();
                             }))
@@ -59,7 +61,8 @@ int RandomStrategy::attack(const GameState& state, const Cards& hand)
     }
 }
 
-int RandomStrategy::defend(const GameState& state, const Cards& hand)
+template <typename CardTraits>
+int BasicRandomStrategy<CardTraits>::defend(const GameState& state, const Cards& hand)
 {
     if (hand.empty()) {
         return -1;
@@ -80,11 +83,38 @@ int RandomStrategy::defend(const GameState& state, const Cards& hand)
     return candidates[index];
 }
 
-const std::string& RandomStrategy::name() const
+template <typename CardTraits>
+int BasicRandomStrategy<CardTraits>::transfer(const GameState& state, const Cards& hand)
+{
+    const auto& attacker = state.undefendedCards().front();
+
+    // Use -1(=defend) as one of random options
+    std::vector<int> candidates{-1};
+
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (hand[i].rank() == attacker.rank()) {
+            candidates.push_back(i);
+        }
+    }
+    size_t index = randGenerator_() % candidates.size();
+    return candidates[index];
+}
+
+template <typename CardTraits>
+void BasicRandomStrategy<CardTraits>::seed(uint64_t value)
+{
+    randGenerator_.seed(static_cast<std::mt19937::result_type>(value ^ (value >> 32)));
+}
+
+template <typename CardTraits>
+const std::string& BasicRandomStrategy<CardTraits>::name() const
 {
     static const std::string NAME = "Random strategy";
     return NAME;
 }
 
-} // namespace miplot::cardgame::durak
+template class BasicRandomStrategy<cards::Std24CardTraits>;
+template class BasicRandomStrategy<cards::Std36CardTraits>;
+template class BasicRandomStrategy<cards::Std52CardTraits>;
 
+} // namespace miplot::cardgame::durak
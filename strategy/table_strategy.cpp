@@ -0,0 +1,92 @@
+#include "strategy.h"
+#include "game.h"
+#include "opening_table.h"
+
+#include <algorithm>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+// First attack of a round: nothing was played yet and nobody has drawn
+bool isOpening(const GameState& state, const Cards& hand)
+{
+    if (!state.discard().empty() || !state.undefendedCards().empty()
+            || !state.defendedCards().empty() || hand.size() != OpeningTable::HAND_SIZE) {
+        return false;
+    }
+    const auto& opponents = state.opponents();
+    return std::all_of(opponents.begin(), opponents.end(), [](const Opponent& o) {
+        return o.numCards == OpeningTable::HAND_SIZE;
+    });
+}
+
+} // namespace
+
+TableStrategy::TableStrategy(std::shared_ptr<const OpeningTable> table,
+                             std::unique_ptr<Strategy> fallback)
+    : table_(std::move(table))
+    , fallback_(std::move(fallback))
+{
+}
+
+int TableStrategy::attack(const GameState& state, const Cards& hand)
+{
+    if (isOpening(state, hand)) {
+        auto code = table_->lookup(CardSet::of(hand), state.trumpSuit(), state.opponents().size());
+        if (code != OpeningTable::NO_ENTRY) {
+            auto itr = std::find_if(hand.begin(), hand.end(),
+                                    [&](const Card& c) { return c.code() == code; });
+            if (itr != hand.end()) {
+                return std::distance(hand.begin(), itr);
+            }
+        }
+    }
+    return fallback_->attack(state, hand);
+}
+
+AttackBatch TableStrategy::attackBatch(const GameState& state, const Cards& hand)
+{
+    if (isOpening(state, hand)) {
+        return Strategy::attackBatch(state, hand);
+    }
+    return fallback_->attackBatch(state, hand);
+}
+
+int TableStrategy::defend(const GameState& state, const Cards& hand)
+{
+    return fallback_->defend(state, hand);
+}
+
+int TableStrategy::transfer(const GameState& state, const Cards& hand)
+{
+    return fallback_->transfer(state, hand);
+}
+
+const std::string& TableStrategy::name() const
+{
+    static const std::string NAME = "Opening table strategy";
+    return NAME;
+}
+
+void TableStrategy::seed(uint64_t value)
+{
+    fallback_->seed(value);
+}
+
+GameObserver* TableStrategy::observer()
+{
+    return fallback_->observer();
+}
+
+std::string TableStrategy::saveState() const
+{
+    return fallback_->saveState();
+}
+
+void TableStrategy::loadState(const std::string& state)
+{
+    fallback_->loadState(state);
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,200 @@
+#include "strategy.h"
+#include "helper.h"
+#include "game.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace miplot::cardgame::durak {
+
+namespace {
+
+constexpr size_t HAND_SIZE = 6;
+
+template <typename CardTraits>
+size_t deckSize(const BasicGameState<CardTraits>& state)
+{
+    size_t numSeen = state.undefendedCards().size() + 2 * state.defendedCards().size()
+        + state.discard().size();
+    for (const auto& opponent : state.opponents()) {
+        numSeen += opponent.numCards;
+    }
+    return numSeen < CardTraits::radix() ? CardTraits::radix() - numSeen : 0;
+}
+
+template <typename CardTraits>
+bool matchesTable(const BasicGameState<CardTraits>& state, const cards::Card<CardTraits>& card)
+{
+    return std::any_of(state.defendedCards().begin(), state.defendedCards().end(),
+                       [&](const auto& pair) {
+                           return pair.attacking.rank() == card.rank()
+                               || pair.defending.rank() == card.rank();
+                       })
+        || std::any_of(state.undefendedCards().begin(), state.undefendedCards().end(),
+                       [&](const auto& c) { return c.rank() == card.rank(); });
+}
+
+} // namespace
+
+std::vector<double> HeuristicWeights::toVector() const
+{
+    return {trumpValue, leadPairBonus, pileOnLimit, resignLimit, transferLimit, endgameAggression};
+}
+
+HeuristicWeights HeuristicWeights::fromVector(const std::vector<double>& values)
+{
+    REQUIRE(values.size() == SIZE, "Expected " << SIZE << " weights, got " << values.size());
+    HeuristicWeights weights;
+    weights.trumpValue = values[0];
+    weights.leadPairBonus = values[1];
+    weights.pileOnLimit = values[2];
+    weights.resignLimit = values[3];
+    weights.transferLimit = values[4];
+    weights.endgameAggression = values[5];
+    return weights;
+}
+
+std::string HeuristicWeights::toString() const
+{
+    std::ostringstream out;
+    auto values = toVector();
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i ? "," : "") << values[i];
+    }
+    return out.str();
+}
+
+HeuristicWeights HeuristicWeights::parse(const std::string& text)
+{
+    std::vector<double> values;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        values.push_back(std::strtod(item.c_str(), &end));
+        REQUIRE(!item.empty() && *end == '\0', "Invalid weight: '" << item << "'");
+    }
+    return fromVector(values);
+}
+
+template <typename CardTraits>
+BasicWeightedHeuristicStrategy<CardTraits>::BasicWeightedHeuristicStrategy(const HeuristicWeights& weights)
+    : weights_(weights)
+{
+}
+
+template <typename CardTraits>
+double BasicWeightedHeuristicStrategy<CardTraits>::value(const GameState& state, const Card& card) const
+{
+    double rank = static_cast<double>(card.rank()) / (CardTraits::numRanks() - 1);
+    return card.suit() == state.trumpSuit() ? rank + weights_.trumpValue : rank;
+}
+
+template <typename CardTraits>
+double BasicWeightedHeuristicStrategy<CardTraits>::limit(const GameState& state, double base) const
+{
+    size_t numDealt = state.opponents().size() * HAND_SIZE;
+    size_t initialDeck = numDealt < CardTraits::radix() ? CardTraits::radix() - numDealt : 0;
+    double endgame = initialDeck == 0
+        ? 1.0
+        : 1.0 - std::min(1.0, static_cast<double>(deckSize(state)) / initialDeck);
+    return base + weights_.endgameAggression * endgame;
+}
+
+template <typename CardTraits>
+int BasicWeightedHeuristicStrategy<CardTraits>::attack(const GameState& state, const Cards& hand)
+{
+    if (hand.empty()) {
+        return -1;
+    }
+
+    int bestIdx = -1;
+    double bestCost = 0;
+
+    if (state.defendedCards().empty() && state.undefendedCards().empty()) {
+        // Leading is mandatory, prefer ranks that can be piled on later
+        for (size_t i = 0; i < hand.size(); ++i) {
+            size_t numSameRank = std::count_if(hand.begin(), hand.end(), [&](const Card& card) {
+                return card.rank() == hand[i].rank();
+            });
+            double cost = value(state, hand[i]) - weights_.leadPairBonus * (numSameRank - 1);
+            if (bestIdx == -1 || cost < bestCost) {
+                bestIdx = i;
+                bestCost = cost;
+            }
+        }
+        return bestIdx;
+    }
+
+    // Safety check
+    if (state.defendedCards().size() + state.undefendedCards().size() >= MAX_ATTACK_SIZE
+            || state.undefendedCards().size() >= state.opponents()[state.defenderIdx()].numCards) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (!matchesTable(state, hand[i])) {
+            continue;
+        }
+        double cost = value(state, hand[i]);
+        if (bestIdx == -1 || cost < bestCost) {
+            bestIdx = i;
+            bestCost = cost;
+        }
+    }
+    return bestIdx != -1 && bestCost <= limit(state, weights_.pileOnLimit) ? bestIdx : -1;
+}
+
+template <typename CardTraits>
+int BasicWeightedHeuristicStrategy<CardTraits>::defend(const GameState& state, const Cards& hand)
+{
+    const auto& attacker = state.undefendedCards().front();
+
+    int bestIdx = -1;
+    double bestCost = 0;
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (!canDefend(attacker, hand[i], state.trumpSuit())) {
+            continue;
+        }
+        double cost = value(state, hand[i]);
+        if (bestIdx == -1 || cost < bestCost) {
+            bestIdx = i;
+            bestCost = cost;
+        }
+    }
+    return bestIdx != -1 && bestCost <= limit(state, weights_.resignLimit) ? bestIdx : -1;
+}
+
+template <typename CardTraits>
+int BasicWeightedHeuristicStrategy<CardTraits>::transfer(const GameState& state, const Cards& hand)
+{
+    const auto& attacker = state.undefendedCards().front();
+
+    int bestIdx = -1;
+    double bestCost = 0;
+    for (size_t i = 0; i < hand.size(); ++i) {
+        if (hand[i].rank() != attacker.rank()) {
+            continue;
+        }
+        double cost = value(state, hand[i]);
+        if (bestIdx == -1 || cost < bestCost) {
+            bestIdx = i;
+            bestCost = cost;
+        }
+    }
+    return bestIdx != -1 && bestCost <= limit(state, weights_.transferLimit) ? bestIdx : -1;
+}
+
+template <typename CardTraits>
+const std::string& BasicWeightedHeuristicStrategy<CardTraits>::name() const
+{
+    static const std::string NAME = "Weighted heuristic strategy";
+    return NAME;
+}
+
+template class BasicWeightedHeuristicStrategy<cards::Std24CardTraits>;
+template class BasicWeightedHeuristicStrategy<cards::Std36CardTraits>;
+template class BasicWeightedHeuristicStrategy<cards::Std52CardTraits>;
+
+} // namespace miplot::cardgame::durak
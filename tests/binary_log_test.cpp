@@ -0,0 +1,111 @@
+#include "card.h"
+#include "logging/deferred.h"
+#include "tests/check.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+// The logger is created once per process, so every check shares the log
+test::TempFile logFile("log.dkbl");
+
+// Lines of durak-logdecode for a log, sorted
+std::vector<std::string> decode(const std::string& path)
+{
+    test::TempFile text("log.txt");
+    std::string command = "./durak-logdecode " + path + " > " + text.path() + " 2> /dev/null";
+    REQUIRE(std::system(command.c_str()) == 0, "Cannot decode " << path);
+    std::vector<std::string> lines;
+    std::ifstream in(text.path());
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end());
+    return lines;
+}
+
+template <typename... Args>
+std::string line(log::Level level, const Args&... args)
+{
+    std::ostringstream os;
+    os << "[" << level << "] ";
+    (os << ... << args);
+    return os.str();
+}
+
+// Logs messages of every argument type, returns their lines as a text logger writes them
+std::vector<std::string> writeMessages(size_t thread)
+{
+    using cards::Card52;
+    Cards hand;
+    hand.emplace_back(Suit::Hearts, Rank::Ten);
+    hand.emplace_back(Suit::Clubs, Rank::Six);
+    CardPairs table;
+    table.push_back({Card(Suit::Spades, Rank::Seven), Card(Suit::Spades, Rank::Ace)});
+    Card52 two(Suit::Diamonds, cards::Rank13::Two);
+
+    std::vector<std::string> lines;
+    for (int i = 0; i < 3; ++i) {
+        INFOF("Thread {} message {} of {}", thread, i, -3);
+        lines.push_back(line(log::Level::Info, "Thread ", thread, " message ", i, " of ", -3));
+    }
+    INFOF("Ratio {}, {} and {}", 0.1, 1e300, 2.5f);
+    lines.push_back(line(log::Level::Info, "Ratio ", 0.1, ", ", 1e300, " and ", 2.5f));
+    DEBUGF("Hand {}, table {}, nothing {}", hand, table, Cards());
+    lines.push_back(line(log::Level::Debug, "Hand ", hand[0], ",", hand[1], ", table (", table[0].attacking,
+                         ",", table[0].defending, "), nothing "));
+    DEBUGF("Card {} of 52, name {}, flag {}", two, std::string("Weighted"), true);
+    lines.push_back(line(log::Level::Debug, "Card ", two, " of 52, name Weighted, flag 1"));
+    INFOF("No arguments");
+    lines.push_back(line(log::Level::Info, "No arguments"));
+    INFO() << "Text message " << thread;
+    lines.push_back(line(log::Level::Info, "Text message ", thread));
+    return lines;
+}
+
+void roundTrip()
+{
+    auto expected = writeMessages(0);
+    std::vector<std::string> other;
+    // Buffers are written out when their thread ends
+    std::thread([&] { other = writeMessages(1); }).join();
+    log::flush();
+
+    expected.insert(expected.end(), other.begin(), other.end());
+    std::sort(expected.begin(), expected.end());
+    auto decoded = decode(logFile.path());
+    CHECK_EQ(decoded.size(), expected.size());
+    for (size_t idx = 0; idx < expected.size(); ++idx) {
+        CHECK_EQ(decoded[idx], expected[idx]);
+    }
+}
+
+// A chunk torn by a crash is dropped, the ones before it are decoded
+void tornChunk()
+{
+    test::TempFile copy("torn.dkbl");
+    std::filesystem::copy_file(logFile.path(), copy.path());
+    auto complete = decode(copy.path());
+    std::filesystem::resize_file(copy.path(), std::filesystem::file_size(copy.path()) - 5);
+    auto torn = decode(copy.path());
+    CHECK(torn.size() < complete.size());
+    CHECK(std::includes(complete.begin(), complete.end(), torn.begin(), torn.end()));
+}
+
+} // namespace
+
+int main()
+{
+    log::setLogger(log::toBinaryFile(logFile.path().c_str()));
+    log::setLogLevel(log::Level::Debug);
+    return test::run("binary log", {
+        {"round trip", roundTrip},
+        {"torn chunk", tornChunk},
+    });
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "exception.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+namespace miplot::test {
+
+/*
+ * Minimal checks for `make check`: every test binary runs a list of named
+ * checks, a failed CHECK throws and fails its check, the binary exits
+ * with failure if any did
+ */
+
+#define CHECK(statement) \
+    REQUIRE(statement, __FILE__ << ":" << __LINE__ << ": " << #statement)
+
+#define CHECK_EQ(lhs, rhs)                                                              \
+    REQUIRE((lhs) == (rhs), __FILE__ << ":" << __LINE__ << ": " << #lhs << " == " << #rhs \
+            << ", got " << (lhs) << " and " << (rhs))
+
+struct Check {
+    const char* name;
+    std::function<void()> run;
+};
+
+inline int run(const char* test, std::initializer_list<Check> checks)
+{
+    size_t numFailed = 0;
+    for (const auto& check : checks) {
+        try {
+            check.run();
+        } catch (const std::exception& e) {
+            std::cerr << test << ": " << check.name << " failed: " << e.what() << "\n";
+            ++numFailed;
+        }
+    }
+    std::cout << test << ": " << checks.size() - numFailed << " of " << checks.size() << " passed\n";
+    return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Scratch file removed on destruction, nothing is left from an earlier run
+class TempFile {
+public:
+    explicit TempFile(const std::string& name)
+        : path_(std::filesystem::temp_directory_path() / ("durak-test-" + std::to_string(getpid()) + "-" + name))
+    {
+        std::filesystem::remove(path_);
+    }
+
+    ~TempFile()
+    {
+        std::error_code error;
+        std::filesystem::remove(path_, error);
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator= (const TempFile&) = delete;
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+} // namespace miplot::test
@@ -0,0 +1,122 @@
+#include "checkpoint.h"
+#include "tests/check.h"
+
+#include <fstream>
+
+using namespace miplot;
+
+namespace {
+
+Checkpoint makeCheckpoint(uint64_t end)
+{
+    Checkpoint checkpoint;
+    checkpoint.config = "players=4 rounds=1000";
+    checkpoint.seed = 0xfeedfacecafebeefULL;
+    checkpoint.begin = 100;
+    checkpoint.end = end;
+    checkpoint.counters = {end, 0, 7, UINT64_MAX};
+    checkpoint.sums = {0.5, -1e300, 3.25};
+    checkpoint.game = std::string("\0\1snapshot\xff", 12);
+    checkpoint.states = {"", std::string(70000, 'x'), "weights"};
+    return checkpoint;
+}
+
+void checkSame(const Checkpoint& expected, const Checkpoint& actual)
+{
+    CHECK_EQ(actual.config, expected.config);
+    CHECK_EQ(actual.seed, expected.seed);
+    CHECK_EQ(actual.begin, expected.begin);
+    CHECK_EQ(actual.end, expected.end);
+    CHECK(actual.counters == expected.counters);
+    CHECK(actual.sums == expected.sums);
+    CHECK(actual.game == expected.game);
+    CHECK(actual.states == expected.states);
+}
+
+void roundTrip()
+{
+    test::TempFile file("round_trip.dkck");
+    {
+        CheckpointLog log(file.path());
+        CHECK(!log.last());
+        log.append(makeCheckpoint(200));
+        log.append(makeCheckpoint(300));
+    }
+    auto last = CheckpointLog::read(file.path());
+    CHECK(last);
+    checkSame(makeCheckpoint(300), *last);
+
+    // Reopened logs continue after the last record
+    {
+        CheckpointLog log(file.path());
+        CHECK(log.last());
+        checkSame(makeCheckpoint(300), *log.last());
+        log.append(makeCheckpoint(400));
+    }
+    checkSame(makeCheckpoint(400), *CheckpointLog::read(file.path()));
+}
+
+void tornRecord()
+{
+    test::TempFile file("torn.dkck");
+    {
+        CheckpointLog log(file.path());
+        log.append(makeCheckpoint(200));
+        log.append(makeCheckpoint(300));
+    }
+    auto size = std::filesystem::file_size(file.path());
+    std::filesystem::resize_file(file.path(), size - 3);
+    checkSame(makeCheckpoint(200), *CheckpointLog::read(file.path()));
+
+    // The torn record is cut off before appending
+    {
+        CheckpointLog log(file.path());
+        checkSame(makeCheckpoint(200), *log.last());
+        log.append(makeCheckpoint(500));
+    }
+    checkSame(makeCheckpoint(500), *CheckpointLog::read(file.path()));
+}
+
+void corruptRecord()
+{
+    test::TempFile file("corrupt.dkck");
+    {
+        CheckpointLog log(file.path());
+        log.append(makeCheckpoint(200));
+        log.append(makeCheckpoint(300));
+    }
+    // Flip a byte inside the last record, its checksum no longer matches
+    auto size = std::filesystem::file_size(file.path());
+    {
+        std::fstream out(file.path(), std::ios::in | std::ios::out | std::ios::binary);
+        out.seekp(size - 20);
+        out.put('?');
+    }
+    checkSame(makeCheckpoint(200), *CheckpointLog::read(file.path()));
+}
+
+void notALog()
+{
+    test::TempFile file("not_a_log.dkck");
+    std::ofstream(file.path()) << "DKSP\1\0\0\0";
+    bool thrown = false;
+    try {
+        CheckpointLog::read(file.path());
+    } catch (const Exception&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+} // namespace
+
+int main()
+{
+    log::setLogLevel(log::Level::Error);
+    return test::run("checkpoint", {
+        {"round trip", roundTrip},
+        {"torn record", tornRecord},
+        {"corrupt record", corruptRecord},
+        {"not a log", notALog},
+    });
+}
@@ -0,0 +1,145 @@
+#include "notation.h"
+#include "strategy.h"
+#include "tests/check.h"
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+template <typename CardTraits>
+BasicPlayers<CardTraits> makePlayers(size_t numPlayers)
+{
+    BasicPlayers<CardTraits> players;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        auto name = "Player " + std::to_string(idx + 1);
+        if (idx % 2 == 0) {
+            players.emplace_back(name, std::make_unique<BasicRandomStrategy<CardTraits>>());
+        } else {
+            players.emplace_back(name, std::make_unique<BasicMinCardStrategy<CardTraits>>());
+        }
+    }
+    return players;
+}
+
+template <typename CardTraits>
+std::string positionOf(const BasicGame<CardTraits>& game)
+{
+    std::string out;
+    notation::appendPosition(out, game.position());
+    return out;
+}
+
+template <typename CardTraits>
+void cards()
+{
+    using Notation = notation::CardNotation<CardTraits>;
+    for (size_t code = 0; code < CardTraits::radix(); ++code) {
+        char name[2];
+        Notation::format(name, code);
+        CHECK_EQ(Notation::parse(name[0], name[1]), static_cast<int>(code));
+    }
+    CHECK_EQ(Notation::parse('A', 'x'), -1);
+    CHECK_EQ(Notation::parse('1', 'c'), -1);
+    CHECK_EQ(Notation::parse('\xff', 'c'), -1);
+    if (CardTraits::radix() < 52) {
+        CHECK_EQ(Notation::parse('2', 'c'), -1);
+    }
+}
+
+// Written rounds replay to the same results and end positions
+template <typename CardTraits>
+void rounds(size_t numPlayers, Rules rules)
+{
+    notation::BasicNotatedGame<CardTraits> game(makePlayers<CardTraits>(numPlayers), rules);
+    notation::BasicNotatedGame<CardTraits> replayed(makePlayers<CardTraits>(numPlayers), rules);
+    game.seed(7);
+    std::string line;
+    for (size_t round = 0; round < 50; ++round) {
+        line.clear();
+        auto result = game.playRound(round % numPlayers, line);
+        auto replayedResult = replayed.replay(line);
+        REQUIRE(replayedResult.losingPlayerIdx == result.losingPlayerIdx && replayedResult.places == result.places,
+                "Round " << round << " replays differently: " << line);
+        CHECK_EQ(positionOf(replayed), positionOf(game));
+    }
+}
+
+// Positions along written rounds parse back and load into the same game
+template <typename CardTraits>
+void positions(size_t numPlayers, Rules rules)
+{
+    notation::BasicNotatedGame<CardTraits> game(makePlayers<CardTraits>(numPlayers), rules);
+    notation::BasicNotatedGame<CardTraits> sought(makePlayers<CardTraits>(numPlayers), rules);
+    notation::BasicNotatedGame<CardTraits> loaded(makePlayers<CardTraits>(numPlayers), rules);
+    game.seed(11);
+    std::string line;
+    for (size_t round = 0; round < 10; ++round) {
+        line.clear();
+        game.playRound(round % numPlayers, line);
+        for (size_t numMoves : {0, 1, 5, 12, 30}) {
+            sought.seek(line, numMoves);
+            auto position = positionOf(sought);
+            loaded.setPosition(notation::parsePosition<CardTraits>(position));
+            CHECK_EQ(positionOf(loaded), position);
+        }
+    }
+}
+
+template <typename CardTraits>
+void deck()
+{
+    cards<CardTraits>();
+    Rules transfer;
+    transfer.transfer = true;
+    Rules teams;
+    teams.numTeams = 2;
+    rounds<CardTraits>(2, Rules());
+    rounds<CardTraits>(3, transfer);
+    rounds<CardTraits>(4, teams);
+    positions<CardTraits>(2, transfer);
+    positions<CardTraits>(4, Rules());
+}
+
+void illegalMoves()
+{
+    notation::NotatedGame game(makePlayers<cards::Std36CardTraits>(2));
+    game.seed(3);
+    std::string line;
+    game.playRound(0, line);
+
+    // The first attacker folding at once is not a legal move
+    auto deckEnd = line.find(' ');
+    std::string folded = line.substr(0, deckEnd) + " 0 -";
+    for (const auto& round : {folded, line.substr(0, deckEnd) + " 0 Zz", std::string("6c7c 0")}) {
+        bool thrown = false;
+        try {
+            notation::NotatedGame replayed(makePlayers<cards::Std36CardTraits>(2));
+            replayed.replay(round);
+        } catch (const Exception&) {
+            thrown = true;
+        }
+        REQUIRE(thrown, "Accepted " << round);
+    }
+
+    bool thrown = false;
+    try {
+        notation::parsePosition<cards::Std36CardTraits>("x 6c7h/9s - - - - 0,0,1 0,0,1,0 0/0");
+    } catch (const Exception&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+} // namespace
+
+int main()
+{
+    log::setLogLevel(log::Level::Warn);
+    return test::run("notation", {
+        {"24 cards", deck<cards::Std24CardTraits>},
+        {"36 cards", deck<cards::Std36CardTraits>},
+        {"52 cards", deck<cards::Std52CardTraits>},
+        {"illegal moves", illegalMoves},
+    });
+}
@@ -0,0 +1,87 @@
+#include "perft.h"
+#include "tests/check.h"
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+/*
+ * Positions at every ply of fixed deals. A difference is a change of the
+ * rules or of move generation, to be explained before the counts are updated
+ */
+struct Case {
+    size_t deckSize;
+    size_t numPlayers;
+    bool transfer;
+    uint64_t seed;
+    bool validate;
+    std::vector<uint64_t> nodes;
+};
+
+const std::vector<Case> CASES = {
+    {36, 2, false, 1, true, {1, 6, 24, 50, 218, 579, 1367}},
+    {36, 2, true, 5, true, {1, 6, 16, 27, 95, 292, 726, 2227, 6779}},
+    {36, 2, true, 5, false, {1, 6, 16, 27, 95, 292, 726, 2227, 6779, 18444, 56584}},
+    {36, 4, true, 1, false, {1, 6, 16, 32, 56, 108, 237, 559}},
+    {24, 3, true, 1, false, {1, 6, 26, 52, 121, 335, 874, 2424}},
+    {52, 3, true, 1, false, {1, 6, 22, 48, 73, 215, 513, 1195}},
+};
+
+void counts()
+{
+    for (const auto& c : CASES) {
+        Rules rules;
+        rules.transfer = c.transfer;
+        PerftOptions options;
+        options.depth = c.nodes.size() - 1;
+        options.deckSize = c.deckSize;
+        options.validate = c.validate;
+        Perft perft(c.numPlayers, rules, options);
+        auto result = perft.run(perft.deal(c.seed));
+
+        REQUIRE(result.nodes == c.nodes, "Deck " << c.deckSize << ", " << c.numPlayers << " players, seed "
+                << c.seed << ": " << result.nodes.size() << " plies, " << result.numNodes() << " nodes");
+        CHECK_EQ(result.numMismatches, 0);
+    }
+}
+
+void divideSums()
+{
+    PerftOptions options;
+    options.depth = 5;
+    options.divide = true;
+    Perft perft(2, Rules(), options);
+    auto result = perft.run(perft.deal(1));
+    uint64_t total = 0;
+    for (const auto& [move, count] : result.divide) {
+        total += count;
+    }
+    CHECK_EQ(result.divide.size(), result.nodes[1]);
+    CHECK_EQ(total, result.nodes.back());
+}
+
+// Threads split root moves, counts do not depend on their number
+void threads()
+{
+    PerftOptions options;
+    options.depth = 7;
+    options.numThreads = 1;
+    Perft single(3, Rules(), options);
+    options.numThreads = 4;
+    Perft parallel(3, Rules(), options);
+    auto snapshot = single.deal(9);
+    CHECK(single.run(snapshot).nodes == parallel.run(snapshot).nodes);
+}
+
+} // namespace
+
+int main()
+{
+    log::setLogLevel(log::Level::Warn);
+    return test::run("perft", {
+        {"counts", counts},
+        {"divide sums", divideSums},
+        {"threads", threads},
+    });
+}
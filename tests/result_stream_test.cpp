@@ -0,0 +1,107 @@
+#include "rating.h"
+#include "tests/check.h"
+
+#include <cstring>
+
+using namespace miplot;
+
+namespace {
+
+constexpr size_t NUM_SEATS = 4;
+
+const std::vector<std::string> NAMES = {"MinCard", "Random", "", "Weighted Heuristic"};
+
+// Entrants rotate between seats, places follow the round
+void makeRecord(size_t round, uint16_t* entrants, uint8_t* places)
+{
+    for (size_t seat = 0; seat < NUM_SEATS; ++seat) {
+        entrants[seat] = (round + seat) % NAMES.size();
+        places[seat] = (round * 7 + seat * 3) % NUM_SEATS;
+    }
+}
+
+void checkRecords(const ResultStream& stream, size_t numRecords)
+{
+    CHECK_EQ(stream.numSeats(), NUM_SEATS);
+    CHECK(stream.names() == NAMES);
+    CHECK_EQ(stream.numRecords(), numRecords);
+    uint16_t entrants[NUM_SEATS];
+    uint8_t places[NUM_SEATS];
+    for (size_t round = 0; round < numRecords; ++round) {
+        makeRecord(round, entrants, places);
+        const uint8_t* record = stream.record(round);
+        for (size_t seat = 0; seat < NUM_SEATS; ++seat) {
+            uint16_t entrant;
+            std::memcpy(&entrant, record + 2 * seat, sizeof(entrant));
+            CHECK_EQ(entrant, entrants[seat]);
+            CHECK_EQ(record[2 * NUM_SEATS + seat], places[seat]);
+        }
+    }
+}
+
+void append(ResultStreamWriter& writer, size_t begin, size_t end)
+{
+    uint16_t entrants[NUM_SEATS];
+    uint8_t places[NUM_SEATS];
+    for (size_t round = begin; round < end; ++round) {
+        makeRecord(round, entrants, places);
+        writer.append(entrants, places);
+    }
+}
+
+void roundTrip()
+{
+    test::TempFile file("round_trip.dkrs");
+    {
+        ResultStreamWriter writer(file.path(), NAMES, NUM_SEATS);
+        // More than one flush of the buffer
+        append(writer, 0, 20000);
+        writer.sync();
+    }
+    checkRecords(ResultStream::open(file.path()), 20000);
+}
+
+void resume()
+{
+    test::TempFile file("resume.dkrs");
+    {
+        ResultStreamWriter writer(file.path(), NAMES, NUM_SEATS);
+        append(writer, 0, 500);
+    }
+    // A checkpoint at 300 records drops the rest, appending continues from it
+    {
+        ResultStreamWriter writer(file.path(), NAMES, NUM_SEATS, 300);
+        append(writer, 300, 400);
+    }
+    checkRecords(ResultStream::open(file.path()), 400);
+
+    bool thrown = false;
+    try {
+        ResultStreamWriter writer(file.path(), {"Other"}, NUM_SEATS, 100);
+    } catch (const Exception&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+void tornRecord()
+{
+    test::TempFile file("torn.dkrs");
+    {
+        ResultStreamWriter writer(file.path(), NAMES, NUM_SEATS);
+        append(writer, 0, 10);
+    }
+    std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) - 1);
+    checkRecords(ResultStream::open(file.path()), 9);
+}
+
+} // namespace
+
+int main()
+{
+    return test::run("result stream", {
+        {"round trip", roundTrip},
+        {"resume", resume},
+        {"torn record", tornRecord},
+    });
+}
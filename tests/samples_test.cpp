@@ -0,0 +1,125 @@
+#include "samples.h"
+#include "tests/check.h"
+
+#include <random>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+// Rows with sparse card masks and long zero runs, as self-play writes them
+SampleChunk makeChunk(size_t numRows, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    auto cards = [&](size_t numCards) {
+        CardSet set;
+        for (size_t i = 0; i < numCards; ++i) {
+            set.insert(rng() % NUM_CARD_CODES);
+        }
+        return set;
+    };
+
+    SampleChunk chunk;
+    chunk.resize(numRows);
+    for (size_t row = 0; row < numRows; ++row) {
+        DecisionRecord record;
+        record.kind = static_cast<protocol::DecisionKind>(rng() % 3);
+        record.trump = rng() % 4;
+        record.numPlayers = 2 + rng() % 5;
+        record.numOtherCards = rng() % 30;
+        record.deckSize = row < numRows / 2 ? 0 : rng() % 24;
+        record.hand = cards(rng() % 8);
+        record.undefended = cards(rng() % 3);
+        record.attacking = cards(rng() % 4);
+        record.defending = cards(rng() % 4);
+        record.discard = row % 7 == 0 ? cards(rng() % 36) : CardSet();
+        size_t action = rng() % 5 == 0 ? PASS_ACTION : rng() % NUM_CARD_CODES;
+        chunk.set(row, rng() % 6, record, action);
+        chunk.setRound(row, row / 40 + (row % 100 == 0 ? uint64_t(1) << 40 : 0));
+        chunk.setOutcome(row, static_cast<int>(rng() % 3) - 1);
+    }
+    return chunk;
+}
+
+void checkSame(const SampleChunk& expected, const SampleChunk& actual)
+{
+    CHECK_EQ(actual.numRows(), expected.numRows());
+    for (size_t idx = 0; idx < NUM_SAMPLE_COLUMNS; ++idx) {
+        auto column = static_cast<SampleColumn>(idx);
+        REQUIRE(actual.column(column) == expected.column(column), "Column " << idx << " differs");
+    }
+    for (size_t row = 0; row < expected.numRows(); ++row) {
+        auto lhs = expected.record(row);
+        auto rhs = actual.record(row);
+        CHECK(lhs.hand == rhs.hand && lhs.discard == rhs.discard && lhs.kind == rhs.kind);
+        CHECK_EQ(actual.action(row), expected.action(row));
+        CHECK_EQ(actual.outcome(row), expected.outcome(row));
+        CHECK_EQ(actual.round(row), expected.round(row));
+    }
+}
+
+void roundTrip()
+{
+    test::TempFile file("samples.dksp");
+    std::vector<SampleChunk> chunks;
+    for (size_t numRows : {1, 1000, 77, 4096}) {
+        chunks.push_back(makeChunk(numRows, chunks.size() + 1));
+    }
+    {
+        SampleWriter writer(file.path());
+        for (const auto& chunk : chunks) {
+            writer.append(compressChunk(chunk), chunk.numRows());
+        }
+        writer.close();
+    }
+
+    SampleReader reader(file.path());
+    CHECK_EQ(reader.numChunks(), chunks.size());
+    CHECK_EQ(reader.numRows(), 1 + 1000 + 77 + 4096);
+    SampleChunk chunk;
+    for (size_t idx = 0; idx < chunks.size(); ++idx) {
+        CHECK_EQ(reader.chunkRows(idx), chunks[idx].numRows());
+        reader.read(idx, chunk);
+        checkSame(chunks[idx], chunk);
+    }
+}
+
+void emptyFile()
+{
+    test::TempFile file("empty.dksp");
+    SampleWriter(file.path()).close();
+    SampleReader reader(file.path());
+    CHECK_EQ(reader.numChunks(), 0);
+    CHECK_EQ(reader.numRows(), 0);
+}
+
+void truncatedFile()
+{
+    test::TempFile file("truncated.dksp");
+    {
+        SampleWriter writer(file.path());
+        auto chunk = makeChunk(100, 5);
+        writer.append(compressChunk(chunk), chunk.numRows());
+        writer.close();
+    }
+    std::filesystem::resize_file(file.path(), std::filesystem::file_size(file.path()) - 1);
+    bool thrown = false;
+    try {
+        SampleReader reader(file.path());
+    } catch (const Exception&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+} // namespace
+
+int main()
+{
+    return test::run("samples", {
+        {"round trip", roundTrip},
+        {"empty file", emptyFile},
+        {"truncated file", truncatedFile},
+    });
+}
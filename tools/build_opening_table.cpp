@@ -0,0 +1,204 @@
+#include "exception.h"
+#include "game.h"
+#include "logging/logging.h"
+#include "opening_table.h"
+#include "simulator.h"
+#include "strategy.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+constexpr size_t RADIX = Card::Traits::radix();
+
+struct Options {
+    std::string output;
+    size_t numPlayers = 0; // 0 means every supported number of players
+    size_t begin = 0;
+    size_t end = OpeningTable::numHands();
+    size_t rounds = 100;
+    size_t threads = defaultNumThreads();
+    uint64_t seed = 1;
+};
+
+void usage()
+{
+    std::cerr << "Usage: durak-opening-table <table file> [--players N] [--begin I] [--end J]\n"
+                 "                           [--rounds K] [--threads T] [--seed S]\n"
+                 "Fills table entries for hand indices [I, J) by simulating K rounds\n"
+                 "per candidate card. Only hands in canonical form up to suit symmetry\n"
+                 "are simulated. Existing table files are updated in place.\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> unsigned long long {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (arg == "--players") options.numPlayers = value();
+        else if (arg == "--begin") options.begin = value();
+        else if (arg == "--end") options.end = value();
+        else if (arg == "--rounds") options.rounds = value();
+        else if (arg == "--threads") options.threads = value();
+        else if (arg == "--seed") options.seed = value();
+        else if (options.output.empty() && arg[0] != '-') options.output = arg;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    REQUIRE(!options.output.empty(), "Table file is not specified");
+    REQUIRE(options.begin <= options.end && options.end <= OpeningTable::numHands(),
+            "Invalid hand range");
+    REQUIRE(options.rounds > 0, "Number of rounds must be positive");
+    return options;
+}
+
+// Attacks with a preset card once, then plays as the rollout strategy
+class ProbeStrategy : public Strategy {
+public:
+    void force(int cardIdx) { forcedIdx_ = cardIdx; }
+
+    int attack(const GameState& state, const Cards& hand) override
+    {
+        int idx = forcedIdx_;
+        forcedIdx_ = -1;
+        return idx != -1 ? idx : rollout_.attack(state, hand);
+    }
+
+    int defend(const GameState& state, const Cards& hand) override
+    {
+        return rollout_.defend(state, hand);
+    }
+
+private:
+    int forcedIdx_ = -1;
+    MinCardStrategy rollout_;
+};
+
+// Random deal giving the hand to the first player, with a Clubs trump
+Deck::Order makeDeal(const uint8_t* hand, CardSet handSet, size_t numPlayers, std::mt19937_64& rng)
+{
+    CardSet clubs;
+    for (size_t code = 0; code < Card::Traits::numRanks(); ++code) {
+        clubs.insert(code);
+    }
+    clubs -= handSet;
+
+    std::array<uint8_t, RADIX> rest;
+    size_t numRest = 0;
+    (CardSet::full() - handSet).forEach([&](size_t code) { rest[numRest++] = code; });
+    std::shuffle(rest.begin(), rest.begin() + numRest, rng);
+
+    // Swap a random remaining club into the trump position
+    size_t trumpPos = OpeningTable::HAND_SIZE * (numPlayers - 1);
+    size_t trumpCode = 0;
+    size_t clubIdx = rng() % clubs.size();
+    clubs.forEach([&](size_t code) {
+        if (clubIdx-- == 0) trumpCode = code;
+    });
+    auto itr = std::find(rest.begin(), rest.begin() + numRest, trumpCode);
+    std::swap(*itr, rest[trumpPos]);
+
+    Deck::Order order;
+    std::copy(hand, hand + OpeningTable::HAND_SIZE, order.begin());
+    std::copy(rest.begin(), rest.begin() + numRest, order.begin() + OpeningTable::HAND_SIZE);
+    return order;
+}
+
+void buildTable(OpeningTable& table, size_t numPlayers, const Options& options)
+{
+    parallelFor(options.end - options.begin, options.threads,
+                [&](size_t, size_t begin, size_t end) {
+        auto probe = std::make_unique<ProbeStrategy>();
+        ProbeStrategy* prober = probe.get();
+
+        Players players;
+        players.emplace_back("Prober", std::move(probe));
+        for (size_t idx = 1; idx < numPlayers; ++idx) {
+            players.emplace_back("Player " + std::to_string(idx + 1),
+                                 std::make_unique<MinCardStrategy>());
+        }
+        Game game{std::move(players)};
+
+        std::vector<Deck::Order> deals(options.rounds);
+
+        for (size_t handIdx = options.begin + begin; handIdx < options.begin + end; ++handIdx) {
+            CardSet handSet = OpeningTable::handAt(handIdx);
+            // Lookups map other hands to their canonical forms
+            if (!OpeningTable::isCanonical(handSet)) {
+                continue;
+            }
+            uint8_t hand[OpeningTable::HAND_SIZE];
+            size_t pos = 0;
+            handSet.forEach([&](size_t code) { hand[pos++] = code; });
+
+            // The same deals are replayed for every candidate card
+            std::mt19937_64 rng(mixSeed(options.seed, handIdx));
+            for (auto& deal : deals) {
+                deal = makeDeal(hand, handSet, numPlayers, rng);
+            }
+
+            size_t bestIdx = 0;
+            size_t bestLosses = options.rounds + 1;
+            for (size_t cardIdx = 0; cardIdx < OpeningTable::HAND_SIZE; ++cardIdx) {
+                size_t losses = 0;
+                for (size_t round = 0; round < deals.size() && losses < bestLosses; ++round) {
+                    game.seed(mixSeed(options.seed, round));
+                    prober->force(cardIdx);
+                    auto result = game.playRound(0, deals[round]);
+                    losses += result.losingPlayerIdx && *result.losingPlayerIdx == 0;
+                }
+                if (losses < bestLosses) {
+                    bestLosses = losses;
+                    bestIdx = cardIdx;
+                }
+            }
+            table.setEntry(numPlayers, handIdx, hand[bestIdx]);
+        }
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    auto options = parseOptions(argc, argv);
+
+    log::setLogLevel(log::Level::Error);
+
+    auto table = OpeningTable::openWritable(options.output);
+
+    size_t minPlayers = options.numPlayers ? options.numPlayers : table.minPlayers();
+    size_t maxPlayers = options.numPlayers ? options.numPlayers : table.maxPlayers();
+    REQUIRE(minPlayers >= table.minPlayers() && maxPlayers <= table.maxPlayers(),
+            "Unsupported number of players: " << options.numPlayers);
+
+    for (size_t numPlayers = minPlayers; numPlayers <= maxPlayers; ++numPlayers) {
+        std::cout << "Building " << numPlayers << " players table for hands ["
+                  << options.begin << ", " << options.end << ")\n";
+        buildTable(table, numPlayers, options);
+        table.sync();
+    }
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
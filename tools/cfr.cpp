@@ -0,0 +1,170 @@
+#include "cfr/policy.h"
+#include "cfr/trainer.h"
+#include "exception.h"
+#include "logging/logging.h"
+#include "simulator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-cfr train <checkpoint> [--iterations N] [--threads T] [--memory-mb M]\n"
+                 "                        [--checkpoint-every K] [--explore D] [--max-skip S] [--seed S]\n"
+                 "       durak-cfr export <checkpoint> <policy> [--memory-mb M]\n"
+                 "       durak-cfr play <policy> [--rounds R] [--threads T] [--seed S]\n"
+                 "train runs MCCFR on the abstracted two player game until N iterations\n"
+                 "are done, resuming from the checkpoint if it exists and saving it every\n"
+                 "K iterations. export writes the average strategy as a policy file,\n"
+                 "play matches the policy against the min card strategy.\n";
+}
+
+bool exists(const std::string& path)
+{
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+int train(const std::string& path, int argc, char** argv)
+{
+    size_t numIterations = 1000000;
+    size_t memoryMb = 1024;
+    size_t checkpointEvery = 100000;
+    cfr::TrainerOptions options;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--iterations") numIterations = std::stoull(value());
+        else if (arg == "--threads") options.numThreads = std::stoull(value());
+        else if (arg == "--memory-mb") memoryMb = std::stoull(value());
+        else if (arg == "--checkpoint-every") checkpointEvery = std::stoull(value());
+        else if (arg == "--explore") options.exploreDepth = std::stoull(value());
+        else if (arg == "--max-skip") options.maxSkip = std::stoull(value());
+        else if (arg == "--seed") options.seed = std::stoull(value());
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    REQUIRE(checkpointEvery > 0, "Checkpoint interval must be positive");
+
+    cfr::RegretTable table(memoryMb << 20);
+    size_t done = 0;
+    if (exists(path)) {
+        done = table.load(path);
+        std::cout << "Resumed at iteration " << done << " with " << table.size() << " information sets\n";
+    }
+
+    cfr::Trainer trainer(table, options);
+    while (done < numIterations) {
+        size_t count = std::min(checkpointEvery, numIterations - done);
+        auto start = std::chrono::steady_clock::now();
+        trainer.run(done, count);
+        done += count;
+        table.save(path, done);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Iteration " << done << ": " << table.size() << " of " << table.capacity()
+                  << " information sets, dropped " << table.numDropped() << ", "
+                  << count / elapsed << " iterations/s\n";
+    }
+    std::cout << "Visited " << trainer.numNodes() << " decisions\n";
+    return EXIT_SUCCESS;
+}
+
+int exportPolicy(const std::string& checkpoint, const std::string& path, int argc, char** argv)
+{
+    size_t memoryMb = 1024;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--memory-mb") memoryMb = std::stoull(value());
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    cfr::RegretTable table(memoryMb << 20);
+    size_t done = table.load(checkpoint);
+    cfr::Policy::write(path, table);
+    auto policy = cfr::Policy::open(path);
+    std::cout << "Exported " << policy.numEntries() << " information sets after "
+              << done << " iterations\n";
+    return EXIT_SUCCESS;
+}
+
+int play(const std::string& path, int argc, char** argv)
+{
+    size_t numRounds = 100000;
+    size_t numThreads = defaultNumThreads();
+    uint64_t seed = 1;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--rounds") numRounds = std::stoull(value());
+        else if (arg == "--threads") numThreads = std::stoull(value());
+        else if (arg == "--seed") seed = std::stoull(value());
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    auto policy = std::make_shared<const cfr::Policy>(cfr::Policy::open(path));
+    Rules rules;
+    rules.maxBouts = cfr::MAX_BOUTS;
+    Simulator simulator([policy] {
+        Players players;
+        players.emplace_back("CFR", std::make_unique<CfrStrategy>(policy, std::make_unique<MinCardStrategy>()));
+        players.emplace_back("Min card", std::make_unique<MinCardStrategy>());
+        return players;
+    }, numThreads, rules);
+
+    auto result = simulator.run(seed, 0, numRounds);
+    for (size_t idx = 0; idx < result.losses.size(); ++idx) {
+        std::cout << (idx == 0 ? "CFR" : "Min card") << " lost " << result.losses[idx] << " of "
+                  << result.numRounds << " (" << 100.0 * result.losses[idx] / result.numRounds << "%)\n";
+    }
+    std::cout << "Draws: " << result.draws << "\n";
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 3 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 3 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    log::setLogLevel(log::Level::Warn);
+
+    std::string command = argv[1];
+    if (command == "train") {
+        return train(argv[2], argc - 3, argv + 3);
+    }
+    if (command == "export" && argc >= 4) {
+        return exportPolicy(argv[2], argv[3], argc - 4, argv + 4);
+    }
+    if (command == "play") {
+        return play(argv[2], argc - 3, argv + 3);
+    }
+    usage();
+    return EXIT_FAILURE;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,124 @@
+#include "deal_corpus.h"
+#include "exception.h"
+#include "logging/logging.h"
+#include "simulator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-deals write <file> [--deals N] [--seed S] [--deck 24|36|52]\n"
+                 "       durak-deals info <file>\n"
+                 "       durak-deals bench <file> [--rounds R] [--players P]\n"
+                 "write stores N shuffled decks to share between experiments, info prints\n"
+                 "the corpus header, bench compares rounds/s of shuffled and corpus deals.\n";
+}
+
+int write(const std::string& path, int argc, char** argv)
+{
+    size_t numDeals = 1000000;
+    uint64_t seed = 1;
+    size_t deckSize = 36;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--deals") numDeals = std::stoull(value());
+        else if (arg == "--seed") seed = std::stoull(value());
+        else if (arg == "--deck") deckSize = std::stoull(value());
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DealCorpus::write(path, deckSize, seed, numDeals);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << numDeals << " deals of " << deckSize << " cards in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+}
+
+int info(const std::string& path)
+{
+    auto corpus = DealCorpus::open(path);
+    std::cout << "Deals: " << corpus.numDeals() << ", deck: " << corpus.radix()
+              << " cards, seed: " << corpus.seed() << "\n";
+    return EXIT_SUCCESS;
+}
+
+int bench(const std::string& path, int argc, char** argv)
+{
+    size_t numRounds = 100000;
+    size_t numPlayers = 2;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--rounds") numRounds = std::stoull(value());
+        else if (arg == "--players") numPlayers = std::stoull(value());
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    auto corpus = std::make_shared<const DealCorpus>(DealCorpus::open(path));
+    Rules rules;
+    rules.maxBouts = 1000;
+    Simulator simulator([numPlayers] {
+        Players players;
+        for (size_t idx = 0; idx < numPlayers; ++idx) {
+            players.emplace_back("Player " + std::to_string(idx + 1), std::make_unique<MinCardStrategy>());
+        }
+        return players;
+    }, 1, rules);
+
+    for (bool fromCorpus : {false, true}) {
+        simulator.setDeals(fromCorpus ? corpus : nullptr);
+        auto start = std::chrono::steady_clock::now();
+        auto result = simulator.run(corpus->seed(), 0, numRounds);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << (fromCorpus ? "Corpus" : "Shuffled") << ": " << result.numRounds / elapsed
+                  << " rounds/s, draws: " << result.draws << "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 3 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 3 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    log::setLogLevel(log::Level::Warn);
+
+    std::string command = argv[1];
+    if (command == "write") {
+        return write(argv[2], argc - 3, argv + 3);
+    }
+    if (command == "info" && argc == 3) {
+        return info(argv[2]);
+    }
+    if (command == "bench") {
+        return bench(argv[2], argc - 3, argv + 3);
+    }
+    usage();
+    return EXIT_FAILURE;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,285 @@
+#include "exception.h"
+#include "protocol.h"
+#include "strategy/protocol_min_card.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string socketPath;
+    size_t numTables = 1000;
+    size_t concurrency = 100;
+    protocol::Join join;
+};
+
+void usage()
+{
+    std::cerr << "Usage: durak-loadgen <socket path> [--tables N] [--concurrency C] [--players P]\n"
+                 "                     [--rounds R] [--seed S] [--transfer]\n"
+                 "Plays N tables against durak-server keeping C of them open at once and\n"
+                 "reports throughput and latency of the server's moves.\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    options.join.numRounds = 10;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> unsigned long long {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (arg == "--tables") options.numTables = value();
+        else if (arg == "--concurrency") options.concurrency = value();
+        else if (arg == "--players") options.join.numPlayers = value();
+        else if (arg == "--rounds") options.join.numRounds = value();
+        else if (arg == "--seed") options.join.seed = value();
+        else if (arg == "--transfer") options.join.rules.transfer = true;
+        else if (options.socketPath.empty() && arg[0] != '-') options.socketPath = arg;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    REQUIRE(!options.socketPath.empty(), "Socket path is not specified");
+    REQUIRE(options.concurrency > 0, "Concurrency must be positive");
+    return options;
+}
+
+struct Client {
+    int fd = -1;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    std::optional<Clock::time_point> respondedAt;
+};
+
+class LoadGenerator {
+public:
+    explicit LoadGenerator(Options options)
+        : options_(std::move(options))
+        , epoll_(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        REQUIRE(epoll_ >= 0, "Cannot create epoll: " << std::strerror(errno));
+    }
+
+    ~LoadGenerator()
+    {
+        for (auto& [fd, client] : clients_) {
+            ::close(fd);
+        }
+        ::close(epoll_);
+    }
+
+    void run()
+    {
+        auto start = Clock::now();
+        epoll_event events[256];
+        while (numFinished_ < options_.numTables) {
+            while (numStarted_ < options_.numTables && clients_.size() < options_.concurrency) {
+                connect();
+            }
+
+            int numEvents = ::epoll_wait(epoll_, events, 256, 1000);
+            if (numEvents < 0) {
+                REQUIRE(errno == EINTR, "epoll_wait failed: " << std::strerror(errno));
+                continue;
+            }
+            for (int i = 0; i < numEvents; ++i) {
+                auto itr = clients_.find(events[i].data.fd);
+                if (itr != clients_.end()) {
+                    onReadable(*itr->second);
+                }
+            }
+        }
+        elapsed_ = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void report() const
+    {
+        auto latencies = latencies_;
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1,
+                                                                size_t(p * latencies.size()))];
+        };
+
+        std::cout << "Tables: " << numFinished_ << " (" << numErrors_ << " failed)"
+                  << ", rounds: " << numRounds_ << ", decisions: " << latencies.size()
+                  << " in " << elapsed_ << " s\n"
+                  << "Tables/s: " << numFinished_ / elapsed_
+                  << ", rounds/s: " << numRounds_ / elapsed_
+                  << ", decisions/s: " << latencies.size() / elapsed_ << "\n"
+                  << "Move latency, us: p50 " << percentile(0.5)
+                  << ", p99 " << percentile(0.99)
+                  << ", max " << (latencies.empty() ? 0.0 : latencies.back()) << "\n";
+    }
+
+private:
+    void connect()
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        REQUIRE(options_.socketPath.size() < sizeof(address.sun_path),
+                "Socket path is too long: " << options_.socketPath);
+        std::strcpy(address.sun_path, options_.socketPath.c_str());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        REQUIRE(fd >= 0, "Cannot create socket: " << std::strerror(errno));
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw Exception() << "Cannot connect to " << options_.socketPath << ": " << std::strerror(error);
+        }
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        REQUIRE(::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) == 0,
+                "Cannot poll a connection: " << std::strerror(errno));
+
+        auto join = options_.join;
+        join.seed += numStarted_++;
+        protocol::Writer writer(client->output);
+        protocol::writeJoin(writer, join);
+        send(*client);
+
+        clients_.emplace(fd, std::move(client));
+    }
+
+    // Messages are tiny, a blocking write is good enough for the client side
+    void send(Client& client)
+    {
+        size_t sent = 0;
+        while (sent < client.output.size()) {
+            ssize_t numWritten = ::send(client.fd, client.output.data() + sent,
+                                        client.output.size() - sent, MSG_NOSIGNAL);
+            REQUIRE(numWritten >= 0 || errno == EINTR, "Cannot send: " << std::strerror(errno));
+            sent += std::max<ssize_t>(numWritten, 0);
+        }
+        client.output.clear();
+    }
+
+    void onReadable(Client& client)
+    {
+        size_t size = client.input.size();
+        client.input.resize(size + 4096);
+        ssize_t numRead = ::read(client.fd, client.input.data() + size, 4096);
+        client.input.resize(size + std::max<ssize_t>(numRead, 0));
+        if (numRead <= 0) {
+            if (numRead < 0 && errno == EINTR) {
+                return;
+            }
+            ++numErrors_;
+            finish(client);
+            return;
+        }
+
+        size_t pos = 0;
+        while (size_t frameSize = protocol::frameSize(client.input.data() + pos, client.input.size() - pos)) {
+            const uint8_t* frame = client.input.data() + pos;
+            pos += frameSize;
+            if (!onFrame(client, protocol::frameType(frame), protocol::framePayload(frame, frameSize))) {
+                return;
+            }
+        }
+        client.input.erase(client.input.begin(), client.input.begin() + pos);
+    }
+
+    // Return false if the client is finished
+    bool onFrame(Client& client, protocol::MessageType type, protocol::Reader payload)
+    {
+        if (client.respondedAt) {
+            latencies_.push_back(std::chrono::duration<double, std::micro>(
+                Clock::now() - *client.respondedAt).count());
+            client.respondedAt.reset();
+        }
+
+        switch (type) {
+            case protocol::MessageType::Request: {
+                auto request = protocol::readRequest(payload);
+                protocol::Writer writer(client.output);
+                int cardIdx = minCardDecision(request);
+                protocol::writeResponse(writer, {request.id, static_cast<int8_t>(cardIdx)});
+                send(client);
+                client.respondedAt = Clock::now();
+                return true;
+            }
+            case protocol::MessageType::RoundOver:
+                ++numRounds_;
+                return true;
+            case protocol::MessageType::TableClosed:
+                finish(client);
+                return false;
+            case protocol::MessageType::Error:
+                std::cerr << "Server error: " << protocol::readError(payload) << "\n";
+                ++numErrors_;
+                finish(client);
+                return false;
+            default:
+                throw Exception() << "Unexpected message type " << static_cast<int>(type);
+        }
+    }
+
+    void finish(Client& client)
+    {
+        int fd = client.fd;
+        ::epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        clients_.erase(fd);
+        ++numFinished_;
+    }
+
+    Options options_;
+    int epoll_;
+    std::unordered_map<int, std::unique_ptr<Client>> clients_;
+
+    size_t numStarted_ = 0;
+    size_t numFinished_ = 0;
+    size_t numErrors_ = 0;
+    size_t numRounds_ = 0;
+    std::vector<double> latencies_;
+    double elapsed_ = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    LoadGenerator generator(parseOptions(argc, argv));
+    generator.run();
+    generator.report();
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "server.h"
+#include "simulator.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+Server* runningServer = nullptr;
+
+void onSignal(int)
+{
+    if (runningServer) {
+        runningServer->stop();
+    }
+}
+
+void usage()
+{
+    std::cerr << "Usage: durak-server <socket path> [--threads T] [--table-budget BYTES]\n"
+                 "                    [--max-tables N] [--max-bouts B]\n"
+                 "Hosts tables for clients of the binary protocol, each client plays\n"
+                 "against bots. Stops on SIGINT or SIGTERM.\n";
+}
+
+ServerOptions parseOptions(int argc, char** argv)
+{
+    ServerOptions options;
+    options.numThreads = defaultNumThreads();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> unsigned long long {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (arg == "--threads") options.numThreads = value();
+        else if (arg == "--table-budget") options.tableBudget = value();
+        else if (arg == "--max-tables") options.maxTablesPerThread = value();
+        else if (arg == "--max-bouts") options.maxBoutsPerRound = value();
+        else if (options.socketPath.empty() && arg[0] != '-') options.socketPath = arg;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    REQUIRE(!options.socketPath.empty(), "Socket path is not specified");
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    auto options = parseOptions(argc, argv);
+
+    log::setLogLevel(log::Level::Warn);
+
+    Server server(options);
+    runningServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Serving on " << options.socketPath << " with " << options.numThreads << " threads\n";
+    server.run();
+    runningServer = nullptr;
+
+    auto stats = server.stats();
+    std::cout << "Connections: " << stats.connections << ", tables: " << stats.tables
+              << ", rounds: " << stats.rounds << ", decisions: " << stats.decisions
+              << ", errors: " << stats.errors << "\n";
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,99 @@
+#include "cfr/policy.h"
+#include "exception.h"
+#include "exploit.h"
+#include "logging/logging.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-exploit [--strategy S] [--base S] [--rounds N] [--threads T] [--seed S]\n"
+                 "                     [--rollouts K] [--max-nodes M]\n"
+                 "Estimates how much a best response wins against the strategy in two player\n"
+                 "games: the base strategy with exact search once the deck is empty and, with\n"
+                 "K > 0, K determinized playouts per decision before that.\n"
+                 "Strategies: min-card, random, weighted[:w1,w2,...], cfr:<policy file>.\n";
+}
+
+StrategyFactory makeFactory(const std::string& name)
+{
+    if (name == "min-card") {
+        return [] { return std::make_unique<MinCardStrategy>(); };
+    }
+    if (name == "random") {
+        return [] { return std::make_unique<RandomStrategy>(); };
+    }
+    if (name == "weighted" || name.rfind("weighted:", 0) == 0) {
+        auto weights = name == "weighted" ? HeuristicWeights() : HeuristicWeights::parse(name.substr(9));
+        return [weights] { return std::make_unique<WeightedHeuristicStrategy>(weights); };
+    }
+    if (name.rfind("cfr:", 0) == 0) {
+        auto policy = std::make_shared<const cfr::Policy>(cfr::Policy::open(name.substr(4)));
+        return [policy] {
+            return std::make_unique<CfrStrategy>(policy, std::make_unique<MinCardStrategy>());
+        };
+    }
+    throw Exception() << "Unknown strategy: " << name;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    std::string strategy = "min-card";
+    std::string base = "min-card";
+    size_t numRounds = 10000;
+    uint64_t seed = 1;
+    ExploitabilityOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--strategy") strategy = value();
+        else if (arg == "--base") base = value();
+        else if (arg == "--rounds") numRounds = std::stoull(value());
+        else if (arg == "--threads") options.numThreads = std::stoull(value());
+        else if (arg == "--seed") seed = std::stoull(value());
+        else if (arg == "--rollouts") options.numRollouts = std::stoull(value());
+        else if (arg == "--max-nodes") options.maxEndgameNodes = std::stoull(value());
+        else if (arg == "--help") { usage(); return EXIT_SUCCESS; }
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    log::setLogLevel(log::Level::Warn);
+
+    Rules rules;
+    rules.maxBouts = 1000;
+    ExploitabilityEvaluator evaluator(makeFactory(strategy), makeFactory(base), options, rules);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = evaluator.run(seed, 0, numRounds);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 95% confidence intervals
+    std::cout << "Exploitability of " << strategy << " >= " << result.exploitability()
+              << " +- " << 1.96 * result.stdErr() << "\n"
+              << "Base " << base << " alone: " << result.baseValue() << " +- " << 1.96 * result.baseStdErr()
+              << ", gain of search: " << result.gain() << " +- " << 1.96 * result.gainStdErr() << "\n"
+              << "Endgames searched: " << result.numEndgames << ", over budget: " << result.numUnsolved
+              << ", positions: " << result.numNodes << "\n"
+              << result.numRounds << " rounds in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,305 @@
+#include "common/card_traits.h"
+#include "exception.h"
+#include "logging/deferred.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace miplot;
+namespace binary = log::binary;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-logdecode [--time] [--thread] [--sort] [--level LEVEL] <log>\n"
+                 "Renders a binary log written with durak --binary-log as text.\n"
+                 "Messages are in the order threads wrote them out, --sort orders them by time.\n"
+                 "  --time         prefix seconds since the log was opened\n"
+                 "  --thread       prefix the number of the writing thread\n"
+                 "  --level LEVEL  fatal, error, warn, info or debug, messages above it are skipped\n";
+}
+
+log::Level parseLevel(const std::string& name)
+{
+    static const char* names[] = {"fatal", "error", "warn", "info", "debug"};
+    for (size_t i = 0; i < std::size(names); ++i) {
+        if (name == names[i]) {
+            return static_cast<log::Level>(i);
+        }
+    }
+    throw Exception() << "Unknown log level: " << name;
+}
+
+struct Definition {
+    log::Level level;
+    std::string_view format;
+    std::string_view file;
+    uint32_t line;
+};
+
+struct Entry {
+    uint64_t ns;
+    std::string text;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size)
+        : data_(data)
+        , end_(data + size)
+    {}
+
+    bool done() const { return data_ == end_; }
+
+    template <typename T>
+    T get()
+    {
+        REQUIRE(end_ - data_ >= static_cast<ptrdiff_t>(sizeof(T)), "Binary log is truncated");
+        T value;
+        std::memcpy(&value, data_, sizeof(T));
+        data_ += sizeof(T);
+        return value;
+    }
+
+    std::string_view bytes(size_t size)
+    {
+        REQUIRE(end_ - data_ >= static_cast<ptrdiff_t>(size), "Binary log is truncated");
+        std::string_view result(reinterpret_cast<const char*>(data_), size);
+        data_ += size;
+        return result;
+    }
+
+    std::string_view string() { return bytes(get<uint16_t>()); }
+
+private:
+    const uint8_t* data_;
+    const uint8_t* end_;
+};
+
+template <typename Traits>
+void appendCard(std::string& out, uint8_t code)
+{
+    REQUIRE(code < Traits::radix(), "Invalid card code " << int(code));
+    out += cards::name(Traits::rankOf(code));
+    out += cards::name(Traits::suitOf(code));
+}
+
+void appendCard(std::string& out, uint8_t radix, uint8_t code)
+{
+    switch (radix) {
+        case cards::Std24CardTraits::radix(): return appendCard<cards::Std24CardTraits>(out, code);
+        case cards::Std36CardTraits::radix(): return appendCard<cards::Std36CardTraits>(out, code);
+        case cards::Std52CardTraits::radix(): return appendCard<cards::Std52CardTraits>(out, code);
+    }
+    throw Exception() << "Unknown deck of " << int(radix) << " cards";
+}
+
+// Renders an argument the way LOGF() formats it for a text logger
+void appendArg(std::string& out, Reader& reader)
+{
+    using binary::ArgType;
+    auto type = static_cast<ArgType>(reader.get<uint8_t>());
+    switch (type) {
+        case ArgType::Int:
+            out += std::to_string(reader.get<int64_t>());
+            return;
+        case ArgType::Uint:
+            out += std::to_string(reader.get<uint64_t>());
+            return;
+        case ArgType::Double: {
+            std::ostringstream os;
+            os << reader.get<double>();
+            out += os.str();
+            return;
+        }
+        case ArgType::String:
+            out += reader.string();
+            return;
+        case ArgType::Card: {
+            uint8_t radix = reader.get<uint8_t>();
+            appendCard(out, radix, reader.get<uint8_t>());
+            return;
+        }
+        case ArgType::Cards:
+        case ArgType::CardPairs: {
+            uint8_t radix = reader.get<uint8_t>();
+            uint8_t count = reader.get<uint8_t>();
+            for (uint8_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    out += ",";
+                }
+                if (type == ArgType::Cards) {
+                    appendCard(out, radix, reader.get<uint8_t>());
+                } else {
+                    out += "(";
+                    appendCard(out, radix, reader.get<uint8_t>());
+                    out += ",";
+                    appendCard(out, radix, reader.get<uint8_t>());
+                    out += ")";
+                }
+            }
+            return;
+        }
+    }
+    throw Exception() << "Unknown argument type " << int(type);
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    log::setLogLevel(log::Level::Warn);
+
+    bool printTime = false;
+    bool printThread = false;
+    bool sort = false;
+    log::Level maxLevel = log::Level::Debug;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        } else if (arg == "--time") {
+            printTime = true;
+        } else if (arg == "--thread") {
+            printThread = true;
+        } else if (arg == "--sort") {
+            sort = true;
+        } else if (arg == "--level") {
+            maxLevel = parseLevel(value());
+        } else if (arg.starts_with("--")) {
+            throw Exception() << "Unknown argument: " << arg;
+        } else {
+            REQUIRE(path.empty(), "Only one log is decoded at a time");
+            path = arg;
+        }
+    }
+    if (path.empty()) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    auto file = MappedFile::open(path);
+    Reader header(file.data(), file.size());
+    REQUIRE(header.bytes(sizeof(binary::MAGIC)) == std::string_view(binary::MAGIC, sizeof(binary::MAGIC)),
+            "Not a binary log: " << path);
+    uint32_t version = header.get<uint32_t>();
+    REQUIRE(version == binary::VERSION, "Unsupported binary log version: " << version);
+
+    // Chunks of a thread, a chunk torn by a crash is dropped
+    struct Chunk {
+        uint32_t thread;
+        Reader entries;
+    };
+    std::vector<Chunk> chunks;
+    while (!header.done()) {
+        try {
+            uint32_t thread = header.get<uint32_t>();
+            uint32_t size = header.get<uint32_t>();
+            auto bytes = header.bytes(size);
+            chunks.push_back({thread, Reader(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size())});
+        } catch (const Exception&) {
+            std::cerr << "Ignoring the torn end of " << path << "\n";
+            break;
+        }
+    }
+
+    // Definitions may follow messages of other threads, so they are read
+    // first. They are written in chunks of their own, readers are copied
+    std::unordered_map<uint32_t, Definition> definitions;
+    for (auto chunk : chunks) {
+        Reader& reader = chunk.entries;
+        while (!reader.done()) {
+            auto kind = reader.get<uint8_t>();
+            if (kind == binary::MESSAGE) {
+                break;
+            }
+            REQUIRE(kind == binary::DEFINE, "Invalid entry in " << path);
+            uint32_t id = reader.get<uint32_t>();
+            auto level = static_cast<log::Level>(reader.get<uint8_t>());
+            auto format = reader.string();
+            auto source = reader.string();
+            definitions[id] = {level, format, source, reader.get<uint32_t>()};
+        }
+    }
+
+    std::vector<Entry> entries;
+    std::string text;
+    for (auto& chunk : chunks) {
+        Reader& reader = chunk.entries;
+        while (!reader.done()) {
+            auto kind = reader.get<uint8_t>();
+            if (kind == binary::DEFINE) {
+                // Already read
+                reader.get<uint32_t>();
+                reader.get<uint8_t>();
+                reader.string();
+                reader.string();
+                reader.get<uint32_t>();
+                continue;
+            }
+            REQUIRE(kind == binary::MESSAGE, "Invalid entry in " << path);
+            uint32_t id = reader.get<uint32_t>();
+            auto ns = reader.get<uint64_t>();
+            auto numArgs = reader.get<uint8_t>();
+            auto itr = definitions.find(id);
+            REQUIRE(itr != definitions.end(), "Format " << id << " is not defined in " << path);
+            const auto& definition = itr->second;
+
+            text.clear();
+            std::string_view rest = definition.format;
+            for (uint8_t i = 0; i < numArgs; ++i) {
+                auto pos = rest.find("{}");
+                text += rest.substr(0, pos);
+                rest = pos == std::string_view::npos ? std::string_view() : rest.substr(pos + 2);
+                appendArg(text, reader);
+            }
+            text += rest;
+            if (definition.level > maxLevel) {
+                continue;
+            }
+
+            std::ostringstream line;
+            if (printTime) {
+                line << "[" << std::fixed << std::setprecision(6) << ns * 1e-9 << "] ";
+            }
+            if (printThread) {
+                line << "[" << chunk.thread << "] ";
+            }
+            line << "[" << definition.level << "] " << text << "\n";
+            entries.push_back({ns, line.str()});
+            if (!sort) {
+                std::cout << entries.back().text;
+                entries.clear();
+            }
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return lhs.ns < rhs.ns;
+    });
+    for (const auto& entry : entries) {
+        std::cout << entry.text;
+    }
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,169 @@
+#include "async_game.h"
+#include "exception.h"
+#include "logging/logging.h"
+#include "neural_strategy.h"
+#include "simulator.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-neural init <file> [--hidden N,N,...] [--int8] [--seed S]\n"
+                 "       durak-neural play <file> [--games N] [--rounds R] [--players P] [--max-batch B]\n"
+                 "init writes a policy network with random weights.\n"
+                 "play runs N concurrent games of R rounds each, the network takes seat 0\n"
+                 "in every game against MinCard strategies and evaluates decisions in batches.\n";
+}
+
+std::vector<size_t> parseSizes(const std::string& value)
+{
+    std::vector<size_t> sizes;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        sizes.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        REQUIRE(sizes.back() > 0, "Invalid layer size: " << item);
+    }
+    return sizes;
+}
+
+int init(const std::string& path, int argc, char** argv)
+{
+    std::vector<size_t> hidden = {128, 64};
+    nn::LayerType type = nn::LayerType::Float32;
+    uint64_t seed = 1;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--hidden") hidden = parseSizes(value());
+        else if (arg == "--int8") type = nn::LayerType::Int8;
+        else if (arg == "--seed") seed = std::strtoull(value().c_str(), nullptr, 10);
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    std::vector<nn::LayerSpec> layers;
+    size_t inSize = NUM_FEATURES;
+    for (size_t size : hidden) {
+        layers.push_back(nn::LayerSpec{inSize, size, type, nn::Activation::Relu});
+        inSize = size;
+    }
+    layers.push_back(nn::LayerSpec{inSize, NUM_ACTIONS, type, nn::Activation::None});
+    nn::Network::writeRandom(path, layers, seed);
+    return EXIT_SUCCESS;
+}
+
+async::Task<size_t> playGame(AsyncGame& game, size_t numRounds, SimulationResult& result)
+{
+    for (size_t round = 0; round < numRounds; ++round) {
+        auto roundResult = co_await game.playRound(round % game.numPlayers());
+        ++result.numRounds;
+        if (roundResult.losingPlayerIdx) {
+            ++result.losses[*roundResult.losingPlayerIdx];
+        } else {
+            ++result.draws;
+        }
+    }
+    co_return numRounds;
+}
+
+int play(const std::string& path, int argc, char** argv)
+{
+    size_t numGames = 1000;
+    size_t numRounds = 10;
+    size_t numPlayers = 2;
+    size_t maxBatchSize = 1024;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> unsigned long long {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (arg == "--games") numGames = value();
+        else if (arg == "--rounds") numRounds = value();
+        else if (arg == "--players") numPlayers = value();
+        else if (arg == "--max-batch") maxBatchSize = value();
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    auto network = std::make_shared<const nn::Network>(nn::Network::load(path));
+    auto batcher = std::make_shared<InferenceBatcher>(network, maxBatchSize);
+
+    Rules rules;
+    // Keep deterministic strategies from passing cards around forever
+    rules.maxBouts = 1000;
+
+    async::Scheduler scheduler;
+    std::vector<std::unique_ptr<AsyncGame>> games;
+    SimulationResult result;
+    result.losses.assign(numPlayers, 0);
+    for (size_t gameIdx = 0; gameIdx < numGames; ++gameIdx) {
+        Players players;
+        players.emplace_back("Neural", std::make_unique<NeuralStrategy>(batcher));
+        for (size_t idx = 1; idx < numPlayers; ++idx) {
+            players.emplace_back("Player " + std::to_string(idx + 1), std::make_unique<MinCardStrategy>());
+        }
+        games.push_back(std::make_unique<AsyncGame>(std::move(players), scheduler, rules));
+        games.back()->seed(mixSeed(1, gameIdx));
+        scheduler.spawn(playGame(*games.back(), numRounds, result), [](size_t) {});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (scheduler.numActive() > 0) {
+        scheduler.run();
+        batcher->evaluate();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto& stats = batcher->stats();
+    size_t evaluated = stats.decisions - stats.forced;
+    std::cout << "Network lost " << result.losses[0] * 100.0 / result.numRounds << " % of "
+              << result.numRounds << " rounds, draws: " << result.draws << "\n"
+              << "Decisions: " << stats.decisions << ", forced: " << stats.forced
+              << ", batches: " << stats.batches
+              << " (" << (stats.batches ? double(evaluated) / stats.batches : 0.0) << " per batch)\n"
+              << "Decisions/s: " << stats.decisions / elapsed << " in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 3 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 3 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    log::setLogLevel(log::Level::Warn);
+
+    std::string command = argv[1];
+    if (command == "init") {
+        return init(argv[2], argc - 3, argv + 3);
+    }
+    if (command == "play") {
+        return play(argv[2], argc - 3, argv + 3);
+    }
+    usage();
+    return EXIT_FAILURE;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
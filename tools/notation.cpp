@@ -0,0 +1,196 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "notation.h"
+#include "strategy.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-notation play [options] [--rounds N] [--seed S]\n"
+                 "       durak-notation check [options] [--moves K] [--positions] <rounds>\n"
+                 "Options: [--deck 24|36|52] [--players P] [--transfer] [--teams T]\n"
+                 "play writes rounds of random and minimal card players in notation, one per line.\n"
+                 "check replays every round of a file, - for stdin, against the rules;\n"
+                 "--positions prints the position after K moves of each round, or at its end,\n"
+                 "and checks that it loads back into the same game.\n";
+}
+
+struct Options {
+    bool play = false;
+    size_t deckSize = 36;
+    size_t numPlayers = 2;
+    Rules rules;
+    size_t numRounds = 1000;
+    uint64_t seed = 1;
+    size_t numMoves = SIZE_MAX;
+    bool positions = false;
+    std::string path;
+};
+
+template <typename CardTraits>
+BasicPlayers<CardTraits> makePlayers(size_t numPlayers)
+{
+    BasicPlayers<CardTraits> players;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        auto name = "Player " + std::to_string(idx + 1);
+        if (idx % 2 == 0) {
+            players.emplace_back(name, std::make_unique<BasicRandomStrategy<CardTraits>>());
+        } else {
+            players.emplace_back(name, std::make_unique<BasicMinCardStrategy<CardTraits>>());
+        }
+    }
+    return players;
+}
+
+void report(const char* what, size_t numRounds, std::chrono::steady_clock::time_point start)
+{
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << what << " " << numRounds << " rounds in " << elapsed << " s ("
+              << (elapsed > 0 ? numRounds / elapsed : 0.0) << " rounds/s)\n";
+}
+
+template <typename CardTraits>
+void play(const Options& options)
+{
+    notation::BasicNotatedGame<CardTraits> game(makePlayers<CardTraits>(options.numPlayers), options.rules);
+    game.seed(options.seed);
+
+    auto start = std::chrono::steady_clock::now();
+    std::string out;
+    for (size_t round = 0; round < options.numRounds; ++round) {
+        game.playRound(round % options.numPlayers, out);
+        out += '\n';
+        if (out.size() >= (1 << 16)) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    }
+    std::fwrite(out.data(), 1, out.size(), stdout);
+    std::fflush(stdout);
+    report("Played", options.numRounds, start);
+}
+
+template <typename CardTraits>
+void check(const Options& options)
+{
+    notation::BasicNotatedGame<CardTraits> game(makePlayers<CardTraits>(options.numPlayers), options.rules);
+    notation::BasicNotatedGame<CardTraits> loaded(makePlayers<CardTraits>(options.numPlayers), options.rules);
+
+    std::ifstream file;
+    if (options.path != "-") {
+        file.open(options.path);
+        REQUIRE(file, "Cannot open " << options.path);
+    }
+    std::istream& in = options.path == "-" ? std::cin : file;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string line;
+    BasicPosition<CardTraits> parsed;
+    std::string position;
+    std::string reloaded;
+    size_t numRounds = 0;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        ++numRounds;
+        try {
+            if (!options.positions) {
+                game.replay(line);
+                continue;
+            }
+            game.seek(line, options.numMoves);
+            position.clear();
+            notation::appendPosition(position, game.position());
+            notation::parsePosition(position, parsed);
+            loaded.setPosition(parsed);
+            reloaded.clear();
+            notation::appendPosition(reloaded, loaded.position());
+            REQUIRE(reloaded == position, "Position loads back as " << reloaded);
+            std::cout << position << "\n";
+        } catch (const Exception& e) {
+            throw Exception() << "Round " << numRounds << ": " << e.what();
+        }
+    }
+    report("Replayed", numRounds, start);
+}
+
+template <typename CardTraits>
+void run(const Options& options)
+{
+    options.play ? play<CardTraits>(options) : check<CardTraits>(options);
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    log::setLogLevel(log::Level::Warn);
+
+    if (argc < 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    Options options;
+    std::string command = argv[1];
+    if (command == "--help") {
+        usage();
+        return EXIT_SUCCESS;
+    }
+    REQUIRE(command == "play" || command == "check", "Unknown command: " << command);
+    options.play = command == "play";
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--deck") {
+            options.deckSize = std::stoul(value());
+        } else if (arg == "--players") {
+            options.numPlayers = std::stoul(value());
+        } else if (arg == "--transfer") {
+            options.rules.transfer = true;
+        } else if (arg == "--teams") {
+            options.rules.numTeams = std::stoul(value());
+        } else if (arg == "--rounds") {
+            options.numRounds = std::stoul(value());
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(value());
+        } else if (arg == "--moves") {
+            options.numMoves = std::stoul(value());
+        } else if (arg == "--positions") {
+            options.positions = true;
+        } else if (arg.starts_with("--")) {
+            throw Exception() << "Unknown argument: " << arg;
+        } else {
+            options.path = arg;
+        }
+    }
+    REQUIRE(options.play || !options.path.empty(), "No rounds to check");
+
+    switch (options.deckSize) {
+        case 24: run<cards::Std24CardTraits>(options); break;
+        case 36: run<cards::Std36CardTraits>(options); break;
+        case 52: run<cards::Std52CardTraits>(options); break;
+        default: throw Exception() << "Unsupported deck size: " << options.deckSize;
+    }
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
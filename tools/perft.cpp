@@ -0,0 +1,130 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "notation.h"
+#include "perft.h"
+#include "strategy.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-perft [--seed S | --snapshot F | --position P] [--depth N] [--players P] [--transfer]\n"
+                 "                   [--deck 24|36|52] [--teams T] [--threads T] [--divide] [--validate] [--save F]\n"
+                 "Counts all legal decision sequences of a round to depth N from\n"
+                 "the first decision of the round dealt from seed S, or from a game snapshot\n"
+                 "or a position in notation.\n"
+                 "--divide counts every root move, --validate checks every node against Game's\n"
+                 "rules and the built-in strategies, --save writes the root snapshot.\n";
+}
+
+template <typename CardTraits>
+std::string positionSnapshot(const std::string& position, size_t numPlayers, const Rules& rules)
+{
+    BasicPlayers<CardTraits> players;
+    for (size_t idx = 0; idx < numPlayers; ++idx) {
+        players.emplace_back("Player " + std::to_string(idx + 1),
+                             std::make_unique<BasicMinCardStrategy<CardTraits>>());
+    }
+    BasicGame<CardTraits> game(std::move(players), rules);
+    game.setPosition(notation::parsePosition<CardTraits>(position));
+    return game.snapshot();
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    log::setLogLevel(log::Level::Warn);
+
+    uint64_t seed = 1;
+    std::string snapshotPath;
+    std::string position;
+    std::string savePath;
+    size_t numPlayers = 2;
+    Rules rules;
+    PerftOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--seed") seed = std::stoull(value());
+        else if (arg == "--snapshot") snapshotPath = value();
+        else if (arg == "--position") position = value();
+        else if (arg == "--save") savePath = value();
+        else if (arg == "--depth") options.depth = std::stoul(value());
+        else if (arg == "--players") numPlayers = std::stoul(value());
+        else if (arg == "--transfer") rules.transfer = true;
+        else if (arg == "--deck") options.deckSize = std::stoul(value());
+        else if (arg == "--teams") rules.numTeams = std::stoul(value());
+        else if (arg == "--threads") options.numThreads = std::stoul(value());
+        else if (arg == "--divide") options.divide = true;
+        else if (arg == "--validate") options.validate = true;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+
+    Perft perft(numPlayers, rules, options);
+    std::string snapshot;
+    if (!position.empty()) {
+        // The root snapshot of a game with the position
+        switch (options.deckSize) {
+            case 24: snapshot = positionSnapshot<cards::Std24CardTraits>(position, numPlayers, rules); break;
+            case 52: snapshot = positionSnapshot<cards::Std52CardTraits>(position, numPlayers, rules); break;
+            default: snapshot = positionSnapshot<cards::Std36CardTraits>(position, numPlayers, rules); break;
+        }
+    } else if (!snapshotPath.empty()) {
+        std::ifstream in(snapshotPath, std::ios::binary);
+        REQUIRE(in, "Cannot open " << snapshotPath);
+        snapshot.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    } else {
+        snapshot = perft.deal(seed);
+    }
+    if (!savePath.empty()) {
+        std::ofstream out(savePath, std::ios::binary);
+        REQUIRE(out.write(snapshot.data(), snapshot.size()), "Cannot write " << savePath);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = perft.run(snapshot);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const auto& [move, count] : result.divide) {
+        std::cout << move << ": " << count << "\n";
+    }
+    for (size_t ply = 0; ply < result.nodes.size(); ++ply) {
+        std::cout << "Ply " << ply << ": " << result.nodes[ply] << "\n";
+    }
+    std::cout << "Rounds over before depth " << options.depth << ": " << result.finished << "\n"
+              << "Nodes: " << result.numNodes() << " in " << elapsed << " s ("
+              << (elapsed > 0 ? result.numNodes() / elapsed : 0.0) << " nodes/s)\n";
+    if (options.validate) {
+        std::cout << "Mismatches: " << result.numMismatches << "\n";
+        for (const auto& mismatch : result.mismatches) {
+            std::cout << "  " << mismatch << "\n";
+        }
+    }
+    return result.numMismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
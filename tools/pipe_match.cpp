@@ -0,0 +1,130 @@
+#include "async_game.h"
+#include "exception.h"
+#include "logging/logging.h"
+#include "pipe_strategy.h"
+#include "simulator.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+struct Options {
+    std::string command;
+    size_t numGames = 100;
+    size_t numRounds = 10;
+    size_t numPlayers = 2;
+    size_t timeoutMs = 1000;
+    uint64_t seed = 1;
+    Rules rules;
+};
+
+void usage()
+{
+    std::cerr << "Usage: durak-pipe-match <bot command> [--games N] [--rounds R] [--players P]\n"
+                 "                        [--timeout MS] [--seed S] [--transfer]\n"
+                 "Plays N concurrent games of R rounds each, the bot process takes seat 0\n"
+                 "in every game against MinCard strategies.\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> unsigned long long {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+        if (arg == "--games") options.numGames = value();
+        else if (arg == "--rounds") options.numRounds = value();
+        else if (arg == "--players") options.numPlayers = value();
+        else if (arg == "--timeout") options.timeoutMs = value();
+        else if (arg == "--seed") options.seed = value();
+        else if (arg == "--transfer") options.rules.transfer = true;
+        else if (options.command.empty() && arg[0] != '-') options.command = arg;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    REQUIRE(!options.command.empty(), "Bot command is not specified");
+    // Keep deterministic strategies from passing cards around forever
+    options.rules.maxBouts = 1000;
+    return options;
+}
+
+async::Task<size_t> playGame(AsyncGame& game, size_t numRounds, SimulationResult& result)
+{
+    for (size_t round = 0; round < numRounds; ++round) {
+        auto roundResult = co_await game.playRound(round % game.numPlayers());
+        ++result.numRounds;
+        if (roundResult.losingPlayerIdx) {
+            ++result.losses[*roundResult.losingPlayerIdx];
+        } else {
+            ++result.draws;
+        }
+    }
+    co_return numRounds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 2 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    auto options = parseOptions(argc, argv);
+
+    log::setLogLevel(log::Level::Warn);
+
+    auto bot = std::make_shared<BotProcess>(options.command, std::chrono::milliseconds(options.timeoutMs));
+    async::Scheduler scheduler;
+
+    std::vector<std::unique_ptr<AsyncGame>> games;
+    SimulationResult result;
+    result.losses.assign(options.numPlayers, 0);
+    for (size_t gameIdx = 0; gameIdx < options.numGames; ++gameIdx) {
+        Players players;
+        players.emplace_back("Bot", std::make_unique<PipeStrategy>(bot));
+        for (size_t idx = 1; idx < options.numPlayers; ++idx) {
+            players.emplace_back("Player " + std::to_string(idx + 1), std::make_unique<MinCardStrategy>());
+        }
+        games.push_back(std::make_unique<AsyncGame>(std::move(players), scheduler, options.rules));
+        games.back()->seed(mixSeed(options.seed, gameIdx));
+        scheduler.spawn(playGame(*games.back(), options.numRounds, result), [](size_t) {});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (scheduler.numActive() > 0) {
+        scheduler.run();
+        bot->flush();
+        bot->poll(scheduler.hasReady() ? 0 : static_cast<int>(options.timeoutMs));
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Bot lost " << result.losses[0] * 100.0 / result.numRounds << " % of "
+              << result.numRounds << " rounds, draws: " << result.draws << "\n";
+
+    const auto& stats = bot->stats();
+    std::cout << "Requests: " << stats.requests << ", batches: " << stats.batches
+              << " (" << (stats.batches ? double(stats.requests) / stats.batches : 0.0) << " per batch)"
+              << ", timeouts: " << stats.timeouts << ", invalid: " << stats.invalid
+              << ", crashed: " << (stats.crashed ? "yes" : "no") << "\n"
+              << "Decisions/s: " << stats.requests / elapsed << " in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,79 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "rating.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace miplot;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-rate [--glicko] [--k K] [--min-deviation D] <results>...\n"
+                 "Rates the entrants of result streams written by durak --results,\n"
+                 "streams are applied in the order given, like shards of one run.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    log::setLogLevel(log::Level::Warn);
+
+    RatingMethod method = RatingMethod::Elo;
+    double k = 16;
+    double minDeviation = 30;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        } else if (arg == "--glicko") {
+            method = RatingMethod::Glicko;
+        } else if (arg == "--k") {
+            k = std::stod(value());
+        } else if (arg == "--min-deviation") {
+            minDeviation = std::stod(value());
+        } else if (arg.starts_with("--")) {
+            throw Exception() << "Unknown argument: " << arg;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        usage();
+        return EXIT_FAILURE;
+    }
+
+    RatingTable ratings(method, k, minDeviation);
+    size_t numResults = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& path : paths) {
+        auto stream = ResultStream::open(path);
+        ratings.update(stream);
+        numResults += stream.numRecords();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ratings.print(std::cout);
+    std::cout << "Rated " << numResults << " results in " << elapsed << " s ("
+              << (elapsed > 0 ? numResults / elapsed : 0.0) << " results/s)\n";
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,113 @@
+#include "exception.h"
+#include "protocol.h"
+#include "strategy/protocol_min_card.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+struct Options {
+    // Simulated thinking time per batch of requests
+    std::chrono::microseconds delay{0};
+};
+
+void usage()
+{
+    std::cerr << "Usage: durak-refbot [--delay-us D]\n"
+                 "Reference bot for PipeStrategy: reads requests from stdin and answers\n"
+                 "with the lowest allowed card on stdout. All requests read at once are\n"
+                 "answered with a single write.\n";
+}
+
+Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--delay-us" && i + 1 < argc) {
+            options.delay = std::chrono::microseconds(std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            throw Exception() << "Unknown argument: " << arg;
+        }
+    }
+    return options;
+}
+
+void writeAll(const std::vector<uint8_t>& output)
+{
+    size_t written = 0;
+    while (written < output.size()) {
+        ssize_t numWritten = ::write(STDOUT_FILENO, output.data() + written, output.size() - written);
+        REQUIRE(numWritten >= 0 || errno == EINTR, "Cannot write: " << std::strerror(errno));
+        written += std::max<ssize_t>(numWritten, 0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc > 1 && std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return EXIT_SUCCESS;
+    }
+    auto options = parseOptions(argc, argv);
+
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    constexpr size_t READ_CHUNK = 64 * 1024;
+
+    while (true) {
+        size_t size = input.size();
+        input.resize(size + READ_CHUNK);
+        ssize_t numRead = ::read(STDIN_FILENO, input.data() + size, READ_CHUNK);
+        input.resize(size + std::max<ssize_t>(numRead, 0));
+        if (numRead == 0) {
+            break;
+        }
+        if (numRead < 0) {
+            REQUIRE(errno == EINTR, "Cannot read: " << std::strerror(errno));
+            continue;
+        }
+
+        size_t pos = 0;
+        while (size_t frameSize = protocol::frameSize(input.data() + pos, input.size() - pos)) {
+            const uint8_t* frame = input.data() + pos;
+            pos += frameSize;
+            REQUIRE(protocol::frameType(frame) == protocol::MessageType::Request,
+                    "Unexpected message type " << static_cast<int>(protocol::frameType(frame)));
+            auto payload = protocol::framePayload(frame, frameSize);
+            auto request = protocol::readRequest(payload);
+
+            protocol::Writer writer(output);
+            int cardIdx = minCardDecision(request);
+            protocol::writeResponse(writer, {request.id, static_cast<int8_t>(cardIdx)});
+        }
+        input.erase(input.begin(), input.begin() + pos);
+
+        if (!output.empty()) {
+            std::this_thread::sleep_for(options.delay);
+            writeAll(output);
+            output.clear();
+        }
+    }
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
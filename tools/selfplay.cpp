@@ -0,0 +1,135 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "samples.h"
+#include "selfplay.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-selfplay write <file> [--rounds N] [--players P] [--threads T]\n"
+                 "                      [--seed S] [--strategy random|min-card|mixed] [--transfer]\n"
+                 "       durak-selfplay info <file>\n"
+                 "write plays N rounds and stores every decision with its features, action\n"
+                 "and the final outcome of the round. info prints a summary of a sample file.\n";
+}
+
+std::unique_ptr<Strategy> makeStrategy(const std::string& name, size_t seat)
+{
+    if (name == "random" || (name == "mixed" && seat % 2 == 0)) {
+        return std::make_unique<RandomStrategy>();
+    }
+    if (name == "min-card" || name == "mixed") {
+        return std::make_unique<MinCardStrategy>();
+    }
+    throw Exception() << "Unknown strategy: " << name;
+}
+
+int write(const std::string& path, int argc, char** argv)
+{
+    size_t numRounds = 100000;
+    size_t numPlayers = 2;
+    size_t numThreads = defaultNumThreads();
+    uint64_t seed = 1;
+    std::string strategy = "mixed";
+    Rules rules;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--rounds") numRounds = std::stoull(value());
+        else if (arg == "--players") numPlayers = std::stoull(value());
+        else if (arg == "--threads") numThreads = std::stoull(value());
+        else if (arg == "--seed") seed = std::stoull(value());
+        else if (arg == "--strategy") strategy = value();
+        else if (arg == "--transfer") rules.transfer = true;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    makeStrategy(strategy, 0);
+    // Keep deterministic strategies from passing cards around forever
+    rules.maxBouts = 1000;
+
+    SampleWriter writer(path);
+    SelfPlay selfPlay(numPlayers, [&](size_t seat) { return makeStrategy(strategy, seat); },
+                      writer, numThreads, rules);
+
+    auto start = std::chrono::steady_clock::now();
+    auto result = selfPlay.run(seed, 0, numRounds);
+    writer.close();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Rounds: " << result.numRounds << ", draws: " << result.draws << "\n"
+              << "Samples: " << writer.numRows() << ", " << writer.numBytes() << " bytes ("
+              << double(writer.numBytes()) / std::max<size_t>(1, writer.numRows()) << " per sample)\n"
+              << "Samples/s: " << writer.numRows() / elapsed << " in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+}
+
+int info(const std::string& path)
+{
+    SampleReader reader(path);
+
+    size_t rawRowSize = 0;
+    for (size_t idx = 0; idx < NUM_SAMPLE_COLUMNS; ++idx) {
+        rawRowSize += columnWidth(static_cast<SampleColumn>(idx));
+    }
+
+    SampleChunk chunk;
+    size_t numBytes = 0;
+    size_t outcomes[3] = {};
+    size_t numPasses = 0;
+    for (size_t chunkIdx = 0; chunkIdx < reader.numChunks(); ++chunkIdx) {
+        reader.read(chunkIdx, chunk);
+        numBytes += reader.chunkBytes(chunkIdx);
+        for (size_t row = 0; row < chunk.numRows(); ++row) {
+            ++outcomes[chunk.outcome(row) + 1];
+            numPasses += chunk.action(row) == PASS_ACTION;
+        }
+    }
+
+    std::cout << "Chunks: " << reader.numChunks() << ", samples: " << reader.numRows() << "\n"
+              << "Compressed: " << numBytes << " bytes, raw: " << reader.numRows() * rawRowSize
+              << " bytes (" << double(reader.numRows() * rawRowSize) / std::max<size_t>(1, numBytes) << "x)\n"
+              << "Outcomes: won " << outcomes[2] << ", lost " << outcomes[0] << ", draw " << outcomes[1] << "\n"
+              << "Passes: " << numPasses << "\n";
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    if (argc < 3 || std::strcmp(argv[1], "--help") == 0) {
+        usage();
+        return argc < 3 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    log::setLogLevel(log::Level::Warn);
+
+    std::string command = argv[1];
+    if (command == "write") {
+        return write(argv[2], argc - 3, argv + 3);
+    }
+    if (command == "info" && argc == 3) {
+        return info(argv[2]);
+    }
+    usage();
+    return EXIT_FAILURE;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,104 @@
+#include "exception.h"
+#include "logging/logging.h"
+#include "tuner.h"
+#include "utils.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace miplot;
+using namespace miplot::cardgame::durak;
+
+namespace {
+
+void usage()
+{
+    std::cerr << "Usage: durak-tune [--iterations N] [--pairs P] [--rounds R] [--players P]\n"
+                 "                  [--threads T] [--seed S] [--a A] [--c C]\n"
+                 "                  [--start w1,w2,...] [--opponent min-card|random] [--transfer]\n"
+                 "Tunes WeightedHeuristicStrategy weights with SPSA against the opponent,\n"
+                 "R rounds per candidate, then compares the start and tuned weights on fresh deals.\n"
+                 "Weights: trumpValue, leadPairBonus, pileOnLimit, resignLimit, transferLimit,\n"
+                 "endgameAggression.\n";
+}
+
+std::unique_ptr<Strategy> makeOpponent(const std::string& name)
+{
+    if (name == "min-card") {
+        return std::make_unique<MinCardStrategy>();
+    }
+    if (name == "random") {
+        return std::make_unique<RandomStrategy>();
+    }
+    throw Exception() << "Unknown opponent: " << name;
+}
+
+} // namespace
+
+int main(int argc, char** argv) try
+{
+    SpsaOptions options;
+    size_t numPlayers = 2;
+    size_t numThreads = defaultNumThreads();
+    std::string opponent = "min-card";
+    HeuristicWeights start;
+    Rules rules;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            REQUIRE(i + 1 < argc, "Missing value for " << arg);
+            return argv[++i];
+        };
+        if (arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        }
+        else if (arg == "--iterations") options.numIterations = std::stoull(value());
+        else if (arg == "--pairs") options.numPairs = std::stoull(value());
+        else if (arg == "--rounds") options.roundsPerCandidate = std::stoull(value());
+        else if (arg == "--players") numPlayers = std::stoull(value());
+        else if (arg == "--threads") numThreads = std::stoull(value());
+        else if (arg == "--seed") options.seed = std::stoull(value());
+        else if (arg == "--a") options.a = std::stod(value());
+        else if (arg == "--c") options.c = std::stod(value());
+        else if (arg == "--start") start = HeuristicWeights::parse(value());
+        else if (arg == "--opponent") opponent = value();
+        else if (arg == "--transfer") rules.transfer = true;
+        else throw Exception() << "Unknown argument: " << arg;
+    }
+    makeOpponent(opponent);
+    // Keep deterministic strategies from passing cards around forever
+    rules.maxBouts = 1000;
+
+    log::setLogLevel(log::Level::Warn);
+
+    HeuristicEvaluator evaluator(numPlayers, [&](size_t) { return makeOpponent(opponent); },
+                                 numThreads, rules);
+    SpsaTuner tuner(evaluator, options);
+
+    auto begin = std::chrono::steady_clock::now();
+    auto tuned = tuner.run(start, [](size_t iteration, const HeuristicWeights& weights, double loss) {
+        std::cout << "Iteration " << iteration + 1 << ": loss " << loss * 100 << " %, weights "
+                  << weights.toString() << std::endl;
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // Deals not seen while tuning
+    size_t numCheckRounds = options.roundsPerCandidate * options.numPairs * 2;
+    auto losses = evaluator.evaluate({start, tuned}, mixSeed(options.seed, options.numIterations),
+                                     numCheckRounds);
+    std::cout << "Start: " << start.toString() << ", loss " << losses[0] * 100 << " %\n"
+              << "Tuned: " << tuned.toString() << ", loss " << losses[1] * 100 << " %\n"
+              << "Checked on " << numCheckRounds << " rounds, tuned in " << elapsed << " s\n";
+    return EXIT_SUCCESS;
+} catch (const Exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+} catch (std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+#include "tuner.h"
+#include "exception.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace miplot::cardgame::durak {
+
+HeuristicEvaluator::HeuristicEvaluator(size_t numPlayers, OpponentFactory opponents,
+                                       size_t numThreads, Rules rules)
+    : numPlayers_(numPlayers)
+    , opponents_(std::move(opponents))
+    , numThreads_(numThreads)
+    , rules_(rules)
+{
+    REQUIRE(numPlayers_ >= 2, "At least 2 players are required");
+}
+
+std::vector<double> HeuristicEvaluator::evaluate(const std::vector<HeuristicWeights>& candidates,
+                                                 uint64_t seed, size_t numRounds) const
+{
+    size_t numThreads = std::max<size_t>(1, numThreads_);
+    // Half-losses per thread and candidate, so that draws stay integral
+    std::vector<std::vector<size_t>> halfLosses(numThreads, std::vector<size_t>(candidates.size(), 0));
+
+    parallelFor(numRounds, numThreads, [&](size_t threadIdx, size_t begin, size_t end) {
+        std::vector<std::unique_ptr<Game>> games;
+        for (const auto& weights : candidates) {
+            Players players;
+            players.emplace_back("Candidate", std::make_unique<WeightedHeuristicStrategy>(weights));
+            for (size_t seat = 1; seat < numPlayers_; ++seat) {
+                players.emplace_back("Player " + std::to_string(seat + 1), opponents_(seat));
+            }
+            games.push_back(std::make_unique<Game>(std::move(players), rules_));
+        }
+
+        // Candidates are compared on common deals: every round is dealt from
+        // an order shuffled from the same initial one, whatever order the
+        // games' own decks were left in. Creating a deck seeds it from
+        // std::random_device, reuse one
+        auto deck = Game::Deck::create();
+        const auto initial = deck.order();
+        auto& counts = halfLosses[threadIdx];
+        for (size_t round = begin; round < end; ++round) {
+            deck.arrange(initial);
+            deck.seed(mixSeed(seed, round));
+            deck.shuffle();
+            const auto order = deck.order();
+            for (size_t idx = 0; idx < games.size(); ++idx) {
+                games[idx]->seed(mixSeed(seed, round));
+                auto result = games[idx]->playRound(round % numPlayers_, order);
+                if (!result.losingPlayerIdx) {
+                    counts[idx] += 1;
+                } else if (*result.losingPlayerIdx == 0) {
+                    counts[idx] += 2;
+                }
+            }
+        }
+    });
+
+    std::vector<double> losses(candidates.size(), 0.0);
+    for (size_t idx = 0; idx < candidates.size(); ++idx) {
+        size_t total = 0;
+        for (const auto& counts : halfLosses) {
+            total += counts[idx];
+        }
+        losses[idx] = numRounds ? total / (2.0 * numRounds) : 0.0;
+    }
+    return losses;
+}
+
+SpsaTuner::SpsaTuner(const HeuristicEvaluator& evaluator, SpsaOptions options)
+    : evaluator_(evaluator)
+    , options_(options)
+{
+    REQUIRE(options_.numPairs > 0, "At least one perturbation per iteration is required");
+}
+
+HeuristicWeights SpsaTuner::run(const HeuristicWeights& start, const IterationCallback& onIteration) const
+{
+    auto theta = start.toVector();
+    std::mt19937_64 random(options_.seed);
+
+    for (size_t k = 0; k < options_.numIterations; ++k) {
+        double ak = options_.a / std::pow(k + 1 + options_.stability, options_.alpha);
+        double ck = options_.c / std::pow(k + 1, options_.gamma);
+
+        std::vector<std::vector<double>> deltas(options_.numPairs, std::vector<double>(theta.size()));
+        std::vector<HeuristicWeights> candidates;
+        for (auto& delta : deltas) {
+            auto plus = theta;
+            auto minus = theta;
+            for (size_t i = 0; i < theta.size(); ++i) {
+                delta[i] = (random() & 1) ? 1.0 : -1.0;
+                plus[i] += ck * delta[i];
+                minus[i] -= ck * delta[i];
+            }
+            candidates.push_back(HeuristicWeights::fromVector(plus));
+            candidates.push_back(HeuristicWeights::fromVector(minus));
+        }
+
+        auto losses = evaluator_.evaluate(candidates, mixSeed(options_.seed, k), options_.roundsPerCandidate);
+
+        std::vector<double> gradient(theta.size(), 0.0);
+        double meanLoss = 0;
+        for (size_t p = 0; p < deltas.size(); ++p) {
+            double diff = losses[2 * p] - losses[2 * p + 1];
+            meanLoss += losses[2 * p] + losses[2 * p + 1];
+            for (size_t i = 0; i < theta.size(); ++i) {
+                gradient[i] += diff / (2 * ck * deltas[p][i]);
+            }
+        }
+        meanLoss /= losses.size();
+
+        // Noisy estimates may ask for huge steps, move by at most one perturbation
+        for (size_t i = 0; i < theta.size(); ++i) {
+            theta[i] -= std::clamp(ak * gradient[i] / deltas.size(), -ck, ck);
+        }
+        if (onIteration) {
+            onIteration(k, HeuristicWeights::fromVector(theta), meanLoss);
+        }
+    }
+    return HeuristicWeights::fromVector(theta);
+}
+
+} // namespace miplot::cardgame::durak
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "simulator.h"
+#include "strategy.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace miplot::cardgame::durak {
+
+// Creates an opponent of the tuned strategy for a seat in [1, numPlayers)
+using OpponentFactory = std::function<std::unique_ptr<Strategy>(size_t seat)>;
+
+/**
+ * Scores weighted heuristic candidates against fixed opponents.
+ * All candidates play the same deals: round i is seeded from (seed, i) for every
+ * candidate, so the differences between their scores come from the weights,
+ * not from the cards. Rounds are split between threads, each thread plays
+ * its rounds for all candidates
+ */
+class HeuristicEvaluator {
+public:
+    HeuristicEvaluator(size_t numPlayers, OpponentFactory opponents,
+                       size_t numThreads = defaultNumThreads(), Rules rules = Rules());
+
+    // Loss rate of every candidate in seat 0, a draw counts as half a loss
+    std::vector<double> evaluate(const std::vector<HeuristicWeights>& candidates,
+                                 uint64_t seed, size_t numRounds) const;
+
+private:
+    size_t numPlayers_;
+    OpponentFactory opponents_;
+    size_t numThreads_;
+    Rules rules_;
+};
+
+struct SpsaOptions {
+    size_t numIterations = 100;
+    // Perturbations averaged per iteration, each one plays two candidates
+    size_t numPairs = 4;
+    size_t roundsPerCandidate = 2000;
+    // Step sizes a / (k + 1 + A)^alpha and perturbations c / (k + 1)^gamma
+    double a = 10.0;
+    double c = 0.2;
+    double stability = 10.0;
+    double alpha = 0.602;
+    double gamma = 0.101;
+    uint64_t seed = 1;
+};
+
+/**
+ * Simultaneous perturbation stochastic approximation: every iteration moves
+ * all weights at once along random +-1 directions, and estimates the gradient
+ * from the score difference of the two perturbed candidates per direction.
+ * All candidates of an iteration share deals, fresh deals every iteration
+ */
+class SpsaTuner {
+public:
+    // Called after every iteration with the updated weights and the mean loss of its candidates
+    using IterationCallback = std::function<void(size_t iteration, const HeuristicWeights& weights, double loss)>;
+
+    SpsaTuner(const HeuristicEvaluator& evaluator, SpsaOptions options = SpsaOptions());
+
+    HeuristicWeights run(const HeuristicWeights& start,
+                         const IterationCallback& onIteration = IterationCallback()) const;
+
+private:
+    const HeuristicEvaluator& evaluator_;
+    SpsaOptions options_;
+};
+
+} // namespace miplot::cardgame::durak
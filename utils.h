@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -19,4 +22,24 @@ std::string join(const Cont<T>& vec, const std::string& delim = ",")
     return os.str();
 }
 
+// Derive an independent seed for the given index (splitmix64 finalizer)
+inline uint64_t mixSeed(uint64_t seed, uint64_t index)
+{
+    uint64_t z = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Standard error of the mean of count samples from their sum and sum of squares
+inline double standardError(double sum, double sumSq, size_t count)
+{
+    if (count < 2) {
+        return 0.0;
+    }
+    double mean = sum / count;
+    double variance = std::max(0.0, (sumSq - sum * mean) / (count - 1));
+    return std::sqrt(variance / count);
+}
+
 } // namespace miplot::cardgame::durak
\ No newline at end of file